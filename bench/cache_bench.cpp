@@ -0,0 +1,147 @@
+/**
+ * @file cache_bench.cpp
+ * @brief 单锁 LRUCache 与分片缓存在多线程读取下的吞吐对比
+ *
+ * 每个线程按 Zipf 近似分布随机查找块，未命中时插入，块大小 4KB。
+ * 另外对比以 SHA-256 十六进制字符串 + 偏移量与以 BlockCacheKey 作为块缓存 key 的吞吐。
+ * 用法：cache_bench [线程数]，默认 32 个线程。
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "block/block.hh"
+#include "cache.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr size_t K_BLOCK_SIZE       = 4096;
+constexpr size_t K_CAPACITY         = 64UL << 20;
+constexpr int    K_BLOCKS           = 32768;
+constexpr int    K_OPS_PER_THREAD   = 200000;
+constexpr int    K_SHARD_BITS       = 6;
+constexpr double K_ZIPF_EXPONENT    = 0.9;
+constexpr int    K_KEYS_PER_THREAD  = 1 << 16;
+
+/* 预先生成每个线程的访问序列，避免随机数生成影响计时 */
+auto MakeKeys(int threads) -> std::vector<std::vector<int>> {
+  std::vector<double> weights(K_BLOCKS);
+  for (int i = 0; i < K_BLOCKS; i++) {
+    weights[i] = 1.0 / std::pow(i + 1, K_ZIPF_EXPONENT);
+  }
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  std::vector<std::vector<int>>   keys(threads);
+  for (int t = 0; t < threads; t++) {
+    std::mt19937 rng(t);
+    for (int i = 0; i < K_KEYS_PER_THREAD; i++) {
+      keys[t].push_back(dist(rng));
+    }
+  }
+  return keys;
+}
+
+constexpr int K_TABLES = 64;
+
+/* 以表的 SHA-256 十六进制字符串作为前缀的 key */
+struct OidKey {
+  std::string oid_;
+  uint64_t    offset_;
+  auto operator==(const OidKey &rhs) const -> bool { return oid_ == rhs.oid_ && offset_ == rhs.offset_; }
+};
+
+struct OidKeyHash {
+  auto operator()(const OidKey &k) const -> size_t {
+    return std::hash<std::string>()(k.oid_) ^ std::hash<uint64_t>()(k.offset_);
+  }
+};
+
+auto MakeOid(int table) -> std::string {
+  std::mt19937_64 rng(table);
+  char            buf[65];
+  for (int i = 0; i < 64; i += 16) {
+    std::snprintf(buf + i, 17, "%016llx", static_cast<unsigned long long>(rng()));
+  }
+  return {buf, 64};
+}
+
+template <typename Fn>
+auto Run(const char *name, int threads, const std::vector<std::vector<int>> &keys, Fn &&lookup_or_insert) {
+  std::vector<std::thread> workers;
+  auto                     begin = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([&, t]() {
+      const auto &seq = keys[t];
+      for (int i = 0; i < K_OPS_PER_THREAD; i++) {
+        lookup_or_insert(seq[i % K_KEYS_PER_THREAD]);
+      }
+    });
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+  std::printf("%-10s %8.2f Mops/s\n", name, threads * K_OPS_PER_THREAD / elapsed.count() / 1e6);
+}
+
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  int threads = argc > 1 ? std::atoi(argv[1]) : 32;
+  std::printf("threads: %d, capacity: %zu MB, blocks: %d x %zu KB\n", threads, K_CAPACITY >> 20, K_BLOCKS,
+              K_BLOCK_SIZE >> 10);
+  auto keys  = MakeKeys(threads);
+  auto block = std::make_shared<const std::string>(K_BLOCK_SIZE, 'x');
+
+  /* 单锁 LRU 按条目计数，值为 shared_ptr 以免 Get 拷贝整个块 */
+  LRUCache<int, std::shared_ptr<const std::string>, std::mutex> lru(K_CAPACITY / K_BLOCK_SIZE);
+  Run("lru", threads, keys, [&](int key) {
+    std::shared_ptr<const std::string> value;
+    if (!lru.Get(key, value)) {
+      lru.Put(key, block);
+    }
+  });
+
+  for (auto policy : {CacheEvictionPolicy::LRU, CacheEvictionPolicy::S3_FIFO}) {
+    ShardedCache<int, std::shared_ptr<const std::string>> sharded(K_CAPACITY, K_SHARD_BITS, policy);
+    Run(policy == CacheEvictionPolicy::LRU ? "sharded" : "s3-fifo", threads, keys, [&](int key) {
+      if (!sharded.Lookup(key)) {
+        sharded.Insert(key, block, K_BLOCK_SIZE);
+      }
+    });
+  }
+
+  /* 块号拆成表号和表内偏移量 */
+  std::vector<std::string> oids;
+  for (int t = 0; t < K_TABLES; t++) {
+    oids.push_back(MakeOid(t));
+  }
+  ShardedCache<OidKey, std::shared_ptr<const std::string>, OidKeyHash> oid_cache(K_CAPACITY, K_SHARD_BITS,
+                                                                                  CacheEvictionPolicy::S3_FIFO);
+  Run("oid-key", threads, keys, [&](int block_num) {
+    OidKey key{oids[block_num % K_TABLES], static_cast<uint64_t>(block_num / K_TABLES) * K_BLOCK_SIZE};
+    if (!oid_cache.Lookup(key)) {
+      oid_cache.Insert(key, block, K_BLOCK_SIZE);
+    }
+  });
+
+  ShardedCache<BlockCacheKey, std::shared_ptr<const std::string>> id_cache(K_CAPACITY, K_SHARD_BITS,
+                                                                            CacheEvictionPolicy::S3_FIFO);
+  std::vector<uint64_t> ids;
+  for (int t = 0; t < K_TABLES; t++) {
+    ids.push_back(id_cache.NewId());
+  }
+  Run("int-key", threads, keys, [&](int block_num) {
+    BlockCacheKey key(ids[block_num % K_TABLES], static_cast<uint64_t>(block_num / K_TABLES) * K_BLOCK_SIZE);
+    if (!id_cache.Lookup(key)) {
+      id_cache.Insert(key, block, K_BLOCK_SIZE);
+    }
+  });
+  return 0;
+}
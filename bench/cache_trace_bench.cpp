@@ -0,0 +1,147 @@
+/**
+ * @file cache_trace_bench.cpp
+ * @brief 按访问轨迹回放，对比不同淘汰策略以及 TinyLFU 准入的命中率，以及高优先级池对索引块命中率的影响
+ *
+ * 默认生成一条被扫描污染的轨迹：点查按 Zipf 分布访问热点块，其间周期性插入一次性的顺序扫描。
+ * 统计优先级池时每次读块之前先读它所在表的索引块（每 K_BLOCKS_PER_INDEX 个块一个索引块），索引块以高优先级插入。
+ * 也可以传入轨迹文件回放，文件每行一个块号，以 s 开头的行视为扫描读到的块，只统计点查的命中率。
+ * 用法：cache_trace_bench [轨迹文件]
+ */
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "cache.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr size_t   K_BLOCK_SIZE       = 4096;
+constexpr int      K_POINT_BLOCKS     = 100000;
+constexpr int      K_POINT_ACCESSES   = 2000000;
+constexpr int      K_SCAN_INTERVAL    = 50000;  // 每隔多少次点查插入一次扫描
+constexpr int      K_SCAN_LENGTH      = 20000;  // 一次扫描读取的块数
+constexpr double   K_ZIPF_EXPONENT    = 0.9;
+constexpr uint64_t K_SCAN_BLOCK_BASE  = 1UL << 40;
+constexpr uint64_t K_INDEX_BASE       = 1UL << 62;
+constexpr uint64_t K_BLOCKS_PER_INDEX = 64;
+
+struct Access {
+  uint64_t block_;
+  bool     scan_;
+};
+
+auto GenerateTrace() -> std::vector<Access> {
+  std::vector<double> weights(K_POINT_BLOCKS);
+  for (int i = 0; i < K_POINT_BLOCKS; i++) {
+    weights[i] = 1.0 / std::pow(i + 1, K_ZIPF_EXPONENT);
+  }
+  std::discrete_distribution<int> dist(weights.begin(), weights.end());
+  std::mt19937                    rng(42);
+  std::vector<Access>             trace;
+  uint64_t                        next_scan_block = K_SCAN_BLOCK_BASE;
+  for (int i = 0; i < K_POINT_ACCESSES; i++) {
+    /* 块号打散，避免热点块在分片间分布不均 */
+    trace.push_back({static_cast<uint64_t>(dist(rng)) * 2654435761ULL, false});
+    if ((i + 1) % K_SCAN_INTERVAL == 0) {
+      for (int j = 0; j < K_SCAN_LENGTH; j++) {
+        trace.push_back({next_scan_block++, true});
+      }
+    }
+  }
+  return trace;
+}
+
+auto LoadTrace(const char *path) -> std::vector<Access> {
+  std::vector<Access> trace;
+  std::ifstream       in(path);
+  std::string         line;
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    bool scan = line[0] == 's';
+    trace.push_back({std::stoull(scan ? line.substr(1) : line), scan});
+  }
+  return trace;
+}
+
+/* 未命中时插入，返回点查的命中率 */
+auto Replay(const std::vector<Access> &trace, size_t capacity, CacheEvictionPolicy policy, bool tiny_lfu) -> double {
+  ShardedCache<uint64_t, int> cache(CacheOptions{.capacity_               = capacity,
+                                                 .policy_                 = policy,
+                                                 .tiny_lfu_admission_     = tiny_lfu,
+                                                 .estimated_entry_charge_ = K_BLOCK_SIZE});
+  size_t                      point_accesses = 0;
+  size_t                      point_hits     = 0;
+  for (const auto &access : trace) {
+    bool hit = static_cast<bool>(cache.Lookup(access.block_));
+    if (!hit) {
+      cache.Insert(access.block_, 0, K_BLOCK_SIZE);
+    }
+    if (!access.scan_) {
+      point_accesses++;
+      point_hits += hit ? 1 : 0;
+    }
+  }
+  return point_accesses == 0 ? 0 : static_cast<double>(point_hits) / static_cast<double>(point_accesses);
+}
+
+/* 索引块和数据块都在未命中时插入，返回点查读索引块的命中率 */
+auto ReplayWithIndex(const std::vector<Access> &trace, size_t capacity, CacheEvictionPolicy policy, double ratio)
+    -> double {
+  ShardedCache<uint64_t, int> cache(
+      CacheOptions{.capacity_ = capacity, .policy_ = policy, .high_pri_pool_ratio_ = ratio});
+  size_t index_accesses = 0;
+  size_t index_hits     = 0;
+  for (const auto &access : trace) {
+    /* 点查的块号已经打散，按取模分到索引块；扫描的块号连续，按区间分到索引块 */
+    uint64_t index_block = K_INDEX_BASE + (access.scan_ ? access.block_ / K_BLOCKS_PER_INDEX
+                                                        : access.block_ % (K_POINT_BLOCKS / K_BLOCKS_PER_INDEX));
+    bool     hit         = static_cast<bool>(cache.Lookup(index_block));
+    if (!hit) {
+      cache.Insert(index_block, 0, K_BLOCK_SIZE, CachePriority::HIGH);
+    }
+    if (!access.scan_) {
+      index_accesses++;
+      index_hits += hit ? 1 : 0;
+    }
+    if (!cache.Lookup(access.block_)) {
+      cache.Insert(access.block_, 0, K_BLOCK_SIZE);
+    }
+  }
+  return index_accesses == 0 ? 0 : static_cast<double>(index_hits) / static_cast<double>(index_accesses);
+}
+
+}  // namespace
+
+auto main(int argc, char **argv) -> int {
+  auto trace = argc > 1 ? LoadTrace(argv[1]) : GenerateTrace();
+  std::printf("accesses: %zu\n", trace.size());
+  std::printf("%-12s %10s %10s %14s %14s\n", "capacity", "lru", "s3-fifo", "lru+tinylfu", "s3-fifo+tinylfu");
+  for (double ratio : {0.01, 0.05, 0.1, 0.2}) {
+    size_t capacity   = static_cast<size_t>(K_POINT_BLOCKS * ratio) * K_BLOCK_SIZE;
+    double lru        = Replay(trace, capacity, CacheEvictionPolicy::LRU, false);
+    double s3fifo     = Replay(trace, capacity, CacheEvictionPolicy::S3_FIFO, false);
+    double lru_lfu    = Replay(trace, capacity, CacheEvictionPolicy::LRU, true);
+    double s3fifo_lfu = Replay(trace, capacity, CacheEvictionPolicy::S3_FIFO, true);
+    std::printf("%9zu MB %9.2f%% %9.2f%% %13.2f%% %13.2f%%\n", capacity >> 20, lru * 100, s3fifo * 100,
+                lru_lfu * 100, s3fifo_lfu * 100);
+  }
+
+  std::printf("\nindex block hit rate\n");
+  std::printf("%-12s %10s %14s %10s %14s\n", "capacity", "lru", "lru+high-pri", "s3-fifo", "s3-fifo+high-pri");
+  for (double ratio : {0.01, 0.05, 0.1, 0.2}) {
+    size_t capacity    = static_cast<size_t>(K_POINT_BLOCKS * ratio) * K_BLOCK_SIZE;
+    double lru         = ReplayWithIndex(trace, capacity, CacheEvictionPolicy::LRU, 0);
+    double lru_high    = ReplayWithIndex(trace, capacity, CacheEvictionPolicy::LRU, 0.5);
+    double s3fifo      = ReplayWithIndex(trace, capacity, CacheEvictionPolicy::S3_FIFO, 0);
+    double s3fifo_high = ReplayWithIndex(trace, capacity, CacheEvictionPolicy::S3_FIFO, 0.5);
+    std::printf("%9zu MB %9.2f%% %13.2f%% %9.2f%% %13.2f%%\n", capacity >> 20, lru * 100, lru_high * 100,
+                s3fifo * 100, s3fifo_high * 100);
+  }
+  return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file filter_bench.cpp
+ * @brief 过滤器逐个探测与批量探测（MayContainBatch）的吞吐对比
+ *
+ * 模拟 MultiGet：每批随机查询若干不存在的 key，每个 key 依次探测每张表的过滤器。
+ * 过滤器总大小远大于缓存，探测基本都是缓存未命中。
+ */
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "block/filter_block.hh"
+#include "util/monitor_logger.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr int K_TABLES           = 64;
+constexpr int K_BLOCKS_PER_TABLE = 256;
+constexpr int K_KEYS_PER_BLOCK   = 1024;
+constexpr int K_BATCH_SIZE       = 100;
+constexpr int K_ROUNDS           = 200;
+
+struct Table {
+  string            block;
+  FilterBlockReader reader;
+};
+
+auto BuildTables() -> std::vector<std::unique_ptr<Table>> {
+  std::vector<std::unique_ptr<Table>> tables;
+  for (int t = 0; t < K_TABLES; t++) {
+    FilterBlockWriter writer(std::make_unique<BloomFilter>(10));
+    for (int b = 0; b < K_BLOCKS_PER_TABLE; b++) {
+      for (int i = 0; i < K_KEYS_PER_BLOCK; i++) {
+        writer.Update("table" + std::to_string(t) + "_key" + std::to_string(b * K_KEYS_PER_BLOCK + i));
+      }
+      writer.Keys2Block();
+    }
+    auto table = std::make_unique<Table>();
+    writer.Final(table->block);
+    table->reader.Init(table->block);
+    tables.push_back(std::move(table));
+  }
+  return tables;
+}
+
+}  // namespace
+
+auto main() -> int {
+  MLog->set_level(spdlog::level::err);
+  auto   tables = BuildTables();
+  size_t bytes  = 0;
+  for (const auto &table : tables) {
+    bytes += table->block.size();
+  }
+  std::printf("tables: %d, filter bytes: %zu MB, batch: %d\n", K_TABLES, bytes >> 20, K_BATCH_SIZE);
+
+  std::mt19937_64                    rng(42);
+  std::vector<string>                keys(K_BATCH_SIZE);
+  std::vector<int>                   block_nums(K_BATCH_SIZE);
+  std::vector<LookupContext>         ctxs;
+  std::vector<const LookupContext *> ctx_ptrs(K_BATCH_SIZE);
+  std::vector<bool>                  results;
+  size_t                             single_hits = 0;
+  size_t                             batch_hits  = 0;
+  std::chrono::nanoseconds           single_time{0};
+  std::chrono::nanoseconds           batch_time{0};
+
+  for (int round = 0; round < K_ROUNDS; round++) {
+    ctxs.clear();
+    for (int i = 0; i < K_BATCH_SIZE; i++) {
+      keys[i]       = "missing_key" + std::to_string(rng());
+      block_nums[i] = static_cast<int>(rng() % K_BLOCKS_PER_TABLE);
+    }
+    for (int i = 0; i < K_BATCH_SIZE; i++) {
+      ctxs.emplace_back(keys[i]);
+    }
+    for (int i = 0; i < K_BATCH_SIZE; i++) {
+      ctx_ptrs[i] = &ctxs[i];
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (auto &table : tables) {
+      for (int i = 0; i < K_BATCH_SIZE; i++) {
+        single_hits += table->reader.IsKeyExists(block_nums[i], ctxs[i]) ? 1 : 0;
+      }
+    }
+    auto mid = std::chrono::steady_clock::now();
+    for (auto &table : tables) {
+      table->reader.IsKeysExist(block_nums, ctx_ptrs, results);
+      for (bool result : results) {
+        batch_hits += result ? 1 : 0;
+      }
+    }
+    auto end = std::chrono::steady_clock::now();
+    single_time += mid - begin;
+    batch_time += end - mid;
+  }
+
+  double probes = static_cast<double>(K_ROUNDS) * K_TABLES * K_BATCH_SIZE;
+  std::printf("single: %.1f ns/probe (false positives %zu)\n", single_time.count() / probes, single_hits);
+  std::printf("batch:  %.1f ns/probe (false positives %zu)\n", batch_time.count() / probes, batch_hits);
+  return 0;
+}
@@ -0,0 +1,164 @@
+/**
+ * @file merging_iterator_bench.cpp
+ * @brief 败者树 MergingIterator 与二叉堆归并的对比，k = 4 ~ 64
+ *
+ * 输入为内存中的有序 inner_key 数组，测的是归并本身的开销：每个 entry 的时间和比较次数。
+ * 二叉堆归并与改用败者树之前的 MergingIterator 相同，用 std::pop_heap/push_heap 维护各输入当前的 key。
+ */
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "memtable/keys.hh"
+#include "merging_iterator.hh"
+#include "util/monitor_logger.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr int K_ENTRIES = 1 << 21;
+
+/* 有序 inner_key 数组上的迭代器 */
+class VectorIterator {
+ public:
+  explicit VectorIterator(const std::vector<std::string> *keys) : keys_(keys) {}
+
+  auto Valid() const -> bool { return pos_ < keys_->size(); }
+  void SeekToFirst() { pos_ = 0; }
+  void Seek(std::string_view inner_key) {
+    pos_ = std::lower_bound(keys_->begin(), keys_->end(), inner_key,
+                            [](const std::string &a, std::string_view b) { return CmpInnerKey(a, b) < 0; }) -
+           keys_->begin();
+  }
+  void Next() { pos_++; }
+  auto Key() const -> std::string_view { return (*keys_)[pos_]; }
+  auto Value() const -> std::string_view { return {}; }
+  auto Status() const -> RC { return RC::OK; }
+
+ private:
+  const std::vector<std::string> *keys_;
+  size_t                          pos_{0};
+};
+
+/* 统计比较次数的 InnerKeyComparator */
+struct CountingComparator {
+  auto operator()(std::string_view k1, std::string_view k2) const -> int {
+    (*count_)++;
+    return InnerKeyComparator()(k1, k2);
+  }
+
+  uint64_t *count_;
+};
+
+/* 二叉堆归并 */
+template <typename Cmp>
+class HeapMergingIterator {
+ public:
+  HeapMergingIterator(std::vector<VectorIterator> children, Cmp cmp) : children_(std::move(children)), cmp_(cmp) {}
+
+  auto Valid() const -> bool { return !heap_.empty(); }
+  void SeekToFirst() {
+    heap_.clear();
+    for (int i = 0; i < static_cast<int>(children_.size()); i++) {
+      children_[i].SeekToFirst();
+      if (children_[i].Valid()) {
+        heap_.push_back(i);
+      }
+    }
+    std::make_heap(heap_.begin(), heap_.end(), Greater());
+  }
+  void Next() {
+    std::pop_heap(heap_.begin(), heap_.end(), Greater());
+    auto &child = children_[heap_.back()];
+    child.Next();
+    if (child.Valid()) {
+      std::push_heap(heap_.begin(), heap_.end(), Greater());
+    } else {
+      heap_.pop_back();
+    }
+  }
+  auto Key() const -> std::string_view { return children_[heap_.front()].Key(); }
+
+ private:
+  auto Greater() const {
+    return [this](int a, int b) {
+      int cmp = cmp_(children_[a].Key(), children_[b].Key());
+      return cmp > 0 || (cmp == 0 && a > b);
+    };
+  }
+
+  std::vector<VectorIterator> children_;
+  Cmp                         cmp_;
+  std::vector<int>            heap_;
+};
+
+/* 把 K_ENTRIES 个随机 key 随机分到 k 个有序输入中 */
+auto BuildInputs(int k) -> std::vector<std::vector<std::string>> {
+  std::mt19937                          rng(k);
+  std::vector<std::vector<std::string>> inputs(k);
+  for (int i = 0; i < K_ENTRIES; i++) {
+    auto user_key = fmt::format("key{:010}", rng() % (K_ENTRIES * 4));
+    inputs[rng() % k].push_back(MemKey(user_key, i + 1).ToSSTableKey());
+  }
+  for (auto &input : inputs) {
+    std::sort(input.begin(), input.end(), [](const auto &a, const auto &b) { return CmpInnerKey(a, b) < 0; });
+  }
+  return inputs;
+}
+
+auto Children(const std::vector<std::vector<std::string>> &inputs) -> std::vector<VectorIterator> {
+  std::vector<VectorIterator> children;
+  for (const auto &input : inputs) {
+    children.emplace_back(&input);
+  }
+  return children;
+}
+
+/* 遍历所有 entry，返回每个 entry 的纳秒数；校验和防止循环被优化掉 */
+template <typename Merger>
+auto Scan(Merger &iter, uint64_t &checksum) -> double {
+  auto begin = std::chrono::steady_clock::now();
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    checksum += iter.Key().size();
+  }
+  std::chrono::duration<double, std::nano> time = std::chrono::steady_clock::now() - begin;
+  return time.count() / K_ENTRIES;
+}
+
+void Run(int k) {
+  auto     inputs   = BuildInputs(k);
+  uint64_t checksum = 0;
+
+  HeapMergingIterator<InnerKeyComparator> heap(Children(inputs), InnerKeyComparator());
+  MergingIterator<VectorIterator>         loser_tree(Children(inputs));
+  double                                  heap_time       = Scan(heap, checksum);
+  double                                  loser_tree_time = Scan(loser_tree, checksum);
+
+  uint64_t                                heap_cmps       = 0;
+  uint64_t                                loser_tree_cmps = 0;
+  HeapMergingIterator<CountingComparator> counting_heap(Children(inputs), CountingComparator{&heap_cmps});
+  MergingIterator<VectorIterator, CountingComparator> counting_loser_tree(Children(inputs),
+                                                                          CountingComparator{&loser_tree_cmps});
+  Scan(counting_heap, checksum);
+  Scan(counting_loser_tree, checksum);
+
+  std::printf("k = %2d  heap: %6.1f ns/entry %5.2f cmp/entry  loser tree: %6.1f ns/entry %5.2f cmp/entry (%llu)\n", k,
+              heap_time, static_cast<double>(heap_cmps) / K_ENTRIES, loser_tree_time,
+              static_cast<double>(loser_tree_cmps) / K_ENTRIES, static_cast<unsigned long long>(checksum));
+}
+
+}  // namespace
+
+auto main() -> int {
+  MLog->set_level(spdlog::level::err);
+  for (int k : {4, 8, 16, 32, 64}) {
+    Run(k);
+  }
+  return 0;
+}
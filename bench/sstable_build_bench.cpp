@@ -0,0 +1,65 @@
+/**
+ * @file sstable_build_bench.cpp
+ * @brief SSTable 串行生成与流水线生成（编码 / 内容哈希 / 写文件三个阶段并行）的吞吐对比，
+ *        以及 SHA-256 与 HASH128 两种内容哈希的对比
+ */
+#include <fmt/format.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include "sstable/sstable.hh"
+#include "util/monitor_logger.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr int K_KEYS   = 1000000;
+constexpr int K_ROUNDS = 3;
+
+auto Build(const std::string &dbname, const DBOptions &options) -> size_t {
+  std::unique_ptr<TempFile> file;
+  FileManager::OpenTempFile(SstDir(dbname), "bench_", file);
+  SSTableWriter writer(dbname, file.release(), options);
+  std::string   value(200, 'v');
+  for (int i = 0; i < K_KEYS; i++) {
+    writer.Add(MemKey(fmt::format("key{:010}", i), i + 1).ToSSTableKey(), value);
+  }
+  FileMetaData meta;
+  writer.Finish(&meta);
+  FileManager::Destroy(meta.GetSSTablePath(dbname));
+  return meta.file_size_;
+}
+
+}  // namespace
+
+auto main() -> int {
+  MLog->set_level(spdlog::level::err);
+  std::string dbname = "/tmp/sstable_build_bench";
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  FileManager::Create(dbname, FileOptions::DIR_);
+  FileManager::Create(SstDir(dbname), FileOptions::DIR_);
+
+  for (auto content_hash : {ContentHashType::SHA256, ContentHashType::HASH128}) {
+    for (int inflight_blocks : {0, 4, 16, 64}) {
+      DBOptions options;
+      options.content_hash_                  = content_hash;
+      options.sstable_build_inflight_blocks_ = inflight_blocks;
+      size_t bytes                           = 0;
+      auto   begin                           = std::chrono::steady_clock::now();
+      for (int round = 0; round < K_ROUNDS; round++) {
+        bytes += Build(dbname, options);
+      }
+      std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - begin;
+      std::printf("%-7s inflight blocks %2d: %7.1f MB/s\n",
+                  content_hash == ContentHashType::SHA256 ? "sha256" : "hash128", inflight_blocks,
+                  static_cast<double>(bytes) / elapsed.count() / 1e6);
+    }
+  }
+
+  FileManager::Destroy(dbname);
+  return 0;
+}
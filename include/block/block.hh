@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "return_code.hh"
@@ -110,6 +111,8 @@ class BlockReader : public std::enable_shared_from_this<BlockReader> {
       std::function<RC(string_view, string_view, string_view innner_key, string &key, string &value)> &&handle_result)
       -> RC;
   auto Get(std::string_view want_key, std::string &key, std::string &value) -> RC;
+  /* 定位到第一个大于等于 key 的条目并解码，不存在时返回 End() */
+  auto Seek(std::string_view key) -> Iterator;
 
  private:
   auto BsearchRestartPoint(string_view key, int *index) -> RC;
@@ -151,14 +154,22 @@ struct BlockHandle {
   }
 };
 
-struct BlockCacheHandle {
-  string oid_;
-  int    offset_;
-  BlockCacheHandle() = default;
-  BlockCacheHandle(string oid, int offset) : oid_(std::move(oid)), offset_(offset) {}
-  auto operator==(const BlockCacheHandle &h) const -> bool { return h.oid_ == oid_ && h.offset_ == offset_; }
+/**
+ * @brief 块缓存的 key
+ * @details 每张表打开时从块缓存分配一个 64 位的 cache_id（ShardedCache::NewId），与块在文件中的偏移量组成 16 字节的 key，
+ *          查找块时不需要分配、哈希和比较 SHA-256 的十六进制字符串。
+ */
+struct BlockCacheKey {
+  uint64_t cache_id_{0};
+  uint64_t offset_{0};
+
+  BlockCacheKey() = default;
+  BlockCacheKey(uint64_t cache_id, uint64_t offset) : cache_id_(cache_id), offset_(offset) {}
+  auto operator==(const BlockCacheKey &rhs) const -> bool = default;
 };
 
+static_assert(sizeof(BlockCacheKey) == 16 && std::is_trivially_copyable_v<BlockCacheKey>);
+
 auto DecodeRestartsPointKeyWrap(const char *restart_record, string_view &restarts_key) -> RC;
 auto DecodeRestartsPointValueWrap(const char *restart_record, string_view &restarts_value) -> RC;
 
@@ -172,10 +183,15 @@ auto DecodeRestartsPointKeyAndValueWrap(const char *restart_record, string_view
 
 namespace std {
 template <>  // function-template-specialization
-class hash<lsm_tree::BlockCacheHandle> {
+class hash<lsm_tree::BlockCacheKey> {
  public:
-  auto operator()(const lsm_tree::BlockCacheHandle &h) const -> size_t {
-    return hash<string>()(h.oid_) ^ hash<int>()(h.offset_);
+  /* 同一张表的块偏移量只有低位不同，混合后高位和低位都分布均匀 */
+  auto operator()(const lsm_tree::BlockCacheKey &k) const -> size_t {
+    uint64_t h = (k.cache_id_ * 0x9E3779B97F4A7C15ULL) ^ k.offset_;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    return h;
   }
 };
 
@@ -1,9 +1,12 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 #include "return_code.hh"
+#include "util/hash64.hh"
+#include "util/prefix_extractor.hh"
 
 namespace lsm_tree {
 
@@ -12,26 +15,72 @@ using std::string_view;
 using std::unique_ptr;
 using std::vector;
 
+/* 过滤器查询键，构造时计算一次哈希，之后对所有 SSTable 的过滤器探测都复用这个哈希 */
+class FilterKey {
+ public:
+  FilterKey() = default;
+  explicit FilterKey(string_view key) : key_(key), hash_(Hash64(key)) {}
+  auto Key() const -> string_view { return key_; }
+  auto Hash() const -> uint64_t { return hash_; }
+
+ private:
+  string_view key_;
+  uint64_t    hash_{0};
+};
+
+/**
+ * @brief 一次点查的上下文
+ * @details 在查询开始时对 user_key 及其前缀各计算一次哈希，随后传给每一个 SSTable 的过滤器，
+ *          避免每个过滤器重复哈希同一个 key。key 的内存由调用方保证在查询期间有效。
+ */
+struct LookupContext {
+  explicit LookupContext(string_view user_key, const PrefixExtractor *prefix_extractor = nullptr);
+
+  FilterKey              key_;                        // 完整的 user_key
+  FilterKey              prefix_;                     // user_key 的前缀，has_prefix_ 为 true 时有效
+  bool                   has_prefix_{false};          // user_key 是否在前缀提取器的定义域内
+  const PrefixExtractor *prefix_extractor_{nullptr};  // 计算 prefix_ 所用的提取器
+};
+
 class FilterAlgorithm {
  public:
   virtual auto Keys2Block(const vector<string> &keys, string &result) -> RC = 0;
   virtual auto IsKeyExists(string_view key, string_view bitmap) -> bool     = 0;
-  virtual void FilterInfo(string &info);
+  virtual void FilterInfo(string &info)                                     = 0;
+  /* 使用预先计算好的哈希探测，不支持哈希复用的算法按 key 探测 */
+  virtual auto MayContain(const FilterKey &key, string_view bitmap) -> bool { return IsKeyExists(key.Key(), bitmap); }
+  /* 批量探测，keys[i] 在 bitmaps[i] 中探测，结果写入 results[i] */
+  virtual void MayContainBatch(const vector<FilterKey> &keys, const vector<string_view> &bitmaps,
+                               vector<bool> &results);
   virtual ~FilterAlgorithm() = default;
 };
 
 class BloomFilter : public FilterAlgorithm {
  public:
+  /* 第一版使用两次 Murmur3 哈希，只用于读取旧的 SSTable */
+  static constexpr int K_MURMUR3_VERSION = 1;
+  /* 第二版使用一次 64 位哈希，高低 32 位分别作为双哈希的两个值 */
+  static constexpr int K_HASH64_VERSION = 2;
+  /* key 很少时位图过小，误判率会明显偏高 */
+  static constexpr uint32_t K_MIN_BITMAP_BITS = 64;
+
   /* bits_per_key 将会决定 一个 bloom-filter-block n 个 key 需要存储的总大小 */
-  explicit BloomFilter(int bits_per_key);
+  explicit BloomFilter(int bits_per_key, int version = K_HASH64_VERSION);
   auto Keys2Block(const vector<string> &keys, string &result) -> RC override;
   auto IsKeyExists(string_view key, string_view bitmap) -> bool override;
+  auto MayContain(const FilterKey &key, string_view bitmap) -> bool override;
+  void MayContainBatch(const vector<FilterKey> &keys, const vector<string_view> &bitmaps,
+                       vector<bool> &results) override;
   void FilterInfo(string &info) override;
   ~BloomFilter() override = default;
 
  private:
+  void HashPair(string_view key, uint32_t *h1, uint32_t *h2);
+  auto MayContain(uint32_t h1, uint32_t h2, string_view bitmap) -> bool;
+
   int bits_per_key_;  // 每个 key 所占用 的 bit 数量
   int k_;             // 哈希函数个数
+  int version_;       // 过滤器格式版本
 };
 
 /*
@@ -42,35 +91,73 @@ class BloomFilter : public FilterAlgorithm {
 ----------------------------------------------------------------------------------------
 |             filter_info           |               filter_info_len                    |
 ----------------------------------------------------------------------------------------
+
+配置了前缀提取器时，每个 bitmap 额外索引 key 的前缀，并在最后追加一个索引整张表所有前缀的 bitmap，
+filter_info 在算法信息之后追加前缀信息：
+----------------------------------------------------------------
+| algorithm_info |  flags  |      prefix_extractor_name       |
+----------------------------------------------------------------
+|                | 1 byte  |                                  |
+----------------------------------------------------------------
 */
 
 class FilterBlockWriter {
  public:
-  explicit FilterBlockWriter(unique_ptr<FilterAlgorithm> &&method);
+  explicit FilterBlockWriter(unique_ptr<FilterAlgorithm>            &&method,
+                             std::shared_ptr<const PrefixExtractor> prefix_extractor    = nullptr,
+                             bool                                   whole_key_filtering = true);
   auto Update(string_view key) -> RC;
   auto Final(string &result) -> RC;
   auto Keys2Block() -> RC;
 
+  /* filter_info 中 flags 的取值 */
+  static constexpr char K_WHOLE_KEY_FILTERING = 0x1;
+  static constexpr char K_TABLE_PREFIX_FILTER = 0x2;
+
  private:
+  void AddPrefix(string_view key);
+
   string         buffer_;   // filter_block 缓冲区，保存了多个位图，一个位图对应一个block
   vector<string> keys_;     // 用来保存目前填入的 key ，在 Keys2Block 被调用时生成filter_block
   vector<int>    offsets_;  // 每个 filter 的偏移量
   unique_ptr<FilterAlgorithm> method_;  // 过滤器算法，目前只有 bloom-filter
+
+  bool                                   pending_{false};          // 上次 Keys2Block 之后是否有新的 key
+  std::shared_ptr<const PrefixExtractor> prefix_extractor_;        // 前缀提取器，为空时不索引前缀
+  bool                                   whole_key_filtering_;     // 是否索引完整的 key
+  string                                 last_prefix_;             // 当前 filter 最后加入的前缀
+  bool                                   has_last_prefix_{false};  // last_prefix_ 是否有效
+  vector<string>                         table_prefixes_;          // 整张表的前缀，用于生成表级前缀过滤器
 };
 
 class FilterBlockReader {
  public:
   FilterBlockReader();
-  auto Init(string_view filter_block) -> RC;
+  auto Init(string_view filter_block, const PrefixExtractor *prefix_extractor = nullptr) -> RC;
   auto IsKeyExists(int filter_block_num, string_view key) -> bool;
+  auto IsKeyExists(int filter_block_num, const LookupContext &ctx) -> bool;
+  void IsKeysExist(const vector<int> &filter_block_nums, const vector<const LookupContext *> &ctxs,
+                   vector<bool> &results);
+  auto IsPrefixExists(int filter_block_num, string_view key) -> bool;
+  auto IsTablePrefixExists(string_view key) -> bool;
+  auto PrefixExtractorName() const -> string_view { return prefix_extractor_name_; }
 
  private:
   auto                        CreateFilterAlgorithm() -> RC;
+  auto                        ProbeKey(const LookupContext &ctx) const -> const FilterKey *;
+  auto                        MayMatch(int filter_idx, const FilterKey &key) -> bool;
+  auto                        FilterBitmap(int filter_idx) -> string_view;
   int                         filters_nums_;            // 过滤器块的个数
+  int                         data_filters_nums_;       // 数据块对应的过滤器个数，不包含表级前缀过滤器
   int                         filters_offsets_offset_;  // 过滤器偏移量数组在块中的偏移量
   string_view                 filters_offsets_;         // 过滤器数组
   string_view                 filter_info_;             // 过滤器信息
   string_view                 filter_blocks_;           // 整个过滤器块
   unique_ptr<FilterAlgorithm> method_;                  // 过滤器算法，目前只有 bloom-filter
+
+  bool                   whole_key_filtering_{true};       // 构建时是否索引了完整 key
+  bool                   has_table_prefix_filter_{false};  // 是否有表级前缀过滤器
+  string_view            prefix_extractor_name_;           // 构建时使用的前缀提取器
+  const PrefixExtractor *prefix_extractor_{nullptr};       // 与构建时一致的前缀提取器，否则为空
 };
 }  // namespace lsm_tree
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace lsm_tree {
+
+/**
+ * @brief 按层分配布隆过滤器的 bits_per_key（Monkey）
+ * @details 绝大多数不存在的 key 的查询都会走到最深的一层，各层使用相同的 bits_per_key 并不划算。
+ *          在过滤器总内存不变的前提下，让每层的误判率与该层的 key 数成正比，可以使所有层误判率之和最小，
+ *          即浅层的小文件多分配 bit，深层少分配。应在 flush/compaction 生成 SSTable 时按当前各层大小重新计算。
+ * @param level_keys 各层的 key 数
+ * @param bits_per_key 平均每个 key 的 bit 数，决定过滤器总内存
+ * @return vector<int> 各层的 bits_per_key，至少为 1；没有 key 的层返回 bits_per_key
+ */
+auto AllocateFilterBits(const std::vector<uint64_t> &level_keys, double bits_per_key) -> std::vector<int>;
+
+/* 布隆过滤器在给定 bits_per_key 下的理论误判率 */
+auto BloomFalsePositiveRate(double bits_per_key) -> double;
+
+/**
+ * @brief 各层过滤器的统计信息
+ * @details 记录每层过滤器占用的内存，以及过滤器的探测结果。过滤器判断可能存在、但数据块中没有找到的查询计为一次误判，
+ *          观测误判率 = 误判次数 / (误判次数 + 过滤器排除的次数)。所有计数都是原子的，可以在多个读线程中同时更新。
+ */
+class FilterStats {
+ public:
+  static constexpr int K_MAX_LEVELS = 8;
+
+  /* 生成或删除 SSTable 时更新该层过滤器的内存 */
+  void AddFilter(int level, uint64_t bytes);
+  void RemoveFilter(int level, uint64_t bytes);
+  /* 读取时记录过滤器的结果 */
+  void RecordProbe(int level, bool may_match);
+  void RecordFalsePositive(int level);
+
+  auto FilterBytes(int level) const -> uint64_t;
+  auto Probes(int level) const -> uint64_t;
+  auto ObservedFalsePositiveRate(int level) const -> double;
+  auto ToString() const -> std::string;
+
+ private:
+  struct LevelStats {
+    std::atomic<uint64_t> filter_bytes_{0};     // 过滤器占用的内存
+    std::atomic<uint64_t> probes_{0};           // 探测次数
+    std::atomic<uint64_t> negatives_{0};        // 过滤器排除的次数
+    std::atomic<uint64_t> false_positives_{0};  // 误判次数
+  };
+
+  std::array<LevelStats, K_MAX_LEVELS> levels_;
+};
+
+}  // namespace lsm_tree
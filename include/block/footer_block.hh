@@ -4,39 +4,48 @@
 
 #include "block.hh"
 #include "return_code.hh"
+#include "util/content_hash.hh"
 
 namespace lsm_tree {
 
 /*
-------------------------------------------------------------------------------------
-| meta_block_handle | index_block_handle |    magic_number    |    magic_number    |
-------------------------------------------------------------------------------------
-|     8 bytes       |      8 bytes       |        0x12        |        0x34        |
-------------------------------------------------------------------------------------
+-------------------------------------------------------------------------------------------------------
+| meta_block_handle | index_block_handle | content_hash_type |    magic_number    |    magic_number    |
+-------------------------------------------------------------------------------------------------------
+|     8 bytes       |      8 bytes       |      1 byte       |        0x12        |        0x35        |
+-------------------------------------------------------------------------------------------------------
+content_hash_type 为文件名所用的 ContentHashType。
+旧格式没有 content_hash_type，magic_number 为 0x12 0x34，共 LEGACY_FOOTER_SIZE 字节，内容哈希固定为 SHA-256。
 */
 class FooterBlockWriter {
  public:
-  auto Add(string_view meta_block_handle, string_view index_block_handle) -> RC;
+  auto Add(string_view meta_block_handle, string_view index_block_handle,
+           ContentHashType content_hash = ContentHashType::SHA256) -> RC;
   auto Final(string &result) -> RC;
 
-  static constexpr int FOOTER_SIZE = 2 + 8 * 2;
+  static constexpr int FOOTER_SIZE        = 2 + 8 * 2 + 1;
+  static constexpr int LEGACY_FOOTER_SIZE = 2 + 8 * 2;
 
  private:
-  string_view meta_block_handle_;
-  string_view index_block_handle_;
+  string_view     meta_block_handle_;
+  string_view     index_block_handle_;
+  ContentHashType content_hash_{ContentHashType::SHA256};
 };
 
 class FooterBlockReader {
  public:
   FooterBlockReader() = default;
+  /* footer_buffer 为文件最后 FOOTER_SIZE 字节（文件更短时为整个文件），按末尾的 magic_number 识别新旧格式 */
   auto Init(string_view footer_buffer) -> RC;
   auto MetaBlockHandle() const -> const BlockHandle & { return meta_block_handle_; }
   auto IndexBlockHandle() const -> const BlockHandle & { return index_block_handle_; }
+  auto ContentHash() const -> ContentHashType { return content_hash_; }
 
  private:
-  string_view footer_buffer_;
-  BlockHandle meta_block_handle_;
-  BlockHandle index_block_handle_;
+  string_view     footer_buffer_;
+  BlockHandle     meta_block_handle_;
+  BlockHandle     index_block_handle_;
+  ContentHashType content_hash_{ContentHashType::SHA256};
 };
 
 }  // namespace lsm_tree
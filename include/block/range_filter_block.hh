@@ -0,0 +1,81 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "block/filter_block.hh"
+#include "return_code.hh"
+
+namespace lsm_tree {
+
+/*
+范围过滤器（前缀哈希阶梯）：回答 "SSTable 中是否可能有 key 落在 [lower, upper) 内"，
+用于短范围查询在读取索引块之前跳过 SSTable。
+
+表中所有 key 共享的公共前缀记为 P，对每个 key 把 P 之后 max_depth 字节内的每个前缀加入布隆过滤器，
+前缀以半字节（4 bit）为单位，每层最多 16 个分支。长度不超过 |P| + max_depth 的 key 额外加入一个终止标记，
+表示恰好有一个 key 等于该前缀。查询时沿 lower 和 upper 两条边界路径向下逐个半字节展开，
+边界之间的前缀只要有一个存在就返回可能存在，所有前缀都不存在时可以排除这张表。
+
+------------------------------------------------------------------------------------------------------
+| bitmap | smallest_key | largest_key | bitmap_len | smallest_len | largest_len | keys_num | max_depth |
+------------------------------------------------------------------------------------------------------
+|        |              |             |  4 bytes   |   4 bytes    |   4 bytes   | 4 bytes  |  4 bytes  |
+------------------------------------------------------------------------------------------------------
+| bits_per_key | version |
+--------------------------
+|   4 bytes    | 4 bytes |
+--------------------------
+*/
+
+class RangeFilterBlockWriter {
+ public:
+  explicit RangeFilterBlockWriter(int bits_per_key, int max_depth = K_DEFAULT_MAX_DEPTH);
+  /* key 必须按升序加入 */
+  auto Update(string_view key) -> RC;
+  auto Final(string &result) -> RC;
+
+  static constexpr int K_DEFAULT_MAX_DEPTH = 8;
+  static constexpr int K_TRAILER_SIZE      = 7 * sizeof(int);
+  /* 过滤器中的三类元素以不同的标记开头 */
+  static constexpr char K_PREFIX_TAG      = 'p';  // 整字节的前缀
+  static constexpr char K_HALF_PREFIX_TAG = 'h';  // 以半字节结尾的前缀
+  static constexpr char K_TERMINAL_TAG    = 't';  // 完整的 key
+
+  static void EncodeEntry(string_view key, size_t nibbles, string &entry);
+
+ private:
+  int            bits_per_key_;
+  int            max_depth_;
+  string         smallest_key_;
+  string         largest_key_;
+  size_t         common_prefix_len_{0};  // 目前加入的 key 的公共前缀长度，只会变短
+  vector<string> keys_;                  // 截断到 common_prefix_len_ + max_depth_ 的 key，最终的公共前缀在 Final 时确定
+  vector<bool>   truncated_;             // keys_[i] 是否被截断
+};
+
+class RangeFilterBlockReader {
+ public:
+  RangeFilterBlockReader() = default;
+  auto Init(string_view range_filter_block) -> RC;
+  /* 是否可能有 key 落在 [lower, upper) 内，upper 为空表示没有上界 */
+  auto MayContainRange(string_view lower, string_view upper) -> bool;
+
+  static constexpr int K_MAX_PROBES = 256;  // 单次查询最多探测次数，超过后按可能存在处理
+
+ private:
+  auto Search(size_t nibbles, string_view lower, string_view upper, bool lower_tight, bool upper_tight, int &probes)
+      -> bool;
+
+  string_view             bitmap_;
+  string_view             smallest_key_;
+  string_view             largest_key_;
+  int                     keys_num_{0};
+  int                     max_depth_{0};
+  size_t                  common_prefix_len_{0};  // 所有 key 的公共前缀长度
+  unique_ptr<BloomFilter> method_;
+  string                  path_;   // 查询时当前前缀对应的字节，最后一个字节可能只有高半字节有效
+  string                  probe_;  // 探测时拼接标记和前缀的缓冲区
+};
+
+}  // namespace lsm_tree
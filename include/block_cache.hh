@@ -0,0 +1,87 @@
+/**
+ * @file block_cache.hh
+ * @brief 未压缩块和压缩块两层的块缓存
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include "block/block.hh"
+#include "cache.hh"
+#include "return_code.hh"
+
+namespace lsm_tree {
+
+class SecondaryCache;
+
+struct BlockCacheStats {
+  CacheStats uncompressed_;
+  CacheStats compressed_;
+  uint64_t   decompressions_{0};       // 未压缩层未命中、从压缩层解压得到的块
+  uint64_t   decompress_failures_{0};  // 压缩层中解压失败的块，已被删除
+};
+
+/**
+ * @brief 两层块缓存：未压缩块缓存 + 压缩块缓存
+ * @details 只缓存解压后的块时，同样的内存能容纳的工作集受块的压缩率限制。压缩层保存块在文件中的压缩形式，
+ *          未压缩层未命中时先在压缩层查找，命中只需要一次解压，不需要读磁盘，解压得到的块重新放入未压缩层。
+ *          两层共用一个字节预算：压缩层占 compressed_ratio，其余给未压缩层，调整容量时按同样的比例重新划分。
+ *
+ *          从磁盘读到块时两层都插入（包含式），热点块在未压缩层被淘汰后仍然可以从压缩层恢复，插入时不需要重新压缩。
+ *          块在文件中没有压缩时（压缩后不比原块小）只放入未压缩层。压缩层中的块总是低优先级；
+ *          索引块和过滤器块的高优先级只作用于未压缩层。
+ *
+ *          设置了二级缓存时，未压缩层因容量不足淘汰的块写入二级缓存，两层都未命中时再查二级缓存。
+ */
+class BlockCache {
+ public:
+  using Cache  = ShardedCache<BlockCacheKey, std::string>;
+  using Handle = Cache::Handle;
+  /* 把压缩的块解压到 block 中 */
+  using Decompressor = std::function<RC(std::string_view compressed, std::string &block)>;
+
+  /* compressed_ratio 为 0 或 decompressor 为空时不使用压缩层 */
+  BlockCache(const CacheOptions &options, double compressed_ratio, Decompressor decompressor);
+
+  /* 未压缩层未命中时从压缩层解压，两层都未命中时返回空的 Handle */
+  auto Lookup(const BlockCacheKey &key) -> Handle;
+  /**
+   * @brief 插入从磁盘读到的块
+   * @param block 解压后的块
+   * @param compressed 块在文件中的压缩形式，为空表示块没有压缩
+   * @param priority 块在未压缩层中的优先级
+   */
+  auto Insert(const BlockCacheKey &key, std::string block, std::string_view compressed,
+              CachePriority priority = CachePriority::LOW) -> Handle;
+  /* 表文件被删除时调用，同时删除各层中的块 */
+  void Erase(const BlockCacheKey &key);
+  /* 在开始使用前设置，secondary 的生命周期必须长于块缓存 */
+  void SetSecondaryCache(SecondaryCache *secondary);
+  /* 按 compressed_ratio 重新划分两层的容量 */
+  void SetCapacity(size_t capacity);
+  auto NewId() -> uint64_t { return uncompressed_.NewId(); }
+
+  auto Capacity() const -> size_t { return uncompressed_.Capacity() + compressed_.Capacity(); }
+  auto Usage() const -> size_t { return uncompressed_.Usage() + compressed_.Usage(); }
+  auto Stats() const -> BlockCacheStats;
+
+ private:
+  static auto CompressedOptions(const CacheOptions &options, double compressed_ratio) -> CacheOptions;
+  static auto UncompressedOptions(const CacheOptions &options, double compressed_ratio) -> CacheOptions;
+  auto        LookupCompressed(const BlockCacheKey &key, std::string &block) -> bool;
+
+  const double    compressed_ratio_;
+  Decompressor    decompressor_;
+  Cache           uncompressed_;
+  Cache           compressed_;
+  SecondaryCache *secondary_{nullptr};
+
+  std::atomic<uint64_t> decompressions_{0};
+  std::atomic<uint64_t> decompress_failures_{0};
+};
+
+}  // namespace lsm_tree
@@ -11,10 +11,20 @@
 #pragma once
 
 #include <algorithm>
+#include <cassert>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
+#include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
+#include "util/frequency_sketch.hh"
 namespace lsm_tree {
 
 class NullLock {
@@ -121,4 +131,781 @@ void LRUCache<Key, Value, Lock>::Prune() {
   }
 }
 
+/* 分片缓存的淘汰策略 */
+enum class CacheEvictionPolicy {
+  LRU,      // 命中时移到链表头部，查找需要独占锁
+  S3_FIFO,  // 小 FIFO + 主 FIFO + 幽灵队列，命中只增加访问计数，查找只需要共享锁，能抵抗扫描
+};
+
+/* 条目的优先级，索引块和过滤器块使用高优先级 */
+enum class CachePriority { LOW, HIGH };
+
+struct CacheOptions {
+  /* 容量（字节） */
+  size_t capacity_ = 8UL << 20;
+  /* 分为 2^shard_bits_ 个分片，每个分片一把锁 */
+  int                 shard_bits_ = 4;
+  CacheEvictionPolicy policy_     = CacheEvictionPolicy::LRU;
+  /* TinyLFU 准入：缓存已满时，新条目的估计访问频率必须高于将被淘汰的条目才会被缓存，避免只访问一次的块挤占缓存 */
+  bool tiny_lfu_admission_ = false;
+  /* 估计的单个条目大小，用于确定频率计数器的个数 */
+  size_t estimated_entry_charge_ = 4096;
+  /* 高优先级池占容量的比例，为 0 时不区分优先级。低优先级池中还有可以淘汰的条目时，高优先级池中的条目不会被淘汰 */
+  double high_pri_pool_ratio_ = 0;
+};
+
+/* 二级缓存的配置，见 SecondaryCache */
+struct SecondaryCacheOptions {
+  /* 缓存文件所在的目录，应放在本地 SSD 上，为空表示不使用二级缓存 */
+  std::string path_;
+  /* 所有缓存文件的总大小，超过后删除最早的缓存文件 */
+  size_t capacity_ = 1UL << 30;
+  /* 单个缓存文件的大小，写满后切换到新文件 */
+  size_t file_size_ = 64UL << 20;
+  /* 等待后台写入的最大字节数，超过后直接丢弃新插入的块 */
+  size_t max_pending_bytes_ = 16UL << 20;
+};
+
+struct CacheStats {
+  uint64_t lookups_{0};
+  uint64_t hits_{0};
+  uint64_t inserts_{0};
+  uint64_t rejections_{0};  // 被准入过滤器拒绝的插入
+  size_t   usage_{0};
+  size_t   high_pri_usage_{0};  // 高优先级池占用的字节数，其余为低优先级池
+  size_t   pinned_usage_{0};
+
+  auto HitRatio() const -> double { return lookups_ == 0 ? 0 : static_cast<double>(hits_) / lookups_; }
+  auto HighPriRatio() const -> double { return usage_ == 0 ? 0 : static_cast<double>(high_pri_usage_) / usage_; }
+};
+
+/**
+ * @brief 分片缓存，容量以字节计
+ * @details 按 key 的哈希分到 2^shard_bits 个分片，每个分片有自己的锁，多个读线程访问不同分片时互不阻塞。
+ *          每个条目插入时指定占用的字节数（charge），分片内已用字节数超过容量时按淘汰策略淘汰条目。
+ *          查找返回带引用计数的 Handle，持有 Handle 期间条目不会被淘汰也不会被释放，读取时不需要拷贝值。
+ *          被 Handle 引用的条目仍然计入已用容量，被淘汰或删除后在最后一个 Handle 释放时才真正释放。
+ *
+ *          S3-FIFO：新条目先进入容量为 1/10 的小队列，只被访问过一次的条目（例如扫描读到的块）直接从小队列淘汰，
+ *          只把 key 的哈希记入幽灵队列；在小队列中被再次访问过的条目移入主队列。主队列按 CLOCK 方式淘汰，
+ *          访问计数不为 0 的条目计数减一后重新排到队尾。幽灵队列中的 key 再次插入时直接进入主队列。
+ *
+ *          TinyLFU 准入：每次查找都在频率计数器中记录 key，缓存已满时比较新 key 与下一个将被淘汰的条目的估计频率，
+ *          新 key 不占优时不缓存，只把条目交给调用方。幽灵队列中的 key 和替换已有条目的插入总是准入。
+ *
+ *          优先级池：高优先级的条目（索引块、过滤器块）放在单独的队列中，总是准入，淘汰时先淘汰低优先级池，
+ *          大范围扫描只会替换低优先级池中的数据块。高优先级池超过 high_pri_pool_ratio_ 时，最早的条目降级到低优先级池；
+ *          S3-FIFO 下被访问过的条目按 CLOCK 方式留在池中。需要常驻的块（如 L0 表的索引块）由表一直持有 Handle。
+ */
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedCache {
+  struct ListNode {
+    ListNode *prev_{this};
+    ListNode *next_{this};
+  };
+
+  /* 条目所在的队列 */
+  enum Queue : uint8_t { K_NONE, K_LRU, K_SMALL, K_MAIN, K_HIGH };
+
+  struct Entry : public ListNode {
+    Entry(const Key &key, Value &&value, size_t charge, size_t hash)
+        : key_(key), value_(std::move(value)), charge_(charge), hash_(hash) {}
+
+    Key                   key_;
+    Value                 value_;
+    size_t                charge_;
+    size_t                hash_;
+    std::atomic<uint32_t> refs_{0};  // 引用计数，在缓存中时缓存本身持有一个引用
+    std::atomic<uint8_t>  freq_{0};  // S3-FIFO 的访问计数，最大为 K_MAX_FREQ
+    Queue                 queue_{K_NONE};
+  };
+
+  class Shard;
+
+ public:
+  /* 指向缓存条目的引用计数句柄，析构时释放引用 */
+  class Handle {
+   public:
+    Handle() = default;
+    Handle(const Handle &rhs);
+    Handle(Handle &&rhs) noexcept;
+    auto operator=(const Handle &rhs) -> Handle &;
+    auto operator=(Handle &&rhs) noexcept -> Handle &;
+    ~Handle() { Reset(); }
+
+    void Reset();
+    auto operator*() const -> const Value & { return entry_->value_; }
+    auto operator->() const -> const Value * { return &entry_->value_; }
+    explicit operator bool() const { return entry_ != nullptr; }
+
+   private:
+    friend class ShardedCache;
+    Handle(Shard *shard, Entry *entry) : shard_(shard), entry_(entry) {}
+
+    Shard *shard_{nullptr};
+    Entry *entry_{nullptr};
+  };
+
+  using EvictionCallback = std::function<void(const Key &, const Value &)>;
+
+  ShardedCache(const ShardedCache &)                     = delete;
+  auto operator=(const ShardedCache &) -> ShardedCache & = delete;
+
+  explicit ShardedCache(const CacheOptions &options);
+  explicit ShardedCache(size_t capacity, int shard_bits = K_DEFAULT_SHARD_BITS,
+                        CacheEvictionPolicy policy = CacheEvictionPolicy::LRU)
+      : ShardedCache(CacheOptions{capacity, shard_bits, policy}) {}
+  ~ShardedCache() = default;
+
+  /* 插入后返回新条目的句柄，同一个 key 的旧条目会被替换 */
+  auto Insert(const Key &k, Value v, size_t charge, CachePriority priority = CachePriority::LOW) -> Handle;
+  /* 未命中时返回空句柄 */
+  auto Lookup(const Key &k) -> Handle;
+  auto Erase(const Key &k) -> bool;
+  void SetCapacity(size_t capacity);
+  auto Capacity() const -> size_t { return capacity_; }
+  auto Policy() const -> CacheEvictionPolicy { return options_.policy_; }
+  auto Usage() const -> size_t;
+  /* 被 Handle 引用而不能淘汰的字节数 */
+  auto PinnedUsage() const -> size_t;
+  auto HighPriorityUsage() const -> size_t;
+  auto Stats() const -> CacheStats;
+  /* 条目因容量不足被淘汰时调用（不包括 Erase 和替换），在分片的锁内执行，回调中不能访问缓存 */
+  void SetEvictionCallback(const EvictionCallback &callback);
+  /* 分配一个新的 id，每张表打开时取一个作为块缓存 key 的前缀，保证不同表的 key 互不相同 */
+  auto NewId() -> uint64_t { return last_id_.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+  static constexpr int     K_DEFAULT_SHARD_BITS = 4;
+  static constexpr uint8_t K_MAX_FREQ           = 3;
+  static constexpr size_t  K_SMALL_RATIO        = 10;  // 小队列占容量的 1/K_SMALL_RATIO
+
+ private:
+  class Shard {
+   public:
+    Shard(const CacheOptions &options, size_t capacity);
+    ~Shard();
+
+    void SetCapacity(size_t capacity);
+    void SetEvictionCallback(const EvictionCallback &callback);
+    auto Insert(const Key &k, Value &&v, size_t charge, size_t hash, CachePriority priority) -> Entry *;
+    auto Lookup(const Key &k, size_t hash) -> Entry *;
+    auto Erase(const Key &k) -> bool;
+    void Release(Entry *e);
+    auto Usage() const -> size_t { return usage_.load(std::memory_order_relaxed); }
+    auto HighPriorityUsage() const -> size_t { return high_usage_.load(std::memory_order_relaxed); }
+    auto PinnedUsage() const -> size_t;
+    void AddStats(CacheStats &stats) const;
+
+   private:
+    static void ListRemove(ListNode *node);
+    static void ListAppend(ListNode *list, ListNode *node);
+    static auto Pinned(const Entry *e) -> bool { return e->refs_.load(std::memory_order_acquire) > 1; }
+    static auto FirstUnpinned(const ListNode *list) -> const Entry *;
+    void        Unref(Entry *e);
+    void        FinishErase(Entry *e);
+    void        Evict(Entry *e);
+    void        EvictLocked();
+    auto        EvictLRU() -> bool;
+    auto        EvictSmall() -> bool;
+    auto        EvictMain() -> bool;
+    auto        EvictHigh() -> bool;
+    void        DemoteHigh();
+    void        MoveToMain(Entry *e);
+    auto        NextVictim() const -> const Entry *;
+    auto        Admit(size_t hash, size_t charge) const -> bool;
+    void        GhostAdd(size_t hash);
+    auto        GhostRemove(size_t hash) -> bool;
+
+    const CacheEvictionPolicy              policy_;
+    const double                           high_pri_pool_ratio_;
+    mutable std::shared_mutex              mutex_;
+    std::atomic<size_t>                    capacity_{0};
+    std::atomic<size_t>                    usage_{0};
+    std::unordered_map<Key, Entry *, Hash> table_;
+    std::unique_ptr<FrequencySketch>       sketch_;  // 开启 TinyLFU 准入时记录访问频率
+    EvictionCallback                       evict_callback_;
+
+    /* 统计信息 */
+    std::atomic<uint64_t> lookups_{0};
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> inserts_{0};
+    std::atomic<uint64_t> rejections_{0};
+
+    /* LRU */
+    ListNode lru_;  // lru_.next_ 最久未使用
+
+    /* 高优先级池，LRU 下 high_.next_ 最久未使用，S3-FIFO 下 high_.next_ 最早进入 */
+    ListNode            high_;
+    std::atomic<size_t> high_usage_{0};
+
+    /* S3-FIFO，队列的 next_ 是队头（最早进入） */
+    ListNode                                small_;
+    ListNode                                main_;
+    size_t                                  small_usage_{0};
+    size_t                                  main_entries_{0};
+    std::unordered_map<size_t, uint64_t>    ghost_;       // 被淘汰的 key 的哈希 -> 加入时的序号
+    std::deque<std::pair<size_t, uint64_t>> ghost_fifo_;  // 按加入顺序排列，序号与 ghost_ 不一致的是过期项
+    uint64_t                                ghost_seq_{0};
+  };
+
+  auto ShardOf(size_t hash) -> Shard &;
+
+  size_t                              capacity_;
+  int                                 shard_bits_;
+  CacheOptions                        options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::atomic<uint64_t>               last_id_{0};
+};
+
+/*
+**********************************************************************************************************************************************
+* ShardedCache::Handle
+**********************************************************************************************************************************************
+*/
+
+/* 被拷贝的 Handle 已经持有引用，条目不会被释放，增加引用计数不需要加锁 */
+template <typename Key, typename Value, typename Hash>
+ShardedCache<Key, Value, Hash>::Handle::Handle(const Handle &rhs) : shard_(rhs.shard_), entry_(rhs.entry_) {
+  if (entry_ != nullptr) {
+    entry_->refs_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+ShardedCache<Key, Value, Hash>::Handle::Handle(Handle &&rhs) noexcept : shard_(rhs.shard_), entry_(rhs.entry_) {
+  rhs.shard_ = nullptr;
+  rhs.entry_ = nullptr;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Handle::operator=(const Handle &rhs) -> Handle & {
+  if (this != &rhs) {
+    Reset();
+    shard_ = rhs.shard_;
+    entry_ = rhs.entry_;
+    if (entry_ != nullptr) {
+      entry_->refs_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  return *this;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Handle::operator=(Handle &&rhs) noexcept -> Handle & {
+  if (this != &rhs) {
+    Reset();
+    std::swap(shard_, rhs.shard_);
+    std::swap(entry_, rhs.entry_);
+  }
+  return *this;
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Handle::Reset() {
+  if (entry_ != nullptr) {
+    shard_->Release(entry_);
+    shard_ = nullptr;
+    entry_ = nullptr;
+  }
+}
+
+/*
+**********************************************************************************************************************************************
+* ShardedCache::Shard
+**********************************************************************************************************************************************
+*/
+
+template <typename Key, typename Value, typename Hash>
+ShardedCache<Key, Value, Hash>::Shard::Shard(const CacheOptions &options, size_t capacity)
+    : policy_(options.policy_),
+      high_pri_pool_ratio_(std::clamp(options.high_pri_pool_ratio_, 0.0, 1.0)),
+      capacity_(capacity) {
+  if (options.tiny_lfu_admission_) {
+    sketch_ = std::make_unique<FrequencySketch>(capacity / std::max<size_t>(options.estimated_entry_charge_, 1));
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+ShardedCache<Key, Value, Hash>::Shard::~Shard() {
+  for (ListNode *list : {&lru_, &small_, &main_, &high_}) {
+    for (ListNode *node = list->next_; node != list;) {
+      auto *e = static_cast<Entry *>(node);
+      node    = node->next_;
+      /* 销毁缓存时不应该还有 Handle 存在 */
+      assert(!Pinned(e));
+      delete e;
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::ListRemove(ListNode *node) {
+  node->next_->prev_ = node->prev_;
+  node->prev_->next_ = node->next_;
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::ListAppend(ListNode *list, ListNode *node) {
+  node->next_        = list;
+  node->prev_        = list->prev_;
+  node->prev_->next_ = node;
+  node->next_->prev_ = node;
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::Unref(Entry *e) {
+  if (e->refs_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    delete e;
+  }
+}
+
+/* 将已经从 table_ 中移除的条目移出队列，并释放缓存持有的引用 */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::FinishErase(Entry *e) {
+  ListRemove(e);
+  if (e->queue_ == K_SMALL) {
+    small_usage_ -= e->charge_;
+  } else if (e->queue_ == K_MAIN) {
+    main_entries_--;
+  } else if (e->queue_ == K_HIGH) {
+    high_usage_.fetch_sub(e->charge_, std::memory_order_relaxed);
+  }
+  e->queue_ = K_NONE;
+  usage_.fetch_sub(e->charge_, std::memory_order_relaxed);
+  Unref(e);
+}
+
+/* 因容量不足淘汰条目，淘汰前交给回调，例如写入二级缓存 */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::Evict(Entry *e) {
+  table_.erase(e->key_);
+  if (evict_callback_) {
+    evict_callback_(e->key_, e->value_);
+  }
+  FinishErase(e);
+}
+
+/* 被引用的条目不能淘汰，全部被引用时允许暂时超出容量；低优先级池没有可以淘汰的条目时才淘汰高优先级池 */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::EvictLocked() {
+  while (usage_.load(std::memory_order_relaxed) > capacity_.load(std::memory_order_relaxed)) {
+    bool evicted;
+    if (policy_ == CacheEvictionPolicy::LRU) {
+      evicted = EvictLRU() || EvictHigh();
+    } else if (small_usage_ * K_SMALL_RATIO > capacity_.load(std::memory_order_relaxed) || main_entries_ == 0) {
+      evicted = EvictSmall() || EvictMain() || EvictHigh();
+    } else {
+      evicted = EvictMain() || EvictSmall() || EvictHigh();
+    }
+    if (!evicted) {
+      break;
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::EvictLRU() -> bool {
+  for (ListNode *node = lru_.next_; node != &lru_; node = node->next_) {
+    auto *e = static_cast<Entry *>(node);
+    if (!Pinned(e)) {
+      Evict(e);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* 小队列队头的条目：被访问过的移入主队列，否则淘汰并记入幽灵队列 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::EvictSmall() -> bool {
+  for (ListNode *node = small_.next_; node != &small_;) {
+    auto *e = static_cast<Entry *>(node);
+    node    = node->next_;
+    if (Pinned(e)) {
+      continue;
+    }
+    if (e->freq_.load(std::memory_order_relaxed) > 0) {
+      MoveToMain(e);
+      continue;
+    }
+    GhostAdd(e->hash_);
+    Evict(e);
+    return true;
+  }
+  return false;
+}
+
+/* 主队列按 CLOCK 淘汰，每个条目最多被跳过 K_MAX_FREQ 次 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::EvictMain() -> bool {
+  size_t max_visits = main_entries_ * (K_MAX_FREQ + 1);
+  for (size_t visits = 0; visits < max_visits && main_.next_ != &main_; visits++) {
+    auto *e = static_cast<Entry *>(main_.next_);
+    ListRemove(e);
+    ListAppend(&main_, e);
+    if (Pinned(e)) {
+      continue;
+    }
+    uint8_t freq = e->freq_.load(std::memory_order_relaxed);
+    if (freq > 0) {
+      e->freq_.store(freq - 1, std::memory_order_relaxed);
+      continue;
+    }
+    Evict(e);
+    return true;
+  }
+  return false;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::EvictHigh() -> bool {
+  for (ListNode *node = high_.next_; node != &high_; node = node->next_) {
+    auto *e = static_cast<Entry *>(node);
+    if (!Pinned(e)) {
+      Evict(e);
+      return true;
+    }
+  }
+  return false;
+}
+
+/* 高优先级池超出比例时，把最早的条目降级到低优先级池的尾部；S3-FIFO 下访问计数不为 0 的条目计数减一后重新排到队尾 */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::DemoteHigh() {
+  auto high_capacity = static_cast<size_t>(static_cast<double>(capacity_.load(std::memory_order_relaxed)) *
+                                           high_pri_pool_ratio_);
+  while (high_usage_.load(std::memory_order_relaxed) > high_capacity && high_.next_ != &high_) {
+    auto *e = static_cast<Entry *>(high_.next_);
+    ListRemove(e);
+    if (policy_ == CacheEvictionPolicy::S3_FIFO) {
+      uint8_t freq = e->freq_.load(std::memory_order_relaxed);
+      if (freq > 0) {
+        e->freq_.store(freq - 1, std::memory_order_relaxed);
+        ListAppend(&high_, e);
+        continue;
+      }
+    }
+    high_usage_.fetch_sub(e->charge_, std::memory_order_relaxed);
+    if (policy_ == CacheEvictionPolicy::LRU) {
+      e->queue_ = K_LRU;
+      ListAppend(&lru_, e);
+    } else {
+      e->queue_ = K_MAIN;
+      ListAppend(&main_, e);
+      main_entries_++;
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::MoveToMain(Entry *e) {
+  ListRemove(e);
+  small_usage_ -= e->charge_;
+  ListAppend(&main_, e);
+  main_entries_++;
+  e->queue_ = K_MAIN;
+  e->freq_.store(0, std::memory_order_relaxed);
+}
+
+/* 幽灵队列最多保留与主队列条目数相同的 key */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::GhostAdd(size_t hash) {
+  static constexpr size_t k_min_ghost_entries = 16;
+
+  ghost_[hash] = ++ghost_seq_;
+  ghost_fifo_.emplace_back(hash, ghost_seq_);
+  while (ghost_fifo_.size() > std::max(main_entries_, k_min_ghost_entries)) {
+    auto [old_hash, seq] = ghost_fifo_.front();
+    ghost_fifo_.pop_front();
+    if (auto iter = ghost_.find(old_hash); iter != ghost_.end() && iter->second == seq) {
+      ghost_.erase(iter);
+    }
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::GhostRemove(size_t hash) -> bool {
+  return ghost_.erase(hash) > 0;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::FirstUnpinned(const ListNode *list) -> const Entry * {
+  for (const ListNode *node = list->next_; node != list; node = node->next_) {
+    if (!Pinned(static_cast<const Entry *>(node))) {
+      return static_cast<const Entry *>(node);
+    }
+  }
+  return nullptr;
+}
+
+/* 下一个将被淘汰的条目，只用于准入判断，不需要与淘汰时的选择完全一致 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::NextVictim() const -> const Entry * {
+  if (policy_ == CacheEvictionPolicy::LRU) {
+    return FirstUnpinned(&lru_);
+  }
+  const Entry *victim = nullptr;
+  if (small_usage_ * K_SMALL_RATIO > capacity_.load(std::memory_order_relaxed) || main_entries_ == 0) {
+    victim = FirstUnpinned(&small_);
+  }
+  if (victim == nullptr) {
+    victim = FirstUnpinned(&main_);
+  }
+  return victim != nullptr ? victim : FirstUnpinned(&high_);
+}
+
+/* 缓存未满时总是准入，否则新 key 的估计频率必须高于下一个将被淘汰的条目 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::Admit(size_t hash, size_t charge) const -> bool {
+  if (!sketch_ || usage_.load(std::memory_order_relaxed) + charge <= capacity_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  const Entry *victim = NextVictim();
+  return victim == nullptr || sketch_->Estimate(hash) > sketch_->Estimate(victim->hash_);
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::SetCapacity(size_t capacity) {
+  std::unique_lock<std::shared_mutex> g(mutex_);
+  capacity_.store(capacity, std::memory_order_relaxed);
+  DemoteHigh();
+  EvictLocked();
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::SetEvictionCallback(const EvictionCallback &callback) {
+  std::unique_lock<std::shared_mutex> g(mutex_);
+  evict_callback_ = callback;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::Insert(const Key &k, Value &&v, size_t charge, size_t hash,
+                                                   CachePriority priority) -> Entry * {
+  auto *e = new Entry(k, std::move(v), charge, hash);
+  e->refs_.store(1, std::memory_order_relaxed);  // 返回给调用方的引用
+  std::unique_lock<std::shared_mutex> g(mutex_);
+  /* 容量为 0 时不缓存，只把条目交给调用方 */
+  if (capacity_.load(std::memory_order_relaxed) == 0) {
+    return e;
+  }
+  inserts_.fetch_add(1, std::memory_order_relaxed);
+  bool high       = priority == CachePriority::HIGH && high_pri_pool_ratio_ > 0;
+  bool from_ghost = policy_ == CacheEvictionPolicy::S3_FIFO && GhostRemove(hash);
+  if (!high && !from_ghost && table_.find(k) == table_.end() && !Admit(hash, charge)) {
+    rejections_.fetch_add(1, std::memory_order_relaxed);
+    return e;
+  }
+  e->refs_.fetch_add(1, std::memory_order_relaxed);  // 缓存持有的引用
+  if (high) {
+    e->queue_ = K_HIGH;
+    ListAppend(&high_, e);
+    high_usage_.fetch_add(charge, std::memory_order_relaxed);
+  } else if (policy_ == CacheEvictionPolicy::LRU) {
+    e->queue_ = K_LRU;
+    ListAppend(&lru_, e);
+  } else if (from_ghost) {
+    e->queue_ = K_MAIN;
+    ListAppend(&main_, e);
+    main_entries_++;
+  } else {
+    e->queue_ = K_SMALL;
+    ListAppend(&small_, e);
+    small_usage_ += charge;
+  }
+  usage_.fetch_add(charge, std::memory_order_relaxed);
+  auto [iter, inserted] = table_.try_emplace(k, e);
+  if (!inserted) {
+    Entry *old   = iter->second;
+    iter->second = e;
+    FinishErase(old);
+  }
+  if (high) {
+    DemoteHigh();
+  }
+  EvictLocked();
+  return e;
+}
+
+/* LRU 命中时要调整链表，需要独占锁；S3-FIFO 只增加访问计数，共享锁即可 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::Lookup(const Key &k, size_t hash) -> Entry * {
+  lookups_.fetch_add(1, std::memory_order_relaxed);
+  if (sketch_) {
+    sketch_->Increment(hash);
+  }
+  if (policy_ == CacheEvictionPolicy::LRU) {
+    std::unique_lock<std::shared_mutex> g(mutex_);
+    auto                                iter = table_.find(k);
+    if (iter == table_.end()) {
+      return nullptr;
+    }
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    Entry *e = iter->second;
+    ListRemove(e);
+    ListAppend(e->queue_ == K_HIGH ? &high_ : &lru_, e);
+    e->refs_.fetch_add(1, std::memory_order_relaxed);
+    return e;
+  }
+  std::shared_lock<std::shared_mutex> g(mutex_);
+  auto                                iter = table_.find(k);
+  if (iter == table_.end()) {
+    return nullptr;
+  }
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  Entry  *e    = iter->second;
+  uint8_t freq = e->freq_.load(std::memory_order_relaxed);
+  if (freq < K_MAX_FREQ) {
+    /* 并发命中时少计一次无关紧要 */
+    e->freq_.store(freq + 1, std::memory_order_relaxed);
+  }
+  e->refs_.fetch_add(1, std::memory_order_relaxed);
+  return e;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::Erase(const Key &k) -> bool {
+  std::unique_lock<std::shared_mutex> g(mutex_);
+  auto                                iter = table_.find(k);
+  if (iter == table_.end()) {
+    return false;
+  }
+  Entry *e = iter->second;
+  table_.erase(iter);
+  FinishErase(e);
+  return true;
+}
+
+/* 释放引用不需要加锁；被引用期间分片超出了容量时，加锁淘汰 */
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::Release(Entry *e) {
+  Unref(e);
+  if (usage_.load(std::memory_order_relaxed) > capacity_.load(std::memory_order_relaxed)) {
+    std::unique_lock<std::shared_mutex> g(mutex_);
+    EvictLocked();
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Shard::PinnedUsage() const -> size_t {
+  std::shared_lock<std::shared_mutex> g(mutex_);
+  size_t                              pinned = 0;
+  for (const ListNode *list : {&lru_, &small_, &main_, &high_}) {
+    for (const ListNode *node = list->next_; node != list; node = node->next_) {
+      const auto *e = static_cast<const Entry *>(node);
+      pinned += Pinned(e) ? e->charge_ : 0;
+    }
+  }
+  return pinned;
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::Shard::AddStats(CacheStats &stats) const {
+  stats.lookups_ += lookups_.load(std::memory_order_relaxed);
+  stats.hits_ += hits_.load(std::memory_order_relaxed);
+  stats.inserts_ += inserts_.load(std::memory_order_relaxed);
+  stats.rejections_ += rejections_.load(std::memory_order_relaxed);
+  stats.usage_ += Usage();
+  stats.high_pri_usage_ += HighPriorityUsage();
+  stats.pinned_usage_ += PinnedUsage();
+}
+
+/*
+**********************************************************************************************************************************************
+* ShardedCache
+**********************************************************************************************************************************************
+*/
+
+/* 每个分片分到相同的容量，向上取整 */
+template <typename Key, typename Value, typename Hash>
+ShardedCache<Key, Value, Hash>::ShardedCache(const CacheOptions &options)
+    : capacity_(options.capacity_), shard_bits_(std::clamp(options.shard_bits_, 0, 16)), options_(options) {
+  size_t shards_num = 1UL << shard_bits_;
+  size_t per_shard  = (capacity_ + shards_num - 1) / shards_num;
+  for (size_t i = 0; i < shards_num; i++) {
+    shards_.push_back(std::make_unique<Shard>(options_, per_shard));
+  }
+}
+
+/* 用哈希值的高位选择分片，分片内的哈希表使用低位，两者互不相关 */
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::ShardOf(size_t hash) -> Shard & {
+  if (shard_bits_ == 0) {
+    return *shards_[0];
+  }
+  uint64_t h = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+  return *shards_[h >> (64 - shard_bits_)];
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Insert(const Key &k, Value v, size_t charge, CachePriority priority) -> Handle {
+  size_t hash  = Hash()(k);
+  Shard &shard = ShardOf(hash);
+  return Handle(&shard, shard.Insert(k, std::move(v), charge, hash, priority));
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Lookup(const Key &k) -> Handle {
+  size_t hash  = Hash()(k);
+  Shard &shard = ShardOf(hash);
+  Entry *e     = shard.Lookup(k, hash);
+  return e == nullptr ? Handle() : Handle(&shard, e);
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Erase(const Key &k) -> bool {
+  return ShardOf(Hash()(k)).Erase(k);
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::SetCapacity(size_t capacity) {
+  size_t per_shard = (capacity + shards_.size() - 1) / shards_.size();
+  capacity_        = capacity;
+  for (auto &shard : shards_) {
+    shard->SetCapacity(per_shard);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+void ShardedCache<Key, Value, Hash>::SetEvictionCallback(const EvictionCallback &callback) {
+  for (auto &shard : shards_) {
+    shard->SetEvictionCallback(callback);
+  }
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Usage() const -> size_t {
+  size_t usage = 0;
+  for (const auto &shard : shards_) {
+    usage += shard->Usage();
+  }
+  return usage;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::PinnedUsage() const -> size_t {
+  size_t pinned = 0;
+  for (const auto &shard : shards_) {
+    pinned += shard->PinnedUsage();
+  }
+  return pinned;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::HighPriorityUsage() const -> size_t {
+  size_t usage = 0;
+  for (const auto &shard : shards_) {
+    usage += shard->HighPriorityUsage();
+  }
+  return usage;
+}
+
+template <typename Key, typename Value, typename Hash>
+auto ShardedCache<Key, Value, Hash>::Stats() const -> CacheStats {
+  CacheStats stats;
+  for (const auto &shard : shards_) {
+    shard->AddStats(stats);
+  }
+  return stats;
+}
+
 }  // namespace lsm_tree
@@ -0,0 +1,234 @@
+/**
+ * @file compaction.hh
+ * @brief compaction 的输入选择和执行
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "options.hh"
+#include "return_code.hh"
+#include "sstable/sstable.hh"
+#include "version.hh"
+#include "worker.hh"
+
+namespace lsm_tree {
+
+/* 一层的 compaction 统计，按输出层累计 */
+struct CompactionStats {
+  int      compactions_{0};
+  int      trivial_moves_{0};  // 不重写数据、直接移动到下一层的文件个数
+  int      input_files_{0};
+  int      output_files_{0};
+  uint64_t bytes_read_{0};
+  uint64_t bytes_written_{0};
+  int64_t  input_entries_{0};
+  int64_t  output_entries_{0};
+  int      subcompactions_{0};
+  int64_t  dropped_obsolete_entries_{0};  // 被同一个快照区间内更新的版本覆盖而丢弃的版本
+  int64_t  dropped_tombstones_{0};        // 更低的层不可能有该 key 而丢弃的删除标记
+
+  void Add(const CompactionStats &other);
+};
+
+/* 一层中参与 compaction 的文件 */
+struct CompactionInputs {
+  int                      level_{0};
+  vector<Version::FileRef> files_;
+};
+
+/**
+ * @brief 一次 compaction：把 inputs_ 中的文件归并后写入 output_level_
+ * @details inputs_ 按从新到旧排列，同一层的文件在一起：分层 compaction 中 inputs_[0] 为被选中的层，
+ *          之后为输出层中与其重叠的文件。grandparents_ 为输出层的下一层中与输入重叠的文件，用于切分输出文件。
+ */
+struct Compaction {
+  vector<CompactionInputs> inputs_;
+  int                      output_level_{0};
+  vector<Version::FileRef> grandparents_;
+  size_t                   max_output_file_size_{0};
+  uint64_t                 max_grandparent_overlap_bytes_{0};
+  double                   score_{0};  // 被选中时输入层的分数
+  /* 选择输入时的 Version 和存活的快照（从旧到新），由 DB 在执行前设置，用于丢弃旧版本和删除标记 */
+  std::shared_ptr<const Version> input_version_;
+  vector<int64_t>                snapshots_;
+
+  auto NumInputFiles() const -> int;
+  auto InputBytes() const -> uint64_t;
+  /**
+   * @brief 输出层以下的层中是否不可能有 user_key
+   * @details 输出到 L0 时输入之外可能还有更旧的 L0 文件，没有 input_version_ 时无法判断，都返回 false。
+   */
+  auto IsBottommostForKey(string_view user_key) const -> bool;
+  /* 只有一个输入文件，输出层没有与其重叠的文件，且与 grandparents_ 的重叠不大，可以直接移动到输出层 */
+  auto IsTrivialMove() const -> bool;
+  /* 删除所有输入文件 */
+  void AddInputDeletions(VersionEdit &edit) const;
+};
+
+/* 根据当前 Version 选择下一次 compaction，不同的 compaction 策略实现不同的 picker */
+class CompactionPicker {
+ public:
+  virtual ~CompactionPicker() = default;
+
+  virtual auto NeedsCompaction(const Version &version) const -> bool = 0;
+  /* 不需要 compaction 时返回 nullptr */
+  virtual auto PickCompaction(const Version &version) const -> std::unique_ptr<Compaction> = 0;
+};
+
+/**
+ * @brief 分层 compaction
+ * @details 每层有目标大小：L1 为 max_bytes_for_level_base_，之后每层乘以 max_bytes_for_level_multiplier_。
+ *          L0 的分数为文件个数与 level_files_limit_ 之比，其他层为大小与目标大小之比，选择分数最大且不小于 1 的层，
+ *          最后一层不参与。
+ *
+ *          L0 的文件之间可能重叠：从最旧的文件开始，加入所有与已选文件重叠的 L0 文件，保证留在 L0 的文件都比被移到
+ *          L1 的同一个 key 的数据新。其他层选择一个文件：与下一层重叠的字节数和自身大小之比最小的文件，
+ *          每写入一个字节引起的重写最少。
+ */
+class LeveledCompactionPicker : public CompactionPicker {
+ public:
+  explicit LeveledCompactionPicker(const DBOptions &options) : options_(options) {}
+
+  auto NeedsCompaction(const Version &version) const -> bool override;
+  auto PickCompaction(const Version &version) const -> std::unique_ptr<Compaction> override;
+
+  auto LevelScore(const Version &version, int level) const -> double;
+  auto MaxBytesForLevel(int level) const -> double;
+  auto MaxFileSizeForLevel(int level) const -> size_t;
+
+ private:
+  /* 分数最大的层，没有分数不小于 1 的层时返回 -1 */
+  auto PickLevel(const Version &version, double &score) const -> int;
+  void PickL0Files(const Version &version, vector<Version::FileRef> &files) const;
+  auto PickFile(const Version &version, int level) const -> Version::FileRef;
+
+  const DBOptions &options_;
+};
+
+/**
+ * @brief 按大小分级的（universal）compaction
+ * @details 把数据看作从新到旧的有序段：每个 L0 文件是一个有序段，L1 及以下每个非空的层是一个有序段。
+ *          每次合并若干个相邻的有序段，写入紧挨着下一个（更旧的）有序段之上的层，包括最旧的段时写入最后一层，
+ *          下一个段在 L0 或 L1 时写入 L0。每个字节被重写的次数约为有序段个数的对数，远少于分层 compaction，
+ *          代价是点查需要查找更多的有序段，旧版本在合并到最旧的段之前一直占用空间。
+ *
+ *          有序段个数达到 level_files_limit_ 时按以下顺序选择：
+ *          1. 空间放大：除最旧的段外的总大小超过最旧的段的 max_size_amplification_percent_% 时，合并所有段；
+ *          2. 大小比例：从最新的段开始累计，下一个段不大于已选段总大小的 (100 + size_ratio_)% 时加入，
+ *             个数不少于 min_merge_width_ 时合并，否则从下一个段重新开始；
+ *          3. 都不满足时合并最新的若干个段，使有序段个数降到 level_files_limit_ 以下。
+ */
+class UniversalCompactionPicker : public CompactionPicker {
+ public:
+  /* 一个有序段：L0 中的一个文件，或者 L1 及以下的一整层 */
+  struct SortedRun {
+    int              level_{0};
+    Version::FileRef file_;  // 只有 L0 的有序段有
+    uint64_t         size_{0};
+  };
+
+  explicit UniversalCompactionPicker(const DBOptions &options) : options_(options) {}
+
+  auto NeedsCompaction(const Version &version) const -> bool override;
+  auto PickCompaction(const Version &version) const -> std::unique_ptr<Compaction> override;
+
+  /* 从新到旧的有序段 */
+  static auto SortedRuns(const Version &version) -> vector<SortedRun>;
+
+ private:
+  auto PickSpaceAmplification(const vector<SortedRun> &runs, size_t &count) const -> bool;
+  auto PickSizeRatio(const vector<SortedRun> &runs, size_t &start, size_t &count) const -> bool;
+  /* 合并 runs 中 [start, start + count) 的有序段 */
+  auto NewCompaction(const Version &version, const vector<SortedRun> &runs, size_t start, size_t count) const
+      -> std::unique_ptr<Compaction>;
+
+  const DBOptions &options_;
+};
+
+/* 按 compaction_style_ 创建 picker */
+auto NewCompactionPicker(const DBOptions &options) -> std::unique_ptr<CompactionPicker>;
+
+/**
+ * @brief 执行一次 compaction
+ * @details 归并所有输入文件，按 inner_key 的顺序写入输出层的新文件。同一个 user_key 的所有版本写入同一个文件，
+ *          输出层的文件之间不重叠。当前文件超过 max_output_file_size_，或与 grandparents_ 重叠的字节数超过
+ *          max_grandparent_overlap_bytes_ 时，在下一个 user_key 之前切分出新的文件。
+ *          外部导入的文件按全局序列号读取，输出的文件中 key 的序列号都是真实的序列号。
+ *
+ *          max_subcompactions_ 大于 1 时按 user_key 把输入切分为多个互不重叠的范围（subcompaction），
+ *          各自归并和写入自己的输出文件，第一个在调用线程中执行，其余交给 workers 并发执行。
+ *          切分点从输入文件的边界和索引块中每个数据块的最后一个 key 中选取，使每个范围的输入字节数大致相同。
+ *          所有 subcompaction 的输出在 Install 时通过一个 VersionEdit 一起生效。输出到 L0 时只有一个范围。
+ *
+ *          归并时丢弃不再可见的数据：快照把序列号分成若干区间，同一个 user_key 在每个区间内只有最新的版本可见，
+ *          之后的版本都丢弃；最后一个快照之后的区间只对不带快照的读取可见。比所有快照都旧的删除标记，
+ *          在输出层以下的层中不可能有该 key 时也丢弃，它覆盖的更旧的版本已经在同一个区间内被丢弃。
+ */
+class CompactionJob {
+ public:
+  /* workers 用于并发执行 subcompaction，subcompaction 个数不超过 workers 的个数 + 1 */
+  CompactionJob(string_view dbname, const DBOptions &options, const Compaction &compaction,
+                vector<std::shared_ptr<Worker>> workers = {});
+  CompactionJob(const CompactionJob &)                     = delete;
+  auto operator=(const CompactionJob &) -> CompactionJob & = delete;
+
+  /* 写入输出文件，失败时删除已经写入的文件 */
+  auto Run() -> RC;
+  /* 删除输入文件、加入输出文件，失败时删除输出文件 */
+  auto Install(VersionSet *versions) -> RC;
+
+  /* 按 key 排列的输出文件 */
+  auto Outputs() const -> const vector<FileMetaData> & { return outputs_; }
+  auto Stats() const -> const CompactionStats & { return stats_; }
+  /* 切分点，Run 之后有效，个数为 subcompaction 个数 - 1 */
+  auto Boundaries() const -> const vector<string> & { return boundaries_; }
+
+ private:
+  /* user_key 在 [begin_, end_) 内的一个 subcompaction，第一个没有下界，最后一个没有上界 */
+  struct Subcompaction {
+    string begin_;
+    string end_;
+
+    std::unique_ptr<SSTableWriter> writer_;
+    string                         output_path_;  // 当前输出文件的临时路径
+    vector<FileMetaData>           outputs_;
+    size_t                         grandparent_index_{0};
+    bool                           seen_key_{false};
+    uint64_t                       overlapped_bytes_{0};  // 当前输出文件与 grandparents_ 重叠的字节数
+    CompactionStats                stats_;
+    RC                             status_{RC::OK};
+  };
+
+  auto OpenInputs() -> RC;
+  void GenerateSubcompactions();
+  void RunSubcompaction(Subcompaction &sub);
+  auto ProcessKeys(Subcompaction &sub) -> RC;
+  auto OpenOutput(Subcompaction &sub) -> RC;
+  auto FinishOutput(Subcompaction &sub) -> RC;
+  /* 是否丢弃该版本，见类的说明；last_stripe 为同一个 user_key 上一个版本所在的快照区间 */
+  auto ShouldDrop(Subcompaction &sub, string_view key, size_t &last_stripe) -> bool;
+  /* 在 user_key 之前是否应该切分：与 grandparents_ 的重叠超过上限 */
+  auto ShouldStopBefore(Subcompaction &sub, string_view user_key) -> bool;
+  void RemoveOutputs();
+
+  const string                    dbname_;
+  const DBOptions                &options_;
+  const Compaction               &compaction_;
+  vector<std::shared_ptr<Worker>> workers_;
+  int                             filter_bits_per_key_;  // 输出文件的过滤器 bits_per_key，见 Version::FilterBitsPerKey
+
+  /* 与 compaction_.inputs_ 中的文件一一对应 */
+  vector<std::shared_ptr<SSTableReader>> readers_;
+  vector<Version::FileRef>               files_;
+  vector<string>                         boundaries_;
+  vector<Subcompaction>                  subcompactions_;
+  vector<FileMetaData>                   outputs_;
+  CompactionStats                        stats_;
+};
+
+}  // namespace lsm_tree
@@ -0,0 +1,166 @@
+/**
+ * @file db.hh
+ * @brief DB 的读写入口
+ *
+ */
+#pragma once
+
+#include <array>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "block/filter_block.hh"
+#include "block/filter_policy.hh"
+#include "block_cache.hh"
+#include "compaction.hh"
+#include "memtable/memtable.hh"
+#include "options.hh"
+#include "return_code.hh"
+#include "row_cache.hh"
+#include "secondary_cache.hh"
+#include "sstable/table_cache.hh"
+#include "version.hh"
+#include "worker.hh"
+
+namespace lsm_tree {
+
+/**
+ * @brief DB：内存表 + 不可变内存表 + 各层 SSTable
+ * @details 写入先追加到当前内存表的 WAL，再插入内存表。内存表超过 mem_table_size_ 后冻结为不可变内存表，
+ *          切换到新的内存表和新的 WAL，不可变内存表交给后台 Worker 按从旧到新的顺序 flush 为 L0 的 SSTable，
+ *          新的 Version 生效后删除它的 WAL。不可变内存表在 flush 完成之前仍然可读。
+ *          只有不可变内存表的个数达到 max_immutable_mem_tables_ 时写入才阻塞，等待最旧的一个 flush 完成。
+ *
+ *          读取在锁内取得内存表、不可变内存表和当前 Version 的快照，之后不持有锁：
+ *          依次查找内存表、从新到旧的不可变内存表、从新到旧的 L0 文件和 L1 及以下每层中覆盖该 key 的文件，
+ *          第一个找到的版本即为结果。flush 先让新的 Version 生效，再移除不可变内存表，读取总能看到数据。
+ *          设置 row_cache_capacity_ 时，内存表中没有的 key 先查行缓存，在 SSTable 中查到的结果放入行缓存，见 RowCache。
+ *
+ *          打开时回放 wal 目录下剩余的 WAL，每个 WAL 回放为一个内存表并直接 flush 到 L0。
+ *
+ *          flush、导入和 compaction 完成后检查是否需要 compaction，需要时交给后台的 compaction Worker，
+ *          同一时刻最多有一个 compaction。compaction 删除的文件在没有 Version 引用之后才从磁盘删除。
+ *
+ *          快照为一个序列号，读取快照时只能看到序列号不大于它的版本。compaction 只保留存活的快照和最新的读取
+ *          能看到的版本，见 CompactionJob。
+ */
+class DB {
+ public:
+  DB(const DB &)                     = delete;
+  auto operator=(const DB &) -> DB & = delete;
+  /* 等待所有不可变内存表 flush 完成，当前内存表留在 WAL 中，下次打开时回放 */
+  ~DB();
+
+  static auto Open(string_view dbname, const DBOptions &options, std::unique_ptr<DB> &db) -> RC;
+
+  auto Put(string_view key, string_view value) -> RC;
+  auto Delete(string_view key) -> RC;
+  auto Get(string_view key, string &value) -> RC;
+  /* 读取快照 snapshot 时 key 的值 */
+  auto Get(string_view key, string &value, int64_t snapshot) -> RC;
+  /* 批量读取，values[i] 和 rcs[i] 为 keys[i] 的结果，与 Get 相同 */
+  void MultiGet(const vector<string_view> &keys, vector<string> &values, vector<RC> &rcs);
+  /* 以当前的最大序列号创建快照，释放之前 compaction 保留它能看到的版本 */
+  auto GetSnapshot() -> int64_t;
+  void ReleaseSnapshot(int64_t snapshot);
+  /**
+   * @brief 导入 SstFileWriter 生成的外部文件，见 ExternalFileIngestionJob
+   * @details 内存表或不可变内存表与导入的 key 范围重叠时，先冻结内存表并等待 flush 完成，保证导入的数据比内存中的新；
+   *          还要等待正在执行的 compaction 结束，等待期间不调度新的 compaction。导入期间阻塞写入。
+   */
+  auto IngestExternalFile(const vector<string> &paths, const IngestExternalFileOptions &ingest_options) -> RC;
+  /* 冻结当前内存表，等待所有不可变内存表 flush 完成 */
+  auto Flush() -> RC;
+
+  auto LastSequence() const -> int64_t { return versions_.LastSequence(); }
+  auto CurrentVersion() const -> std::shared_ptr<const Version> { return versions_.Current(); }
+  auto NumImmutableMemTables() -> int;
+  /* 因不可变内存表已满而阻塞的写入次数 */
+  auto WriteStalls() -> uint64_t;
+  /* 输出到 level 的 compaction 的累计统计 */
+  auto GetCompactionStats(int level) -> CompactionStats;
+  auto GetBlockCacheStats() const -> BlockCacheStats { return block_cache_->Stats(); }
+  /* 没有设置 row_cache_capacity_ 时全部为 0 */
+  auto GetRowCacheStats() const -> CacheStats { return row_cache_ ? row_cache_->Stats() : CacheStats(); }
+  /* 没有设置 secondary_cache_options_.path_ 时全部为 0 */
+  auto GetSecondaryCacheStats() const -> SecondaryCacheStats {
+    return secondary_cache_ ? secondary_cache_->Stats() : SecondaryCacheStats();
+  }
+  /* 各层过滤器的内存和探测统计 */
+  auto GetFilterStats() const -> const FilterStats & { return filter_stats_; }
+  /* 等待当前和因此触发的 compaction 全部完成 */
+  auto WaitForCompaction() -> RC;
+
+ private:
+  DB(string_view dbname, const DBOptions &options);
+
+  auto Recover() -> RC;
+  auto RecoverWAL(int64_t log_number) -> RC;
+  auto Write(string_view key, string_view value, OperatorType type) -> RC;
+  /* snapshot 为空时读取最新的数据 */
+  auto GetImpl(string_view key, std::optional<int64_t> snapshot, string &value) -> RC;
+  /* 内存表写满时切换，不可变内存表已满时等待 */
+  auto MakeRoomForWrite(std::unique_lock<std::mutex> &lock) -> RC;
+  auto SwitchMemTable() -> RC;
+  void BackgroundFlush();
+  /* 内存表或不可变内存表中是否有 user_key 落在 [smallest, largest] 内 */
+  auto MemTablesOverlap(string_view smallest, string_view largest) -> bool;
+  /* 调用方持有 mutex_，等待到可以让导入生效 */
+  auto WaitForIngestion(const vector<FileMetaData> &files, std::unique_lock<std::mutex> &lock) -> RC;
+  /* 表缓存中的 key：文件 id 和层。同一个文件在不同的层按各自的层打开，移动到其他层后按新的层读取 */
+  static auto TableId(uint64_t file_id, int level) -> uint64_t {
+    return file_id ^ (static_cast<uint64_t>(level) << 56);
+  }
+  auto FindTable(const FileMetaData &file, TableCache::Handle &handle) -> RC;
+  auto GetFromTable(const FileMetaData &file, const LookupContext &ctx, string_view inner_key, string &key,
+                    string &value) -> RC;
+  auto OpenTable(const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) -> RC;
+  /* 从表缓存中移除文件在 level 打开的表 */
+  void EvictTable(uint64_t file_id, int level);
+  /* 调用方持有 mutex_ */
+  void MaybeScheduleCompaction();
+  void BackgroundCompaction();
+  auto RunCompaction(const Compaction &compaction) -> RC;
+  /* 删除不再被任何 Version 引用的文件 */
+  void DeleteObsoleteFiles();
+
+  const string    dbname_;
+  const DBOptions options_;
+  VersionSet      versions_;
+
+  std::unique_ptr<SecondaryCache> secondary_cache_;  // 在 block_cache_ 之后析构
+  std::unique_ptr<BlockCache>     block_cache_;
+  std::unique_ptr<RowCache>       row_cache_;  // row_cache_capacity_ 为 0 时为空
+  FilterStats                     filter_stats_;
+  TableCache                      table_cache_;
+
+  std::mutex                                mutex_;  // 串行化写入，保护以下成员
+  std::condition_variable                   cond_;   // 不可变内存表 flush 完成时通知
+  std::shared_ptr<MemTable>                 mem_;
+  std::deque<std::shared_ptr<MemTable>>     imms_;  // 从新到旧
+  int64_t                                   log_number_{0};
+  RC                                        bg_error_{RC::OK};
+  uint64_t                                  write_stalls_{0};
+  bool                                      compaction_scheduled_{false};
+  int                                       ingestions_waiting_{0};  // 大于 0 时不调度新的 compaction
+  bool                                      shutting_down_{false};
+  std::multiset<int64_t>                    snapshots_;
+  std::array<CompactionStats, K_NUM_LEVELS> compaction_stats_;
+  /* compaction 删除的文件，引用计数降为 1（只剩这里）后删除 */
+  vector<Version::FileRef> obsolete_files_;
+
+  std::unique_ptr<CompactionPicker> compaction_picker_;
+  /* 最先析构，析构之前已经没有待 flush 的内存表和正在执行的 compaction */
+  std::shared_ptr<Worker>         compaction_worker_;
+  std::shared_ptr<Worker>         flush_worker_;
+  vector<std::shared_ptr<Worker>> subcompaction_workers_;  // max_subcompactions_ - 1 个
+};
+
+}  // namespace lsm_tree
@@ -0,0 +1,70 @@
+/**
+ * @file external_file_ingestion.hh
+ * @brief 导入 SstFileWriter 生成的外部 SSTable
+ *
+ */
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include "options.hh"
+#include "return_code.hh"
+#include "util/file_util.hh"
+#include "version.hh"
+
+namespace lsm_tree {
+
+/**
+ * @brief 一次外部文件导入
+ * @details 批量加载时绕过 WAL、内存表和 compaction，把已经排好序的 SSTable 直接放入合适的层：
+ *          Prepare      —— 打开每个文件，读取属性块得到 key 范围，得到文件的内容哈希，检查文件之间的 key 范围不重叠；
+ *          InstallFiles —— 把文件链接（或拷贝）到 sst 目录下，文件名只与内容有关，不需要持有任何锁；
+ *          Apply        —— 在 VersionSet 的锁内分配全局序列号、选择层并生效。
+ *
+ *          外部文件中 key 的序列号都是 0。导入的 key 范围与 DB 中已有的数据都不重叠时，文件不需要序列号，
+ *          直接放入最底层；否则整批文件分配同一个全局序列号 LastSequence() + 1，读取时 key 的序列号按全局序列号处理，
+ *          保证导入的数据比已有的数据新。每个文件放入不与其 key 范围重叠的最深的一层，且更浅的层也都不重叠，
+ *          这样更新的数据总是在更浅的层中；与 L0 重叠时只能放入 L0。
+ *
+ *          调用方负责：Apply 之前把与导入的 key 范围重叠的内存表 flush 到 SSTable，Apply 期间阻塞写入，
+ *          使全局序列号不会被写入重复使用。拷贝大文件可能很慢，InstallFiles 应在阻塞写入之前调用。
+ *          InstallFiles 新建的文件在没有生效（Apply 失败或没有调用 Apply）时，于 job 析构时删除。
+ */
+class ExternalFileIngestionJob {
+ public:
+  ExternalFileIngestionJob(string_view dbname, const DBOptions &options,
+                           const IngestExternalFileOptions &ingest_options, VersionSet *versions);
+  ExternalFileIngestionJob(const ExternalFileIngestionJob &)                     = delete;
+  auto operator=(const ExternalFileIngestionJob &) -> ExternalFileIngestionJob & = delete;
+  ~ExternalFileIngestionJob();
+
+  auto Prepare(const vector<string> &paths) -> RC;
+  auto InstallFiles() -> RC;
+  auto Apply() -> RC;
+
+  /* Prepare 之后为按 key 排序的文件，Apply 之后填充了层号和全局序列号 */
+  auto Files() const -> const vector<FileMetaData> & { return files_; }
+  /* 0 表示没有分配全局序列号 */
+  auto GlobalSequence() const -> int64_t { return global_seq_; }
+
+ private:
+  auto PrepareFile(string_view path, FileMetaData &meta) const -> RC;
+  auto HashFile(string_view path, ContentHashType type, unsigned char *digest) const -> RC;
+  /* 链接或拷贝到 sst 目录下，created 表示是否新建了文件，sst 目录下已有同名文件时为 false */
+  auto InstallFile(string_view path, const FileMetaData &meta, bool &created) const -> RC;
+  auto CopyFile(string_view path, string_view target) const -> RC;
+  auto PickLevel(const Version &version, const FileMetaData &meta) const -> int;
+
+  const string                    dbname_;
+  const DBOptions                &options_;
+  const IngestExternalFileOptions ingest_options_;
+  VersionSet                     *versions_;
+
+  vector<string>       paths_;  // 与 files_ 对应的原文件路径
+  vector<FileMetaData> files_;
+  int64_t              global_seq_{0};
+  vector<string>       created_files_;  // InstallFiles 在 sst 目录下新建、还没有生效的文件
+};
+
+}  // namespace lsm_tree
@@ -11,6 +11,8 @@
  */
 
 #pragma once
+#include <cstdint>
+#include <cstring>
 #include <ostream>
 #include <string>
 #include <string_view>
@@ -65,11 +67,35 @@ struct MemKey {
   static auto NewMinMemKey(std::string_view key) -> MemKey;
 };
 
-inline auto InnerKeyToUserKey(std::string_view inner_key) -> std::string_view;
-inline auto InnerKeySeq(std::string_view inner_key) -> int64_t;
-inline auto InnerKeyOpType(std::string_view inner_key) -> OperatorType;
+auto InnerKeyToUserKey(std::string_view inner_key) -> std::string_view;
+auto InnerKeySeq(std::string_view inner_key) -> int64_t;
+auto InnerKeyOpType(std::string_view inner_key) -> OperatorType;
+void SetInnerKeySeq(std::string &inner_key, int64_t seq);
 
 auto CmpInnerKey(std::string_view k1, std::string_view k2) -> int;
+/**
+ * @brief CmpInnerKey 的函数对象形式
+ * @details 定义在头文件中，作为模板参数时（如 MergingIterator）比较可以内联，不需要每次比较都调用 keys.cpp 中的函数。
+ *          CmpInnerKey 也由它实现，两者的顺序始终一致。
+ */
+struct InnerKeyComparator {
+  auto operator()(std::string_view k1, std::string_view k2) const -> int {
+    if (int ret = k1.substr(0, k1.size() - K_TAG_SIZE).compare(k2.substr(0, k2.size() - K_TAG_SIZE)); ret) {
+      return ret;
+    }
+    /* seq op 反过来比较 */
+    int64_t seq1;
+    int64_t seq2;
+    std::memcpy(&seq1, k1.data() + k1.size() - K_TAG_SIZE, sizeof(seq1));
+    std::memcpy(&seq2, k2.data() + k2.size() - K_TAG_SIZE, sizeof(seq2));
+    if (seq1 != seq2) {
+      return seq1 > seq2 ? -1 : 1;
+    }
+    return static_cast<int>(k2.back()) - static_cast<int>(k1.back());
+  }
+
+  static constexpr size_t K_TAG_SIZE = sizeof(int64_t) + 1;  // seq + type
+};
 auto CmpUserKeyOfInnerKey(std::string_view k1, std::string_view k2) -> int;
 auto CmpKeyAndUserKey(std::string_view key, std::string_view user_key) -> int;
 auto SaveResultIfUserKeyMatch(std::string_view rk, std::string_view rv, std::string_view tk, std::string &dk,
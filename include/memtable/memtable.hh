@@ -31,14 +31,19 @@ class MemTable {
 
  public:
   auto Empty() -> bool;                                                           // 判断MemTable是否为空
+  auto NumEntries() -> size_t;                                                    // 条目数, 包括删除标记
   auto Put(const MemKey &key, string_view value) -> RC;                           // 插入数据
   auto PutTeeWAL(const MemKey &key, string_view value) -> RC;                     // 插入数据, 并写入WAL
   auto GetMemTableSize() -> size_t;                                               // 获取MemTable的大小
   auto DropWAL() -> RC;                                                           // 删除WAL
   auto Get(string_view key, string &value, int64_t seq = INT64_MAX) -> RC;        // 查询数据
   auto GetNoLock(string_view key, string &value, int64_t seq = INT64_MAX) -> RC;  // 查询数据, 不加锁
-  auto BuildSSTable(string_view dbname, FileMetaData **meta_data_pointer) -> RC;  // 构建SSTable
+  auto BuildSSTable(string_view dbname, FileMetaData **meta_data_pointer, int bits_per_key = -1) -> RC;  // 构建SSTable
   auto ForEachNoLock(std::function<RC(const MemKey &key, string_view value)> &&func) -> RC;  // 遍历数据, 不加锁
+  /* 查询seq可见的最新版本, 包括删除标记: 找到时返回OK, type为该版本的操作类型 */
+  auto Lookup(string_view key, int64_t seq, string &value, OperatorType &type) -> RC;
+  /* 是否有user_key落在[smallest, largest]内 */
+  auto OverlapUserKeyRange(string_view smallest, string_view largest) -> bool;
 
  private:
   Stat                          stat_;
@@ -0,0 +1,121 @@
+/**
+ * @file merging_iterator.hh
+ * @brief 多路有序输入的归并
+ *
+ */
+#pragma once
+
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "memtable/keys.hh"
+#include "return_code.hh"
+
+namespace lsm_tree {
+
+/**
+ * @brief 按 inner_key 归并多个有序的子迭代器
+ * @details 子迭代器需要提供 Valid、SeekToFirst、Seek、Next、Key、Value 和 Status，如 SSTableReader::Iterator。
+ *          Cmp 为比较 key 的函数对象，默认为 InnerKeyComparator，比较在模板中内联。
+ *
+ *          用败者树维护各子迭代器当前的 key：k 个子迭代器为叶子，内部节点 1 ~ k-1 记录该节点比赛的败者，
+ *          tree_[0] 记录最终的胜者（最小的 key）。Next 推进胜者后只需沿它的叶子到根的路径与各节点的败者比较，
+ *          每次约 log2(k) 次比较；二叉堆的下沉每层要比较两个孩子，次数约为它的两倍。
+ *          各子迭代器当前的 key 缓存在连续的 keys_ 中，比较时不需要访问子迭代器。
+ *          已经结束的子迭代器视为无穷大，inner_key 相同时下标小的子迭代器在前。
+ */
+template <typename Iter, typename Cmp = InnerKeyComparator>
+class MergingIterator {
+ public:
+  explicit MergingIterator(std::vector<Iter> children, Cmp cmp = Cmp())
+      : children_(std::move(children)),
+        cmp_(std::move(cmp)),
+        keys_(children_.size()),
+        valid_(children_.size(), 0),
+        tree_(children_.size(), 0) {}
+
+  auto Valid() const -> bool { return !tree_.empty() && valid_[tree_[0]]; }
+  void SeekToFirst() {
+    for (auto &child : children_) {
+      child.SeekToFirst();
+    }
+    Build();
+  }
+  void Seek(std::string_view inner_key) {
+    for (auto &child : children_) {
+      child.Seek(inner_key);
+    }
+    Build();
+  }
+  void Next() {
+    int winner = tree_[0];
+    children_[winner].Next();
+    Update(winner);
+    /* 从叶子的父节点到根重赛，赢的继续向上，输的留在节点中 */
+    int k = static_cast<int>(children_.size());
+    for (int node = (winner + k) / 2; node > 0; node /= 2) {
+      if (Less(tree_[node], winner)) {
+        std::swap(tree_[node], winner);
+      }
+    }
+    tree_[0] = winner;
+  }
+  auto Key() const -> std::string_view { return keys_[tree_[0]]; }
+  auto Value() const -> std::string_view { return children_[tree_[0]].Value(); }
+  /* 第一个出错的子迭代器的错误 */
+  auto Status() const -> RC {
+    for (const auto &child : children_) {
+      if (auto rc = child.Status(); rc != RC::OK) {
+        return rc;
+      }
+    }
+    return RC::OK;
+  }
+
+ private:
+  /* 子迭代器 a 当前的 key 是否排在 b 之前 */
+  auto Less(int a, int b) const -> bool {
+    if (!valid_[a] || !valid_[b]) {
+      return valid_[a] && !valid_[b];
+    }
+    int cmp = cmp_(keys_[a], keys_[b]);
+    return cmp < 0 || (cmp == 0 && a < b);
+  }
+
+  void Update(int i) {
+    valid_[i] = children_[i].Valid();
+    keys_[i]  = valid_[i] ? children_[i].Key() : std::string_view();
+  }
+
+  /* 节点 node 的子树中的胜者，败者留在 node 中。叶子 i 的编号为 k + i，节点 n 的孩子为 2n 和 2n+1 */
+  auto Play(int node) -> int {
+    int k = static_cast<int>(children_.size());
+    if (node >= k) {
+      return node - k;
+    }
+    int left  = Play(2 * node);
+    int right = Play(2 * node + 1);
+    if (Less(right, left)) {
+      std::swap(left, right);
+    }
+    tree_[node] = right;
+    return left;
+  }
+
+  void Build() {
+    for (int i = 0; i < static_cast<int>(children_.size()); i++) {
+      Update(i);
+    }
+    if (!tree_.empty()) {
+      tree_[0] = Play(1);
+    }
+  }
+
+  std::vector<Iter>             children_;
+  Cmp                           cmp_;
+  std::vector<std::string_view> keys_;   // 各子迭代器当前的 key
+  std::vector<char>             valid_;  // 各子迭代器是否有效
+  std::vector<int>              tree_;   // tree_[0] 为胜者，tree_[1 ~ k-1] 为各节点的败者
+};
+
+}  // namespace lsm_tree
@@ -1,22 +1,96 @@
 #pragma once
 
+#include <algorithm>
+#include <climits>
 #include <cstddef>
+#include <memory>
+#include <string_view>
+#include "cache.hh"
 #include "spdlog/spdlog.h"
+#include "util/content_hash.hh"
+#include "util/prefix_extractor.hh"
 
 namespace lsm_tree {
 
+/* SSTable 的读取方式，见 SSTableReader */
+enum class TableReadMode {
+  MMAP,   // 整个文件 mmap，零拷贝，依赖 page cache
+  PREAD,  // 按块 pread，使用块缓存
+};
+
+/* compaction 策略，见 LeveledCompactionPicker 和 UniversalCompactionPicker */
+enum class CompactionStyle {
+  LEVELED,    // 分层：读放大和空间放大小，写放大大
+  UNIVERSAL,  // 按大小分级合并有序段：写放大小，读放大和空间放大大
+};
+
+/* UNIVERSAL compaction 的选项 */
+struct UniversalCompactionOptions {
+  /* 候选的有序段总大小乘以 (100 + size_ratio_)% 不小于下一个有序段时，把下一个段也加入合并 */
+  int size_ratio_ = 1;
+  /* 一次合并的有序段个数的下限和上限 */
+  int min_merge_width_ = 2;
+  int max_merge_width_ = INT_MAX;
+  /* 除最旧的有序段外的大小超过最旧的有序段的该百分比时，合并所有有序段 */
+  int max_size_amplification_percent_ = 200;
+};
+
 struct DBOptions {
   /* DB OPERATION */
   bool create_if_not_exists_ = false;
 
   /* SSTABLE */
+  /* 数据块的目标大小，块中的数据超过后切分出新的数据块 */
+  size_t block_size_ = 4096;
+  /* SSTable 的读取方式，数据集能放进 page cache 时 MMAP 没有拷贝，否则 PREAD 配合块缓存更可控 */
+  TableReadMode table_read_mode_ = TableReadMode::PREAD;
+  /* 生成 SSTable 时最多有多少个块已编码但还未写入文件，大于 0 时 SHA-256 和文件写入在后台线程中流水进行，
+     编码下一个块的同时哈希和写入前面的块；0 表示在调用线程中串行完成 */
+  int sstable_build_inflight_blocks_ = 0;
+  /* SSTable 的内容哈希，决定文件名。HASH128 比 SHA-256 快得多，但不抗碰撞攻击；已有的文件不受影响 */
+  ContentHashType content_hash_ = ContentHashType::SHA256;
   /* 布隆过滤器 */
   int bits_per_key_ = 10;
+  /* 按层分配布隆过滤器的 bit：过滤器总内存仍按 bits_per_key_ 计算，浅层多分配、深层少分配，见 AllocateFilterBits */
+  bool optimize_filters_for_levels_ = true;
+  /* 前缀提取器，设置后过滤器会额外索引 key 的前缀，用于前缀查找 */
+  std::shared_ptr<const PrefixExtractor> prefix_extractor_;
+  /* 过滤器是否索引完整的 key，关闭后过滤器只对前缀生效 */
+  bool whole_key_filtering_ = true;
+  /* 范围过滤器索引 key 公共前缀之后的字节数，0 表示不生成范围过滤器 */
+  int range_filter_depth_ = 0;
 
   /* MEMTABLE */
   /* 内存表最大大小，超过了则应该冻结内存表 */
   static constexpr size_t MEM_TABLE_MAX_SIZE = 1UL << 22; /* 4MB */
-  static constexpr size_t BLOCK_CACHE_SIZE   = 1UL << 11; /* 2048 个 BLOCK */
+  /* 内存表超过该大小后冻结为不可变内存表，切换到新的内存表和 WAL */
+  size_t mem_table_size_ = MEM_TABLE_MAX_SIZE;
+  /* 等待 flush 的不可变内存表的最大个数，达到后写入阻塞，直到最旧的一个 flush 到 L0 */
+  int max_immutable_mem_tables_ = 2;
+
+  /* BLOCK CACHE */
+  /* 块缓存按块的大小计费，默认 8MB；淘汰策略默认为 S3-FIFO，避免一次大范围扫描把点查的热点块全部挤出缓存；
+     一半容量留给索引块和过滤器块所在的高优先级池 */
+  CacheOptions block_cache_options_{
+      .capacity_ = 8UL << 20, .policy_ = CacheEvictionPolicy::S3_FIFO, .high_pri_pool_ratio_ = 0.5};
+  /* 块缓存中压缩块层占的比例：块有压缩时，未压缩层未命中先从压缩层解压，不读磁盘；0 表示只缓存未压缩的块。
+     需要解压函数，DB 目前不压缩块、不提供解压函数，此时忽略该比例，全部容量给未压缩层 */
+  double compressed_block_cache_ratio_ = 0;
+  /* 本地 SSD 上的二级块缓存，块缓存淘汰的块写入其中，path_ 为空时不使用 */
+  SecondaryCacheOptions secondary_cache_options_;
+
+  /* ROW CACHE */
+  /* 行缓存的容量（字节），从块缓存的容量中划出，两者总和不变；0 表示不使用行缓存 */
+  size_t row_cache_capacity_ = 0;
+
+  /* 块缓存实际使用的容量 */
+  auto BlockCacheCapacity() const -> size_t {
+    return block_cache_options_.capacity_ - std::min(row_cache_capacity_, block_cache_options_.capacity_);
+  }
+
+  /* TABLE CACHE */
+  /* 同时打开的 SSTable 的最大个数，超过后关闭最久未使用的表；不大于 0 表示不限制 */
+  int max_open_files_ = 1000;
 
   /* BACKGROUND */
   int background_workers_number_ = 1;
@@ -32,6 +106,35 @@ struct DBOptions {
   bool sync_ = false;
 
   /* major compaction */
+  CompactionStyle compaction_style_ = CompactionStyle::LEVELED;
+  /* L0 的文件个数达到该值时触发 L0 到 L1 的 compaction；UNIVERSAL 时为触发合并的有序段个数 */
   int level_files_limit_ = 4;
+  /* L1 的目标大小，之后每层的目标大小是上一层的 max_bytes_for_level_multiplier_ 倍 */
+  size_t max_bytes_for_level_base_       = 10UL << 20;
+  double max_bytes_for_level_multiplier_ = 10;
+  /* compaction 输出的 L1 文件的目标大小，之后每层是上一层的 target_file_size_multiplier_ 倍 */
+  size_t target_file_size_base_       = 2UL << 20;
+  double target_file_size_multiplier_ = 1;
+  /* 一个输出文件与下下层重叠的字节数超过目标文件大小的该倍数时切分，限制以后 compaction 这个文件的代价 */
+  int max_grandparent_overlap_factor_ = 10;
+  /* 一次 compaction 最多按 key 范围切分成几个并发执行的 subcompaction，1 表示不切分 */
+  int max_subcompactions_ = 1;
+  UniversalCompactionOptions universal_compaction_options_;
+};
+
+struct ReadOptions {
+  /* 前缀查找模式：迭代器只返回与 seek key 前缀相同的数据，过滤器排除该前缀的 SSTable 和数据块会被跳过。
+     需要设置 DBOptions::prefix_extractor_，seek key 不在提取器的定义域内时按全序查找 */
+  bool prefix_seek_ = false;
+  /* 范围查询的上界（不包含），为空表示没有上界。创建迭代器时用范围过滤器跳过与 [seek key, 上界) 不相交的 SSTable */
+  std::string_view iterate_upper_bound_;
+};
+
+/* 导入外部 SSTable 的选项，见 ExternalFileIngestionJob */
+struct IngestExternalFileOptions {
+  /* 通过硬链接导入，不拷贝数据，导入成功后删除原文件；不在同一个文件系统中时退化为拷贝。false 时总是拷贝 */
+  bool move_files_ = false;
+  /* 重新计算文件的内容哈希并与文件名校验，文件名不是内容哈希时总是重新计算 */
+  bool verify_content_hash_ = false;
 };
 }  // namespace lsm_tree
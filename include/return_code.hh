@@ -45,6 +45,7 @@ enum class RC {
   BAD_CURRENT_FILE,
   NEW_SSTABLE_ERROR,
   CREATE_FILE_FAILED,
+  INVALID_ARGUMENT,
 };
 
 inline auto RcToString(RC rc) -> std::string_view {
@@ -111,6 +112,8 @@ inline auto RcToString(RC rc) -> std::string_view {
       return "NEW_SSTABLE_ERROR";
     case RC::CREATE_FILE_FAILED:
       return "CREATE_FILE_FAILED";
+    case RC::INVALID_ARGUMENT:
+      return "INVALID_ARGUMENT";
   }
   return "UNKNOWN";
 }
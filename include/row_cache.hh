@@ -0,0 +1,79 @@
+/**
+ * @file row_cache.hh
+ * @brief 点查结果缓存
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "cache.hh"
+#include "util/hash64.hh"
+
+namespace lsm_tree {
+
+/**
+ * @brief 行缓存：缓存点查在内存表和所有 SSTable 中合并后的最终结果
+ * @details 热点 key 的点查命中后不需要再查内存表、解码数据块和二分查找。每个条目记录：
+ *          read_seq  —— 产生结果的读使用的序列号（快照）；
+ *          found_seq —— 结果对应的版本的序列号，key 不存在时为 0，被删除时为删除操作的序列号。
+ *          结果对快照 S 可见的条件是 found_seq <= S，并且 (found_seq, S] 内没有对该 key 的写入。
+ *
+ *          写入不删除缓存中的条目，而是通过序列号判断可见性：按 key 的哈希分到固定个数的槽位，每个槽位记录落在其中的
+ *          key 的最大写入序列号。写入在序列号对读可见之前调用 RecordWrite 更新槽位，查找时若 S <= read_seq，
+ *          读到的就是 S 可见的版本；若 S > read_seq，只有槽位中的序列号不超过 read_seq（之后没有写入）才能使用。
+ *          哈希冲突的写入只会使条目提前失效，不会返回过期的结果。
+ *
+ *          条目按 key 和值的大小计费，容量从块缓存的内存预算中划出，见 DBOptions::row_cache_capacity_。
+ */
+class RowCache {
+ public:
+  explicit RowCache(size_t capacity, int shard_bits = K_DEFAULT_SHARD_BITS, size_t write_slots = K_DEFAULT_WRITE_SLOTS);
+
+  /* 写入 user_key 前调用，必须在 seq 对读可见之前 */
+  void RecordWrite(std::string_view user_key, int64_t seq);
+  /* 无法逐个记录 key 的写入（如导入外部文件）在 seq 对读可见之前调用，相当于对每个 key 调用 RecordWrite */
+  void RecordWriteAll(int64_t seq);
+  /**
+   * @brief 查找快照 snapshot 下 user_key 的结果
+   * @param found 命中时表示 key 是否存在
+   * @param value 命中且 key 存在时返回值
+   * @return true 命中
+   */
+  auto Lookup(std::string_view user_key, int64_t snapshot, bool &found, std::string &value) -> bool;
+  /* 缓存在快照 read_seq 下读到的结果，found_seq 为结果对应版本的序列号 */
+  void Insert(std::string_view user_key, int64_t read_seq, int64_t found_seq, bool found, std::string_view value);
+
+  auto Capacity() const -> size_t { return cache_.Capacity(); }
+  auto Usage() const -> size_t { return cache_.Usage(); }
+  auto Stats() const -> CacheStats { return cache_.Stats(); }
+
+  static constexpr int    K_DEFAULT_SHARD_BITS  = 4;
+  static constexpr size_t K_DEFAULT_WRITE_SLOTS = 1 << 14;
+  static constexpr size_t K_ENTRY_OVERHEAD      = 64;  // 每个条目除 key 和值以外的内存，计入 charge
+
+ private:
+  struct Row {
+    std::string value_;
+    int64_t     read_seq_;
+    int64_t     found_seq_;
+    bool        found_;
+  };
+
+  struct KeyHash {
+    auto operator()(const std::string &key) const -> size_t { return Hash64(key); }
+  };
+
+  auto WriteSlot(std::string_view user_key) -> std::atomic<int64_t> & {
+    return write_seqs_[Hash64(user_key) & write_slots_mask_];
+  }
+
+  ShardedCache<std::string, Row, KeyHash> cache_;
+  size_t                                  write_slots_mask_;
+  std::unique_ptr<std::atomic<int64_t>[]> write_seqs_;  // 每个槽位中 key 的最大写入序列号
+};
+
+}  // namespace lsm_tree
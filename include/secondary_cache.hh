@@ -0,0 +1,114 @@
+/**
+ * @file secondary_cache.hh
+ * @brief 本地 SSD 上的二级块缓存
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "block/block.hh"
+#include "cache.hh"
+#include "return_code.hh"
+#include "util/file_util.hh"
+#include "worker.hh"
+
+namespace lsm_tree {
+
+struct SecondaryCacheStats {
+  uint64_t inserts_{0};
+  uint64_t dropped_{0};  // 写队列已满而丢弃的插入
+  uint64_t hits_{0};
+  uint64_t misses_{0};
+  uint64_t check_sum_errors_{0};
+  size_t   usage_{0};  // 缓存文件的总大小
+};
+
+/**
+ * @brief 持久化的二级块缓存
+ * @details 块缓存淘汰的块写入本地的缓存文件，内存中的块缓存未命中时先在这里查找，命中只需要一次本地读取。
+ *          缓存文件只追加写入，写满后切换到新文件，总大小超过容量时整个删除最早的文件，同时删除其中的块的索引。
+ *          插入是异步的：块先放入写队列，由后台线程写入文件，写入完成后才加入索引，写队列中的块也可以被查找。
+ *          索引只保存在内存中，cache_id 在每次打开表时重新分配，所以打开时会删除目录中遗留的缓存文件。
+ *
+ *          记录格式：
+ *          -----------------------------------------------------------------
+ *          | check_sum | cache_id | offset  | block_len |       block       |
+ *          -----------------------------------------------------------------
+ *          |  4 bytes  | 8 bytes  | 8 bytes |  4 bytes  |  block_len bytes  |
+ *          -----------------------------------------------------------------
+ *          check_sum 为 check_sum 之后所有内容的 crc32c，读取时校验，校验失败的块从索引中删除。
+ */
+class SecondaryCache {
+ public:
+  SecondaryCache(const SecondaryCache &)                     = delete;
+  auto operator=(const SecondaryCache &) -> SecondaryCache & = delete;
+  ~SecondaryCache();
+
+  static auto Open(const SecondaryCacheOptions &options, std::unique_ptr<SecondaryCache> &result) -> RC;
+
+  /* 把块放入写队列，不等待写入 */
+  void Insert(const BlockCacheKey &key, string_view block);
+  /* 未命中返回 NOT_FOUND，校验失败返回 CHECK_SUM_ERROR */
+  auto Lookup(const BlockCacheKey &key, string &block) -> RC;
+  void Erase(const BlockCacheKey &key);
+  /* 等待写队列中的块全部写入文件 */
+  void WaitForPendingWrites();
+  auto Stats() const -> SecondaryCacheStats;
+
+  static constexpr size_t K_HEADER_SIZE   = sizeof(uint32_t) + sizeof(uint64_t) * 2 + sizeof(uint32_t);
+  static constexpr char   K_FILE_SUFFIX[] = ".cache";
+
+ private:
+  /* 块在缓存文件中的位置 */
+  struct Location {
+    uint64_t file_number_;
+    uint64_t offset_;
+    uint32_t size_;  // 整条记录的大小
+  };
+
+  struct CacheFile {
+    uint64_t                          number_;
+    size_t                            size_{0};
+    std::shared_ptr<RandomAccessFile> reader_;
+    std::vector<BlockCacheKey>        keys_;  // 写入该文件的块，删除文件时删除它们的索引
+  };
+
+  explicit SecondaryCache(const SecondaryCacheOptions &options);
+  auto FileName(uint64_t file_number) const -> string;
+  void WritePending(const BlockCacheKey &key);
+  auto Append(const BlockCacheKey &key, string_view block, Location &location) -> RC;
+  auto NewFile() -> RC;
+  void RemoveOldestFile();
+
+  SecondaryCacheOptions   options_;
+  std::shared_ptr<Worker> worker_;
+
+  mutable std::mutex                                               mutex_;
+  std::condition_variable                                          pending_cond_;
+  std::unordered_map<BlockCacheKey, std::shared_ptr<const string>> pending_;  // 等待写入的块
+  size_t                                                           pending_bytes_{0};
+  std::unordered_map<BlockCacheKey, Location>                      index_;
+  std::deque<CacheFile>                                            files_;  // 按创建顺序排列，最后一个正在写入
+  size_t                                                           usage_{0};
+
+  /* 只有后台线程访问 */
+  std::unique_ptr<WritAbleFile> writer_;
+  uint64_t                      next_file_number_{0};
+
+  /* 统计信息 */
+  std::atomic<uint64_t> inserts_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+  std::atomic<uint64_t> check_sum_errors_{0};
+};
+
+}  // namespace lsm_tree
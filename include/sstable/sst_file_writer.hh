@@ -0,0 +1,54 @@
+/**
+ * @file sst_file_writer.hh
+ * @brief 在 DB 之外生成 SSTable，之后通过 IngestExternalFile 导入
+ *
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include "options.hh"
+#include "return_code.hh"
+#include "sstable/sstable.hh"
+
+namespace lsm_tree {
+
+/* SstFileWriter::Finish 生成的文件的信息 */
+struct ExternalSstFileInfo {
+  string file_path_;
+  string smallest_key_;  // 最小的 user_key
+  string largest_key_;   // 最大的 user_key
+  int    num_entries_{0};
+  size_t file_size_{0};
+};
+
+/**
+ * @brief 外部 SSTable 的生成
+ * @details 批量加载时按 key 的顺序直接生成 SSTable，再整体导入 DB，不经过 WAL、内存表和 compaction。
+ *          user_key 必须严格递增，所有 key 的序列号都是 0，导入时由 DB 按需分配全局序列号
+ *          （FileMetaData::global_seq_）。
+ *          文件格式与 DB 生成的 SSTable 相同，文件名为内容哈希，导入时可以直接链接到 sst 目录下。
+ */
+class SstFileWriter {
+ public:
+  explicit SstFileWriter(const DBOptions &options) : options_(options) {}
+
+  /* 在 dir 下创建临时文件，Finish 后重命名为 dir 下以内容哈希命名的文件 */
+  auto Open(string_view dir) -> RC;
+  /* user_key 必须严格递增，否则返回 INVALID_ARGUMENT */
+  auto Put(string_view user_key, string_view value) -> RC;
+  auto Delete(string_view user_key) -> RC;
+  /* 没有写入任何 key 时返回 NEW_SSTABLE_ERROR，info 可以为空 */
+  auto Finish(ExternalSstFileInfo *info) -> RC;
+
+ private:
+  auto Add(string_view user_key, string_view value, OperatorType type) -> RC;
+
+  const DBOptions          &options_;
+  string                    dir_;
+  unique_ptr<SSTableWriter> writer_;
+  string                    last_user_key_;
+};
+
+}  // namespace lsm_tree
@@ -11,25 +11,116 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "block/block.hh"
 #include "block/filter_block.hh"
+#include "block/filter_policy.hh"
 #include "block/footer_block.hh"
+#include "block/range_filter_block.hh"
+#include "block_cache.hh"
 #include "options.hh"
 #include "util/file_util.hh"
+#include "worker.hh"
 
 namespace lsm_tree {
+
+/**
+ * @brief 生成 SSTable 时的块写入流水线
+ * @details 调用线程编码块后提交，哈希线程按提交顺序计算内容哈希，写线程按提交顺序追加到文件，
+ *          三个阶段同时处理不同的块。已提交但还未写入的块不超过 max_inflight 个，超过时 Submit 阻塞，
+ *          内存不随表的大小增长。
+ */
+class TableBuildPipeline {
+ public:
+  /* file 和 hasher 在流水线析构前必须有效，期间调用线程不能直接访问它们 */
+  TableBuildPipeline(WritAbleFile *file, ContentHasher *hasher, int max_inflight);
+  TableBuildPipeline(const TableBuildPipeline &)                     = delete;
+  auto operator=(const TableBuildPipeline &) -> TableBuildPipeline & = delete;
+  ~TableBuildPipeline();
+
+  /* 提交一个块，返回之前的块写入时遇到的错误 */
+  auto Submit(string block) -> RC;
+  /* 等待已提交的块全部写入 */
+  auto Wait() -> RC;
+
+ private:
+  void Append(string_view block);
+
+  WritAbleFile  *file_;
+  ContentHasher *content_hasher_;
+  const int      max_inflight_;
+
+  std::shared_ptr<Worker> hasher_;
+  std::shared_ptr<Worker> appender_;
+
+  std::mutex              mutex_;
+  std::condition_variable cond_;
+  int                     inflight_{0};
+  RC                      status_{RC::OK};  // 第一个写入错误，之后的块不再写入
+};
+
+/* 表的属性，写在 properties 块中，打开表时不需要读取数据块就能得到 key 范围等信息 */
+struct TableProperties {
+  int     num_entries_{0};
+  int64_t max_seq_{0};
+  string  smallest_key_;  // 最小的 inner_key
+  string  largest_key_;   // 最大的 inner_key
+
+  void EncodeTo(string &dst) const;
+  auto DecodeFrom(string_view src) -> RC;
+};
+
+/*
+SSTable 文件格式：
+------------------------------------------------------------------------------------------------------------------------
+| data_block_1 | ... | data_block_n | filter_block | properties_block | range_filter_block | meta_block | index_block |
+------------------------------------------------------------------------------------------------------------------------
+| footer |
+----------
+index_block：每个数据块一项，key 为块中最后一个 inner_key，value 为块的 BlockHandle 和块的序号（4 字节），
+             序号即该块在过滤器块中对应的过滤器的下标
+properties_block：TableProperties
+meta_block：key 为 K_FILTER_BLOCK_NAME 等元数据块的名字，value 为对应块的 BlockHandle，没有生成的块不记录
+footer：meta_block 和 index_block 的 BlockHandle，见 FooterBlockWriter
+*/
 class SSTableWriter {
  public:
-  SSTableWriter(string_view dbname, WritAbleFile *file, const DBOptions &options);
+  /* file 一般是 sst 目录下的临时文件，Finish 之后按内容哈希（DBOptions::content_hash_）重命名；
+     bits_per_key 为过滤器每个 key 的 bit 数，小于 0 时使用 options.bits_per_key_，见 Version::FilterBitsPerKey */
+  SSTableWriter(string_view dbname, WritAbleFile *file, const DBOptions &options, int bits_per_key = -1);
+  SSTableWriter(const SSTableWriter &)                     = delete;
+  auto operator=(const SSTableWriter &) -> SSTableWriter & = delete;
+
+  /* key 为 inner_key，必须严格递增 */
+  auto Add(string_view key, string_view value) -> RC;
+  /* 写入剩余的块和尾信息块，关闭文件并重命名为 sst 目录下以内容哈希命名的文件，填充 meta 中除层号以外的信息 */
+  auto Finish(FileMetaData *meta) -> RC;
+  /* Finish 时文件重命名到的目录，默认为 SstDir(dbname) */
+  void SetOutputDir(string_view dir) { output_dir_ = dir; }
+  /* 已经写入文件的字节数，不包括当前还未写满的数据块 */
+  auto FileSize() const -> size_t { return offset_; }
+  auto NumEntries() const -> int { return num_keys_; }
+
+  /* 元数据块中的 key 必须有序 */
+  static constexpr char K_FILTER_BLOCK_NAME[]       = "filter";
+  static constexpr char K_PROPERTIES_BLOCK_NAME[]   = "properties";
+  static constexpr char K_RANGE_FILTER_BLOCK_NAME[] = "range_filter";
 
  private:
-  static constexpr unsigned int need_flush_size_ = (1UL << 12); /* 4KB */
+  auto FlushDataBlock() -> RC;
+  /* 使用流水线时 block 被移走 */
+  auto WriteBlock(string &block, BlockHandle &handle) -> RC;
+  auto AddMetaBlock(string_view name, BlockHandle &handle) -> RC;
 
-  string                   dbname_;
+  string                   output_dir_;
   unique_ptr<WritAbleFile> file_;
+  const size_t             block_size_; /* 数据块的目标大小，超过后切分 */
 
   /* 数据块 */
   BlockWriter data_block_;
@@ -43,19 +134,218 @@ class SSTableWriter {
   FilterBlockWriter filter_block_;
   BlockHandle       filter_block_handle_;
 
+  /* 范围过滤器块，range_filter_depth_ 为 0 时不生成 */
+  unique_ptr<RangeFilterBlockWriter> range_filter_block_;
+  BlockHandle                        range_filter_block_handle_;
+
+  /* 属性块 */
+  BlockHandle properties_block_handle_;
+
   /* 元数据块 */
   BlockWriter meta_data_block_;
   BlockHandle meta_data_block_handle_;
 
   /* 尾信息块 */
   FooterBlockWriter foot_block_;
-  // BlockHandle foot_block_handle_;
 
-  SHA256_CTX sha256_;
-  string     buffer_;   /* 数据 */
-  int        offset_;   /* 数据的偏移量 */
-  string     last_key_; /* 最后一次 add 的 key */
+  ContentHasher content_hasher_;
+  string        buffer_;           /* 编码块的缓冲区 */
+  size_t        offset_{0};        /* 下一个块在文件中的偏移量 */
+  string        first_key_;        /* 第一次 add 的 key */
+  string        last_key_;         /* 最后一次 add 的 key */
+  int           num_keys_{0};      /* 已经 add 的 key 个数 */
+  int           data_blocks_{0};   /* 已经写入的数据块个数 */
+  int64_t       max_seq_{0};       /* 最大的序列号 */
+  bool          finished_{false};  /* 是否已经调用过 Finish */
+
+  /* 块写入流水线，sstable_build_inflight_blocks_ 为 0 时为空；最先析构，析构时等待在途的块写完 */
+  unique_ptr<TableBuildPipeline> pipeline_;
+};
+
+/* SSTable 文件中的一个块，owner_ 保证 data_ 在使用期间有效 */
+struct TableBlock {
+  string_view           data_;
+  std::shared_ptr<void> owner_;  // 块缓存的 Handle 或读缓冲区；mmap 时为空，由 SSTableReader 保证有效
+};
+
+/* pread 读取数据块的缓冲区池，块用完后缓冲区放回池中，避免每次读取都分配内存 */
+class BlockBufferPool {
+ public:
+  auto Acquire(size_t size) -> std::shared_ptr<string>;
+
+  static constexpr size_t K_MAX_FREE_BUFFERS = 32;
+
+ private:
+  std::mutex                      mutex_;
+  std::vector<unique_ptr<string>> free_;
+};
+
+/**
+ * @brief SSTable 的读取
+ * @details 打开时读取尾信息块、元数据块，以及过滤器块、范围过滤器块和索引块。点查先用过滤器排除，
+ *          再在索引块中找到第一个最后一个 key 大于等于查询 key 的数据块，在数据块中查找。
+ *
+ *          两种 I/O 方式（DBOptions::table_read_mode_）：
+ *          MMAP  —— 整个文件映射到内存，块直接指向映射区，没有拷贝，由 page cache 缓存，不使用块缓存；
+ *          PREAD —— 按块 pread。有块缓存时读到的块放入块缓存，索引块和过滤器块为高优先级；
+ *                   没有块缓存时数据块读入缓冲区池中的缓冲区。
+ *          两种方式下索引块和过滤器块都在打开时解析，表打开期间一直持有，点查不需要再查块缓存和解析。
+ */
+class SSTableReader : public std::enable_shared_from_this<SSTableReader> {
+ public:
+  class Iterator;
+
+  SSTableReader(const SSTableReader &)                     = delete;
+  auto operator=(const SSTableReader &) -> SSTableReader & = delete;
+  ~SSTableReader();
+
+  /**
+   * @brief 打开 SSTable
+   * @param path 文件路径
+   * @param options 配置，读取期间必须有效
+   * @param level 表所在的层，用于决定索引块和过滤器块是否常驻，以及过滤器统计
+   * @param block_cache 块缓存，为空时不使用；表持有其中的索引块和过滤器块，块缓存必须在表关闭之后析构
+   * @param filter_stats 过滤器统计，为空时不统计
+   * @param reader 打开的表
+   */
+  static auto Open(string_view path, const DBOptions &options, int level, BlockCache *block_cache,
+                   FilterStats *filter_stats, std::shared_ptr<SSTableReader> &reader) -> RC;
+
+  /**
+   * @brief 查找第一个大于等于 inner_key 且 user_key 相同的条目
+   * @param ctx 查询的上下文，用于过滤器
+   * @param inner_key 查找的 inner_key，一般是 MemKey(user_key, snapshot).ToSSTableKey()
+   * @param key 找到的条目的 inner_key，可能是删除标记，由调用方判断
+   * @param value 找到的条目的值
+   * @return RC OK 找到，NOT_FOUND 没有该 user_key 的可见版本
+   */
+  auto Get(const LookupContext &ctx, string_view inner_key, string &key, string &value) -> RC;
+  /**
+   * @brief 批量点查，每个查询的结果与 Get 相同
+   * @details 先在索引块中定位所有查询的数据块，再通过 FilterBlockReader::IsKeysExist 一次探测所有过滤器，
+   *          各查询的内存访问相互重叠；可能存在的查询再读取数据块，相邻的查询落在同一个数据块时只读取一次，
+   *          inner_keys 按顺序排列时效果最好。
+   * @param ctxs 第 i 个查询的上下文
+   * @param inner_keys 第 i 个查询的 inner_key
+   * @param keys 第 i 个查询找到的条目的 inner_key
+   * @param values 第 i 个查询找到的条目的值
+   * @param rcs 第 i 个查询的结果，OK 或 NOT_FOUND
+   * @return RC 读取索引块、过滤器块或数据块失败时返回错误，此时 rcs 无效
+   */
+  auto MultiGet(const vector<const LookupContext *> &ctxs, const vector<string_view> &inner_keys, vector<string> &keys,
+                vector<string> &values, vector<RC> &rcs) -> RC;
+  /* 表中是否可能有 user_key 落在 [lower, upper) 内，没有范围过滤器时总是返回 true */
+  auto MayContainRange(string_view lower, string_view upper) -> bool;
+  auto NewIterator(const ReadOptions &read_options = {}) -> Iterator;
+  /* 按 key 的顺序返回每个数据块的最后一个 user_key 和块的大小，只读取索引块，用于估计 key 范围内的数据量 */
+  auto SampleDataBlocks(vector<std::pair<string, uint64_t>> &samples) -> RC;
+
+  auto Level() const -> int { return level_; }
+  auto FileSize() const -> size_t { return file_size_; }
+  /* 过滤器块的大小，没有过滤器时为 0 */
+  auto FilterSize() const -> size_t { return has_filter_ ? filter_handle_.block_size_ : 0; }
+  auto Path() const -> const string & { return path_; }
+  /* 文件名所用的内容哈希，记录在尾信息块中 */
+  auto ContentHash() const -> ContentHashType { return content_hash_; }
+  /* 旧格式的表没有属性块，此时返回 nullptr */
+  auto Properties() const -> const TableProperties * { return has_properties_ ? &properties_ : nullptr; }
+  /**
+   * @brief 设置外部导入的表的全局序列号，见 FileMetaData::global_seq_
+   * @details 必须在打开之后、共享给其他线程之前调用。设置后 Get 和迭代器返回的 key 的序列号都替换为 seq，
+   *          快照早于 seq 的点查看不到表中的数据。
+   */
+  void SetGlobalSequence(int64_t seq) { global_seq_ = seq; }
+  auto GlobalSequence() const -> int64_t { return global_seq_; }
+
+ private:
+  SSTableReader(string_view path, const DBOptions &options, int level, BlockCache *block_cache,
+                FilterStats *filter_stats);
+  auto        Init() -> RC;
+  auto        ReadBlock(const BlockHandle &handle, CachePriority priority, TableBlock &block) -> RC;
+  auto        ReadFromFile(const BlockHandle &handle, TableBlock &block) -> RC;
+  /* 打开时读取并解析索引块和过滤器块 */
+  auto        ReadIndexBlock() -> RC;
+  auto        ReadFilterBlock() -> RC;
+  auto        DataBlock(string_view index_value, std::shared_ptr<BlockReader> &data) -> RC;
+  static auto NewBlockReader(TableBlock &&block, std::shared_ptr<BlockReader> &reader) -> RC;
+  /* 在数据块中查找第一个大于等于 inner_key 且 user_key 相同的条目 */
+  auto SearchDataBlock(BlockReader &data, string_view inner_key, string &key, string &value) -> bool;
+  /* 索引项的值中数据块的序号，即对应的过滤器的下标 */
+  static auto DataBlockNum(string_view index_value) -> int;
+
+  string            path_;
+  const DBOptions  *options_;
+  int               level_;
+  BlockCache       *block_cache_;
+  FilterStats      *filter_stats_;
+  uint64_t          cache_id_{0};  // 块缓存 key 的前缀
+  size_t            file_size_{0};
+  MmapReadAbleFile *mmap_file_{nullptr};
+  RandomAccessFile *random_file_{nullptr};
+  BlockBufferPool   buffer_pool_;
+
+  BlockHandle     index_handle_;
+  BlockHandle     filter_handle_;
+  bool            has_filter_{false};
+  ContentHashType content_hash_{ContentHashType::SHA256};
+  TableProperties properties_;
+  bool            has_properties_{false};
+  int64_t         global_seq_{0};
+  /* 打开时解析的索引块和过滤器块，一直持有；有块缓存时持有块缓存中的块，内存计入块缓存 */
+  std::shared_ptr<BlockReader>       index_block_;
+  std::shared_ptr<FilterBlockReader> filter_block_;  // 表没有过滤器时为空
+  /* 范围过滤器块总是常驻 */
+  string                             range_filter_data_;
+  unique_ptr<RangeFilterBlockReader> range_filter_;
+  std::mutex                         range_filter_mutex_;  // RangeFilterBlockReader 查询时使用内部缓冲区
 };
 
-class SSTableReader : public std::enable_shared_from_this<SSTableReader> {};
+/**
+ * @brief SSTable 的两级迭代器：外层遍历索引块，内层遍历数据块
+ * @details 迭代器持有 SSTableReader，遍历期间表不会被关闭。设置了 iterate_upper_bound_ 时，
+ *          user_key 大于等于上界的条目视为不存在；Seek 时先用范围过滤器判断 [seek key, 上界) 内是否可能有 key。
+ *
+ *          设置了 prefix_seek_ 且 seek key 在前缀提取器的定义域内时，只返回与 seek key 前缀相同的条目：
+ *          表级前缀过滤器排除该前缀时不读取任何数据块；读取每个数据块之前用块的过滤器检查前缀，
+ *          相同前缀的 key 是连续的，一个块中没有该前缀时之后的块也不会有，遍历结束。
+ *          seek key 不在定义域内和 SeekToFirst 时按全序遍历。
+ */
+class SSTableReader::Iterator {
+ public:
+  Iterator(std::shared_ptr<SSTableReader> table, const ReadOptions &read_options);
+
+  auto Valid() const -> bool { return valid_; }
+  void SeekToFirst();
+  /* 定位到第一个大于等于 inner_key 的条目 */
+  void Seek(string_view inner_key);
+  void Next();
+  auto Key() const -> string_view { return table_->global_seq_ > 0 ? string_view(key_) : data_iter_.Key(); }
+  auto Value() const -> string_view { return data_iter_.Value(); }
+  /* 读取或解析块失败时不为 OK，此时 Valid() 为 false */
+  auto Status() const -> RC { return status_; }
+
+ private:
+  void InitDataBlock();
+  void SkipEmptyDataBlocks();
+  /* 超出上界或前缀不同时 valid_ 置为 false */
+  void CheckBounds();
+
+  std::shared_ptr<SSTableReader> table_;
+  string                         upper_bound_;
+  bool                           has_upper_bound_;
+  std::shared_ptr<BlockReader>   index_block_;
+  BlockReader::Iterator          index_iter_;
+  std::shared_ptr<BlockReader>   data_block_;
+  BlockReader::Iterator          data_iter_;
+  string                         key_;  // 有全局序列号时替换了序列号的当前 key
+  bool                           valid_{false};
+  RC                             status_{RC::OK};
+
+  /* 前缀查找 */
+  bool                               prefix_seek_;
+  bool                               prefix_mode_{false};  // 当前的 Seek 是否按前缀遍历
+  string                             prefix_key_;          // seek key 的 user_key
+  string                             prefix_;              // prefix_key_ 的前缀
+  std::shared_ptr<FilterBlockReader> filter_block_;        // 检查前缀的过滤器，表没有过滤器时为空
+};
 }  // namespace lsm_tree
@@ -0,0 +1,58 @@
+/**
+ * @file table_cache.hh
+ * @brief 已打开的 SSTable 的缓存
+ *
+ */
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include "cache.hh"
+#include "return_code.hh"
+
+namespace lsm_tree {
+
+class SSTableReader;
+struct FileMetaData;
+
+/**
+ * @brief 表缓存：缓存打开的 SSTableReader 及其文件描述符
+ * @details 打开一张表需要 open + 读取并解析尾信息块、索引块和过滤器块，每次 Get 都重新打开代价太高。
+ *          表缓存按表 id（DB::TableId，由文件 id 和所在层组成）缓存打开的 SSTableReader，每张表计费 1，
+ *          最多同时打开 max_open_files 张表，超过后按 LRU 关闭最久未使用的表。表在第一次被访问时才打开；
+ *          同一张表的并发打开按表 id 分段加锁，只会打开一次。未命中时用调用方持有的 FileMetaData 打开，
+ *          不需要另外登记每张表的路径。
+ *          FindTable 返回的 Handle 在使用期间保证 reader 不会被关闭，表被淘汰后在最后一个 Handle 释放时关闭。
+ */
+class TableCache {
+ public:
+  using Cache  = ShardedCache<uint64_t, std::shared_ptr<SSTableReader>>;
+  using Handle = Cache::Handle;
+  /* 打开 table_id 对应的 SSTable，file 为该表的元数据 */
+  using TableOpener =
+      std::function<RC(uint64_t table_id, const FileMetaData &file, std::shared_ptr<SSTableReader> &reader)>;
+
+  /* max_open_files 不大于 0 时不限制打开的表的个数 */
+  TableCache(int max_open_files, TableOpener opener);
+
+  auto FindTable(uint64_t table_id, const FileMetaData &file, Handle &handle) -> RC;
+  /* 表文件被删除时调用，正在使用的 reader 在 Handle 释放后关闭 */
+  void Evict(uint64_t table_id);
+  auto OpenedTables() const -> size_t { return cache_.Usage(); }
+  auto Stats() const -> CacheStats { return cache_.Stats(); }
+
+  static constexpr size_t K_UNLIMITED_TABLES = 1UL << 40;
+  static constexpr size_t K_OPEN_LOCKS       = 64;
+
+ private:
+  static auto ShardBits(size_t capacity) -> int;
+
+  Cache                                cache_;
+  TableOpener                          opener_;
+  std::array<std::mutex, K_OPEN_LOCKS> open_mutexes_;  // 按表 id 分段，避免同一张表被并发打开多次
+};
+
+}  // namespace lsm_tree
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <openssl/sha.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace lsm_tree {
+
+/* SSTable 内容哈希的算法，决定文件名，记录在尾信息块中 */
+enum class ContentHashType : uint8_t {
+  SHA256  = 0,  // OpenSSL SHA-256，32 字节
+  HASH128 = 1,  // 基于 Hash64 的 128 位非加密哈希，16 字节，比 SHA-256 快一个数量级以上
+};
+
+/* 各算法中最长的摘要 */
+constexpr size_t K_MAX_CONTENT_DIGEST_LENGTH = SHA256_DIGEST_LENGTH;
+
+auto ContentDigestLength(ContentHashType type) -> size_t;
+
+/**
+ * @brief 流式计算文件内容的哈希
+ * @details HASH128 把输入按文件偏移切分为 K_CHUNK_SIZE 的分块，每个分块用两个不同的种子各计算一次 Hash64，
+ *          与前面分块的结果链式混合，最后混入总长度。分块只与偏移有关，结果不依赖 Update 的调用方式，
+ *          完整的分块直接在输入上计算，只有跨越 Update 边界的分块需要拷贝。
+ *          HASH128 不抗碰撞攻击，只用于命名本进程生成的文件，不能用于校验不可信的输入。
+ */
+class ContentHasher {
+ public:
+  explicit ContentHasher(ContentHashType type = ContentHashType::SHA256);
+
+  void Update(std::string_view data);
+  /* digest 至少 ContentDigestLength(Type()) 字节；之后不能再 Update */
+  void Final(unsigned char *digest);
+  auto Type() const -> ContentHashType { return type_; }
+
+  static constexpr size_t K_CHUNK_SIZE = 64 << 10;
+
+ private:
+  void HashChunk(const char *data, size_t len);
+
+  ContentHashType type_;
+  SHA256_CTX      sha256_;
+  uint64_t        lo_{0};
+  uint64_t        hi_{0};
+  uint64_t        length_{0};
+  std::string     pending_;  // 未满一个分块的输入
+};
+
+}  // namespace lsm_tree
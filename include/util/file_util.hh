@@ -10,6 +10,7 @@
 #include <vector>
 #include "memtable/keys.hh"
 #include "return_code.hh"
+#include "util/content_hash.hh"
 
 namespace lsm_tree {
 
@@ -41,6 +42,8 @@ class FileManager {
   static auto FixFileName(string_view path) -> string;
   static auto GetFileSize(string_view path, size_t &size) -> RC;
   static auto ReName(string_view old_path, string_view new_path) -> RC;
+  /* 创建硬链接，两个路径必须在同一个文件系统中 */
+  static auto Link(string_view old_path, string_view new_path) -> RC;
   static auto HandleHomeDir(string_view path) -> string;
   /* open */
   static auto OpenWritAbleFile(string_view filename, std::unique_ptr<WritAbleFile> &result) -> RC;
@@ -150,18 +153,29 @@ class RandomAccessFile {
 struct FileMetaData {
   FileMetaData() = default;
 
-  size_t        file_size_{};
-  int           num_keys_{};
-  int           belong_to_level_{};
-  int64_t       max_seq_{};
-  MemKey        max_inner_key_;
-  MemKey        min_inner_key_;
-  unsigned char sha256_[SHA256_DIGEST_LENGTH];
+  size_t          file_size_{};
+  size_t          filter_size_{};  // 过滤器块的大小，用于统计各层过滤器的内存，见 FilterStats
+  int             num_keys_{};
+  int             belong_to_level_{};
+  int64_t         max_seq_{};
+  MemKey          max_inner_key_;
+  MemKey          min_inner_key_;
+  /* 内容哈希，有效长度为 ContentDigestLength(content_hash_)，文件名为其 16 进制形式 */
+  unsigned char   sha256_[K_MAX_CONTENT_DIGEST_LENGTH];
+  ContentHashType content_hash_{ContentHashType::SHA256};
+  /* 外部导入的表中 key 的序列号都为 0，读取时按 global_seq_ 处理；0 表示使用 key 自身的序列号 */
+  int64_t         global_seq_{};
 
   /* 获取在 db 中的 file 路径 */
   auto GetSSTablePath(string_view dbname) -> string;
   auto GetOid() const -> string;
+  /* 内容哈希的前 8 字节，作为表缓存等内存结构中文件的 id */
+  auto FileId() const -> uint64_t;
   auto operator<(const FileMetaData &f) -> bool { return min_inner_key_ < f.min_inner_key_; }
+  /* 编码到 revision 文件中，不包括 belong_to_level_ */
+  void EncodeTo(string &dst) const;
+  /* 从 src 的开头解码，成功后 src 跳过已解码的部分 */
+  auto DecodeFrom(string_view &src) -> RC;
 };
 
 auto operator<<(ostream &os, const FileMetaData &meta) -> ostream &;
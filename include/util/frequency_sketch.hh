@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace lsm_tree {
+
+/**
+ * @brief TinyLFU 使用的访问频率估计（count-min sketch）
+ * @details 每个 key 对应 4 个 4 bit 计数器，估计值取其中的最小值，最大为 15。
+ *          累计增加次数达到预计条目数的 10 倍时所有计数器减半（老化），使估计值反映最近一段时间的访问频率。
+ *          计数器以原子操作更新，可以在持有共享锁的多个线程中同时调用 Increment。
+ */
+class FrequencySketch {
+ public:
+  /* expected_entries 为缓存中预计的条目数，决定计数器的个数 */
+  explicit FrequencySketch(size_t expected_entries);
+
+  void Increment(uint64_t hash);
+  auto Estimate(uint64_t hash) const -> int;
+
+  static constexpr int K_MAX_FREQ = 15;
+
+ private:
+  auto CounterIndex(uint64_t hash, int row) const -> size_t;
+  void Age();
+
+  size_t                                   counters_mask_;  // 计数器个数 - 1，计数器个数为 2 的幂
+  size_t                                   sample_size_;    // 增加次数达到该值时老化
+  std::atomic<size_t>                      additions_{0};
+  std::unique_ptr<std::atomic<uint64_t>[]> table_;  // 每个 uint64_t 保存 16 个计数器
+};
+
+}  // namespace lsm_tree
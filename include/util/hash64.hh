@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace lsm_tree {
+
+/* XXH3 风格的 64 位哈希：按 8 字节读取输入，使用 64x64->128 乘法折叠混合 */
+auto Hash64(const char *data, size_t len, uint64_t seed = 0) -> uint64_t;
+
+inline auto Hash64(std::string_view data, uint64_t seed = 0) -> uint64_t { return Hash64(data.data(), data.size(), seed); }
+
+}  // namespace lsm_tree
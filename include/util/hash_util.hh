@@ -10,6 +10,10 @@ using std::string;
 using std::string_view;
 
 auto HexStringToInt(const std::string_view &input) -> std::optional<int>;
+/* 查表把每个字节转换为两个小写 16 进制字符 */
+auto DigestToHex(const unsigned char *digest, size_t len) -> string;
+/* hex 的长度必须是偶数，digest 至少 hex.size() / 2 字节；含有非 16 进制字符时返回 false */
+auto HexToDigest(string_view hex, unsigned char *digest) -> bool;
 auto Sha256DigitToHex(const unsigned char hash[SHA256_DIGEST_LENGTH]) -> string;
 void HexToSha256Digit(string_view hex, unsigned char *hash);
 }  // namespace lsm_tree
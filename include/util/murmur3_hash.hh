@@ -7,4 +7,7 @@ namespace lsm_tree {
 
 auto Murmur3Hash(uint32_t seed, const char *data, size_t len) -> uint32_t;
 
+/* 旧版实现：逐字节按有符号 char 拼接输入，结果与标准 Murmur3 不同，仅用于读取旧格式的过滤器 */
+auto LegacyMurmur3Hash(uint32_t seed, const char *data, size_t len) -> uint32_t;
+
 }  // namespace lsm_tree
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "return_code.hh"
+
+namespace lsm_tree {
+
+using std::string;
+using std::string_view;
+
+/**
+ * @brief 前缀提取器，从 user_key 中提取出用于前缀过滤和前缀查找的前缀
+ * @details 过滤器块会记录构建时使用的提取器名称，读取时只有名称一致才会使用前缀过滤。
+ */
+class PrefixExtractor {
+ public:
+  /* 提取器名称，会被写入过滤器块 */
+  virtual auto Name() const -> string = 0;
+  /* key 是否能被提取前缀 */
+  virtual auto InDomain(string_view key) const -> bool = 0;
+  /* 提取前缀，调用前需要保证 InDomain(key) */
+  virtual auto Transform(string_view key) const -> string_view = 0;
+  virtual ~PrefixExtractor() = default;
+};
+
+/* 取固定长度前缀，长度不足的 key 不在定义域内 */
+class FixedPrefixExtractor : public PrefixExtractor {
+ public:
+  explicit FixedPrefixExtractor(size_t prefix_len) : prefix_len_(prefix_len) {}
+  auto Name() const -> string override;
+  auto InDomain(string_view key) const -> bool override { return key.size() >= prefix_len_; }
+  auto Transform(string_view key) const -> string_view override { return key.substr(0, prefix_len_); }
+
+ private:
+  size_t prefix_len_;
+};
+
+/* 取最多 prefix_len 个字节作为前缀，所有 key 都在定义域内 */
+class CappedPrefixExtractor : public PrefixExtractor {
+ public:
+  explicit CappedPrefixExtractor(size_t prefix_len) : prefix_len_(prefix_len) {}
+  auto Name() const -> string override;
+  auto InDomain(string_view key) const -> bool override { return true; }
+  auto Transform(string_view key) const -> string_view override { return key.substr(0, prefix_len_); }
+
+ private:
+  size_t prefix_len_;
+};
+
+auto NewFixedPrefixExtractor(size_t prefix_len) -> std::shared_ptr<const PrefixExtractor>;
+auto NewCappedPrefixExtractor(size_t prefix_len) -> std::shared_ptr<const PrefixExtractor>;
+
+}  // namespace lsm_tree
@@ -0,0 +1,112 @@
+/**
+ * @file version.hh
+ * @brief 各层的 SSTable 集合及其持久化
+ *
+ */
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "options.hh"
+#include "return_code.hh"
+#include "util/file_util.hh"
+
+namespace lsm_tree {
+
+constexpr int K_NUM_LEVELS = 7;
+
+/**
+ * @brief 某一时刻各层的 SSTable，创建后不再修改
+ * @details L0 的文件之间 key 范围可以重叠，按 max_seq_ 从新到旧排列，查找时依次查每个文件；
+ *          L1 及以下每层的文件按最小 key 排列，互不重叠。读操作持有 Version 的 shared_ptr，期间文件不会被删除。
+ */
+class Version {
+ public:
+  using FileRef = std::shared_ptr<FileMetaData>;
+
+  auto Files(int level) const -> const vector<FileRef> & { return files_[level]; }
+  auto NumFiles(int level) const -> int { return static_cast<int>(files_[level].size()); }
+  auto LevelBytes(int level) const -> size_t;
+  auto LevelKeys(int level) const -> uint64_t;
+  /* 在 level 生成 added_keys 个 key 的 SSTable 时过滤器的 bits_per_key：
+     optimize_filters_for_levels_ 时按各层当前的 key 数加上新加入的 key 分配 */
+  auto FilterBitsPerKey(const DBOptions &options, int level, uint64_t added_keys) const -> int;
+  /* level 中 user_key 范围与 [smallest, largest] 相交的文件，L1 及以下按 key 的顺序返回 */
+  void GetOverlappingFiles(int level, string_view smallest, string_view largest, vector<FileRef> &files) const;
+  auto OverlapInLevel(int level, string_view smallest, string_view largest) const -> bool;
+
+ private:
+  friend class VersionSet;
+
+  std::array<vector<FileRef>, K_NUM_LEVELS> files_;
+};
+
+/* 对 Version 的一次修改：flush、compaction 和外部文件导入都通过 VersionEdit 生效 */
+struct VersionEdit {
+  vector<std::pair<int, FileMetaData>> added_files_;        // 层号，文件
+  vector<std::pair<int, string>>       deleted_files_;      // 层号，文件的 oid
+  int64_t                              last_sequence_{-1};  // 小于 0 表示不修改
+
+  void AddFile(int level, const FileMetaData &meta) { added_files_.emplace_back(level, meta); }
+  void DeleteFile(int level, string_view oid) { deleted_files_.emplace_back(level, string(oid)); }
+  void SetLastSequence(int64_t seq) { last_sequence_ = seq; }
+};
+
+/**
+ * @brief 管理当前 Version 及其持久化
+ * @details 持久化的结构与 sst 文件一样按内容寻址：
+ *          level/<n>/<hash>.lvl —— 第 n 层所有文件的 FileMetaData；
+ *          rev/<hash>.rev       —— 最大序列号和每一层的 lvl 文件的哈希；
+ *          CURRENT              —— 当前 rev 文件的哈希。
+ *          LogAndApply 只重写内容变化的层，新文件都先写入临时文件再重命名，最后替换 CURRENT，
+ *          CURRENT 替换之前崩溃时恢复到旧的 Version。替换后删除旧的 rev 文件和不再使用的 lvl 文件，
+ *          不再使用的 sst 文件由调用方处理。
+ */
+class VersionSet {
+ public:
+  VersionSet(string_view dbname, const DBOptions &options);
+
+  /* 从 CURRENT 恢复，没有 CURRENT 时为空的 Version；不存在的目录会被创建 */
+  auto Recover() -> RC;
+  auto Current() const -> std::shared_ptr<const Version>;
+  auto LogAndApply(const VersionEdit &edit) -> RC;
+  /**
+   * @brief 在同一把锁内根据当前 Version 生成 edit 并应用
+   * @details 生成 edit 依赖当前各层的文件时（如导入外部文件时选择层），保证生成和应用之间 Version 不会被修改。
+   *          make_edit 返回错误时不应用。
+   */
+  auto LogAndApply(const std::function<RC(const Version &, VersionEdit &)> &make_edit) -> RC;
+  auto LastSequence() const -> int64_t { return last_sequence_.load(std::memory_order_acquire); }
+  void SetLastSequence(int64_t seq) { last_sequence_.store(seq, std::memory_order_release); }
+
+ private:
+  using Digest = std::array<unsigned char, SHA256_DIGEST_LENGTH>;
+
+  auto Apply(const Version &base, const VersionEdit &edit, Version &version) const -> RC;
+  auto Persist(const Version &version, int64_t last_sequence) -> RC;
+  auto LoadLevel(int level, const Digest &digest, vector<Version::FileRef> &files) const -> RC;
+  /* 写入临时文件后重命名为 dir 下以内容的 SHA-256 命名的文件，同名文件已经存在时不重写 */
+  auto WriteContentFile(string_view dir, string_view content, Digest &digest,
+                        const std::function<string(string_view, string_view)> &file_name) const -> RC;
+
+  const string     dbname_;
+  const DBOptions &options_;
+
+  std::mutex                       apply_mutex_;  // 串行化 LogAndApply
+  mutable std::mutex               mutex_;        // 保护 current_
+  std::shared_ptr<const Version>   current_;
+  std::atomic<int64_t>             last_sequence_{0};
+  bool                             has_revision_{false};
+  Digest                           revision_{};
+  std::array<Digest, K_NUM_LEVELS> level_digests_{};
+};
+
+}  // namespace lsm_tree
@@ -6,6 +6,7 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
 
 namespace lsm_tree {
 
@@ -22,18 +23,18 @@ class Worker {
   Worker(const Worker &)                     = delete;
   auto operator=(const Worker &) -> Worker & = delete;
 
-  inline void Stop();
-  inline void Add(std::function<void()> &&function) noexcept;
-  inline void Run();
-  inline void Join();
-  inline void operator()();
+  void Stop();
+  void Add(std::function<void()> &&function) noexcept;
+  void Run();
+  void Join();
+  void operator()();
 
   static auto NewBackgroundWorker() -> std::shared_ptr<Worker>;
 
  private:
   mutex                   work_queue_mutex_;
   bool                    closed_;
-  std::thread            *thread_;  // 线程中运行worker->Run()
+  std::thread            *thread_{nullptr};  // 线程中运行worker->Run()
   queue<function<void()>> work_queue_;
   condition_variable      work_queue_cond_;
 };
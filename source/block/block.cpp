@@ -1,5 +1,6 @@
 #include "block/block.hh"
 #include <sys/types.h>
+#include <algorithm>
 #include <cstdint>
 #include "util/encode.hh"
 #include "util/monitor_logger.hh"
@@ -120,6 +121,44 @@ auto BlockReader::Init(
   return RC::OK;
 }
 
+auto BlockReader::Begin() -> Iterator { return Iterator(shared_from_this(), 0); }
+
+auto BlockReader::End() -> Iterator { return Iterator(shared_from_this(), restarts_.size()); }
+
+/**
+ * @brief 查找第一个大于等于 want_key 的条目，交给 Init 时传入的 handle_result 处理
+ *
+ * @param want_key 需要查找的键
+ * @param key 输出，handle_result 保存的键
+ * @param value 输出，handle_result 保存的值
+ * @return RC handle_result 的返回值，没有大于等于 want_key 的条目时返回 NOT_FOUND
+ */
+auto BlockReader::Get(std::string_view want_key, std::string &key, std::string &value) -> RC {
+  return GetInternal(want_key,
+                     [&](string_view rk, string_view rv) { return handle_result_fn_(rk, rv, want_key, key, value); });
+}
+
+/**
+ * @brief 从恰好小于等于 key 的重启点开始向后扫描，返回的迭代器已经解码了当前条目
+ *
+ * @param key 需要定位的键
+ * @return Iterator 第一个大于等于 key 的条目，不存在时返回 End()
+ */
+auto BlockReader::Seek(string_view key) -> Iterator {
+  int index = 0;
+  if (BsearchRestartPoint(key, &index) != RC::OK) {
+    return End();
+  }
+  Iterator iter(shared_from_this(), std::max(index, 0));
+  for (; iter; ++iter) {
+    iter.Fetch();
+    if (cmp_fn_(iter.Key(), key) >= 0) {
+      return iter;
+    }
+  }
+  return iter;
+}
+
 /**
  * @brief 在重启点数组中找到恰好小于等于给定键的重启点索引
  *
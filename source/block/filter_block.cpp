@@ -1,4 +1,5 @@
 #include "block/filter_block.hh"
+#include <algorithm>
 #include <cstdint>
 #include "util/encode.hh"
 #include "util/monitor_logger.hh"
@@ -6,6 +7,40 @@
 
 namespace lsm_tree {
 
+/*
+**********************************************************************************************************************************************
+* LookupContext
+**********************************************************************************************************************************************
+*/
+
+/**
+ * @brief Construct a new Lookup Context:: Lookup Context object
+ *
+ * @param user_key 查询的 user_key
+ * @param prefix_extractor 前缀提取器，为空时不计算前缀哈希
+ */
+LookupContext::LookupContext(string_view user_key, const PrefixExtractor *prefix_extractor)
+    : key_(user_key), prefix_extractor_(prefix_extractor) {
+  if (prefix_extractor_ != nullptr && prefix_extractor_->InDomain(user_key)) {
+    prefix_     = FilterKey(prefix_extractor_->Transform(user_key));
+    has_prefix_ = true;
+  }
+}
+
+/*
+**********************************************************************************************************************************************
+* FilterAlgorithm
+**********************************************************************************************************************************************
+*/
+
+void FilterAlgorithm::MayContainBatch(const vector<FilterKey> &keys, const vector<string_view> &bitmaps,
+                                      vector<bool> &results) {
+  results.resize(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    results[i] = MayContain(keys[i], bitmaps[i]);
+  }
+}
+
 /*
 **********************************************************************************************************************************************
 * BloomFilter
@@ -16,8 +51,9 @@ namespace lsm_tree {
  * @brief Construct a new Bloom Filter:: Bloom Filter object
  *
  * @param bits_per_key
+ * @param version 过滤器格式版本，新建的过滤器总是使用最新版本
  */
-BloomFilter::BloomFilter(int bits_per_key) : bits_per_key_(bits_per_key) {
+BloomFilter::BloomFilter(int bits_per_key, int version) : bits_per_key_(bits_per_key), version_(version) {
   k_ = static_cast<int>(bits_per_key * 0.69);  // 0.69 =~ ln(2)
   if (k_ < 1) {
     k_ = 1;
@@ -27,6 +63,21 @@ BloomFilter::BloomFilter(int bits_per_key) : bits_per_key_(bits_per_key) {
   }
 }
 
+/**
+ * @brief 计算双哈希所需的两个哈希值
+ * @details 第一版对 key 计算两次 Murmur3，第二版计算一次 64 位哈希并拆成高低 32 位
+ */
+void BloomFilter::HashPair(string_view key, uint32_t *h1, uint32_t *h2) {
+  if (version_ == K_MURMUR3_VERSION) {
+    *h1 = LegacyMurmur3Hash(0xe2c6928a, key.data(), key.size());
+    *h2 = LegacyMurmur3Hash(0xbaea8a8f, key.data(), key.size());
+    return;
+  }
+  uint64_t h = Hash64(key);
+  *h1        = static_cast<uint32_t>(h);
+  *h2        = static_cast<uint32_t>(h >> 32);
+}
+
 /**
  * @brief 将键集合转换为布隆过滤器的位图表示
  * @details 位图表示的格式如下：
@@ -36,17 +87,19 @@ BloomFilter::BloomFilter(int bits_per_key) : bits_per_key_(bits_per_key) {
  * @return RC 返回操作的状态码
  */
 auto BloomFilter::Keys2Block(const vector<string> &keys, string &result) -> RC {
+  /* 读取时按字节数推算位数，所以位数向上取整到整字节 */
   auto     keys_len        = static_cast<uint32_t>(keys.size());
-  uint32_t bitmap_bits_len = (keys_len * bits_per_key_ + 7) * 8;  // bitmap 长度（bits）
-  uint32_t bitmap_len      = bitmap_bits_len / 8;                 // bitmap 长度（bytes）
+  uint32_t bitmap_len      = (std::max(keys_len * bits_per_key_, K_MIN_BITMAP_BITS) + 7) / 8;  // bitmap 长度（bytes）
+  uint32_t bitmap_bits_len = bitmap_len * 8;                                                   // bitmap 长度（bits）
   auto     init_len        = static_cast<uint32_t>(result.size());
 
   result.resize(init_len + bitmap_len);  // 开辟 bitmap 空间
   auto bitmap = &result[init_len];
   for (const auto &key : keys) {
     /* 双哈希模拟多哈希 （ leveldb 单哈希模拟多哈希）*/
-    auto h1 = Murmur3Hash(0xe2c6928a, key.data(), key.size());
-    auto h2 = Murmur3Hash(0xbaea8a8f, key.data(), key.size());
+    uint32_t h1;
+    uint32_t h2;
+    HashPair(key, &h1, &h2);
     for (int j = 0; j < k_; j++) {
       int bit_pos = static_cast<int>((h1 + j * h2) % bitmap_bits_len);
       bitmap[bit_pos / 8] |= (1 << (bit_pos % 8));
@@ -64,10 +117,64 @@ auto BloomFilter::Keys2Block(const vector<string> &keys, string &result) -> RC {
  * @return false 键不存在于布隆过滤器中
  */
 auto BloomFilter::IsKeyExists(string_view key, string_view bitmap) -> bool {
-  auto bitmap_bits_len = static_cast<uint32_t>(bitmap.size()) * 8;
+  uint32_t h1;
+  uint32_t h2;
+  HashPair(key, &h1, &h2);
+  return MayContain(h1, h2, bitmap);
+}
 
-  auto h1 = Murmur3Hash(0xe2c6928a, key.data(), key.size());
-  auto h2 = Murmur3Hash(0xbaea8a8f, key.data(), key.size());
+/**
+ * @brief 使用查询开始时计算好的哈希检查键是否存在，第一版过滤器的哈希不同，只能重新计算
+ *
+ * @param key 带有哈希的查询键
+ * @param bitmap 布隆过滤器的位图表示
+ * @return true 键存可能在于布隆过滤器中
+ * @return false 键不存在于布隆过滤器中
+ */
+auto BloomFilter::MayContain(const FilterKey &key, string_view bitmap) -> bool {
+  if (version_ == K_MURMUR3_VERSION) {
+    return IsKeyExists(key.Key(), bitmap);
+  }
+  return MayContain(static_cast<uint32_t>(key.Hash()), static_cast<uint32_t>(key.Hash() >> 32), bitmap);
+}
+
+/**
+ * @brief 批量检查多个键
+ * @details 先为所有键的第一个探测位置发出预取，再逐个检查。单个探测几乎总是缓存未命中，
+ *          逐个检查时每次未命中都会阻塞，批量预取可以让这些未命中并行等待。
+ *          不存在的键大多在前一两次探测就被排除，只预取第一个位置，避免为后续探测浪费带宽。
+ * @param keys 带有哈希的查询键
+ * @param bitmaps keys[i] 对应的位图
+ * @param results 输出，results[i] 表示 keys[i] 是否可能存在
+ */
+void BloomFilter::MayContainBatch(const vector<FilterKey> &keys, const vector<string_view> &bitmaps,
+                                  vector<bool> &results) {
+  if (version_ == K_MURMUR3_VERSION) {
+    FilterAlgorithm::MayContainBatch(keys, bitmaps, results);
+    return;
+  }
+  results.resize(keys.size());
+  /* 1. 预取第一个探测位置所在的缓存行 */
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto bitmap_bits_len = static_cast<uint32_t>(bitmaps[i].size()) * 8;
+    if (bitmap_bits_len == 0) {
+      continue;
+    }
+    uint32_t bit_pos = static_cast<uint32_t>(keys[i].Hash()) % bitmap_bits_len;
+    __builtin_prefetch(bitmaps[i].data() + bit_pos / 8);
+  }
+  /* 2. 逐个检查 */
+  for (size_t i = 0; i < keys.size(); i++) {
+    results[i] = MayContain(static_cast<uint32_t>(keys[i].Hash()), static_cast<uint32_t>(keys[i].Hash() >> 32),
+                            bitmaps[i]);
+  }
+}
+
+auto BloomFilter::MayContain(uint32_t h1, uint32_t h2, string_view bitmap) -> bool {
+  auto bitmap_bits_len = static_cast<uint32_t>(bitmap.size()) * 8;
+  if (bitmap_bits_len == 0) {
+    return false;
+  }
   for (int j = 0; j < k_; j++) {
     int bit_pos = static_cast<int>((h1 + j * h2) % bitmap_bits_len);
     if ((bitmap[bit_pos / 8] & (1 << (bit_pos % 8))) == 0) {
@@ -77,8 +184,9 @@ auto BloomFilter::IsKeyExists(string_view key, string_view bitmap) -> bool {
   return true;
 }
 
+/* 第一版为 "bf:"，第二版为 "b2:"，之后都是 bits_per_key */
 void BloomFilter::FilterInfo(string &info) {
-  info.append("bf:");
+  info.append(version_ == K_MURMUR3_VERSION ? "bf:" : "b2:");
   info.append(reinterpret_cast<char *>(&bits_per_key_), sizeof(int));
 }
 
@@ -91,21 +199,49 @@ void BloomFilter::FilterInfo(string &info) {
 /**
  * @brief Construct a new Filter Block Writer:: Filter Block Writer object
  *
- * @param method
+ * @param method 过滤器算法
+ * @param prefix_extractor 前缀提取器，为空时只索引完整的 key
+ * @param whole_key_filtering 是否索引完整的 key
  */
-FilterBlockWriter::FilterBlockWriter(unique_ptr<FilterAlgorithm> &&method) : method_(std::move(method)) {}
+FilterBlockWriter::FilterBlockWriter(unique_ptr<FilterAlgorithm>            &&method,
+                                     std::shared_ptr<const PrefixExtractor> prefix_extractor,
+                                     bool                                   whole_key_filtering)
+    : method_(std::move(method)),
+      prefix_extractor_(std::move(prefix_extractor)),
+      whole_key_filtering_(whole_key_filtering) {}
 
 /**
  * @brief 更新过滤器块，添加新的键
- *
+ * @details 配置了前缀提取器时同时加入 key 的前缀，key 是有序的，所以相邻 key 的相同前缀只需要加入一次
  * @param key 要添加的键
  * @return RC 操作结果代码
  */
 auto FilterBlockWriter::Update(string_view key) -> RC {
-  keys_.emplace_back(key);
+  pending_ = true;
+  if (whole_key_filtering_) {
+    keys_.emplace_back(key);
+  }
+  if (prefix_extractor_) {
+    AddPrefix(key);
+  }
   return RC::OK;
 }
 
+void FilterBlockWriter::AddPrefix(string_view key) {
+  if (!prefix_extractor_->InDomain(key)) {
+    return;
+  }
+  string_view prefix = prefix_extractor_->Transform(key);
+  if (!has_last_prefix_ || prefix != last_prefix_) {
+    keys_.emplace_back(prefix);
+    last_prefix_     = prefix;
+    has_last_prefix_ = true;
+  }
+  if (table_prefixes_.empty() || table_prefixes_.back() != prefix) {
+    table_prefixes_.emplace_back(prefix);
+  }
+}
+
 /**
  * @brief 将当前存储的键转换为过滤器块
  *
@@ -115,6 +251,8 @@ auto FilterBlockWriter::Keys2Block() -> RC {
   offsets_.push_back(static_cast<int>(buffer_.size()));
   method_->Keys2Block(keys_, buffer_);
   keys_.clear();
+  has_last_prefix_ = false;
+  pending_         = false;
   return RC::OK;
 }
 
@@ -122,13 +260,20 @@ auto FilterBlockWriter::Keys2Block() -> RC {
  * @brief 生成最终的过滤器块并返回结果
  * @details 生成的过滤器块的格式如下：
  * | bitmap | offsets | offset_begin_offset | offsets_len | filter_info | filter_info_len |
+ * 配置了前缀提取器时，最后一个 bitmap 是表级前缀过滤器
  * @param result 最终位图结果字符串
  * @return RC 操作结果代码
  */
 auto FilterBlockWriter::Final(string &result) -> RC {
-  if (!keys_.empty()) {
+  if (pending_) {
     Keys2Block();
   }
+  /* 表级前缀过滤器 */
+  if (prefix_extractor_) {
+    offsets_.push_back(static_cast<int>(buffer_.size()));
+    method_->Keys2Block(table_prefixes_, buffer_);
+    table_prefixes_.clear();
+  }
 
   int offset_begin_offset = static_cast<int>(buffer_.size());
   int offset_len          = static_cast<int>(offsets_.size());
@@ -144,6 +289,20 @@ auto FilterBlockWriter::Final(string &result) -> RC {
   /* 追加 filter 算法相关信息及其长度, 比如我们在 bloom filter 选择的 bits_per_key  */
   string filter_info;
   method_->FilterInfo(filter_info);
+  /* 追加前缀信息，没有配置前缀过滤时保持原有格式 */
+  if (prefix_extractor_ || !whole_key_filtering_) {
+    char flags = 0;
+    if (whole_key_filtering_) {
+      flags |= K_WHOLE_KEY_FILTERING;
+    }
+    if (prefix_extractor_) {
+      flags |= K_TABLE_PREFIX_FILTER;
+      filter_info.push_back(flags);
+      filter_info.append(prefix_extractor_->Name());
+    } else {
+      filter_info.push_back(flags);
+    }
+  }
   int filter_info_len = static_cast<int>(filter_info.length());
   if (filter_info_len != 0) {
     buffer_.append(filter_info);
@@ -163,16 +322,17 @@ auto FilterBlockWriter::Final(string &result) -> RC {
  * @brief Construct a new Filter Block Reader:: Filter Block Reader object
  *
  */
-FilterBlockReader::FilterBlockReader() : filters_nums_(0) {}
+FilterBlockReader::FilterBlockReader() : filters_nums_(0), data_filters_nums_(0) {}
 
 /**
  * @brief  初始化过滤器块
  * @details 生成的过滤器块的格式如下：
  * | bitmap | offsets | offset_begin_offset | offsets_len | filter_info | filter_info_len |
  * @param filter_blocks
+ * @param prefix_extractor 当前使用的前缀提取器，与构建时的提取器一致才会启用前缀过滤
  * @return RC
  */
-auto FilterBlockReader::Init(string_view filter_blocks) -> RC {
+auto FilterBlockReader::Init(string_view filter_blocks, const PrefixExtractor *prefix_extractor) -> RC {
   filter_blocks_        = filter_blocks;
   auto filter_block_len = filter_blocks_.length();
   /* 1. GET INFO_LEN */
@@ -215,7 +375,14 @@ auto FilterBlockReader::Init(string_view filter_blocks) -> RC {
   if (filters_zero_offset != 0) {
     return RC::FILTER_BLOCK_ERROR;
   }
-  filters_offsets_ = {&filter_blocks_[filters_offsets_offset_], sizeof(int) * filters_nums_};
+  filters_offsets_   = {&filter_blocks_[filters_offsets_offset_], sizeof(int) * filters_nums_};
+  data_filters_nums_ = has_table_prefix_filter_ ? filters_nums_ - 1 : filters_nums_;
+  if (data_filters_nums_ < 0) {
+    return RC::FILTER_BLOCK_ERROR;
+  }
+  if (prefix_extractor != nullptr && prefix_extractor->Name() == prefix_extractor_name_) {
+    prefix_extractor_ = prefix_extractor;
+  }
   MLog->info(
       "FilterBlockReader filter_block_len:{}, filters_nums_:{}, "
       "filters_offsets_offset_:{}, filters_zero_offset:{}",
@@ -224,40 +391,165 @@ auto FilterBlockReader::Init(string_view filter_blocks) -> RC {
   return RC::OK;
 }
 
-/* 目前只有 bf: */
+/* 目前只有 bf: 和 b2: 两个版本的布隆过滤器，算法信息之后是可选的前缀信息 */
 auto FilterBlockReader::CreateFilterAlgorithm() -> RC {
-  static const char *k_bloom_filter = "bf";
-  string_view        type           = filter_info_.substr(0, 2);
-  if (type != k_bloom_filter) {
+  static const char   *k_bloom_filter_v1       = "bf";
+  static const char   *k_bloom_filter_v2       = "b2";
+  static constexpr int k_bloom_filter_info_len = 3 + sizeof(int);
+  string_view          type                    = filter_info_.substr(0, 2);
+  int                  version;
+  if (type == k_bloom_filter_v1) {
+    version = BloomFilter::K_MURMUR3_VERSION;
+  } else if (type == k_bloom_filter_v2) {
+    version = BloomFilter::K_HASH64_VERSION;
+  } else {
+    return RC::FILTER_BLOCK_ERROR;
+  }
+  if (filter_info_.length() < k_bloom_filter_info_len) {
     return RC::FILTER_BLOCK_ERROR;
   }
   int bits_per_key = 0;
   Decode32(&filter_info_[3], &bits_per_key);
-  MLog->info("FilterBlockReader Use BloomFilter algorithm, bits_per_key:{}", bits_per_key);
-  method_ = std::make_unique<BloomFilter>(bits_per_key);
+  MLog->info("FilterBlockReader Use BloomFilter algorithm, version:{}, bits_per_key:{}", version, bits_per_key);
+  method_ = std::make_unique<BloomFilter>(bits_per_key, version);
+
+  if (filter_info_.length() > k_bloom_filter_info_len) {
+    char flags               = filter_info_[k_bloom_filter_info_len];
+    whole_key_filtering_     = (flags & FilterBlockWriter::K_WHOLE_KEY_FILTERING) != 0;
+    has_table_prefix_filter_ = (flags & FilterBlockWriter::K_TABLE_PREFIX_FILTER) != 0;
+    prefix_extractor_name_   = filter_info_.substr(k_bloom_filter_info_len + 1);
+  }
   return RC::OK;
 }
 
 /**
  * @brief 检查给定的键是否存在于指定的过滤块中
- *
+ * @details 构建时没有索引完整 key 的过滤器只能通过前缀判断
  * @param filter_block_num 要检查的过滤块的编号
  * @param key 要检查的键
  * @return true 键存在于过滤块中
  * @return false 键不存在于过滤块中
  */
 auto FilterBlockReader::IsKeyExists(int filter_block_num, string_view key) -> bool {
-  int filter_offset1;
-  int filter_offset2;
-  if (filter_block_num >= filters_nums_) {
+  return IsKeyExists(filter_block_num, LookupContext(key, prefix_extractor_));
+}
+
+/**
+ * @brief 使用点查上下文中预先计算的哈希检查键是否存在于指定的过滤块中
+ *
+ * @param filter_block_num 要检查的过滤块的编号
+ * @param ctx 点查上下文
+ * @return true 键可能存在于过滤块中
+ * @return false 键不存在于过滤块中
+ */
+auto FilterBlockReader::IsKeyExists(int filter_block_num, const LookupContext &ctx) -> bool {
+  if (filter_block_num >= data_filters_nums_) {
     return false;
   }
-  Decode32(&filters_offsets_[filter_block_num * sizeof(int)], &filter_offset1);
-  if (filter_block_num + 1 == filters_nums_) {
+  const FilterKey *probe_key = ProbeKey(ctx);
+  if (probe_key == nullptr) {
+    return true;
+  }
+  return MayMatch(filter_block_num, *probe_key);
+}
+
+/**
+ * @brief 选出用于探测过滤器的键
+ * @details 构建时索引了完整 key 则使用完整 key，否则只有与构建时相同的提取器算出的前缀才能使用
+ * @param ctx 点查上下文
+ * @return const FilterKey* 用于探测的键，过滤器无法判断时返回 nullptr
+ */
+auto FilterBlockReader::ProbeKey(const LookupContext &ctx) const -> const FilterKey * {
+  if (whole_key_filtering_) {
+    return &ctx.key_;
+  }
+  if (prefix_extractor_ != nullptr && ctx.has_prefix_ && ctx.prefix_extractor_ == prefix_extractor_) {
+    return &ctx.prefix_;
+  }
+  return nullptr;
+}
+
+/**
+ * @brief 批量检查多个键是否存在，用于 MultiGet
+ * @details 能够由过滤器判断的键交给过滤器算法批量探测，其余的键直接认为可能存在
+ * @param filter_block_nums ctxs[i] 所在的过滤块编号
+ * @param ctxs 点查上下文
+ * @param results 输出，results[i] 表示 ctxs[i] 的键是否可能存在
+ */
+void FilterBlockReader::IsKeysExist(const vector<int> &filter_block_nums, const vector<const LookupContext *> &ctxs,
+                                    vector<bool> &results) {
+  vector<FilterKey>   probe_keys;
+  vector<string_view> probe_bitmaps;
+  vector<size_t>      probe_idx;
+  vector<bool>        probe_results;
+
+  results.assign(ctxs.size(), true);
+  for (size_t i = 0; i < ctxs.size(); i++) {
+    int filter_block_num = filter_block_nums[i];
+    if (filter_block_num >= data_filters_nums_) {
+      results[i] = false;
+      continue;
+    }
+    const FilterKey *probe_key = ProbeKey(*ctxs[i]);
+    if (probe_key == nullptr) {
+      continue;
+    }
+    probe_keys.push_back(*probe_key);
+    probe_bitmaps.push_back(FilterBitmap(filter_block_num));
+    probe_idx.push_back(i);
+  }
+
+  method_->MayContainBatch(probe_keys, probe_bitmaps, probe_results);
+  for (size_t i = 0; i < probe_idx.size(); i++) {
+    results[probe_idx[i]] = probe_results[i];
+  }
+}
+
+/**
+ * @brief 检查指定的过滤块中是否可能存在与 key 前缀相同的键
+ *
+ * @param filter_block_num 要检查的过滤块的编号
+ * @param key 前缀查找的 key
+ * @return true 可能存在，或者过滤器无法判断
+ * @return false 一定不存在
+ */
+auto FilterBlockReader::IsPrefixExists(int filter_block_num, string_view key) -> bool {
+  if (prefix_extractor_ == nullptr || !prefix_extractor_->InDomain(key)) {
+    return true;
+  }
+  if (filter_block_num >= data_filters_nums_) {
+    return false;
+  }
+  return MayMatch(filter_block_num, FilterKey(prefix_extractor_->Transform(key)));
+}
+
+/**
+ * @brief 通过表级前缀过滤器检查整张表中是否可能存在与 key 前缀相同的键
+ *
+ * @param key 前缀查找的 key
+ * @return true 可能存在，或者过滤器无法判断
+ * @return false 一定不存在，整张表可以被跳过
+ */
+auto FilterBlockReader::IsTablePrefixExists(string_view key) -> bool {
+  if (prefix_extractor_ == nullptr || !has_table_prefix_filter_ || !prefix_extractor_->InDomain(key)) {
+    return true;
+  }
+  return MayMatch(filters_nums_ - 1, FilterKey(prefix_extractor_->Transform(key)));
+}
+
+auto FilterBlockReader::MayMatch(int filter_idx, const FilterKey &key) -> bool {
+  return method_->MayContain(key, FilterBitmap(filter_idx));
+}
+
+auto FilterBlockReader::FilterBitmap(int filter_idx) -> string_view {
+  int filter_offset1;
+  int filter_offset2;
+  Decode32(&filters_offsets_[filter_idx * sizeof(int)], &filter_offset1);
+  if (filter_idx + 1 == filters_nums_) {
     filter_offset2 = filters_offsets_offset_;
   } else {
-    Decode32(&filters_offsets_[(filter_block_num + 1) * sizeof(int)], &filter_offset2);
+    Decode32(&filters_offsets_[(filter_idx + 1) * sizeof(int)], &filter_offset2);
   }
-  return method_->IsKeyExists(key, {&filter_blocks_[filter_offset1], &filter_blocks_[filter_offset2]});
+  return {&filter_blocks_[filter_offset1], &filter_blocks_[filter_offset2]};
 }
 }  // namespace lsm_tree
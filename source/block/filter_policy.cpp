@@ -0,0 +1,131 @@
+#include "block/filter_policy.hh"
+#include <algorithm>
+#include <cmath>
+#include <fmt/format.h>
+
+namespace lsm_tree {
+
+namespace {
+
+/* 误判率为 p 的布隆过滤器每个 key 需要 -ln(p) / ln(2)^2 个 bit */
+const double K_LN2_SQUARE = std::log(2) * std::log(2);
+
+auto ClampLevel(int level) -> int { return std::clamp(level, 0, FilterStats::K_MAX_LEVELS - 1); }
+
+}  // namespace
+
+/*
+**********************************************************************************************************************************************
+* AllocateFilterBits
+**********************************************************************************************************************************************
+*/
+
+/**
+ * @details 第 i 层的误判率取 p_i = u * N_i，代入总内存约束 sum(-N_i * ln(p_i)) = M * ln(2)^2 解出 ln(u)。
+ *          若某层算出的 p_i >= 1，说明该层的过滤器几乎不能排除查询，该层只分配 1 bit，去掉它和它占用的内存后重新求解。
+ */
+auto AllocateFilterBits(const std::vector<uint64_t> &level_keys, double bits_per_key) -> std::vector<int> {
+  std::vector<int>    result(level_keys.size(), static_cast<int>(std::lround(bits_per_key)));
+  std::vector<size_t> active;
+  double              total_bits = 0;
+  for (size_t i = 0; i < level_keys.size(); i++) {
+    if (level_keys[i] > 0) {
+      active.push_back(i);
+      total_bits += bits_per_key * static_cast<double>(level_keys[i]);
+    }
+  }
+
+  double log_u = 0;
+  while (!active.empty()) {
+    double keys     = 0;
+    double keys_log = 0;
+    for (auto i : active) {
+      auto n = static_cast<double>(level_keys[i]);
+      keys += n;
+      keys_log += n * std::log(n);
+    }
+    log_u = (-total_bits * K_LN2_SQUARE - keys_log) / keys;
+    /* key 最多的层误判率最高，先检查它 */
+    auto largest = std::max_element(active.begin(), active.end(),
+                                    [&](size_t lhs, size_t rhs) { return level_keys[lhs] < level_keys[rhs]; });
+    if (log_u + std::log(static_cast<double>(level_keys[*largest])) < 0) {
+      break;
+    }
+    /* 去掉的层仍然每个 key 占 1 bit，从预算中扣除 */
+    result[*largest] = 1;
+    total_bits -= static_cast<double>(level_keys[*largest]);
+    active.erase(largest);
+  }
+
+  for (auto i : active) {
+    double bits = -(log_u + std::log(static_cast<double>(level_keys[i]))) / K_LN2_SQUARE;
+    result[i]   = std::max(1, static_cast<int>(std::lround(bits)));
+  }
+  return result;
+}
+
+auto BloomFalsePositiveRate(double bits_per_key) -> double {
+  if (bits_per_key <= 0) {
+    return 1;
+  }
+  return std::exp(-bits_per_key * K_LN2_SQUARE);
+}
+
+/*
+**********************************************************************************************************************************************
+* FilterStats
+**********************************************************************************************************************************************
+*/
+
+void FilterStats::AddFilter(int level, uint64_t bytes) {
+  levels_[ClampLevel(level)].filter_bytes_.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void FilterStats::RemoveFilter(int level, uint64_t bytes) {
+  levels_[ClampLevel(level)].filter_bytes_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+void FilterStats::RecordProbe(int level, bool may_match) {
+  auto &stats = levels_[ClampLevel(level)];
+  stats.probes_.fetch_add(1, std::memory_order_relaxed);
+  if (!may_match) {
+    stats.negatives_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+void FilterStats::RecordFalsePositive(int level) {
+  levels_[ClampLevel(level)].false_positives_.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto FilterStats::FilterBytes(int level) const -> uint64_t {
+  return levels_[ClampLevel(level)].filter_bytes_.load(std::memory_order_relaxed);
+}
+
+auto FilterStats::Probes(int level) const -> uint64_t {
+  return levels_[ClampLevel(level)].probes_.load(std::memory_order_relaxed);
+}
+
+auto FilterStats::ObservedFalsePositiveRate(int level) const -> double {
+  const auto &stats           = levels_[ClampLevel(level)];
+  auto        false_positives = stats.false_positives_.load(std::memory_order_relaxed);
+  auto        negatives       = stats.negatives_.load(std::memory_order_relaxed);
+  if (false_positives + negatives == 0) {
+    return 0;
+  }
+  return static_cast<double>(false_positives) / static_cast<double>(false_positives + negatives);
+}
+
+/* 每层一行：过滤器内存、探测次数、观测误判率，没有过滤器也没有探测的层不输出 */
+auto FilterStats::ToString() const -> std::string {
+  std::string result = "level  filter_bytes  probes  observed_fpr\n";
+  for (int level = 0; level < K_MAX_LEVELS; level++) {
+    if (FilterBytes(level) == 0 && Probes(level) == 0) {
+      continue;
+    }
+    result += fmt::format("L{:<5}{:>12}  {:>6}  {:>12.6f}\n", level, FilterBytes(level), Probes(level),
+                          ObservedFalsePositiveRate(level));
+  }
+  return result;
+}
+
+}  // namespace lsm_tree
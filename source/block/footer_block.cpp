@@ -2,21 +2,30 @@
 
 namespace lsm_tree {
 
-auto FooterBlockWriter::Add(string_view meta_block_handle, string_view index_block_handle) -> RC {
+namespace {
+
+constexpr char K_MAGIC_NUMBER[2]        = {0x12, 0x35};
+constexpr char K_LEGACY_MAGIC_NUMBER[2] = {0x12, 0x34};
+
+}  // namespace
+
+auto FooterBlockWriter::Add(string_view meta_block_handle, string_view index_block_handle,
+                            ContentHashType content_hash) -> RC {
   meta_block_handle_  = meta_block_handle;
   index_block_handle_ = index_block_handle;
+  content_hash_       = content_hash;
   return RC::OK;
 }
 
 auto FooterBlockWriter::Final(string &result) -> RC {
-  static const char magic_number[2] = {0x12, 0x34};
-  string            footer;
+  string footer;
   if (meta_block_handle_.length() != 8 || index_block_handle_.length() != 8) {
     return RC::UN_SUPPORTED_FORMAT;
   }
   footer.append(meta_block_handle_);
   footer.append(index_block_handle_);
-  footer.append(magic_number, 2);
+  footer.push_back(static_cast<char>(content_hash_));
+  footer.append(K_MAGIC_NUMBER, 2);
   if (FOOTER_SIZE != footer.length()) {
     return RC::UN_SUPPORTED_FORMAT;
   }
@@ -25,14 +34,24 @@ auto FooterBlockWriter::Final(string &result) -> RC {
 }
 
 auto FooterBlockReader::Init(string_view footer_buffer) -> RC {
-  footer_buffer_ = footer_buffer;
-  if (footer_buffer_.length() != FooterBlockWriter::FOOTER_SIZE ||
-      footer_buffer_[FooterBlockWriter::FOOTER_SIZE - 2] != 0x12 ||
-      footer_buffer_[FooterBlockWriter::FOOTER_SIZE - 1] != 0x34) {
+  if (footer_buffer.size() < FooterBlockWriter::LEGACY_FOOTER_SIZE) {
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  string_view magic = footer_buffer.substr(footer_buffer.size() - 2);
+  if (magic == string_view(K_LEGACY_MAGIC_NUMBER, 2)) {
+    footer_buffer_ = footer_buffer.substr(footer_buffer.size() - FooterBlockWriter::LEGACY_FOOTER_SIZE);
+    content_hash_  = ContentHashType::SHA256;
+  } else if (magic == string_view(K_MAGIC_NUMBER, 2) && footer_buffer.size() >= FooterBlockWriter::FOOTER_SIZE) {
+    footer_buffer_ = footer_buffer.substr(footer_buffer.size() - FooterBlockWriter::FOOTER_SIZE);
+    content_hash_  = static_cast<ContentHashType>(footer_buffer_[16]);
+    if (content_hash_ != ContentHashType::SHA256 && content_hash_ != ContentHashType::HASH128) {
+      return RC::UN_SUPPORTED_FORMAT;
+    }
+  } else {
     return RC::UN_SUPPORTED_FORMAT;
   }
   meta_block_handle_.DecodeFrom(footer_buffer_.substr(0, 8));
-  index_block_handle_.DecodeFrom(footer_buffer_.substr(8, 16));
+  index_block_handle_.DecodeFrom(footer_buffer_.substr(8, 8));
   return RC::OK;
 }
 }  // namespace lsm_tree
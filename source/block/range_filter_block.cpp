@@ -0,0 +1,242 @@
+#include "block/range_filter_block.hh"
+#include <algorithm>
+#include "util/encode.hh"
+
+namespace lsm_tree {
+
+namespace {
+
+auto CommonPrefixLength(string_view lhs, string_view rhs) -> size_t {
+  size_t len = std::min(lhs.size(), rhs.size());
+  size_t i   = 0;
+  while (i < len && lhs[i] == rhs[i]) {
+    i++;
+  }
+  return i;
+}
+
+/* 第 i 个半字节，高 4 位在前，保持字节序 */
+inline auto Nibble(string_view key, size_t i) -> int {
+  auto c = static_cast<unsigned char>(key[i / 2]);
+  return (i % 2 == 0) ? (c >> 4) : (c & 0xf);
+}
+
+/* 以半字节计的公共前缀长度 */
+auto CommonNibbleLength(string_view lhs, string_view rhs) -> size_t {
+  size_t bytes = CommonPrefixLength(lhs, rhs);
+  if (bytes < lhs.size() && bytes < rhs.size() && Nibble(lhs, bytes * 2) == Nibble(rhs, bytes * 2)) {
+    return bytes * 2 + 1;
+  }
+  return bytes * 2;
+}
+
+}  // namespace
+
+/*
+**********************************************************************************************************************************************
+* RangeFilterBlockWriter
+**********************************************************************************************************************************************
+*/
+
+RangeFilterBlockWriter::RangeFilterBlockWriter(int bits_per_key, int max_depth)
+    : bits_per_key_(bits_per_key), max_depth_(std::max(max_depth, 1)) {}
+
+/**
+ * @brief 加入一个 key
+ * @details 有序的 key 的公共前缀就是第一个 key 与最后一个 key 的公共前缀，只会越来越短，
+ *          所以按当前的公共前缀截断保存，已经足够生成最终的过滤器。
+ * @param key 按升序加入的 user_key
+ * @return RC
+ */
+auto RangeFilterBlockWriter::Update(string_view key) -> RC {
+  if (keys_.empty()) {
+    smallest_key_      = key;
+    common_prefix_len_ = key.size();
+  } else {
+    common_prefix_len_ = std::min(common_prefix_len_, CommonPrefixLength(smallest_key_, key));
+  }
+  largest_key_ = key;
+  size_t limit = common_prefix_len_ + max_depth_;
+  keys_.emplace_back(key.substr(0, limit));
+  truncated_.push_back(key.size() > limit);
+  return RC::OK;
+}
+
+/* key 前 nibbles 个半字节组成的前缀：完整的字节之后跟上剩余的半字节，奇偶长度使用不同的标记 */
+void RangeFilterBlockWriter::EncodeEntry(string_view key, size_t nibbles, string &entry) {
+  entry.assign(1, nibbles % 2 == 0 ? K_PREFIX_TAG : K_HALF_PREFIX_TAG);
+  entry.append(key.substr(0, nibbles / 2));
+  if (nibbles % 2 != 0) {
+    entry.push_back(static_cast<char>(Nibble(key, nibbles - 1)));
+  }
+}
+
+/**
+ * @brief 生成范围过滤器块
+ * @details 相邻的 key 共享的前缀只加入一次，每个 key 只贡献比上一个 key 多出来的前缀
+ * @param result 范围过滤器块
+ * @return RC
+ */
+auto RangeFilterBlockWriter::Final(string &result) -> RC {
+  size_t         limit = common_prefix_len_ + max_depth_;
+  vector<string> entries;
+  string_view    last;
+  for (size_t i = 0; i < keys_.size(); i++) {
+    string_view key   = string_view(keys_[i]).substr(0, limit);
+    size_t      begin = std::max(CommonNibbleLength(last, key), common_prefix_len_ * 2) + 1;
+    for (size_t nibbles = begin; nibbles <= key.size() * 2; nibbles++) {
+      entries.emplace_back();
+      EncodeEntry(key, nibbles, entries.back());
+    }
+    if (!truncated_[i] && keys_[i].size() <= limit) {
+      entries.emplace_back(1, K_TERMINAL_TAG);
+      entries.back().append(key);
+    }
+    last = key;
+  }
+
+  BloomFilter method(bits_per_key_);
+  string      buffer;
+  method.Keys2Block(entries, buffer);
+  int bitmap_len   = static_cast<int>(buffer.size());
+  int smallest_len = static_cast<int>(smallest_key_.size());
+  int largest_len  = static_cast<int>(largest_key_.size());
+  int keys_num     = static_cast<int>(keys_.size());
+  int version      = BloomFilter::K_HASH64_VERSION;
+  buffer.append(smallest_key_);
+  buffer.append(largest_key_);
+  buffer.append(reinterpret_cast<char *>(&bitmap_len), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&smallest_len), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&largest_len), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&keys_num), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&max_depth_), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&bits_per_key_), sizeof(int));
+  buffer.append(reinterpret_cast<char *>(&version), sizeof(int));
+
+  keys_.clear();
+  truncated_.clear();
+  result = std::move(buffer);
+  return RC::OK;
+}
+
+/*
+**********************************************************************************************************************************************
+* RangeFilterBlockReader
+**********************************************************************************************************************************************
+*/
+
+auto RangeFilterBlockReader::Init(string_view range_filter_block) -> RC {
+  if (range_filter_block.size() < RangeFilterBlockWriter::K_TRAILER_SIZE) {
+    return RC::FILTER_BLOCK_ERROR;
+  }
+  const char *trailer = range_filter_block.data() + range_filter_block.size() - RangeFilterBlockWriter::K_TRAILER_SIZE;
+  int         bitmap_len;
+  int         smallest_len;
+  int         largest_len;
+  int         bits_per_key;
+  int         version;
+  Decode32(trailer, &bitmap_len);
+  Decode32(trailer + sizeof(int), &smallest_len);
+  Decode32(trailer + sizeof(int) * 2, &largest_len);
+  Decode32(trailer + sizeof(int) * 3, &keys_num_);
+  Decode32(trailer + sizeof(int) * 4, &max_depth_);
+  Decode32(trailer + sizeof(int) * 5, &bits_per_key);
+  Decode32(trailer + sizeof(int) * 6, &version);
+  if (bitmap_len < 0 || smallest_len < 0 || largest_len < 0 || keys_num_ < 0 || max_depth_ < 1 ||
+      static_cast<size_t>(bitmap_len) + smallest_len + largest_len + RangeFilterBlockWriter::K_TRAILER_SIZE !=
+          range_filter_block.size()) {
+    return RC::FILTER_BLOCK_ERROR;
+  }
+  if (version != BloomFilter::K_MURMUR3_VERSION && version != BloomFilter::K_HASH64_VERSION) {
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  bitmap_            = range_filter_block.substr(0, bitmap_len);
+  smallest_key_      = range_filter_block.substr(bitmap_len, smallest_len);
+  largest_key_       = range_filter_block.substr(bitmap_len + smallest_len, largest_len);
+  common_prefix_len_ = CommonPrefixLength(smallest_key_, largest_key_);
+  method_            = std::make_unique<BloomFilter>(bits_per_key, version);
+  return RC::OK;
+}
+
+/**
+ * @brief 判断表中是否可能有 key 落在 [lower, upper) 内
+ * @details 最小、最大 key 本身就是表中的 key，先用它们判断；否则 lower 和 upper 都落在 [smallest, largest] 内，
+ *          共享公共前缀，从公共前缀开始沿两条边界路径展开。
+ * @param lower 下界（包含）
+ * @param upper 上界（不包含），为空表示没有上界
+ * @return true 可能存在
+ * @return false 一定不存在
+ */
+auto RangeFilterBlockReader::MayContainRange(string_view lower, string_view upper) -> bool {
+  bool has_upper = !upper.empty();
+  if (keys_num_ == 0 || (has_upper && lower >= upper)) {
+    return false;
+  }
+  if (lower > largest_key_ || (has_upper && upper <= smallest_key_)) {
+    return false;
+  }
+  if (lower <= smallest_key_ || !has_upper || upper > largest_key_) {
+    return true;
+  }
+  path_.assign(lower.substr(0, common_prefix_len_));
+  int probes = 0;
+  return Search(common_prefix_len_ * 2, lower, upper, true, true, probes);
+}
+
+/**
+ * @brief 在 path_ 前 nibbles 个半字节组成的前缀的子树中查找 [lower, upper) 内的 key
+ * @param nibbles 当前前缀的半字节数，path_ 中保存前缀对应的字节
+ * @param lower_tight 当前前缀是否为 lower 的前缀，为 true 时子树中小于 lower 的部分不在范围内
+ * @param upper_tight 当前前缀是否为 upper 的前缀，为 true 时子树中不小于 upper 的部分不在范围内
+ * @param probes 已经探测的次数
+ * @return true 可能存在
+ * @return false 一定不存在
+ */
+auto RangeFilterBlockReader::Search(size_t nibbles, string_view lower, string_view upper, bool lower_tight,
+                                    bool upper_tight, int &probes) -> bool {
+  /* 1. 恰好等于当前前缀的 key，只可能出现在整字节处 */
+  bool prefix_in_range = (!lower_tight || lower.size() * 2 == nibbles) && (!upper_tight || upper.size() * 2 > nibbles);
+  if (nibbles % 2 == 0 && prefix_in_range) {
+    probe_.assign(1, RangeFilterBlockWriter::K_TERMINAL_TAG);
+    probe_.append(path_, 0, nibbles / 2);
+    if (method_->IsKeyExists(probe_, bitmap_)) {
+      return true;
+    }
+  }
+  if (upper_tight && upper.size() * 2 == nibbles) {
+    return false;
+  }
+  /* 2. 更长的前缀没有记录在过滤器中 */
+  if (nibbles >= (common_prefix_len_ + max_depth_) * 2) {
+    return true;
+  }
+  /* 3. 逐个检查范围内的下一个半字节，只有边界上的前缀需要继续展开 */
+  bool lower_extends = lower_tight && lower.size() * 2 > nibbles;
+  int  first         = lower_extends ? Nibble(lower, nibbles) : 0;
+  int  last          = upper_tight ? Nibble(upper, nibbles) : 0xf;
+  if (nibbles % 2 == 0) {
+    path_.resize(nibbles / 2 + 1);
+  }
+  for (int nibble = first; nibble <= last; nibble++) {
+    if (++probes > K_MAX_PROBES) {
+      return true;
+    }
+    auto &byte = path_[nibbles / 2];
+    byte = static_cast<char>(nibbles % 2 == 0 ? (nibble << 4) : ((byte & 0xf0) | nibble));
+    RangeFilterBlockWriter::EncodeEntry(path_, nibbles + 1, probe_);
+    if (!method_->IsKeyExists(probe_, bitmap_)) {
+      continue;
+    }
+    bool child_lower_tight = lower_extends && nibble == first;
+    bool child_upper_tight = upper_tight && nibble == last;
+    if (!child_lower_tight && !child_upper_tight) {
+      return true;
+    }
+    if (Search(nibbles + 1, lower, upper, child_lower_tight, child_upper_tight, probes)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,105 @@
+#include "block_cache.hh"
+#include <algorithm>
+#include <utility>
+#include "secondary_cache.hh"
+
+namespace lsm_tree {
+
+/* 没有 decompressor 时压缩层中的块无法使用，不划出压缩层，全部容量给未压缩层 */
+BlockCache::BlockCache(const CacheOptions &options, double compressed_ratio, Decompressor decompressor)
+    : compressed_ratio_(decompressor ? std::clamp(compressed_ratio, 0.0, 1.0) : 0),
+      decompressor_(std::move(decompressor)),
+      uncompressed_(UncompressedOptions(options, compressed_ratio_)),
+      compressed_(CompressedOptions(options, compressed_ratio_)) {}
+
+/* 压缩层只保存低优先级的块，不需要高优先级池 */
+auto BlockCache::CompressedOptions(const CacheOptions &options, double compressed_ratio) -> CacheOptions {
+  CacheOptions compressed         = options;
+  compressed.capacity_            = static_cast<size_t>(static_cast<double>(options.capacity_) * compressed_ratio);
+  compressed.high_pri_pool_ratio_ = 0;
+  return compressed;
+}
+
+auto BlockCache::UncompressedOptions(const CacheOptions &options, double compressed_ratio) -> CacheOptions {
+  CacheOptions uncompressed = options;
+  uncompressed.capacity_    = options.capacity_ - CompressedOptions(options, compressed_ratio).capacity_;
+  return uncompressed;
+}
+
+/**
+ * @brief 先查未压缩层，未命中时从压缩层解压或从二级缓存读取，并放入未压缩层
+ * @details 解压失败的块从压缩层删除，调用方按未命中处理，从磁盘重新读取。
+ *          解压得到的块以低优先级放入未压缩层，索引块和过滤器块由表打开时读取，一般不会走到这里。
+ * @param key 块缓存的 key
+ * @return Handle 两层都未命中时为空
+ */
+auto BlockCache::Lookup(const BlockCacheKey &key) -> Handle {
+  if (auto handle = uncompressed_.Lookup(key); handle) {
+    return handle;
+  }
+  std::string block;
+  if (!LookupCompressed(key, block) && (secondary_ == nullptr || secondary_->Lookup(key, block) != RC::OK)) {
+    return Handle();
+  }
+  size_t charge = block.size();
+  return uncompressed_.Insert(key, std::move(block), charge);
+}
+
+auto BlockCache::LookupCompressed(const BlockCacheKey &key, std::string &block) -> bool {
+  if (compressed_ratio_ == 0) {
+    return false;
+  }
+  auto compressed = compressed_.Lookup(key);
+  if (!compressed) {
+    return false;
+  }
+  if (decompressor_(*compressed, block) != RC::OK) {
+    decompress_failures_.fetch_add(1, std::memory_order_relaxed);
+    compressed.Reset();
+    compressed_.Erase(key);
+    return false;
+  }
+  decompressions_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+auto BlockCache::Insert(const BlockCacheKey &key, std::string block, std::string_view compressed,
+                        CachePriority priority) -> Handle {
+  if (compressed_ratio_ > 0 && !compressed.empty() && compressed.size() < block.size()) {
+    compressed_.Insert(key, std::string(compressed), compressed.size());
+  }
+  size_t charge = block.size();
+  return uncompressed_.Insert(key, std::move(block), charge, priority);
+}
+
+void BlockCache::Erase(const BlockCacheKey &key) {
+  uncompressed_.Erase(key);
+  compressed_.Erase(key);
+  if (secondary_ != nullptr) {
+    secondary_->Erase(key);
+  }
+}
+
+/* 淘汰回调在分片的锁内执行，SecondaryCache::Insert 只把块放入写队列 */
+void BlockCache::SetSecondaryCache(SecondaryCache *secondary) {
+  secondary_ = secondary;
+  uncompressed_.SetEvictionCallback(
+      [secondary](const BlockCacheKey &key, const std::string &block) { secondary->Insert(key, block); });
+}
+
+void BlockCache::SetCapacity(size_t capacity) {
+  auto compressed = static_cast<size_t>(static_cast<double>(capacity) * compressed_ratio_);
+  compressed_.SetCapacity(compressed);
+  uncompressed_.SetCapacity(capacity - compressed);
+}
+
+auto BlockCache::Stats() const -> BlockCacheStats {
+  BlockCacheStats stats;
+  stats.uncompressed_        = uncompressed_.Stats();
+  stats.compressed_          = compressed_.Stats();
+  stats.decompressions_      = decompressions_.load(std::memory_order_relaxed);
+  stats.decompress_failures_ = decompress_failures_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+}  // namespace lsm_tree
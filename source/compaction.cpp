@@ -0,0 +1,631 @@
+#include "compaction.hh"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include "merging_iterator.hh"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+namespace {
+
+/* 新的 user_key 还没有版本时的快照区间 */
+constexpr size_t K_NO_STRIPE = SIZE_MAX;
+
+auto TotalFileSize(const vector<Version::FileRef> &files) -> uint64_t {
+  uint64_t bytes = 0;
+  for (const auto &file : files) {
+    bytes += file->file_size_;
+  }
+  return bytes;
+}
+
+/* files 的 user_key 范围 */
+void UserKeyRange(const vector<Version::FileRef> &files, string &smallest, string &largest) {
+  for (size_t i = 0; i < files.size(); i++) {
+    const auto &file = *files[i];
+    if (i == 0 || file.min_inner_key_.user_key_ < smallest) {
+      smallest = file.min_inner_key_.user_key_;
+    }
+    if (i == 0 || file.max_inner_key_.user_key_ > largest) {
+      largest = file.max_inner_key_.user_key_;
+    }
+  }
+}
+
+/* 输出文件的过滤器 bits_per_key，其他层的输入文件中的 key 计入输出层；没有输入 Version 时不按层分配 */
+auto OutputFilterBitsPerKey(const DBOptions &options, const Compaction &compaction) -> int {
+  if (!compaction.input_version_) {
+    return options.bits_per_key_;
+  }
+  uint64_t added_keys = 0;
+  for (const auto &inputs : compaction.inputs_) {
+    for (const auto &file : inputs.files_) {
+      if (inputs.level_ != compaction.output_level_) {
+        added_keys += file->num_keys_;
+      }
+    }
+  }
+  return compaction.input_version_->FilterBitsPerKey(options, compaction.output_level_, added_keys);
+}
+
+}  // namespace
+
+void CompactionStats::Add(const CompactionStats &other) {
+  compactions_ += other.compactions_;
+  trivial_moves_ += other.trivial_moves_;
+  input_files_ += other.input_files_;
+  output_files_ += other.output_files_;
+  bytes_read_ += other.bytes_read_;
+  bytes_written_ += other.bytes_written_;
+  input_entries_ += other.input_entries_;
+  output_entries_ += other.output_entries_;
+  subcompactions_ += other.subcompactions_;
+  dropped_obsolete_entries_ += other.dropped_obsolete_entries_;
+  dropped_tombstones_ += other.dropped_tombstones_;
+}
+
+/*
+**********************************************************************************************************************************************
+* Compaction
+**********************************************************************************************************************************************
+*/
+
+auto Compaction::NumInputFiles() const -> int {
+  int num = 0;
+  for (const auto &inputs : inputs_) {
+    num += static_cast<int>(inputs.files_.size());
+  }
+  return num;
+}
+
+auto Compaction::InputBytes() const -> uint64_t {
+  uint64_t bytes = 0;
+  for (const auto &inputs : inputs_) {
+    bytes += TotalFileSize(inputs.files_);
+  }
+  return bytes;
+}
+
+auto Compaction::IsTrivialMove() const -> bool {
+  return NumInputFiles() == 1 && inputs_[0].level_ != output_level_ &&
+         TotalFileSize(grandparents_) <= max_grandparent_overlap_bytes_;
+}
+
+auto Compaction::IsBottommostForKey(string_view user_key) const -> bool {
+  if (output_level_ == 0 || !input_version_) {
+    return false;
+  }
+  for (int level = output_level_ + 1; level < K_NUM_LEVELS; level++) {
+    if (input_version_->OverlapInLevel(level, user_key, user_key)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Compaction::AddInputDeletions(VersionEdit &edit) const {
+  for (const auto &inputs : inputs_) {
+    for (const auto &file : inputs.files_) {
+      edit.DeleteFile(inputs.level_, file->GetOid());
+    }
+  }
+}
+
+/*
+**********************************************************************************************************************************************
+* LeveledCompactionPicker
+**********************************************************************************************************************************************
+*/
+
+auto LeveledCompactionPicker::MaxBytesForLevel(int level) const -> double {
+  double bytes = static_cast<double>(options_.max_bytes_for_level_base_);
+  for (int i = 1; i < level; i++) {
+    bytes *= options_.max_bytes_for_level_multiplier_;
+  }
+  return bytes;
+}
+
+auto LeveledCompactionPicker::MaxFileSizeForLevel(int level) const -> size_t {
+  double size = static_cast<double>(options_.target_file_size_base_);
+  for (int i = 1; i < level; i++) {
+    size *= options_.target_file_size_multiplier_;
+  }
+  return static_cast<size_t>(size);
+}
+
+auto LeveledCompactionPicker::LevelScore(const Version &version, int level) const -> double {
+  if (level == 0) {
+    return static_cast<double>(version.NumFiles(0)) / std::max(options_.level_files_limit_, 1);
+  }
+  return static_cast<double>(version.LevelBytes(level)) / MaxBytesForLevel(level);
+}
+
+auto LeveledCompactionPicker::PickLevel(const Version &version, double &score) const -> int {
+  int best = -1;
+  score    = 0;
+  for (int level = 0; level < K_NUM_LEVELS - 1; level++) {
+    double level_score = LevelScore(version, level);
+    if (level_score >= 1 && level_score > score) {
+      best  = level;
+      score = level_score;
+    }
+  }
+  return best;
+}
+
+auto LeveledCompactionPicker::NeedsCompaction(const Version &version) const -> bool {
+  double score;
+  return PickLevel(version, score) >= 0;
+}
+
+/* L0 按从新到旧排列，从最后一个（最旧的）文件开始扩展，直到没有新的重叠文件 */
+void LeveledCompactionPicker::PickL0Files(const Version &version, vector<Version::FileRef> &files) const {
+  const auto &level0 = version.Files(0);
+  files.assign(1, level0.back());
+  string smallest = level0.back()->min_inner_key_.user_key_;
+  string largest  = level0.back()->max_inner_key_.user_key_;
+  for (bool expanded = true; expanded;) {
+    expanded = false;
+    for (const auto &file : level0) {
+      if (std::find(files.begin(), files.end(), file) != files.end() ||
+          file->max_inner_key_.user_key_ < smallest || file->min_inner_key_.user_key_ > largest) {
+        continue;
+      }
+      files.push_back(file);
+      smallest = std::min(smallest, file->min_inner_key_.user_key_);
+      largest  = std::max(largest, file->max_inner_key_.user_key_);
+      expanded = true;
+    }
+  }
+  /* 保持从新到旧的顺序 */
+  std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) { return a->max_seq_ > b->max_seq_; });
+}
+
+auto LeveledCompactionPicker::PickFile(const Version &version, int level) const -> Version::FileRef {
+  Version::FileRef         best;
+  double                   best_ratio = 0;
+  vector<Version::FileRef> overlaps;
+  for (const auto &file : version.Files(level)) {
+    version.GetOverlappingFiles(level + 1, file->min_inner_key_.user_key_, file->max_inner_key_.user_key_, overlaps);
+    double ratio =
+        static_cast<double>(TotalFileSize(overlaps)) / static_cast<double>(std::max<size_t>(file->file_size_, 1));
+    if (!best || ratio < best_ratio) {
+      best       = file;
+      best_ratio = ratio;
+    }
+  }
+  return best;
+}
+
+auto LeveledCompactionPicker::PickCompaction(const Version &version) const -> std::unique_ptr<Compaction> {
+  double score;
+  int    level = PickLevel(version, score);
+  if (level < 0) {
+    return nullptr;
+  }
+  auto compaction                            = std::make_unique<Compaction>();
+  compaction->output_level_                  = level + 1;
+  compaction->score_                         = score;
+  compaction->max_output_file_size_          = MaxFileSizeForLevel(level + 1);
+  compaction->max_grandparent_overlap_bytes_ =
+      static_cast<uint64_t>(compaction->max_output_file_size_) * options_.max_grandparent_overlap_factor_;
+
+  CompactionInputs inputs{.level_ = level};
+  if (level == 0) {
+    PickL0Files(version, inputs.files_);
+  } else {
+    inputs.files_.push_back(PickFile(version, level));
+  }
+  string smallest;
+  string largest;
+  UserKeyRange(inputs.files_, smallest, largest);
+  compaction->inputs_.push_back(std::move(inputs));
+
+  CompactionInputs output_inputs{.level_ = level + 1};
+  version.GetOverlappingFiles(level + 1, smallest, largest, output_inputs.files_);
+  if (!output_inputs.files_.empty()) {
+    string output_smallest;
+    string output_largest;
+    UserKeyRange(output_inputs.files_, output_smallest, output_largest);
+    smallest = std::min(smallest, output_smallest);
+    largest  = std::max(largest, output_largest);
+    compaction->inputs_.push_back(std::move(output_inputs));
+  }
+  if (level + 2 < K_NUM_LEVELS) {
+    version.GetOverlappingFiles(level + 2, smallest, largest, compaction->grandparents_);
+  }
+  return compaction;
+}
+
+/*
+**********************************************************************************************************************************************
+* UniversalCompactionPicker
+**********************************************************************************************************************************************
+*/
+
+auto UniversalCompactionPicker::SortedRuns(const Version &version) -> vector<SortedRun> {
+  vector<SortedRun> runs;
+  for (const auto &file : version.Files(0)) {
+    runs.push_back({.level_ = 0, .file_ = file, .size_ = file->file_size_});
+  }
+  for (int level = 1; level < K_NUM_LEVELS; level++) {
+    if (version.NumFiles(level) > 0) {
+      runs.push_back({.level_ = level, .file_ = nullptr, .size_ = version.LevelBytes(level)});
+    }
+  }
+  return runs;
+}
+
+auto UniversalCompactionPicker::NeedsCompaction(const Version &version) const -> bool {
+  auto num_runs = static_cast<int>(SortedRuns(version).size());
+  return num_runs >= 2 && num_runs >= options_.level_files_limit_;
+}
+
+auto UniversalCompactionPicker::PickSpaceAmplification(const vector<SortedRun> &runs, size_t &count) const
+    -> bool {
+  uint64_t newer_bytes = 0;
+  for (size_t i = 0; i + 1 < runs.size(); i++) {
+    newer_bytes += runs[i].size_;
+  }
+  uint64_t oldest_bytes = runs.back().size_;
+  if (newer_bytes * 100 < oldest_bytes * options_.universal_compaction_options_.max_size_amplification_percent_) {
+    return false;
+  }
+  count = runs.size();
+  return true;
+}
+
+/* 每个起点从最新的未选段开始，累计的段越来越大，越旧的段越大，合并的是大小相近的段 */
+auto UniversalCompactionPicker::PickSizeRatio(const vector<SortedRun> &runs, size_t &start, size_t &count) const
+    -> bool {
+  const auto &universal = options_.universal_compaction_options_;
+  auto        max_width = static_cast<size_t>(std::max(universal.max_merge_width_, 2));
+  auto        min_width = static_cast<size_t>(std::max(universal.min_merge_width_, 2));
+  for (start = 0; start + 1 < runs.size(); start++) {
+    uint64_t candidate_bytes = runs[start].size_;
+    count                    = 1;
+    while (start + count < runs.size() && count < max_width &&
+           candidate_bytes * (100 + universal.size_ratio_) >= runs[start + count].size_ * 100) {
+      candidate_bytes += runs[start + count].size_;
+      count++;
+    }
+    if (count >= min_width) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto UniversalCompactionPicker::PickCompaction(const Version &version) const -> std::unique_ptr<Compaction> {
+  if (!NeedsCompaction(version)) {
+    return nullptr;
+  }
+  auto   runs  = SortedRuns(version);
+  size_t start = 0;
+  size_t count = 0;
+  if (PickSpaceAmplification(runs, count) || PickSizeRatio(runs, start, count)) {
+    return NewCompaction(version, runs, start, count);
+  }
+  /* 合并最新的段，合并后的有序段个数为 level_files_limit_ - 1 */
+  count = std::max<size_t>(runs.size() - std::max(options_.level_files_limit_, 1) + 1, 2);
+  return NewCompaction(version, runs, 0, count);
+}
+
+/* 写入下一个更旧的有序段之上最深的层；该层和被合并的段之间的层都是空的，或者就是被合并的段 */
+auto UniversalCompactionPicker::NewCompaction(const Version &version, const vector<SortedRun> &runs, size_t start,
+                                              size_t count) const -> std::unique_ptr<Compaction> {
+  auto compaction = std::make_unique<Compaction>();
+  if (start + count == runs.size()) {
+    compaction->output_level_ = K_NUM_LEVELS - 1;
+  } else {
+    compaction->output_level_ = std::max(runs[start + count].level_ - 1, 0);
+  }
+  /* L0 中的输出必须是一个文件，才是一个有序段 */
+  compaction->max_output_file_size_ =
+      compaction->output_level_ == 0 ? SIZE_MAX : static_cast<size_t>(options_.target_file_size_base_);
+  compaction->score_ = static_cast<double>(runs.size()) / std::max(options_.level_files_limit_, 1);
+  for (size_t i = start; i < start + count; i++) {
+    const auto &run = runs[i];
+    if (run.level_ == 0) {
+      if (compaction->inputs_.empty() || compaction->inputs_.back().level_ != 0) {
+        compaction->inputs_.push_back({.level_ = 0});
+      }
+      compaction->inputs_.back().files_.push_back(run.file_);
+    } else {
+      compaction->inputs_.push_back({.level_ = run.level_, .files_ = version.Files(run.level_)});
+    }
+  }
+  return compaction;
+}
+
+auto NewCompactionPicker(const DBOptions &options) -> std::unique_ptr<CompactionPicker> {
+  if (options.compaction_style_ == CompactionStyle::UNIVERSAL) {
+    return std::make_unique<UniversalCompactionPicker>(options);
+  }
+  return std::make_unique<LeveledCompactionPicker>(options);
+}
+
+/*
+**********************************************************************************************************************************************
+* CompactionJob
+**********************************************************************************************************************************************
+*/
+
+CompactionJob::CompactionJob(string_view dbname, const DBOptions &options, const Compaction &compaction,
+                             vector<std::shared_ptr<Worker>> workers)
+    : dbname_(dbname),
+      options_(options),
+      compaction_(compaction),
+      workers_(std::move(workers)),
+      filter_bits_per_key_(OutputFilterBitsPerKey(options, compaction)) {}
+
+/* compaction 顺序读取整个文件，不经过块缓存，避免挤出点查的热点块 */
+auto CompactionJob::OpenInputs() -> RC {
+  for (const auto &inputs : compaction_.inputs_) {
+    for (const auto &file : inputs.files_) {
+      std::shared_ptr<SSTableReader> reader;
+      if (auto rc = SSTableReader::Open(SstFile(SstDir(dbname_), file->GetOid()), options_, inputs.level_, nullptr,
+                                        nullptr, reader);
+          rc != RC::OK) {
+        return rc;
+      }
+      reader->SetGlobalSequence(file->global_seq_);
+      readers_.push_back(std::move(reader));
+      files_.push_back(file);
+      stats_.input_files_++;
+      stats_.bytes_read_ += file->file_size_;
+    }
+  }
+  return RC::OK;
+}
+
+/**
+ * @brief 选择切分点
+ * @details 每个数据块的最后一个 user_key 和每个文件的最小 user_key 作为候选，按 key 排序后累计数据块的大小，
+ *          每累计到总大小的 1/n 时以当前候选 key 作为切分点。同一个 user_key 只会落在一个范围内。
+ */
+void CompactionJob::GenerateSubcompactions() {
+  int max_subcompactions = std::min(options_.max_subcompactions_, static_cast<int>(workers_.size()) + 1);
+  if (max_subcompactions > 1 && compaction_.output_level_ > 0) {
+    vector<std::pair<string, uint64_t>> samples;
+    uint64_t                            total_bytes = 0;
+    for (size_t i = 0; i < readers_.size(); i++) {
+      samples.emplace_back(files_[i]->min_inner_key_.user_key_, 0);
+      if (readers_[i]->SampleDataBlocks(samples) != RC::OK) {
+        samples.clear();
+        break;
+      }
+    }
+    std::sort(samples.begin(), samples.end());
+    for (const auto &[key, bytes] : samples) {
+      total_bytes += bytes;
+    }
+    uint64_t accumulated = 0;
+    for (size_t i = 0; i < samples.size() && static_cast<int>(boundaries_.size()) + 1 < max_subcompactions; i++) {
+      const auto &[key, bytes] = samples[i];
+      uint64_t    target       = total_bytes / max_subcompactions * (boundaries_.size() + 1);
+      if (accumulated >= target && key > samples.front().first &&
+          (boundaries_.empty() || key > boundaries_.back())) {
+        boundaries_.push_back(key);
+      }
+      accumulated += bytes;
+    }
+  }
+
+  subcompactions_.resize(boundaries_.size() + 1);
+  for (size_t i = 0; i < boundaries_.size(); i++) {
+    subcompactions_[i].end_       = boundaries_[i];
+    subcompactions_[i + 1].begin_ = boundaries_[i];
+  }
+}
+
+auto CompactionJob::Run() -> RC {
+  if (auto rc = OpenInputs(); rc != RC::OK) {
+    return rc;
+  }
+  GenerateSubcompactions();
+
+  std::mutex              mutex;
+  std::condition_variable cond;
+  size_t                  running = subcompactions_.size() - 1;
+  for (size_t i = 1; i < subcompactions_.size(); i++) {
+    workers_[i - 1]->Add([&, i]() {
+      RunSubcompaction(subcompactions_[i]);
+      std::lock_guard<std::mutex> lock(mutex);
+      if (--running == 0) {
+        cond.notify_one();
+      }
+    });
+  }
+  RunSubcompaction(subcompactions_[0]);
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cond.wait(lock, [&running]() { return running == 0; });
+  }
+
+  auto rc = RC::OK;
+  for (auto &sub : subcompactions_) {
+    if (rc == RC::OK) {
+      rc = sub.status_;
+    }
+    for (auto &meta : sub.outputs_) {
+      outputs_.push_back(std::move(meta));
+    }
+    stats_.output_files_ += sub.stats_.output_files_;
+    stats_.bytes_written_ += sub.stats_.bytes_written_;
+    stats_.input_entries_ += sub.stats_.input_entries_;
+    stats_.output_entries_ += sub.stats_.output_entries_;
+    stats_.dropped_obsolete_entries_ += sub.stats_.dropped_obsolete_entries_;
+    stats_.dropped_tombstones_ += sub.stats_.dropped_tombstones_;
+  }
+  if (rc != RC::OK) {
+    MLog->error("compaction to level {} failed: {}", compaction_.output_level_, RcToString(rc));
+    RemoveOutputs();
+    return rc;
+  }
+  stats_.compactions_    = 1;
+  stats_.subcompactions_ = static_cast<int>(subcompactions_.size());
+  return RC::OK;
+}
+
+/* 失败时删除当前未完成的输出文件，已完成的输出文件由 Run 统一删除 */
+void CompactionJob::RunSubcompaction(Subcompaction &sub) {
+  sub.status_ = ProcessKeys(sub);
+  if (sub.status_ != RC::OK && sub.writer_) {
+    sub.writer_.reset();
+    FileManager::Destroy(sub.output_path_);
+  }
+}
+
+auto CompactionJob::ProcessKeys(Subcompaction &sub) -> RC {
+  ReadOptions read_options;
+  read_options.iterate_upper_bound_ = sub.end_;
+  vector<SSTableReader::Iterator> iters;
+  for (size_t i = 0; i < readers_.size(); i++) {
+    const auto &file = *files_[i];
+    if ((!sub.end_.empty() && file.min_inner_key_.user_key_ >= sub.end_) ||
+        (!sub.begin_.empty() && file.max_inner_key_.user_key_ < sub.begin_)) {
+      continue;
+    }
+    iters.push_back(readers_[i]->NewIterator(read_options));
+  }
+  MergingIterator<SSTableReader::Iterator> iter(std::move(iters));
+  if (sub.begin_.empty()) {
+    iter.SeekToFirst();
+  } else {
+    iter.Seek(MemKey(sub.begin_, INT64_MAX, OperatorType::DELETE).ToSSTableKey());
+  }
+
+  auto   rc = RC::OK;
+  string last_user_key;
+  bool   has_last_user_key = false;
+  size_t last_stripe       = 0;
+  for (; iter.Valid() && rc == RC::OK; iter.Next()) {
+    string_view key      = iter.Key();
+    string_view user_key = InnerKeyToUserKey(key);
+    sub.stats_.input_entries_ += 1;
+    /* 只在 user_key 变化时切分，同一个 user_key 的版本不会跨文件 */
+    if (!has_last_user_key || user_key != last_user_key) {
+      bool stop = ShouldStopBefore(sub, user_key);
+      if (sub.writer_ && (stop || sub.writer_->FileSize() >= compaction_.max_output_file_size_)) {
+        rc = FinishOutput(sub);
+      }
+      last_user_key     = user_key;
+      has_last_user_key = true;
+      last_stripe       = K_NO_STRIPE;
+    }
+    if (ShouldDrop(sub, key, last_stripe)) {
+      continue;
+    }
+    if (rc == RC::OK && !sub.writer_) {
+      rc = OpenOutput(sub);
+    }
+    if (rc == RC::OK) {
+      rc = sub.writer_->Add(key, iter.Value());
+      sub.stats_.output_entries_ += 1;
+    }
+  }
+  if (rc == RC::OK) {
+    rc = iter.Status();
+  }
+  if (rc == RC::OK && sub.writer_) {
+    rc = FinishOutput(sub);
+  }
+  return rc;
+}
+
+/**
+ * @brief 同一个 user_key 的版本从新到旧依次经过这里
+ * @details 版本所在的快照区间为第一个不小于其序列号的快照的下标，比所有快照都新时为快照的个数。
+ *          与上一个版本在同一个区间时，读取任何快照都会先看到上一个版本，丢弃；
+ *          区间 0 中最新的版本为删除标记、且更低的层没有该 key 时，没有快照能看到它覆盖的数据，也丢弃。
+ */
+auto CompactionJob::ShouldDrop(Subcompaction &sub, string_view key, size_t &last_stripe) -> bool {
+  const auto &snapshots = compaction_.snapshots_;
+  size_t      stripe    = std::lower_bound(snapshots.begin(), snapshots.end(), InnerKeySeq(key)) - snapshots.begin();
+  bool        shadowed  = stripe == last_stripe;
+  last_stripe           = stripe;
+  if (shadowed) {
+    sub.stats_.dropped_obsolete_entries_++;
+    return true;
+  }
+  if (stripe == 0 && InnerKeyOpType(key) == OperatorType::DELETE &&
+      compaction_.IsBottommostForKey(InnerKeyToUserKey(key))) {
+    sub.stats_.dropped_tombstones_++;
+    return true;
+  }
+  return false;
+}
+
+auto CompactionJob::OpenOutput(Subcompaction &sub) -> RC {
+  std::unique_ptr<TempFile> file;
+  if (auto rc = FileManager::OpenTempFile(SstDir(dbname_), "compact_", file); rc != RC::OK) {
+    return rc;
+  }
+  sub.output_path_ = file->GetPath();
+  sub.writer_      = std::make_unique<SSTableWriter>(dbname_, file.release(), options_, filter_bits_per_key_);
+  return RC::OK;
+}
+
+auto CompactionJob::FinishOutput(Subcompaction &sub) -> RC {
+  FileMetaData meta;
+  auto         rc = sub.writer_->Finish(&meta);
+  sub.writer_.reset();
+  if (rc != RC::OK) {
+    FileManager::Destroy(sub.output_path_);
+    return rc;
+  }
+  meta.belong_to_level_ = compaction_.output_level_;
+  sub.stats_.output_files_++;
+  sub.stats_.bytes_written_ += meta.file_size_;
+  sub.outputs_.push_back(std::move(meta));
+  sub.overlapped_bytes_ = 0;
+  return RC::OK;
+}
+
+/* grandparents_ 按 key 排列，跳过最大 key 小于 user_key 的文件，累计当前输出文件跨过的文件大小 */
+auto CompactionJob::ShouldStopBefore(Subcompaction &sub, string_view user_key) -> bool {
+  const auto &grandparents = compaction_.grandparents_;
+  while (sub.grandparent_index_ < grandparents.size() &&
+         grandparents[sub.grandparent_index_]->max_inner_key_.user_key_ < user_key) {
+    if (sub.seen_key_) {
+      sub.overlapped_bytes_ += grandparents[sub.grandparent_index_]->file_size_;
+    }
+    sub.grandparent_index_++;
+  }
+  sub.seen_key_ = true;
+  if (sub.overlapped_bytes_ > compaction_.max_grandparent_overlap_bytes_) {
+    sub.overlapped_bytes_ = 0;
+    return true;
+  }
+  return false;
+}
+
+auto CompactionJob::Install(VersionSet *versions) -> RC {
+  VersionEdit edit;
+  compaction_.AddInputDeletions(edit);
+  for (const auto &meta : outputs_) {
+    edit.AddFile(compaction_.output_level_, meta);
+  }
+  if (auto rc = versions->LogAndApply(edit); rc != RC::OK) {
+    RemoveOutputs();
+    return rc;
+  }
+  return RC::OK;
+}
+
+/* 内容与某个输入文件相同的输出文件和输入文件是同一个文件，不能删除 */
+void CompactionJob::RemoveOutputs() {
+  for (const auto &meta : outputs_) {
+    bool is_input = std::any_of(files_.begin(), files_.end(),
+                                [&](const Version::FileRef &file) { return file->GetOid() == meta.GetOid(); });
+    if (!is_input) {
+      FileManager::Destroy(SstFile(SstDir(dbname_), meta.GetOid()));
+    }
+  }
+  outputs_.clear();
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,781 @@
+#include "db.hh"
+#include <algorithm>
+#include "external_file_ingestion.hh"
+#include "sstable/sstable.hh"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+DB::DB(string_view dbname, const DBOptions &options)
+    : dbname_(dbname),
+      options_(options),
+      versions_(dbname_, options_),
+      table_cache_(options_.max_open_files_,
+                   [this](uint64_t /*table_id*/, const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) {
+                     return OpenTable(file, reader);
+                   }),
+      compaction_picker_(NewCompactionPicker(options_)),
+      compaction_worker_(Worker::NewBackgroundWorker()),
+      flush_worker_(Worker::NewBackgroundWorker()) {
+  CacheOptions cache_options = options_.block_cache_options_;
+  cache_options.capacity_    = options_.BlockCacheCapacity();
+  block_cache_ = std::make_unique<BlockCache>(cache_options, options_.compressed_block_cache_ratio_, nullptr);
+  if (options_.row_cache_capacity_ > 0) {
+    row_cache_ = std::make_unique<RowCache>(options_.row_cache_capacity_);
+  }
+  for (int i = 1; i < options_.max_subcompactions_; i++) {
+    subcompaction_workers_.push_back(Worker::NewBackgroundWorker());
+  }
+}
+
+/* flush 完成后可能再触发 compaction，所以先等待 flush，再停止调度 compaction */
+DB::~DB() {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return imms_.empty() || bg_error_ != RC::OK; });
+    shutting_down_ = true;
+    cond_.wait(lock, [this]() { return !compaction_scheduled_; });
+  }
+  flush_worker_->Stop();
+  flush_worker_->Join();
+  compaction_worker_->Stop();
+  compaction_worker_->Join();
+  for (const auto &worker : subcompaction_workers_) {
+    worker->Stop();
+    worker->Join();
+  }
+  DeleteObsoleteFiles();
+}
+
+auto DB::Open(string_view dbname, const DBOptions &options, std::unique_ptr<DB> &db) -> RC {
+  if (!FileManager::Exists(dbname)) {
+    if (!options.create_if_not_exists_) {
+      return RC::NOT_FOUND;
+    }
+    if (auto rc = FileManager::Create(dbname, FileOptions::DIR_); rc != RC::OK) {
+      return rc;
+    }
+  }
+  std::unique_ptr<DB> opened(new DB(dbname, options));
+  /* 二级缓存在读取任何表之前设置，打开失败时 DB 打开失败 */
+  if (!options.secondary_cache_options_.path_.empty()) {
+    if (auto rc = SecondaryCache::Open(options.secondary_cache_options_, opened->secondary_cache_); rc != RC::OK) {
+      return rc;
+    }
+    opened->block_cache_->SetSecondaryCache(opened->secondary_cache_.get());
+  }
+  if (auto rc = opened->Recover(); rc != RC::OK) {
+    return rc;
+  }
+  {
+    std::lock_guard<std::mutex> lock(opened->mutex_);
+    opened->MaybeScheduleCompaction();
+  }
+  db = std::move(opened);
+  return RC::OK;
+}
+
+/*
+**********************************************************************************************************************************************
+* 恢复
+**********************************************************************************************************************************************
+*/
+
+/* 先恢复 Version，再按编号从小到大回放 WAL，最后打开新的 WAL */
+auto DB::Recover() -> RC {
+  if (auto rc = versions_.Recover(); rc != RC::OK) {
+    return rc;
+  }
+  auto version = versions_.Current();
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    for (const auto &file : version->Files(level)) {
+      filter_stats_.AddFilter(level, file->filter_size_);
+    }
+  }
+  version.reset();
+  string wal_dir = WalDir(dbname_);
+  if (!FileManager::Exists(wal_dir)) {
+    if (auto rc = FileManager::Create(wal_dir, FileOptions::DIR_); rc != RC::OK) {
+      return rc;
+    }
+  }
+  vector<int64_t> log_numbers;
+  if (auto rc = FileManager::ReadDir(
+          wal_dir, [](string_view name) { return name.ends_with(".wal"); },
+          [&](string_view name) {
+            int64_t log_number;
+            ParseWalFile(name, log_number);
+            log_numbers.push_back(log_number);
+          });
+      rc != RC::OK) {
+    return rc;
+  }
+  std::sort(log_numbers.begin(), log_numbers.end());
+  for (auto log_number : log_numbers) {
+    if (auto rc = RecoverWAL(log_number); rc != RC::OK) {
+      return rc;
+    }
+    log_number_ = log_number + 1;
+  }
+
+  WAL *wal;
+  if (auto rc = FileManager::OpenWAL(dbname_, log_number_++, &wal); rc != RC::OK) {
+    return rc;
+  }
+  mem_ = std::make_shared<MemTable>(options_, wal);
+  return RC::OK;
+}
+
+/* WAL 末尾不完整的记录是写入时崩溃留下的，之前的记录都已经回放 */
+auto DB::RecoverWAL(int64_t log_number) -> RC {
+  std::unique_ptr<WALReader> reader;
+  if (auto rc = FileManager::OpenWALReader(dbname_, log_number, reader); rc != RC::OK) {
+    return rc;
+  }
+  MemTable memtable(options_);
+  int64_t  max_seq = versions_.LastSequence();
+  string   record;
+  RC       rc;
+  while ((rc = reader->ReadRecord(record)) == RC::OK) {
+    MemKey key;
+    string value;
+    DecodeKVPair(record, key, value);
+    memtable.Put(key, value);
+    max_seq = std::max(max_seq, key.seq_);
+  }
+  if (rc != RC::FILE_EOF) {
+    MLog->warn("wal {} ends with a bad record: {}", log_number, RcToString(rc));
+  }
+  reader->Close();
+
+  FileMetaData *raw_meta;
+  int bits_per_key = versions_.Current()->FilterBitsPerKey(options_, 0, memtable.NumEntries());
+  if (rc = memtable.BuildSSTable(dbname_, &raw_meta, bits_per_key); rc != RC::OK) {
+    return rc;
+  }
+  std::unique_ptr<FileMetaData> meta(raw_meta);
+  VersionEdit                   edit;
+  if (meta) {
+    edit.AddFile(0, *meta);
+  }
+  edit.SetLastSequence(max_seq);
+  if (rc = versions_.LogAndApply(edit); rc != RC::OK) {
+    return rc;
+  }
+  if (meta) {
+    filter_stats_.AddFilter(0, meta->filter_size_);
+  }
+  return FileManager::Destroy(WalFile(WalDir(dbname_), log_number));
+}
+
+/*
+**********************************************************************************************************************************************
+* 写入与 flush
+**********************************************************************************************************************************************
+*/
+
+auto DB::Put(string_view key, string_view value) -> RC { return Write(key, value, OperatorType::PUT); }
+
+auto DB::Delete(string_view key) -> RC { return Write(key, "", OperatorType::DELETE); }
+
+/* 写入在锁内串行执行，写入内存表之后才更新最大序列号，读取只会看到完整的写入 */
+auto DB::Write(string_view key, string_view value, OperatorType type) -> RC {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (auto rc = MakeRoomForWrite(lock); rc != RC::OK) {
+    return rc;
+  }
+  int64_t seq = versions_.LastSequence() + 1;
+  if (auto rc = mem_->PutTeeWAL(MemKey(key, seq, type), value); rc != RC::OK) {
+    return rc;
+  }
+  if (row_cache_) {
+    row_cache_->RecordWrite(key, seq);
+  }
+  versions_.SetLastSequence(seq);
+  return RC::OK;
+}
+
+auto DB::MakeRoomForWrite(std::unique_lock<std::mutex> &lock) -> RC {
+  while (true) {
+    if (bg_error_ != RC::OK) {
+      return bg_error_;
+    }
+    if (mem_->GetMemTableSize() < options_.mem_table_size_) {
+      return RC::OK;
+    }
+    if (static_cast<int>(imms_.size()) >= std::max(options_.max_immutable_mem_tables_, 1)) {
+      write_stalls_++;
+      MLog->info("{} immutable memtables waiting for flush, write stalled", imms_.size());
+      cond_.wait(lock);
+      continue;
+    }
+    if (auto rc = SwitchMemTable(); rc != RC::OK) {
+      return rc;
+    }
+  }
+}
+
+/* 调用方持有 mutex_ */
+auto DB::SwitchMemTable() -> RC {
+  WAL *wal;
+  if (auto rc = FileManager::OpenWAL(dbname_, log_number_, &wal); rc != RC::OK) {
+    return rc;
+  }
+  log_number_++;
+  imms_.push_front(std::move(mem_));
+  mem_ = std::make_shared<MemTable>(options_, wal);
+  flush_worker_->Add([this]() { BackgroundFlush(); });
+  return RC::OK;
+}
+
+/**
+ * @brief flush 最旧的不可变内存表
+ * @details 只有一个 flush Worker，任务按冻结的顺序执行，L0 文件按 max_seq_ 排列，越晚 flush 的越新。
+ *          新的 Version 生效之后才删除 WAL 和移除不可变内存表；失败时记录错误，之后的写入都返回该错误。
+ */
+void DB::BackgroundFlush() {
+  std::shared_ptr<MemTable> imm;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (imms_.empty() || bg_error_ != RC::OK) {
+      return;
+    }
+    imm = imms_.back();
+  }
+  FileMetaData *raw_meta;
+  int           bits_per_key = versions_.Current()->FilterBitsPerKey(options_, 0, imm->NumEntries());
+  auto          rc           = imm->BuildSSTable(dbname_, &raw_meta, bits_per_key);
+  std::unique_ptr<FileMetaData> meta(raw_meta);
+  if (rc == RC::OK && meta) {
+    VersionEdit edit;
+    edit.AddFile(0, *meta);
+    rc = versions_.LogAndApply(edit);
+    if (rc == RC::OK) {
+      filter_stats_.AddFilter(0, meta->filter_size_);
+    }
+  }
+  if (rc == RC::OK) {
+    rc = imm->DropWAL();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (rc != RC::OK) {
+    MLog->error("flush memtable failed: {}", RcToString(rc));
+    bg_error_ = rc;
+  } else {
+    imms_.pop_back();
+    MaybeScheduleCompaction();
+  }
+  cond_.notify_all();
+}
+
+auto DB::Flush() -> RC {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (!mem_->Empty()) {
+    while (static_cast<int>(imms_.size()) >= std::max(options_.max_immutable_mem_tables_, 1) &&
+           bg_error_ == RC::OK) {
+      cond_.wait(lock);
+    }
+    if (bg_error_ != RC::OK) {
+      return bg_error_;
+    }
+    if (auto rc = SwitchMemTable(); rc != RC::OK) {
+      return rc;
+    }
+  }
+  cond_.wait(lock, [this]() { return imms_.empty() || bg_error_ != RC::OK; });
+  return bg_error_;
+}
+
+auto DB::NumImmutableMemTables() -> int {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int>(imms_.size());
+}
+
+auto DB::WriteStalls() -> uint64_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return write_stalls_;
+}
+
+/*
+**********************************************************************************************************************************************
+* 读取
+**********************************************************************************************************************************************
+*/
+
+auto DB::Get(string_view key, string &value) -> RC { return GetImpl(key, std::nullopt, value); }
+
+auto DB::Get(string_view key, string &value, int64_t snapshot) -> RC { return GetImpl(key, snapshot, value); }
+
+auto DB::GetSnapshot() -> int64_t {
+  std::lock_guard<std::mutex> lock(mutex_);
+  int64_t                     snapshot = versions_.LastSequence();
+  snapshots_.insert(snapshot);
+  return snapshot;
+}
+
+void DB::ReleaseSnapshot(int64_t snapshot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto iter = snapshots_.find(snapshot); iter != snapshots_.end()) {
+    snapshots_.erase(iter);
+  }
+}
+
+/* 不带快照时序列号与 Version 在同一个锁内取得，之后的 compaction 不会丢弃该序列号能看到的版本 */
+auto DB::GetImpl(string_view key, std::optional<int64_t> snapshot, string &value) -> RC {
+  std::shared_ptr<MemTable>             mem;
+  std::deque<std::shared_ptr<MemTable>> imms;
+  std::shared_ptr<const Version>        version;
+  int64_t                               seq;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mem     = mem_;
+    imms    = imms_;
+    version = versions_.Current();
+    seq     = snapshot.value_or(versions_.LastSequence());
+  }
+
+  OperatorType type;
+  if (mem->Lookup(key, seq, value, type) == RC::OK) {
+    return type == OperatorType::PUT ? RC::OK : RC::NOT_FOUND;
+  }
+  for (const auto &imm : imms) {
+    if (imm->Lookup(key, seq, value, type) == RC::OK) {
+      return type == OperatorType::PUT ? RC::OK : RC::NOT_FOUND;
+    }
+  }
+
+  /* 内存表中没有 seq 可见的版本，结果只取决于 SSTable，可以使用和填充行缓存 */
+  bool cached_found;
+  if (row_cache_ && row_cache_->Lookup(key, seq, cached_found, value)) {
+    return cached_found ? RC::OK : RC::NOT_FOUND;
+  }
+
+  LookupContext ctx(key, options_.prefix_extractor_.get());
+  string        inner_key = MemKey(key, seq, OperatorType::DELETE).ToSSTableKey();
+  string        found_key;
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    const auto &files = version->Files(level);
+    /* L0 从新到旧依次查找；其他层的文件互不重叠，最多一个文件覆盖该 key */
+    auto begin = files.begin();
+    if (level > 0) {
+      begin = std::lower_bound(files.begin(), files.end(), key, [](const auto &file, string_view user_key) {
+        return file->max_inner_key_.user_key_ < user_key;
+      });
+    }
+    for (auto iter = begin; iter != files.end(); ++iter) {
+      const auto &file = **iter;
+      if (file.min_inner_key_.user_key_ > key || file.max_inner_key_.user_key_ < key) {
+        if (level > 0) {
+          break;
+        }
+        continue;
+      }
+      auto rc = GetFromTable(file, ctx, inner_key, found_key, value);
+      if (rc == RC::OK) {
+        bool found = InnerKeyOpType(found_key) == OperatorType::PUT;
+        if (row_cache_) {
+          row_cache_->Insert(key, seq, InnerKeySeq(found_key), found, value);
+        }
+        return found ? RC::OK : RC::NOT_FOUND;
+      }
+      if (rc != RC::NOT_FOUND) {
+        return rc;
+      }
+      if (level > 0) {
+        break;
+      }
+    }
+  }
+  if (row_cache_) {
+    row_cache_->Insert(key, seq, 0, false, {});
+  }
+  return RC::NOT_FOUND;
+}
+
+/**
+ * @brief 批量读取，每个 key 的结果与 Get 相同
+ * @details 内存表和不可变内存表中没有的 key 先查行缓存，未命中的按 user_key 排序后逐层查找：
+ *          L0 从新到旧，每个文件一次查找所有落在其范围内、还没有结果的 key；L1 及以下按覆盖的文件分组，
+ *          每个文件一次查找。同一个文件中的 key 通过 SSTableReader::MultiGet 批量探测过滤器，结果放入行缓存。
+ */
+void DB::MultiGet(const vector<string_view> &keys, vector<string> &values, vector<RC> &rcs) {
+  std::shared_ptr<MemTable>             mem;
+  std::deque<std::shared_ptr<MemTable>> imms;
+  std::shared_ptr<const Version>        version;
+  int64_t                               seq;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mem     = mem_;
+    imms    = imms_;
+    version = versions_.Current();
+    seq     = versions_.LastSequence();
+  }
+
+  values.assign(keys.size(), {});
+  rcs.assign(keys.size(), RC::NOT_FOUND);
+  vector<size_t> pending;
+  for (size_t i = 0; i < keys.size(); i++) {
+    OperatorType type;
+    bool         found = mem->Lookup(keys[i], seq, values[i], type) == RC::OK;
+    for (auto iter = imms.begin(); !found && iter != imms.end(); ++iter) {
+      found = (*iter)->Lookup(keys[i], seq, values[i], type) == RC::OK;
+    }
+    bool cached_found;
+    if (found) {
+      rcs[i] = type == OperatorType::PUT ? RC::OK : RC::NOT_FOUND;
+    } else if (row_cache_ && row_cache_->Lookup(keys[i], seq, cached_found, values[i])) {
+      rcs[i] = cached_found ? RC::OK : RC::NOT_FOUND;
+    } else {
+      pending.push_back(i);
+    }
+  }
+  std::stable_sort(pending.begin(), pending.end(), [&](size_t a, size_t b) { return keys[a] < keys[b]; });
+
+  vector<LookupContext> ctxs;
+  vector<string>        inner_keys(keys.size());
+  ctxs.reserve(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    ctxs.emplace_back(keys[i], options_.prefix_extractor_.get());
+  }
+  for (auto i : pending) {
+    inner_keys[i] = MemKey(keys[i], seq, OperatorType::DELETE).ToSSTableKey();
+  }
+
+  /* 在 file 中查找 batch 中的 key，找到条目（包括删除标记）或出错的 key 在 done 中标记，found_seqs 为条目的序列号 */
+  vector<char>    done(keys.size(), 0);
+  vector<int64_t> found_seqs(keys.size(), 0);
+  vector<size_t>  searched = pending;
+  auto            search   = [&](const FileMetaData &file, const vector<size_t> &batch) {
+    TableCache::Handle            handle;
+    auto                          rc = FindTable(file, handle);
+    vector<const LookupContext *> batch_ctxs;
+    vector<string_view>           batch_keys;
+    vector<string>                found_keys;
+    vector<string>                found_values;
+    vector<RC>                    found_rcs;
+    if (rc == RC::OK) {
+      for (auto i : batch) {
+        batch_ctxs.push_back(&ctxs[i]);
+        batch_keys.emplace_back(inner_keys[i]);
+      }
+      rc = (*handle)->MultiGet(batch_ctxs, batch_keys, found_keys, found_values, found_rcs);
+    }
+    for (size_t j = 0; j < batch.size(); j++) {
+      size_t i = batch[j];
+      if (rc != RC::OK) {
+        rcs[i]  = rc;
+        done[i] = 1;
+      } else if (found_rcs[j] == RC::OK) {
+        done[i]       = 1;
+        found_seqs[i] = InnerKeySeq(found_keys[j]);
+        if (InnerKeyOpType(found_keys[j]) == OperatorType::PUT) {
+          rcs[i]    = RC::OK;
+          values[i] = std::move(found_values[j]);
+        }
+      }
+    }
+  };
+  auto in_range = [&](const FileMetaData &file, size_t i) {
+    return file.min_inner_key_.user_key_ <= keys[i] && keys[i] <= file.max_inner_key_.user_key_;
+  };
+
+  for (int level = 0; level < K_NUM_LEVELS && !pending.empty(); level++) {
+    const auto &files = version->Files(level);
+    if (level == 0) {
+      for (const auto &file : files) {
+        vector<size_t> batch;
+        for (auto i : pending) {
+          if (!done[i] && in_range(*file, i)) {
+            batch.push_back(i);
+          }
+        }
+        if (!batch.empty()) {
+          search(*file, batch);
+        }
+      }
+    } else {
+      /* pending 有序，覆盖各个 key 的文件也有序，相同文件的 key 相邻 */
+      vector<size_t> batch;
+      size_t         batch_file = files.size();
+      for (auto i : pending) {
+        auto iter = std::lower_bound(files.begin(), files.end(), keys[i], [](const auto &file, string_view key) {
+          return file->max_inner_key_.user_key_ < key;
+        });
+        if (iter == files.end() || !in_range(**iter, i)) {
+          continue;
+        }
+        auto file_index = static_cast<size_t>(iter - files.begin());
+        if (file_index != batch_file && !batch.empty()) {
+          search(*files[batch_file], batch);
+          batch.clear();
+        }
+        batch_file = file_index;
+        batch.push_back(i);
+      }
+      if (!batch.empty()) {
+        search(*files[batch_file], batch);
+      }
+    }
+    pending.erase(std::remove_if(pending.begin(), pending.end(), [&](size_t i) { return done[i] != 0; }),
+                  pending.end());
+  }
+  if (row_cache_) {
+    for (auto i : searched) {
+      if (rcs[i] == RC::OK || rcs[i] == RC::NOT_FOUND) {
+        row_cache_->Insert(keys[i], seq, found_seqs[i], rcs[i] == RC::OK, values[i]);
+      }
+    }
+  }
+}
+
+/* 表缓存未命中时由 OpenTable 按 file 中的路径、层和全局序列号打开 */
+auto DB::FindTable(const FileMetaData &file, TableCache::Handle &handle) -> RC {
+  return table_cache_.FindTable(TableId(file.FileId(), file.belong_to_level_), file, handle);
+}
+
+auto DB::GetFromTable(const FileMetaData &file, const LookupContext &ctx, string_view inner_key, string &key,
+                      string &value) -> RC {
+  TableCache::Handle handle;
+  if (auto rc = FindTable(file, handle); rc != RC::OK) {
+    return rc;
+  }
+  return (*handle)->Get(ctx, inner_key, key, value);
+}
+
+auto DB::OpenTable(const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) -> RC {
+  if (auto rc = SSTableReader::Open(SstFile(SstDir(dbname_), file.GetOid()), options_, file.belong_to_level_,
+                                    block_cache_.get(), &filter_stats_, reader);
+      rc != RC::OK) {
+    return rc;
+  }
+  reader->SetGlobalSequence(file.global_seq_);
+  return RC::OK;
+}
+
+void DB::EvictTable(uint64_t file_id, int level) { table_cache_.Evict(TableId(file_id, level)); }
+
+/*
+**********************************************************************************************************************************************
+* 导入外部文件
+**********************************************************************************************************************************************
+*/
+
+auto DB::MemTablesOverlap(string_view smallest, string_view largest) -> bool {
+  return mem_->OverlapUserKeyRange(smallest, largest) ||
+         std::any_of(imms_.begin(), imms_.end(),
+                     [&](const auto &imm) { return imm->OverlapUserKeyRange(smallest, largest); });
+}
+
+/**
+ * @details 与内存表重叠时 flush 内存表。compaction 合并的有序段之间可能有空隙，输出文件跨过空隙，
+ *          导入的文件落在空隙中时 PickLevel 可能把它放入 compaction 的输出层，compaction 生效时两者重叠。
+ *          所以还要等待正在执行的 compaction 结束，调用方增加 ingestions_waiting_ 使期间不再调度新的 compaction。
+ *          等待时会释放锁，期间的写入可能再次与导入的 key 范围重叠，所以每次醒来都重新检查。
+ */
+auto DB::WaitForIngestion(const vector<FileMetaData> &files, std::unique_lock<std::mutex> &lock) -> RC {
+  while (true) {
+    if (bg_error_ != RC::OK) {
+      return bg_error_;
+    }
+    bool overlap = std::any_of(files.begin(), files.end(), [this](const FileMetaData &file) {
+      return MemTablesOverlap(file.min_inner_key_.user_key_, file.max_inner_key_.user_key_);
+    });
+    if (!overlap && !compaction_scheduled_) {
+      return RC::OK;
+    }
+    if (overlap && !mem_->Empty() && static_cast<int>(imms_.size()) < std::max(options_.max_immutable_mem_tables_, 1)) {
+      if (auto rc = SwitchMemTable(); rc != RC::OK) {
+        return rc;
+      }
+    }
+    cond_.wait(lock);
+  }
+}
+
+auto DB::IngestExternalFile(const vector<string> &paths, const IngestExternalFileOptions &ingest_options) -> RC {
+  ExternalFileIngestionJob job(dbname_, options_, ingest_options, &versions_);
+  if (auto rc = job.Prepare(paths); rc != RC::OK) {
+    return rc;
+  }
+  /* 链接或拷贝文件与序列号和层无关，在持有 mutex_ 之前完成，拷贝大文件时不阻塞读写和 flush */
+  if (auto rc = job.InstallFiles(); rc != RC::OK) {
+    return rc;
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  ingestions_waiting_++;
+  auto rc = WaitForIngestion(job.Files(), lock);
+  if (rc == RC::OK) {
+    rc = job.Apply();
+  }
+  ingestions_waiting_--;
+  if (rc != RC::OK) {
+    MaybeScheduleCompaction();
+    return rc;
+  }
+  /* 导入的 key 不经过 Write，全局序列号为 0 时也不推进序列号：推进一个序列号，使行缓存中之前的结果对之后的读取失效。
+     期间持有 mutex_，读取不会同时取到导入之后的 Version 和导入之前的序列号 */
+  if (row_cache_) {
+    int64_t seq = versions_.LastSequence() + 1;
+    row_cache_->RecordWriteAll(seq);
+    versions_.SetLastSequence(seq);
+  }
+  for (const auto &file : job.Files()) {
+    filter_stats_.AddFilter(file.belong_to_level_, file.filter_size_);
+  }
+  MaybeScheduleCompaction();
+  return RC::OK;
+}
+
+/*
+**********************************************************************************************************************************************
+* compaction
+**********************************************************************************************************************************************
+*/
+
+void DB::MaybeScheduleCompaction() {
+  if (compaction_scheduled_ || ingestions_waiting_ > 0 || shutting_down_ || bg_error_ != RC::OK ||
+      !compaction_picker_->NeedsCompaction(*versions_.Current())) {
+    return;
+  }
+  compaction_scheduled_ = true;
+  compaction_worker_->Add([this]() { BackgroundCompaction(); });
+}
+
+/* 每次执行一个 compaction，完成后重新检查，直到不再需要 compaction */
+void DB::BackgroundCompaction() {
+  auto rc         = RC::OK;
+  auto version    = versions_.Current();
+  auto compaction = compaction_picker_->PickCompaction(*version);
+  if (compaction) {
+    compaction->input_version_ = std::move(version);
+    /* 之后创建的快照比所有输入的版本都新，只能看到每个 user_key 最新的版本，不需要加入 snapshots_ */
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      compaction->snapshots_.assign(snapshots_.begin(), snapshots_.end());
+    }
+    rc = RunCompaction(*compaction);
+    /* 释放对输入文件和 Version 的引用，之后才能删除输入文件 */
+    compaction.reset();
+  }
+  version.reset();
+  DeleteObsoleteFiles();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  compaction_scheduled_ = false;
+  if (rc != RC::OK) {
+    MLog->error("compaction failed: {}", RcToString(rc));
+    bg_error_ = rc;
+  }
+  MaybeScheduleCompaction();
+  cond_.notify_all();
+}
+
+/**
+ * @brief 执行 compaction 并生效
+ * @details 只有一个文件且输出层没有重叠时直接修改文件所在的层，不重写数据。否则输入文件在新的 Version 生效后
+ *          成为待删除的文件；输出文件与某个输入文件内容相同时两者是同一个文件，不删除。
+ */
+auto DB::RunCompaction(const Compaction &compaction) -> RC {
+  if (compaction.IsTrivialMove()) {
+    const auto &file = compaction.inputs_[0].files_[0];
+    VersionEdit edit;
+    edit.DeleteFile(compaction.inputs_[0].level_, file->GetOid());
+    edit.AddFile(compaction.output_level_, *file);
+    if (auto rc = versions_.LogAndApply(edit); rc != RC::OK) {
+      return rc;
+    }
+    filter_stats_.RemoveFilter(compaction.inputs_[0].level_, file->filter_size_);
+    filter_stats_.AddFilter(compaction.output_level_, file->filter_size_);
+    /* 之后的读取按新的层打开，原来的层打开的表只有持有旧 Version 的读取还会用到 */
+    EvictTable(file->FileId(), compaction.inputs_[0].level_);
+    CompactionStats stats;
+    stats.trivial_moves_ = 1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    compaction_stats_[compaction.output_level_].Add(stats);
+    return RC::OK;
+  }
+
+  CompactionJob job(dbname_, options_, compaction, subcompaction_workers_);
+  if (auto rc = job.Run(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = job.Install(&versions_); rc != RC::OK) {
+    return rc;
+  }
+  for (const auto &meta : job.Outputs()) {
+    filter_stats_.AddFilter(compaction.output_level_, meta.filter_size_);
+  }
+  const auto &stats = job.Stats();
+  MLog->info(
+      "compacted {} files ({} bytes) to {} files ({} bytes) in level {} with {} subcompactions, dropped {} obsolete "
+      "entries and {} tombstones",
+      stats.input_files_, stats.bytes_read_, stats.output_files_, stats.bytes_written_, compaction.output_level_,
+      stats.subcompactions_, stats.dropped_obsolete_entries_, stats.dropped_tombstones_);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  compaction_stats_[compaction.output_level_].Add(stats);
+  for (const auto &inputs : compaction.inputs_) {
+    for (const auto &file : inputs.files_) {
+      bool is_output = std::any_of(job.Outputs().begin(), job.Outputs().end(),
+                                   [&](const FileMetaData &meta) { return meta.GetOid() == file->GetOid(); });
+      if (is_output) {
+        filter_stats_.RemoveFilter(inputs.level_, file->filter_size_);
+      } else {
+        obsolete_files_.push_back(file);
+      }
+    }
+  }
+  return RC::OK;
+}
+
+/**
+ * @brief 删除不再被引用的文件，并从表缓存中移除
+ * @details 读取持有 Version 期间文件的引用计数大于 1；新的 Version 只从当前 Version 生成，不会再引用这些文件。
+ *          同样内容的文件可能再次通过导入加入，仍在当前 Version 中的文件不删除。
+ *          文件不再被任何 Version 引用后才从 filter_stats_ 中减去它的过滤器内存。
+ */
+void DB::DeleteObsoleteFiles() {
+  vector<Version::FileRef> deletable;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = std::partition(obsolete_files_.begin(), obsolete_files_.end(),
+                                                      [](const auto &file) { return file.use_count() > 1; });
+    deletable.assign(std::make_move_iterator(iter), std::make_move_iterator(obsolete_files_.end()));
+    obsolete_files_.erase(iter, obsolete_files_.end());
+  }
+  if (deletable.empty()) {
+    return;
+  }
+  auto version = versions_.Current();
+  for (const auto &file : deletable) {
+    /* 再次导入的同一个文件在导入时重新计入 */
+    filter_stats_.RemoveFilter(file->belong_to_level_, file->filter_size_);
+    bool live = false;
+    for (int level = 0; level < K_NUM_LEVELS && !live; level++) {
+      live = std::any_of(version->Files(level).begin(), version->Files(level).end(),
+                         [&](const Version::FileRef &other) { return other->GetOid() == file->GetOid(); });
+    }
+    if (live) {
+      continue;
+    }
+    /* 文件可能经过移动，在多个层打开过 */
+    for (int level = 0; level < K_NUM_LEVELS; level++) {
+      EvictTable(file->FileId(), level);
+    }
+    FileManager::Destroy(SstFile(SstDir(dbname_), file->GetOid()));
+  }
+}
+
+auto DB::GetCompactionStats(int level) -> CompactionStats {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return compaction_stats_[level];
+}
+
+auto DB::WaitForCompaction() -> RC {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return !compaction_scheduled_ || bg_error_ != RC::OK; });
+  return bg_error_;
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,245 @@
+#include "external_file_ingestion.hh"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include "sstable/sstable.hh"
+#include "util/hash_util.hh"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+ExternalFileIngestionJob::ExternalFileIngestionJob(string_view dbname, const DBOptions &options,
+                                                   const IngestExternalFileOptions &ingest_options,
+                                                   VersionSet *versions)
+    : dbname_(dbname), options_(options), ingest_options_(ingest_options), versions_(versions) {}
+
+ExternalFileIngestionJob::~ExternalFileIngestionJob() {
+  for (const auto &path : created_files_) {
+    FileManager::Destroy(path);
+  }
+}
+
+/**
+ * @brief 读取每个文件的属性，按最小 key 排序，检查文件之间不重叠
+ * @return RC 文件中有序列号不为 0 的 key、文件之间重叠时返回 INVALID_ARGUMENT，
+ *            校验内容哈希失败时返回 CHECK_SUM_ERROR
+ */
+auto ExternalFileIngestionJob::Prepare(const vector<string> &paths) -> RC {
+  if (paths.empty()) {
+    return RC::INVALID_ARGUMENT;
+  }
+  vector<std::pair<FileMetaData, string>> files(paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    files[i].second = paths[i];
+    if (auto rc = PrepareFile(paths[i], files[i].first); rc != RC::OK) {
+      return rc;
+    }
+  }
+  std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) {
+    return a.first.min_inner_key_.user_key_ < b.first.min_inner_key_.user_key_;
+  });
+  for (size_t i = 1; i < files.size(); i++) {
+    if (files[i - 1].first.max_inner_key_.user_key_ >= files[i].first.min_inner_key_.user_key_) {
+      MLog->error("external files {} and {} overlap", files[i - 1].second, files[i].second);
+      return RC::INVALID_ARGUMENT;
+    }
+  }
+  files_.clear();
+  paths_.clear();
+  for (auto &[meta, path] : files) {
+    files_.push_back(std::move(meta));
+    paths_.push_back(std::move(path));
+  }
+  return RC::OK;
+}
+
+/* 文件名是内容哈希时（SstFileWriter 生成的文件）直接使用，不需要重新读取整个文件 */
+auto ExternalFileIngestionJob::PrepareFile(string_view path, FileMetaData &meta) const -> RC {
+  std::shared_ptr<SSTableReader> reader;
+  if (auto rc = SSTableReader::Open(path, options_, 0, nullptr, nullptr, reader); rc != RC::OK) {
+    return rc;
+  }
+  const auto *properties = reader->Properties();
+  if (properties == nullptr) {
+    MLog->error("external file {} has no properties block", path);
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  if (properties->max_seq_ != 0) {
+    MLog->error("external file {} has keys with sequence {}", path, properties->max_seq_);
+    return RC::INVALID_ARGUMENT;
+  }
+  if (auto rc = FileManager::GetFileSize(path, meta.file_size_); rc != RC::OK) {
+    return rc;
+  }
+  meta.filter_size_  = reader->FilterSize();
+  meta.num_keys_     = properties->num_entries_;
+  meta.max_seq_      = 0;
+  meta.content_hash_ = reader->ContentHash();
+  meta.min_inner_key_.FromSSTableKey(properties->smallest_key_);
+  meta.max_inner_key_.FromSSTableKey(properties->largest_key_);
+
+  string_view stem = path.substr(path.rfind('/') + 1);
+  if (stem.ends_with(".sst")) {
+    stem.remove_suffix(strlen(".sst"));
+  }
+  bool named_by_hash = stem.size() == ContentDigestLength(meta.content_hash_) * 2 && HexToDigest(stem, meta.sha256_);
+  if (named_by_hash && !ingest_options_.verify_content_hash_) {
+    return RC::OK;
+  }
+  if (auto rc = HashFile(path, meta.content_hash_, meta.sha256_); rc != RC::OK) {
+    return rc;
+  }
+  if (named_by_hash && meta.GetOid() != stem) {
+    MLog->error("content hash of external file {} is {}", path, meta.GetOid());
+    return RC::CHECK_SUM_ERROR;
+  }
+  return RC::OK;
+}
+
+auto ExternalFileIngestionJob::HashFile(string_view path, ContentHashType type, unsigned char *digest) const -> RC {
+  std::unique_ptr<SeqReadFile> file;
+  if (auto rc = FileManager::OpenSeqReadFile(path, file); rc != RC::OK) {
+    return rc;
+  }
+  ContentHasher hasher(type);
+  string        buffer;
+  string_view   data;
+  do {
+    if (auto rc = file->Read(ContentHasher::K_CHUNK_SIZE * 16, buffer, data); rc != RC::OK) {
+      return rc;
+    }
+    hasher.Update(data);
+  } while (!data.empty());
+  hasher.Final(digest);
+  return file->Close();
+}
+
+/**
+ * @brief 把文件链接或拷贝到 sst 目录下
+ * @details 文件名只与内容有关，与全局序列号和层无关，可以在生效之前、不持有锁时放入 sst 目录。
+ *          sst 目录下已有同名文件时不新建；新建的文件在生效之前记录在 created_files_ 中。
+ */
+auto ExternalFileIngestionJob::InstallFiles() -> RC {
+  for (size_t i = 0; i < files_.size(); i++) {
+    bool created = false;
+    if (auto rc = InstallFile(paths_[i], files_[i], created); rc != RC::OK) {
+      return rc;
+    }
+    if (created) {
+      created_files_.push_back(SstFile(SstDir(dbname_), files_[i].GetOid()));
+    }
+  }
+  return RC::OK;
+}
+
+/**
+ * @brief 在 VersionSet 的锁内分配全局序列号、选择层并生效
+ * @details 失败时新建的文件在析构时删除；生效之后 move_files_ 时删除原文件。
+ */
+auto ExternalFileIngestionJob::Apply() -> RC {
+  auto rc = versions_->LogAndApply([this](const Version &version, VersionEdit &edit) {
+    bool overlap = false;
+    for (const auto &meta : files_) {
+      for (int level = 0; level < K_NUM_LEVELS; level++) {
+        overlap =
+            overlap || version.OverlapInLevel(level, meta.min_inner_key_.user_key_, meta.max_inner_key_.user_key_);
+        for (const auto &file : version.Files(level)) {
+          if (file->GetOid() == meta.GetOid()) {
+            MLog->error("external file {} already exists in level {}", meta.GetOid(), level);
+            return RC::EXISTED;
+          }
+        }
+      }
+    }
+    global_seq_ = overlap ? versions_->LastSequence() + 1 : 0;
+    if (overlap) {
+      edit.SetLastSequence(global_seq_);
+    }
+    for (auto &meta : files_) {
+      meta.global_seq_         = global_seq_;
+      meta.max_seq_            = global_seq_;
+      meta.min_inner_key_.seq_ = global_seq_;
+      meta.max_inner_key_.seq_ = global_seq_;
+      meta.belong_to_level_    = PickLevel(version, meta);
+      edit.AddFile(meta.belong_to_level_, meta);
+    }
+    return RC::OK;
+  });
+  if (rc != RC::OK) {
+    return rc;
+  }
+  created_files_.clear();
+  if (ingest_options_.move_files_) {
+    for (size_t i = 0; i < paths_.size(); i++) {
+      if (FileManager::FixFileName(paths_[i]) != SstFile(SstDir(dbname_), files_[i].GetOid())) {
+        FileManager::Destroy(paths_[i]);
+      }
+    }
+  }
+  return RC::OK;
+}
+
+/* 不与任何更浅的层重叠的最深的一层，更新的数据总在更浅的层中 */
+auto ExternalFileIngestionJob::PickLevel(const Version &version, const FileMetaData &meta) const -> int {
+  int target = 0;
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    if (version.OverlapInLevel(level, meta.min_inner_key_.user_key_, meta.max_inner_key_.user_key_)) {
+      break;
+    }
+    target = level;
+  }
+  return target;
+}
+
+auto ExternalFileIngestionJob::InstallFile(string_view path, const FileMetaData &meta, bool &created) const -> RC {
+  string target = SstFile(SstDir(dbname_), meta.GetOid());
+  created       = false;
+  if (FileManager::Exists(target)) {
+    return RC::OK;
+  }
+  if (ingest_options_.move_files_) {
+    auto rc = FileManager::Link(path, target);
+    if (rc == RC::OK) {
+      created = true;
+    }
+    if (rc == RC::OK || rc == RC::EXISTED) {
+      return RC::OK;
+    }
+    MLog->warn("link external file {} failed, fall back to copy", path);
+  }
+  if (auto rc = CopyFile(path, target); rc != RC::OK) {
+    return rc;
+  }
+  created = true;
+  return RC::OK;
+}
+
+auto ExternalFileIngestionJob::CopyFile(string_view path, string_view target) const -> RC {
+  std::unique_ptr<SeqReadFile> src;
+  if (auto rc = FileManager::OpenSeqReadFile(path, src); rc != RC::OK) {
+    return rc;
+  }
+  std::unique_ptr<TempFile> dst;
+  if (auto rc = FileManager::OpenTempFile(SstDir(dbname_), "ingest_", dst); rc != RC::OK) {
+    return rc;
+  }
+  string      buffer;
+  string_view data;
+  do {
+    if (auto rc = src->Read(ContentHasher::K_CHUNK_SIZE * 16, buffer, data); rc != RC::OK) {
+      return rc;
+    }
+    if (auto rc = dst->Append(data); rc != RC::OK) {
+      return rc;
+    }
+  } while (!data.empty());
+  if (auto rc = dst->Sync(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = dst->Close(); rc != RC::OK) {
+    return rc;
+  }
+  return dst->ReName(target);
+}
+
+}  // namespace lsm_tree
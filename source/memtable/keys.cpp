@@ -23,7 +23,7 @@ auto MemKey::operator<(const MemKey &other) const -> bool {
     return ret < 0;
   }
   if (seq_ == other.seq_) {
-    return type_ == OperatorType::DELETE;
+    return type_ == OperatorType::DELETE && other.type_ != OperatorType::DELETE;
   }
   return seq_ > other.seq_;
 }
@@ -73,6 +73,10 @@ auto InnerKeySeq(std::string_view inner_key) -> int64_t {
   memcpy(&seq, &inner_key[inner_key.length() - 9], 8);
   return seq;
 }
+
+/* 原地替换inner_key中的seq，user_key和操作类型不变 */
+void SetInnerKeySeq(std::string &inner_key, int64_t seq) { memcpy(&inner_key[inner_key.length() - 9], &seq, 8); }
+
 /**
  * @brief 获取inner_key中的操作类型
  *
@@ -102,20 +106,7 @@ auto CmpUserKeyOfInnerKey(std::string_view k1, std::string_view k2) -> int {
  * @param k2
  * @return int 0: k1 == k2, 1: k1 > k2, -1: k1 < k2
  */
-auto CmpInnerKey(std::string_view k1, std::string_view k2) -> int {
-  if (int ret = CmpUserKeyOfInnerKey(k1, k2); ret) {
-    return ret;
-  }
-  /* seq op 反过来比较 */
-  int64_t seq1 = InnerKeySeq(k1);
-  int64_t seq2 = InnerKeySeq(k2);
-  if (seq1 == seq2) {
-    OperatorType op1 = InnerKeyOpType(k1);
-    OperatorType op2 = InnerKeyOpType(k2);
-    return static_cast<int>(op2) - static_cast<int>(op1);
-  }
-  return seq2 - seq1 > 0 ? 1 : -1;
-}
+auto CmpInnerKey(std::string_view k1, std::string_view k2) -> int { return InnerKeyComparator()(k1, k2); }
 
 auto CmpKeyAndUserKey(std::string_view key, std::string_view user_key) -> int {
   std::string_view key_user = InnerKeyToUserKey(key);
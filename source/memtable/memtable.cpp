@@ -12,6 +12,8 @@
 #include "memtable/memtable.hh"
 #include <mutex>
 #include <shared_mutex>
+#include "options.hh"
+#include "sstable/sstable.hh"
 #include "util/monitor_logger.hh"
 
 namespace lsm_tree {
@@ -24,6 +26,11 @@ auto MemTable::Empty() -> bool {
   return table_.empty();
 }
 
+auto MemTable::NumEntries() -> size_t {
+  std::shared_lock lock(mtx_);
+  return table_.size();
+}
+
 auto MemTable::Put(const MemKey &key, string_view value) -> RC {
   std::unique_lock lock(mtx_);
   if (key.type_ == OperatorType::PUT) {
@@ -61,9 +68,45 @@ auto MemTable::ForEachNoLock(std::function<RC(const MemKey &key, string_view val
   return RC::OK;
 }
 
-/* 一般是 IMEMTABLE 进行 BUILD 不需要加锁 */
-auto MemTable::BuildSSTable(string_view dbname, FileMetaData **meta_data_pointer) -> RC {
-  // TODO(gsj): 123
+/**
+ * @brief 把内存表写成 SSTable
+ * @details 一般是 IMEMTABLE 进行 BUILD 不需要加锁。先写入 sst 目录下的临时文件，写完后按内容的 SHA-256 重命名，
+ *          失败时删除临时文件。
+ * @param dbname 数据库目录
+ * @param meta_data_pointer 成功时返回新表的元数据，由调用方释放；内存表为空时为 nullptr
+ * @param bits_per_key 过滤器每个 key 的 bit 数，小于 0 时使用 options 中的 bits_per_key_
+ * @return RC
+ */
+auto MemTable::BuildSSTable(string_view dbname, FileMetaData **meta_data_pointer, int bits_per_key) -> RC {
+  *meta_data_pointer = nullptr;
+  if (table_.empty()) {
+    return RC::OK;
+  }
+  string sst_dir = SstDir(dbname);
+  if (!FileManager::Exists(sst_dir)) {
+    if (auto rc = FileManager::Create(sst_dir, FileOptions::DIR_); rc != RC::OK) {
+      return rc;
+    }
+  }
+  std::unique_ptr<TempFile> file;
+  if (auto rc = FileManager::OpenTempFile(sst_dir, "build_", file); rc != RC::OK) {
+    return rc;
+  }
+  string        tmp_path = file->GetPath();
+  auto          meta     = std::make_unique<FileMetaData>();
+  SSTableWriter writer(dbname, file.release(), *options_, bits_per_key);
+
+  auto rc =
+      ForEachNoLock([&](const MemKey &key, string_view value) { return writer.Add(key.ToSSTableKey(), value); });
+  if (rc == RC::OK) {
+    rc = writer.Finish(meta.get());
+  }
+  if (rc != RC::OK) {
+    MLog->error("build sstable failed: {}", RcToString(rc));
+    FileManager::Destroy(tmp_path);
+    return rc;
+  }
+  *meta_data_pointer = meta.release();
   return RC::OK;
 }
 
@@ -91,8 +134,26 @@ auto MemTable::DropWAL() -> RC {
 }
 
 auto MemTable::Get(string_view key, string &value, int64_t seq) -> RC {
-  std::unique_lock lock(mtx_);
-  return GetNoLock(key, value);
+  std::shared_lock lock(mtx_);
+  return GetNoLock(key, value, seq);
+}
+
+/* 同一个seq上DELETE排在PUT之前, 用DELETE查找才不会跳过seq上的删除标记 */
+auto MemTable::Lookup(string_view key, int64_t seq, string &value, OperatorType &type) -> RC {
+  std::shared_lock lock(mtx_);
+  auto             iter = table_.lower_bound(MemKey(key, seq, OperatorType::DELETE));
+  if (iter == table_.end() || iter->first.user_key_ != key) {
+    return RC::NOT_FOUND;
+  }
+  type  = iter->first.type_;
+  value = iter->second;
+  return RC::OK;
+}
+
+auto MemTable::OverlapUserKeyRange(string_view smallest, string_view largest) -> bool {
+  std::shared_lock lock(mtx_);
+  auto             iter = table_.lower_bound(MemKey(smallest, INT64_MAX, OperatorType::DELETE));
+  return iter != table_.end() && iter->first.user_key_ <= largest;
 }
 
 auto MemTable::GetNoLock(string_view key, string &value, int64_t seq) -> RC {
@@ -0,0 +1,58 @@
+#include "row_cache.hh"
+#include <algorithm>
+
+namespace lsm_tree {
+
+/* 槽位个数向上取整到 2 的幂 */
+RowCache::RowCache(size_t capacity, int shard_bits, size_t write_slots) : cache_(capacity, shard_bits) {
+  size_t slots = 1;
+  while (slots < write_slots) {
+    slots <<= 1;
+  }
+  write_slots_mask_ = slots - 1;
+  write_seqs_       = std::make_unique<std::atomic<int64_t>[]>(slots);
+}
+
+void RowCache::RecordWrite(std::string_view user_key, int64_t seq) {
+  auto   &slot = WriteSlot(user_key);
+  int64_t last = slot.load(std::memory_order_relaxed);
+  while (last < seq && !slot.compare_exchange_weak(last, seq, std::memory_order_release, std::memory_order_relaxed)) {
+  }
+}
+
+void RowCache::RecordWriteAll(int64_t seq) {
+  for (size_t i = 0; i <= write_slots_mask_; i++) {
+    int64_t last = write_seqs_[i].load(std::memory_order_relaxed);
+    while (last < seq &&
+           !write_seqs_[i].compare_exchange_weak(last, seq, std::memory_order_release, std::memory_order_relaxed)) {
+    }
+  }
+}
+
+auto RowCache::Lookup(std::string_view user_key, int64_t snapshot, bool &found, std::string &value) -> bool {
+  auto handle = cache_.Lookup(std::string(user_key));
+  if (!handle) {
+    return false;
+  }
+  const Row &row = *handle;
+  if (snapshot < row.found_seq_) {
+    return false;
+  }
+  if (snapshot > row.read_seq_ && WriteSlot(user_key).load(std::memory_order_acquire) > row.read_seq_) {
+    return false;
+  }
+  found = row.found_;
+  if (found) {
+    value = row.value_;
+  }
+  return true;
+}
+
+void RowCache::Insert(std::string_view user_key, int64_t read_seq, int64_t found_seq, bool found,
+                      std::string_view value) {
+  std::string key(user_key);
+  size_t      charge = key.size() + (found ? value.size() : 0) + K_ENTRY_OVERHEAD;
+  cache_.Insert(key, Row{std::string(found ? value : std::string_view()), read_seq, found_seq, found}, charge);
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,275 @@
+#include "secondary_cache.hh"
+#include <fmt/format.h>
+#include <cstring>
+#include "crc32c/crc32c.h"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+SecondaryCache::SecondaryCache(const SecondaryCacheOptions &options) : options_(options) {
+  options_.path_ = FileManager::FixDirName(options.path_);
+}
+
+SecondaryCache::~SecondaryCache() {
+  /* 写队列中还没有写入的块直接丢弃 */
+  if (worker_) {
+    worker_->Stop();
+    worker_->Join();
+  }
+}
+
+/**
+ * @brief 打开二级缓存，目录不存在时创建，目录中遗留的缓存文件会被删除
+ * @param options 二级缓存的配置
+ * @param result 打开的二级缓存
+ * @return RC
+ */
+auto SecondaryCache::Open(const SecondaryCacheOptions &options, std::unique_ptr<SecondaryCache> &result) -> RC {
+  if (options.path_.empty()) {
+    return RC::BAD_FILE_PATH;
+  }
+  string dir = FileManager::FixDirName(options.path_);
+  if (!FileManager::Exists(dir)) {
+    if (auto rc = FileManager::Create(dir, FileOptions::DIR_); rc != RC::OK) {
+      return rc;
+    }
+  } else if (!FileManager::IsDirectory(dir)) {
+    return RC::IS_NOT_DIRECTORY;
+  }
+  auto rc = FileManager::ReadDir(
+      dir, [](string_view name) { return name.ends_with(K_FILE_SUFFIX); },
+      [&](string_view name) { FileManager::Destroy(dir + string(name)); });
+  if (rc != RC::OK) {
+    return rc;
+  }
+
+  result.reset(new SecondaryCache(options));
+  result->worker_ = Worker::NewBackgroundWorker();
+  return RC::OK;
+}
+
+auto SecondaryCache::FileName(uint64_t file_number) const -> string {
+  return fmt::format("{}{:06}{}", options_.path_, file_number, K_FILE_SUFFIX);
+}
+
+/*
+**********************************************************************************************************************************************
+* 读写
+**********************************************************************************************************************************************
+*/
+
+/* 写队列已满时丢弃，块缓存中淘汰的块本来就可以丢弃，不能阻塞淘汰 */
+void SecondaryCache::Insert(const BlockCacheKey &key, string_view block) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_bytes_ + block.size() > options_.max_pending_bytes_) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    auto value            = std::make_shared<const string>(block);
+    auto [iter, inserted] = pending_.try_emplace(key, value);
+    if (!inserted) {
+      pending_bytes_ -= iter->second->size();
+      iter->second = value;
+    }
+    pending_bytes_ += block.size();
+  }
+  inserts_.fetch_add(1, std::memory_order_relaxed);
+  worker_->Add([this, key]() { WritePending(key); });
+}
+
+/**
+ * @brief 先查写队列，再按索引读取缓存文件并校验
+ * @param key 块缓存的 key
+ * @param block 命中时返回块的内容
+ * @return RC OK 命中，NOT_FOUND 未命中，CHECK_SUM_ERROR 记录损坏
+ */
+auto SecondaryCache::Lookup(const BlockCacheKey &key, string &block) -> RC {
+  Location                          location;
+  std::shared_ptr<RandomAccessFile> reader;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto iter = pending_.find(key); iter != pending_.end()) {
+      block = *iter->second;
+      hits_.fetch_add(1, std::memory_order_relaxed);
+      return RC::OK;
+    }
+    auto iter = index_.find(key);
+    if (iter == index_.end()) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return RC::NOT_FOUND;
+    }
+    location = iter->second;
+    /* 文件编号连续，索引中的文件都还没有被删除 */
+    reader = files_[location.file_number_ - files_.front().number_].reader_;
+  }
+
+  string      record(location.size_, '\0');
+  string_view view(record);
+  if (auto rc = reader->Read(location.offset_, location.size_, view, true); rc != RC::OK) {
+    return rc;
+  }
+  uint32_t check_sum;
+  uint64_t cache_id;
+  uint64_t offset;
+  uint32_t block_len;
+  memcpy(&check_sum, record.data(), sizeof(uint32_t));
+  memcpy(&cache_id, record.data() + sizeof(uint32_t), sizeof(uint64_t));
+  memcpy(&offset, record.data() + sizeof(uint32_t) + sizeof(uint64_t), sizeof(uint64_t));
+  memcpy(&block_len, record.data() + sizeof(uint32_t) + sizeof(uint64_t) * 2, sizeof(uint32_t));
+  if (check_sum != crc32c::Crc32c(record.data() + sizeof(uint32_t), record.size() - sizeof(uint32_t)) ||
+      BlockCacheKey(cache_id, offset) != key || block_len + K_HEADER_SIZE != location.size_) {
+    MLog->warn("secondary cache record of ({}, {}) in file {} is corrupted", key.cache_id_, key.offset_,
+               location.file_number_);
+    check_sum_errors_.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto iter = index_.find(key); iter != index_.end() && iter->second.file_number_ == location.file_number_ &&
+                                      iter->second.offset_ == location.offset_) {
+      index_.erase(iter);
+    }
+    return RC::CHECK_SUM_ERROR;
+  }
+  block.assign(record, K_HEADER_SIZE);
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  return RC::OK;
+}
+
+/* 文件中的记录不会被删除，只删除索引，空间在删除整个文件时回收 */
+void SecondaryCache::Erase(const BlockCacheKey &key) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto iter = pending_.find(key); iter != pending_.end()) {
+    pending_bytes_ -= iter->second->size();
+    pending_.erase(iter);
+    pending_cond_.notify_all();
+  }
+  index_.erase(key);
+}
+
+void SecondaryCache::WaitForPendingWrites() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_cond_.wait(lock, [this]() { return pending_.empty(); });
+}
+
+auto SecondaryCache::Stats() const -> SecondaryCacheStats {
+  SecondaryCacheStats stats;
+  stats.inserts_          = inserts_.load(std::memory_order_relaxed);
+  stats.dropped_          = dropped_.load(std::memory_order_relaxed);
+  stats.hits_             = hits_.load(std::memory_order_relaxed);
+  stats.misses_           = misses_.load(std::memory_order_relaxed);
+  stats.check_sum_errors_ = check_sum_errors_.load(std::memory_order_relaxed);
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats.usage_ = usage_;
+  return stats;
+}
+
+/*
+**********************************************************************************************************************************************
+* 后台写入
+**********************************************************************************************************************************************
+*/
+
+/**
+ * @brief 在后台线程中把写队列中的块写入缓存文件
+ * @details 写入期间块仍留在写队列中可以被查找；写入完成后如果块没有被删除或替换，就从写队列移到索引中。
+ * @param key 块缓存的 key
+ */
+void SecondaryCache::WritePending(const BlockCacheKey &key) {
+  std::shared_ptr<const string> block;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto                        iter = pending_.find(key);
+    /* 已经被删除，或者同一个 key 更新的值已经被之前的任务写入 */
+    if (iter == pending_.end()) {
+      return;
+    }
+    block = iter->second;
+  }
+
+  Location location;
+  RC       rc = Append(key, *block, location);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto                        iter = pending_.find(key);
+  if (iter == pending_.end() || iter->second != block) {
+    return;
+  }
+  pending_bytes_ -= block->size();
+  pending_.erase(iter);
+  pending_cond_.notify_all();
+  if (rc != RC::OK) {
+    MLog->warn("write secondary cache file failed: {}", RcToString(rc));
+    return;
+  }
+  index_[key] = location;
+  files_.back().keys_.push_back(key);
+}
+
+/* 追加一条记录并刷到文件中，之后就可以通过 pread 读到；总大小超过容量时删除最早的文件 */
+auto SecondaryCache::Append(const BlockCacheKey &key, string_view block, Location &location) -> RC {
+  auto record_size = static_cast<uint32_t>(K_HEADER_SIZE + block.size());
+  auto block_len   = static_cast<uint32_t>(block.size());
+  if (!writer_ || files_.back().size_ + record_size > options_.file_size_) {
+    if (auto rc = NewFile(); rc != RC::OK) {
+      return rc;
+    }
+  }
+
+  string record;
+  record.reserve(record_size);
+  record.append(sizeof(uint32_t), '\0');
+  record.append(reinterpret_cast<const char *>(&key.cache_id_), sizeof(uint64_t));
+  record.append(reinterpret_cast<const char *>(&key.offset_), sizeof(uint64_t));
+  record.append(reinterpret_cast<const char *>(&block_len), sizeof(uint32_t));
+  record.append(block);
+  uint32_t check_sum = crc32c::Crc32c(record.data() + sizeof(uint32_t), record.size() - sizeof(uint32_t));
+  memcpy(record.data(), &check_sum, sizeof(uint32_t));
+  if (auto rc = writer_->Append(record); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = writer_->Flush(); rc != RC::OK) {
+    return rc;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto                       &file = files_.back();
+  location                         = {file.number_, file.size_, record_size};
+  file.size_ += record_size;
+  usage_ += record_size;
+  while (usage_ > options_.capacity_ && files_.size() > 1) {
+    RemoveOldestFile();
+  }
+  return RC::OK;
+}
+
+auto SecondaryCache::NewFile() -> RC {
+  if (writer_) {
+    writer_->Close();
+  }
+  string path = FileName(next_file_number_);
+  if (auto rc = FileManager::OpenWritAbleFile(path, writer_); rc != RC::OK) {
+    return rc;
+  }
+  RandomAccessFile *reader;
+  if (auto rc = FileManager::OpenRandomAccessFile(path, &reader); rc != RC::OK) {
+    writer_.reset();
+    return rc;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  files_.push_back({.number_ = next_file_number_++, .reader_ = std::shared_ptr<RandomAccessFile>(reader)});
+  return RC::OK;
+}
+
+/* 调用时持有 mutex_。正在读取该文件的查找持有 reader_，文件删除后仍然可以读完 */
+void SecondaryCache::RemoveOldestFile() {
+  auto &file = files_.front();
+  for (const auto &key : file.keys_) {
+    if (auto iter = index_.find(key); iter != index_.end() && iter->second.file_number_ == file.number_) {
+      index_.erase(iter);
+    }
+  }
+  usage_ -= file.size_;
+  FileManager::Destroy(FileName(file.number_));
+  files_.pop_front();
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,60 @@
+#include "sstable/sst_file_writer.hh"
+
+namespace lsm_tree {
+
+auto SstFileWriter::Open(string_view dir) -> RC {
+  if (writer_) {
+    return RC::EXISTED;
+  }
+  std::unique_ptr<TempFile> file;
+  if (auto rc = FileManager::OpenTempFile(dir, "external_", file); rc != RC::OK) {
+    return rc;
+  }
+  dir_    = FileManager::FixDirName(dir);
+  writer_ = std::make_unique<SSTableWriter>(dir_, file.release(), options_);
+  writer_->SetOutputDir(dir_);
+  return RC::OK;
+}
+
+auto SstFileWriter::Put(string_view user_key, string_view value) -> RC {
+  return Add(user_key, value, OperatorType::PUT);
+}
+
+auto SstFileWriter::Delete(string_view user_key) -> RC { return Add(user_key, "", OperatorType::DELETE); }
+
+/* 同一个 user_key 只能有一个版本，序列号都为 0，inner_key 的顺序即 user_key 的顺序 */
+auto SstFileWriter::Add(string_view user_key, string_view value, OperatorType type) -> RC {
+  if (!writer_) {
+    return RC::INVALID_ARGUMENT;
+  }
+  if (writer_->NumEntries() > 0 && user_key <= last_user_key_) {
+    return RC::INVALID_ARGUMENT;
+  }
+  if (auto rc = writer_->Add(MemKey(user_key, 0, type).ToSSTableKey(), value); rc != RC::OK) {
+    return rc;
+  }
+  last_user_key_ = user_key;
+  return RC::OK;
+}
+
+auto SstFileWriter::Finish(ExternalSstFileInfo *info) -> RC {
+  if (!writer_) {
+    return RC::INVALID_ARGUMENT;
+  }
+  FileMetaData meta;
+  auto         rc = writer_->Finish(&meta);
+  writer_.reset();
+  if (rc != RC::OK) {
+    return rc;
+  }
+  if (info != nullptr) {
+    info->file_path_    = SstFile(dir_, meta.GetOid());
+    info->smallest_key_ = meta.min_inner_key_.user_key_;
+    info->largest_key_  = meta.max_inner_key_.user_key_;
+    info->num_entries_  = meta.num_keys_;
+    info->file_size_    = meta.file_size_;
+  }
+  return RC::OK;
+}
+
+}  // namespace lsm_tree
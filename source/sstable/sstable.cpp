@@ -0,0 +1,803 @@
+#include "sstable/sstable.hh"
+#include <algorithm>
+#include <cstring>
+#include "util/encode.hh"
+#include "util/hash_util.hh"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+/*
+**********************************************************************************************************************************************
+* TableProperties
+**********************************************************************************************************************************************
+*/
+
+void TableProperties::EncodeTo(string &dst) const {
+  EncodeWithPreLen(dst, smallest_key_);
+  EncodeWithPreLen(dst, largest_key_);
+  dst.append(reinterpret_cast<const char *>(&num_entries_), sizeof(num_entries_));
+  dst.append(reinterpret_cast<const char *>(&max_seq_), sizeof(max_seq_));
+}
+
+auto TableProperties::DecodeFrom(string_view src) -> RC {
+  for (auto *key : {&smallest_key_, &largest_key_}) {
+    int len;
+    if (src.size() < sizeof(len)) {
+      return RC::UN_SUPPORTED_FORMAT;
+    }
+    Decode32(src.data(), &len);
+    if (len < 0 || src.size() - sizeof(len) < static_cast<size_t>(len)) {
+      return RC::UN_SUPPORTED_FORMAT;
+    }
+    key->assign(src.substr(sizeof(len), len));
+    src.remove_prefix(sizeof(len) + len);
+  }
+  if (src.size() != sizeof(num_entries_) + sizeof(max_seq_)) {
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  memcpy(&num_entries_, src.data(), sizeof(num_entries_));
+  memcpy(&max_seq_, src.data() + sizeof(num_entries_), sizeof(max_seq_));
+  return RC::OK;
+}
+
+/*
+**********************************************************************************************************************************************
+* TableBuildPipeline
+**********************************************************************************************************************************************
+*/
+
+TableBuildPipeline::TableBuildPipeline(WritAbleFile *file, ContentHasher *hasher, int max_inflight)
+    : file_(file),
+      content_hasher_(hasher),
+      max_inflight_(std::max(max_inflight, 1)),
+      hasher_(Worker::NewBackgroundWorker()),
+      appender_(Worker::NewBackgroundWorker()) {}
+
+/* 在途的块全部写完后两个队列都为空，此时停止不会丢弃任务 */
+TableBuildPipeline::~TableBuildPipeline() {
+  Wait();
+  hasher_->Stop();
+  appender_->Stop();
+  hasher_->Join();
+  appender_->Join();
+}
+
+/**
+ * @brief 提交一个编码好的块
+ * @details 哈希线程和写线程各自只有一个线程、按 FIFO 顺序执行，块在文件中的顺序与提交顺序一致。
+ *          哈希完成后才把块交给写线程，同一个块不会同时被两个线程访问。
+ * @param block 编码好的块
+ * @return RC 之前的块写入失败时返回该错误，本次的块不再提交
+ */
+auto TableBuildPipeline::Submit(string block) -> RC {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait(lock, [this]() { return inflight_ < max_inflight_; });
+    if (status_ != RC::OK) {
+      return status_;
+    }
+    inflight_++;
+  }
+  auto data = std::make_shared<string>(std::move(block));
+  hasher_->Add([this, data]() {
+    content_hasher_->Update(*data);
+    appender_->Add([this, data]() { Append(*data); });
+  });
+  return RC::OK;
+}
+
+void TableBuildPipeline::Append(string_view block) {
+  bool failed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failed = status_ != RC::OK;
+  }
+  RC rc = failed ? RC::OK : file_->Append(block);
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (status_ == RC::OK) {
+    status_ = rc;
+  }
+  inflight_--;
+  cond_.notify_all();
+}
+
+auto TableBuildPipeline::Wait() -> RC {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this]() { return inflight_ == 0; });
+  return status_;
+}
+
+/*
+**********************************************************************************************************************************************
+* SSTableWriter
+**********************************************************************************************************************************************
+*/
+
+SSTableWriter::SSTableWriter(string_view dbname, WritAbleFile *file, const DBOptions &options, int bits_per_key)
+    : output_dir_(SstDir(dbname)),
+      file_(file),
+      block_size_(options.block_size_),
+      filter_block_(std::make_unique<BloomFilter>(bits_per_key < 0 ? options.bits_per_key_ : bits_per_key),
+                    options.prefix_extractor_, options.whole_key_filtering_),
+      content_hasher_(options.content_hash_) {
+  if (options.range_filter_depth_ > 0) {
+    range_filter_block_ = std::make_unique<RangeFilterBlockWriter>(options.bits_per_key_, options.range_filter_depth_);
+  }
+  if (options.sstable_build_inflight_blocks_ > 0) {
+    pipeline_ =
+        std::make_unique<TableBuildPipeline>(file_.get(), &content_hasher_, options.sstable_build_inflight_blocks_);
+  }
+}
+
+/**
+ * @brief 向表中添加一个键值对
+ * @details 键值对先加入当前数据块，数据块的大小达到 block_size_ 后立即写入文件，
+ *          内存中只保留当前数据块、索引块和过滤器，不随表的大小增长。
+ * @param key inner_key，必须大于上一次添加的 key
+ * @param value 值
+ * @return RC
+ */
+auto SSTableWriter::Add(string_view key, string_view value) -> RC {
+  if (finished_) {
+    return RC::NEW_SSTABLE_ERROR;
+  }
+  if (num_keys_ > 0 && CmpInnerKey(key, last_key_) <= 0) {
+    MLog->error("SSTableWriter::Add key out of order");
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  string_view user_key     = InnerKeyToUserKey(key);
+  bool        new_user_key = num_keys_ == 0 || user_key != InnerKeyToUserKey(last_key_);
+  /* 过滤器按数据块划分，同一个 user_key 的多个版本跨越数据块时，每个数据块的过滤器都要包含它 */
+  if (new_user_key || data_block_.Empty()) {
+    filter_block_.Update(user_key);
+  }
+  if (new_user_key && range_filter_block_) {
+    range_filter_block_->Update(user_key);
+  }
+  if (num_keys_ == 0) {
+    first_key_ = key;
+  }
+  data_block_.Add(key, value);
+  last_key_ = key;
+  num_keys_++;
+  max_seq_ = std::max(max_seq_, InnerKeySeq(key));
+
+  if (data_block_.EstimatedSize() >= block_size_) {
+    return FlushDataBlock();
+  }
+  return RC::OK;
+}
+
+/* 写入当前数据块，并为它生成索引项和过滤器 */
+auto SSTableWriter::FlushDataBlock() -> RC {
+  if (data_block_.Empty()) {
+    return RC::OK;
+  }
+  data_block_.Final(buffer_);
+  data_block_.Reset();
+  if (auto rc = WriteBlock(buffer_, data_block_handle_); rc != RC::OK) {
+    return rc;
+  }
+  string index_value;
+  data_block_handle_.EncodeMeta(index_value);
+  index_value.append(reinterpret_cast<const char *>(&data_blocks_), sizeof(int));
+  index_block_.Add(last_key_, index_value);
+  filter_block_.Keys2Block();
+  data_blocks_++;
+  return RC::OK;
+}
+
+/* 块的内容同时计入 SHA-256，文件名由全部内容决定；块的位置在提交时就已确定，不需要等待写入完成 */
+auto SSTableWriter::WriteBlock(string &block, BlockHandle &handle) -> RC {
+  handle.SetMeta(static_cast<int>(offset_), static_cast<int>(block.size()));
+  offset_ += block.size();
+  if (pipeline_) {
+    return pipeline_->Submit(std::move(block));
+  }
+  if (auto rc = file_->Append(block); rc != RC::OK) {
+    return rc;
+  }
+  content_hasher_.Update(block);
+  return RC::OK;
+}
+
+auto SSTableWriter::AddMetaBlock(string_view name, BlockHandle &handle) -> RC {
+  if (auto rc = WriteBlock(buffer_, handle); rc != RC::OK) {
+    return rc;
+  }
+  string encoded;
+  handle.EncodeMeta(encoded);
+  return meta_data_block_.Add(name, encoded);
+}
+
+/**
+ * @brief 写入最后一个数据块、过滤器块、元数据块、索引块和尾信息块
+ * @details 文件写完后 fsync 并关闭，再按内容的 SHA-256 重命名到 sst 目录下，重命名之后的文件才对 DB 可见。
+ *          元数据块中的 key 必须有序，按名字的顺序写入各个块。
+ * @param meta 输出，表的 key 范围、key 个数、最大序列号、文件大小、过滤器块大小和 SHA-256
+ * @return RC
+ */
+auto SSTableWriter::Finish(FileMetaData *meta) -> RC {
+  if (finished_) {
+    return RC::NEW_SSTABLE_ERROR;
+  }
+  finished_ = true;
+  if (num_keys_ == 0) {
+    return RC::NEW_SSTABLE_ERROR;
+  }
+  if (auto rc = FlushDataBlock(); rc != RC::OK) {
+    return rc;
+  }
+
+  /* 过滤器块 */
+  filter_block_.Final(buffer_);
+  if (auto rc = AddMetaBlock(K_FILTER_BLOCK_NAME, filter_block_handle_); rc != RC::OK) {
+    return rc;
+  }
+  /* 属性块 */
+  TableProperties properties;
+  properties.num_entries_  = num_keys_;
+  properties.max_seq_      = max_seq_;
+  properties.smallest_key_ = first_key_;
+  properties.largest_key_  = last_key_;
+  buffer_.clear();
+  properties.EncodeTo(buffer_);
+  if (auto rc = AddMetaBlock(K_PROPERTIES_BLOCK_NAME, properties_block_handle_); rc != RC::OK) {
+    return rc;
+  }
+  /* 范围过滤器块 */
+  if (range_filter_block_) {
+    range_filter_block_->Final(buffer_);
+    if (auto rc = AddMetaBlock(K_RANGE_FILTER_BLOCK_NAME, range_filter_block_handle_); rc != RC::OK) {
+      return rc;
+    }
+  }
+  /* 元数据块 */
+  meta_data_block_.Final(buffer_);
+  if (auto rc = WriteBlock(buffer_, meta_data_block_handle_); rc != RC::OK) {
+    return rc;
+  }
+  /* 索引块 */
+  index_block_.Final(buffer_);
+  if (auto rc = WriteBlock(buffer_, index_block_handle_); rc != RC::OK) {
+    return rc;
+  }
+  /* 尾信息块 */
+  string meta_handle;
+  string index_handle;
+  meta_data_block_handle_.EncodeMeta(meta_handle);
+  index_block_handle_.EncodeMeta(index_handle);
+  foot_block_.Add(meta_handle, index_handle, content_hasher_.Type());
+  if (auto rc = foot_block_.Final(buffer_); rc != RC::OK) {
+    return rc;
+  }
+  BlockHandle footer_handle;
+  if (auto rc = WriteBlock(buffer_, footer_handle); rc != RC::OK) {
+    return rc;
+  }
+
+  if (pipeline_) {
+    if (auto rc = pipeline_->Wait(); rc != RC::OK) {
+      return rc;
+    }
+  }
+  if (auto rc = file_->Sync(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = file_->Close(); rc != RC::OK) {
+    return rc;
+  }
+  content_hasher_.Final(meta->sha256_);
+  meta->content_hash_ = content_hasher_.Type();
+  if (auto rc = file_->ReName(SstFile(output_dir_, meta->GetOid())); rc != RC::OK) {
+    return rc;
+  }
+  meta->file_size_   = offset_;
+  meta->filter_size_ = filter_block_handle_.block_size_;
+  meta->num_keys_    = num_keys_;
+  meta->max_seq_     = max_seq_;
+  meta->min_inner_key_.FromSSTableKey(first_key_);
+  meta->max_inner_key_.FromSSTableKey(last_key_);
+  return RC::OK;
+}
+
+/*
+**********************************************************************************************************************************************
+* BlockBufferPool
+**********************************************************************************************************************************************
+*/
+
+/* 缓冲区释放时放回池中，池满时直接释放 */
+auto BlockBufferPool::Acquire(size_t size) -> std::shared_ptr<string> {
+  unique_ptr<string> buffer;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      buffer = std::move(free_.back());
+      free_.pop_back();
+    }
+  }
+  if (!buffer) {
+    buffer = std::make_unique<string>();
+  }
+  buffer->resize(size);
+  return {buffer.release(), [this](string *released) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (free_.size() < K_MAX_FREE_BUFFERS) {
+              free_.emplace_back(released);
+            } else {
+              delete released;
+            }
+          }};
+}
+
+/*
+**********************************************************************************************************************************************
+* SSTableReader
+**********************************************************************************************************************************************
+*/
+
+SSTableReader::SSTableReader(string_view path, const DBOptions &options, int level, BlockCache *block_cache,
+                             FilterStats *filter_stats)
+    : path_(path), options_(&options), level_(level), block_cache_(block_cache), filter_stats_(filter_stats) {}
+
+SSTableReader::~SSTableReader() {
+  delete mmap_file_;
+  delete random_file_;
+}
+
+auto SSTableReader::Open(string_view path, const DBOptions &options, int level, BlockCache *block_cache,
+                         FilterStats *filter_stats, std::shared_ptr<SSTableReader> &reader) -> RC {
+  std::shared_ptr<SSTableReader> table(new SSTableReader(path, options, level, block_cache, filter_stats));
+  if (auto rc = table->Init(); rc != RC::OK) {
+    MLog->error("open sstable {} failed: {}", path, RcToString(rc));
+    return rc;
+  }
+  reader = std::move(table);
+  return RC::OK;
+}
+
+/**
+ * @brief 打开文件，读取尾信息块和元数据块，解析索引块和过滤器块
+ * @details 解析后的索引块和过滤器块在表打开期间一直持有，点查不再查块缓存、重新解析。
+ *          有块缓存时两个块以高优先级放入块缓存并一直被引用，内存仍计入块缓存的用量；
+ *          打开的表的个数由表缓存限制，常驻的内存随之有上限。
+ * @return RC
+ */
+auto SSTableReader::Init() -> RC {
+  if (auto rc = FileManager::GetFileSize(path_, file_size_); rc != RC::OK) {
+    return rc;
+  }
+  if (file_size_ < FooterBlockWriter::LEGACY_FOOTER_SIZE) {
+    return RC::UN_SUPPORTED_FORMAT;
+  }
+  if (options_->table_read_mode_ == TableReadMode::MMAP) {
+    if (auto rc = FileManager::OpenMmapReadAbleFile(path_, &mmap_file_); rc != RC::OK) {
+      return rc;
+    }
+  } else {
+    if (auto rc = FileManager::OpenRandomAccessFile(path_, &random_file_); rc != RC::OK) {
+      return rc;
+    }
+    if (block_cache_ != nullptr) {
+      cache_id_ = block_cache_->NewId();
+    }
+  }
+
+  /* 尾信息块，旧格式的尾信息块更短，读取末尾最多 FOOTER_SIZE 字节后由 FooterBlockReader 识别 */
+  BlockHandle footer_handle;
+  TableBlock  footer_block;
+  auto        footer_size = std::min<size_t>(file_size_, FooterBlockWriter::FOOTER_SIZE);
+  footer_handle.SetMeta(static_cast<int>(file_size_ - footer_size), static_cast<int>(footer_size));
+  if (auto rc = ReadFromFile(footer_handle, footer_block); rc != RC::OK) {
+    return rc;
+  }
+  FooterBlockReader footer;
+  if (auto rc = footer.Init(footer_block.data_); rc != RC::OK) {
+    return rc;
+  }
+  index_handle_ = footer.IndexBlockHandle();
+  content_hash_ = footer.ContentHash();
+
+  /* 元数据块，只按顺序遍历 */
+  TableBlock meta_data_block;
+  if (auto rc = ReadFromFile(footer.MetaBlockHandle(), meta_data_block); rc != RC::OK) {
+    return rc;
+  }
+  std::shared_ptr<BlockReader> meta_data;
+  if (auto rc = NewBlockReader(std::move(meta_data_block), meta_data); rc != RC::OK) {
+    return rc;
+  }
+  for (auto iter = meta_data->Begin(); iter; ++iter) {
+    iter.Fetch();
+    BlockHandle handle;
+    handle.DecodeFrom(iter.Value());
+    if (iter.Key() == SSTableWriter::K_FILTER_BLOCK_NAME) {
+      filter_handle_ = handle;
+      has_filter_    = true;
+    } else if (iter.Key() == SSTableWriter::K_PROPERTIES_BLOCK_NAME) {
+      TableBlock properties_block;
+      if (auto rc = ReadFromFile(handle, properties_block); rc != RC::OK) {
+        return rc;
+      }
+      if (auto rc = properties_.DecodeFrom(properties_block.data_); rc != RC::OK) {
+        return rc;
+      }
+      has_properties_ = true;
+    } else if (iter.Key() == SSTableWriter::K_RANGE_FILTER_BLOCK_NAME) {
+      TableBlock range_filter_block;
+      if (auto rc = ReadFromFile(handle, range_filter_block); rc != RC::OK) {
+        return rc;
+      }
+      range_filter_data_ = range_filter_block.data_;
+      range_filter_      = std::make_unique<RangeFilterBlockReader>();
+      if (auto rc = range_filter_->Init(range_filter_data_); rc != RC::OK) {
+        return rc;
+      }
+    }
+  }
+
+  /* 索引块和过滤器块 */
+  if (auto rc = ReadIndexBlock(); rc != RC::OK) {
+    return rc;
+  }
+  if (has_filter_) {
+    if (auto rc = ReadFilterBlock(); rc != RC::OK) {
+      return rc;
+    }
+  }
+  return RC::OK;
+}
+
+/* 块的内存由 owner_ 管理，BlockReader 释放时一起释放 */
+auto SSTableReader::NewBlockReader(TableBlock &&block, std::shared_ptr<BlockReader> &reader) -> RC {
+  std::shared_ptr<BlockReader> block_reader(
+      new BlockReader(), [owner = std::move(block.owner_)](BlockReader *released) { delete released; });
+  if (auto rc = block_reader->Init(block.data_, EasyCmp, EasySaveValue); rc != RC::OK) {
+    return rc;
+  }
+  reader = std::move(block_reader);
+  return RC::OK;
+}
+
+/**
+ * @brief 读取一个块，PREAD 且有块缓存时先查块缓存，未命中时读入后放入块缓存
+ * @param handle 块在文件中的位置
+ * @param priority 块在块缓存中的优先级
+ * @param block 读到的块
+ * @return RC
+ */
+auto SSTableReader::ReadBlock(const BlockHandle &handle, CachePriority priority, TableBlock &block) -> RC {
+  if (mmap_file_ != nullptr || block_cache_ == nullptr) {
+    return ReadFromFile(handle, block);
+  }
+  BlockCacheKey key(cache_id_, handle.block_offset_);
+  auto          cached = block_cache_->Lookup(key);
+  if (!cached) {
+    if (handle.block_offset_ < 0 || handle.block_offset_ + static_cast<size_t>(handle.block_size_) > file_size_) {
+      return RC::OUT_OF_RANGE;
+    }
+    string      data(handle.block_size_, '\0');
+    string_view view(data);
+    if (auto rc = random_file_->Read(handle.block_offset_, handle.block_size_, view, true); rc != RC::OK) {
+      return rc;
+    }
+    cached = block_cache_->Insert(key, std::move(data), {}, priority);
+  }
+  auto owner   = std::make_shared<BlockCache::Handle>(std::move(cached));
+  block.data_  = **owner;
+  block.owner_ = std::move(owner);
+  return RC::OK;
+}
+
+/* 不经过块缓存：mmap 直接指向映射区，pread 读入缓冲区池中的缓冲区 */
+auto SSTableReader::ReadFromFile(const BlockHandle &handle, TableBlock &block) -> RC {
+  if (handle.block_offset_ < 0 || handle.block_offset_ + static_cast<size_t>(handle.block_size_) > file_size_) {
+    return RC::OUT_OF_RANGE;
+  }
+  if (mmap_file_ != nullptr) {
+    block.owner_.reset();
+    return mmap_file_->Read(handle.block_offset_, handle.block_size_, block.data_);
+  }
+  auto        buffer = buffer_pool_.Acquire(handle.block_size_);
+  string_view view(*buffer);
+  if (auto rc = random_file_->Read(handle.block_offset_, handle.block_size_, view, true); rc != RC::OK) {
+    return rc;
+  }
+  block.data_  = *buffer;
+  block.owner_ = std::move(buffer);
+  return RC::OK;
+}
+
+auto SSTableReader::ReadIndexBlock() -> RC {
+  TableBlock block;
+  if (auto rc = ReadBlock(index_handle_, CachePriority::HIGH, block); rc != RC::OK) {
+    return rc;
+  }
+  return NewBlockReader(std::move(block), index_block_);
+}
+
+auto SSTableReader::ReadFilterBlock() -> RC {
+  TableBlock block;
+  if (auto rc = ReadBlock(filter_handle_, CachePriority::HIGH, block); rc != RC::OK) {
+    return rc;
+  }
+  std::shared_ptr<FilterBlockReader> reader(
+      new FilterBlockReader(), [owner = std::move(block.owner_)](FilterBlockReader *released) { delete released; });
+  if (auto rc = reader->Init(block.data_, options_->prefix_extractor_.get()); rc != RC::OK) {
+    return rc;
+  }
+  filter_block_ = std::move(reader);
+  return RC::OK;
+}
+
+/* index_value 为索引项的值：BlockHandle + 块的序号 */
+auto SSTableReader::DataBlock(string_view index_value, std::shared_ptr<BlockReader> &data) -> RC {
+  BlockHandle handle;
+  handle.DecodeFrom(index_value);
+  TableBlock block;
+  if (auto rc = ReadBlock(handle, CachePriority::LOW, block); rc != RC::OK) {
+    return rc;
+  }
+  return NewBlockReader(std::move(block), data);
+}
+
+auto SSTableReader::DataBlockNum(string_view index_value) -> int {
+  int block_num;
+  Decode32(index_value.data() + sizeof(int) * 2, &block_num);
+  return block_num;
+}
+
+auto SSTableReader::SampleDataBlocks(vector<std::pair<string, uint64_t>> &samples) -> RC {
+  auto iter = index_block_->Begin();
+  for (iter.Fetch(); iter; ++iter, iter.Fetch()) {
+    BlockHandle handle;
+    handle.DecodeFrom(iter.Value());
+    samples.emplace_back(InnerKeyToUserKey(iter.Key()), handle.block_size_);
+  }
+  return RC::OK;
+}
+
+/**
+ * @brief 点查：索引块定位数据块，过滤器排除后再读取数据块
+ * @details 过滤器按数据块划分，先查索引块得到数据块的序号才能探测对应的过滤器，两者都已在打开时解析并常驻。
+ *          过滤器判断可能存在、但数据块中没有该 user_key 时记为一次误判。
+ *          有全局序列号的表中 key 的序列号都是 0，快照早于全局序列号时看不到表中的数据。
+ */
+auto SSTableReader::Get(const LookupContext &ctx, string_view inner_key, string &key, string &value) -> RC {
+  if (global_seq_ > 0 && InnerKeySeq(inner_key) < global_seq_) {
+    return RC::NOT_FOUND;
+  }
+  auto index_iter = index_block_->Seek(inner_key);
+  if (!index_iter) {
+    return RC::NOT_FOUND;
+  }
+  string_view index_value = index_iter.Value();
+  if (has_filter_) {
+    bool may_match = filter_block_->IsKeyExists(DataBlockNum(index_value), ctx);
+    if (filter_stats_ != nullptr) {
+      filter_stats_->RecordProbe(level_, may_match);
+    }
+    if (!may_match) {
+      return RC::NOT_FOUND;
+    }
+  }
+
+  std::shared_ptr<BlockReader> data;
+  if (auto rc = DataBlock(index_value, data); rc != RC::OK) {
+    return rc;
+  }
+  if (SearchDataBlock(*data, inner_key, key, value)) {
+    return RC::OK;
+  }
+  if (has_filter_ && filter_stats_ != nullptr) {
+    filter_stats_->RecordFalsePositive(level_);
+  }
+  return RC::NOT_FOUND;
+}
+
+auto SSTableReader::MultiGet(const vector<const LookupContext *> &ctxs, const vector<string_view> &inner_keys,
+                             vector<string> &keys, vector<string> &values, vector<RC> &rcs) -> RC {
+  keys.resize(inner_keys.size());
+  values.resize(inner_keys.size());
+  rcs.assign(inner_keys.size(), RC::NOT_FOUND);
+
+  /* 索引块定位数据块，超出表的范围的查询直接排除 */
+  vector<size_t> candidates;
+  vector<string> index_values(inner_keys.size());
+  for (size_t i = 0; i < inner_keys.size(); i++) {
+    if (global_seq_ > 0 && InnerKeySeq(inner_keys[i]) < global_seq_) {
+      continue;
+    }
+    auto index_iter = index_block_->Seek(inner_keys[i]);
+    if (index_iter) {
+      index_values[i] = index_iter.Value();
+      candidates.push_back(i);
+    }
+  }
+
+  if (has_filter_ && !candidates.empty()) {
+    vector<int>                   block_nums;
+    vector<const LookupContext *> probe_ctxs;
+    for (auto i : candidates) {
+      block_nums.push_back(DataBlockNum(index_values[i]));
+      probe_ctxs.push_back(ctxs[i]);
+    }
+    vector<bool> may_match;
+    filter_block_->IsKeysExist(block_nums, probe_ctxs, may_match);
+    size_t matched = 0;
+    for (size_t j = 0; j < candidates.size(); j++) {
+      if (filter_stats_ != nullptr) {
+        filter_stats_->RecordProbe(level_, may_match[j]);
+      }
+      if (may_match[j]) {
+        candidates[matched++] = candidates[j];
+      }
+    }
+    candidates.resize(matched);
+  }
+
+  std::shared_ptr<BlockReader> data;
+  string_view                  data_index_value;
+  for (auto i : candidates) {
+    if (!data || index_values[i] != data_index_value) {
+      if (auto rc = DataBlock(index_values[i], data); rc != RC::OK) {
+        return rc;
+      }
+      data_index_value = index_values[i];
+    }
+    if (SearchDataBlock(*data, inner_keys[i], keys[i], values[i])) {
+      rcs[i] = RC::OK;
+    } else if (has_filter_ && filter_stats_ != nullptr) {
+      filter_stats_->RecordFalsePositive(level_);
+    }
+  }
+  return RC::OK;
+}
+
+/* 有全局序列号时返回的 key 的序列号替换为全局序列号 */
+auto SSTableReader::SearchDataBlock(BlockReader &data, string_view inner_key, string &key, string &value) -> bool {
+  auto iter = data.Seek(inner_key);
+  if (!iter || CmpUserKeyOfInnerKey(iter.Key(), inner_key) != 0) {
+    return false;
+  }
+  key   = iter.Key();
+  value = iter.Value();
+  if (global_seq_ > 0) {
+    SetInnerKeySeq(key, global_seq_);
+  }
+  return true;
+}
+
+auto SSTableReader::MayContainRange(string_view lower, string_view upper) -> bool {
+  if (!range_filter_) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(range_filter_mutex_);
+  return range_filter_->MayContainRange(lower, upper);
+}
+
+auto SSTableReader::NewIterator(const ReadOptions &read_options) -> Iterator {
+  return {shared_from_this(), read_options};
+}
+
+/*
+**********************************************************************************************************************************************
+* SSTableReader::Iterator
+**********************************************************************************************************************************************
+*/
+
+SSTableReader::Iterator::Iterator(std::shared_ptr<SSTableReader> table, const ReadOptions &read_options)
+    : table_(std::move(table)),
+      upper_bound_(read_options.iterate_upper_bound_),
+      has_upper_bound_(!read_options.iterate_upper_bound_.empty()),
+      index_block_(table_->index_block_),
+      prefix_seek_(read_options.prefix_seek_),
+      filter_block_(table_->filter_block_) {}
+
+void SSTableReader::Iterator::SeekToFirst() {
+  valid_       = false;
+  prefix_mode_ = false;
+  if (status_ != RC::OK) {
+    return;
+  }
+  index_iter_ = index_block_->Begin();
+  index_iter_.Fetch();
+  InitDataBlock();
+  if (data_block_) {
+    data_iter_ = data_block_->Begin();
+    data_iter_.Fetch();
+  }
+  SkipEmptyDataBlocks();
+}
+
+/* 有上界时先用范围过滤器判断 [seek key, 上界) 内是否可能有 key，前缀查找时先用表级前缀过滤器判断，
+   不可能时不读取任何数据块 */
+void SSTableReader::Iterator::Seek(string_view inner_key) {
+  valid_       = false;
+  prefix_mode_ = false;
+  if (status_ != RC::OK) {
+    return;
+  }
+  string_view user_key = InnerKeyToUserKey(inner_key);
+  if (has_upper_bound_ && !table_->MayContainRange(user_key, upper_bound_)) {
+    return;
+  }
+  const auto *extractor = table_->options_->prefix_extractor_.get();
+  if (prefix_seek_ && extractor != nullptr && extractor->InDomain(user_key)) {
+    prefix_mode_ = true;
+    prefix_key_.assign(user_key);
+    prefix_.assign(extractor->Transform(user_key));
+    if (filter_block_ && !filter_block_->IsTablePrefixExists(prefix_key_)) {
+      return;
+    }
+  }
+  index_iter_ = index_block_->Seek(inner_key);
+  InitDataBlock();
+  if (data_block_) {
+    data_iter_ = data_block_->Seek(inner_key);
+  }
+  SkipEmptyDataBlocks();
+}
+
+void SSTableReader::Iterator::Next() {
+  ++data_iter_;
+  data_iter_.Fetch();
+  SkipEmptyDataBlocks();
+}
+
+/* 读取索引迭代器当前指向的数据块，索引迭代器越界时清空 */
+void SSTableReader::Iterator::InitDataBlock() {
+  data_block_.reset();
+  data_iter_ = BlockReader::Iterator();
+  if (!index_iter_) {
+    return;
+  }
+  if (prefix_mode_ && filter_block_ &&
+      !filter_block_->IsPrefixExists(DataBlockNum(index_iter_.Value()), prefix_key_)) {
+    index_iter_ = BlockReader::Iterator();
+    return;
+  }
+  if (status_ = table_->DataBlock(index_iter_.Value(), data_block_); status_ != RC::OK) {
+    data_block_.reset();
+  }
+}
+
+/* 当前数据块遍历完后移到下一个数据块 */
+void SSTableReader::Iterator::SkipEmptyDataBlocks() {
+  while (!data_block_ || !data_iter_) {
+    if (status_ != RC::OK || !index_iter_) {
+      valid_ = false;
+      return;
+    }
+    ++index_iter_;
+    index_iter_.Fetch();
+    InitDataBlock();
+    if (data_block_) {
+      data_iter_ = data_block_->Begin();
+      data_iter_.Fetch();
+    }
+  }
+  valid_ = true;
+  if (table_->global_seq_ > 0) {
+    key_ = data_iter_.Key();
+    SetInnerKeySeq(key_, table_->global_seq_);
+  }
+  CheckBounds();
+}
+
+void SSTableReader::Iterator::CheckBounds() {
+  string_view user_key = InnerKeyToUserKey(Key());
+  if (has_upper_bound_ && user_key >= upper_bound_) {
+    valid_ = false;
+  }
+  if (prefix_mode_) {
+    const auto *extractor = table_->options_->prefix_extractor_.get();
+    if (!extractor->InDomain(user_key) || extractor->Transform(user_key) != prefix_) {
+      valid_ = false;
+    }
+  }
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,56 @@
+#include "sstable/table_cache.hh"
+#include <utility>
+
+namespace lsm_tree {
+
+namespace {
+
+auto TableCapacity(int max_open_files) -> size_t {
+  return max_open_files <= 0 ? TableCache::K_UNLIMITED_TABLES : static_cast<size_t>(max_open_files);
+}
+
+}  // namespace
+
+TableCache::TableCache(int max_open_files, TableOpener opener)
+    : cache_(TableCapacity(max_open_files), ShardBits(TableCapacity(max_open_files)), CacheEvictionPolicy::LRU),
+      opener_(std::move(opener)) {}
+
+/* 每个分片至少能容纳 k_min_tables_per_shard 张表，避免容量很小时分片不均导致表被过早关闭 */
+auto TableCache::ShardBits(size_t capacity) -> int {
+  static constexpr size_t k_min_tables_per_shard = 64;
+  static constexpr int    k_max_shard_bits       = 4;
+
+  int bits = 0;
+  while (bits < k_max_shard_bits && (capacity >> (bits + 1)) >= k_min_tables_per_shard) {
+    bits++;
+  }
+  return bits;
+}
+
+/**
+ * @brief 查找 table_id 对应的表，未打开时打开并加入缓存
+ * @param table_id 表 id，见 DB::TableId
+ * @param file 表的元数据，未命中时传给 opener 打开表
+ * @param handle 返回的表，持有期间不会被关闭
+ * @return RC 打开失败时返回打开的错误码，失败的结果不缓存
+ */
+auto TableCache::FindTable(uint64_t table_id, const FileMetaData &file, Handle &handle) -> RC {
+  if (handle = cache_.Lookup(table_id); handle) {
+    return RC::OK;
+  }
+  std::lock_guard<std::mutex> lock(open_mutexes_[table_id % K_OPEN_LOCKS]);
+  /* 等锁期间可能已经被其他线程打开 */
+  if (handle = cache_.Lookup(table_id); handle) {
+    return RC::OK;
+  }
+  std::shared_ptr<SSTableReader> reader;
+  if (auto rc = opener_(table_id, file, reader); rc != RC::OK) {
+    return rc;
+  }
+  handle = cache_.Insert(table_id, std::move(reader), 1);
+  return RC::OK;
+}
+
+void TableCache::Evict(uint64_t table_id) { cache_.Erase(table_id); }
+
+}  // namespace lsm_tree
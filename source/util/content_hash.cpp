@@ -0,0 +1,73 @@
+#include "util/content_hash.hh"
+#include <algorithm>
+#include <cstring>
+#include "util/hash64.hh"
+
+namespace lsm_tree {
+
+namespace {
+
+/* 两条链的种子，取自 XXH64 的素数 */
+constexpr uint64_t K_LO_SEED = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t K_HI_SEED = 0xC2B2AE3D27D4EB4FULL;
+
+}  // namespace
+
+auto ContentDigestLength(ContentHashType type) -> size_t {
+  return type == ContentHashType::HASH128 ? 2 * sizeof(uint64_t) : SHA256_DIGEST_LENGTH;
+}
+
+ContentHasher::ContentHasher(ContentHashType type) : type_(type), lo_(K_LO_SEED), hi_(K_HI_SEED) {
+  if (type_ == ContentHashType::SHA256) {
+    SHA256_Init(&sha256_);
+  }
+}
+
+void ContentHasher::Update(std::string_view data) {
+  if (type_ == ContentHashType::SHA256) {
+    SHA256_Update(&sha256_, data.data(), data.size());
+    return;
+  }
+  length_ += data.size();
+  /* 先补满上次剩下的分块 */
+  if (!pending_.empty()) {
+    size_t n = std::min(K_CHUNK_SIZE - pending_.size(), data.size());
+    pending_.append(data.substr(0, n));
+    data.remove_prefix(n);
+    if (pending_.size() < K_CHUNK_SIZE) {
+      return;
+    }
+    HashChunk(pending_.data(), pending_.size());
+    pending_.clear();
+  }
+  while (data.size() >= K_CHUNK_SIZE) {
+    HashChunk(data.data(), K_CHUNK_SIZE);
+    data.remove_prefix(K_CHUNK_SIZE);
+  }
+  pending_.append(data);
+}
+
+/* 前一个分块的结果作为下一个分块的种子，分块的顺序会影响结果 */
+void ContentHasher::HashChunk(const char *data, size_t len) {
+  lo_ = Hash64(data, len, lo_);
+  hi_ = Hash64(data, len, hi_ ^ K_HI_SEED);
+}
+
+void ContentHasher::Final(unsigned char *digest) {
+  if (type_ == ContentHashType::SHA256) {
+    SHA256_Final(digest, &sha256_);
+    return;
+  }
+  if (!pending_.empty()) {
+    HashChunk(pending_.data(), pending_.size());
+    pending_.clear();
+  }
+  /* 混入总长度，避免末尾的分块与更短的输入碰撞 */
+  uint64_t state[3] = {lo_, hi_, length_};
+  uint64_t lo       = Hash64(reinterpret_cast<const char *>(state), sizeof(state), K_LO_SEED);
+  uint64_t hi       = Hash64(reinterpret_cast<const char *>(state), sizeof(state), K_HI_SEED);
+  memcpy(digest, &lo, sizeof(lo));
+  memcpy(digest + sizeof(lo), &hi, sizeof(hi));
+}
+
+}  // namespace lsm_tree
@@ -12,6 +12,7 @@
 #include <cstring>
 #include <filesystem>
 #include <memory>
+#include "util/encode.hh"
 #include "util/hash_util.hh"
 #include "util/monitor_logger.hh"
 #include "wal.hh"
@@ -102,19 +103,39 @@ auto FileManager::HandleHomeDir(string_view path) -> string {
  * @return 如果成功销毁目录，则返回 RC::OK，否则返回 RC::DESTROY_DIRECTORY_FAILED。
  */
 auto FileManager::Destroy(string_view path) -> RC {
-  path = HandleHomeDir(path);
-  if (IsDirectory(path)) {
-    if (auto err = RemoveDirectory(path.data()); err) {
+  string real_path = HandleHomeDir(path);
+  if (IsDirectory(real_path)) {
+    if (auto err = RemoveDirectory(real_path.c_str()); err) {
       return RC::DESTROY_DIRECTORY_FAILED;
     }
   } else {
-    if (auto err = unlink(path.data()); err) {
+    if (auto err = unlink(real_path.c_str()); err) {
       return RC::DESTROY_FILE_FAILED;
     }
   }
   return RC::OK;
 }
 
+auto FileManager::ReName(string_view old_path, string_view new_path) -> RC {
+  string from = FixFileName(old_path);
+  string to   = FixFileName(new_path);
+  if (rename(from.c_str(), to.c_str()) != 0) {
+    MLog->error("rename {} to {} failed: {}", from, to, strerror(errno));
+    return RC::RENAME_FILE_ERROR;
+  }
+  return RC::OK;
+}
+
+auto FileManager::Link(string_view old_path, string_view new_path) -> RC {
+  string from = FixFileName(old_path);
+  string to   = FixFileName(new_path);
+  if (link(from.c_str(), to.c_str()) != 0) {
+    MLog->warn("link {} to {} failed: {}", from, to, strerror(errno));
+    return errno == EEXIST ? RC::EXISTED : RC::CREATE_FILE_FAILED;
+  }
+  return RC::OK;
+}
+
 auto FileManager::FixFileName(string_view path) -> string {
   if (path.starts_with("~")) {
     return HandleHomeDir(path);
@@ -226,18 +247,26 @@ auto FileManager::OpenMmapReadAbleFile(string_view file_name, MmapReadAbleFile *
   return rc;
 }
 
+auto FileManager::OpenRandomAccessFile(string_view filename, RandomAccessFile **result) -> RC {
+  int fd = ::open(filename.data(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    *result = nullptr;
+    return RC::OPEN_FILE_ERROR;
+  }
+  *result = new RandomAccessFile(filename, fd);
+  return RC::OK;
+}
+
 auto FileManager::ReadFileToString(string_view filename, string &result) -> RC {
   MmapReadAbleFile *mmap_readable_file{nullptr};
   RC                rc{RC::OK};
   if (rc = OpenMmapReadAbleFile(filename, &mmap_readable_file); rc != RC::OK) {
     // MLog->error("ReadFileToString {} error: {}", filename, strrc(rc));
   } else {
-    auto file_size = mmap_readable_file->Size();
-    result.resize(file_size);
+    auto        file_size = mmap_readable_file->Size();
     string_view result_view;
-    if (auto rc = mmap_readable_file->Read(0, file_size, result_view); rc != RC::OK) {
-      // MLog->error("mmap_readable_file {} Read error: {}", filename, strrc(rc));
-      result = result_view;
+    if (rc = mmap_readable_file->Read(0, file_size, result_view); rc == RC::OK) {
+      result.assign(result_view);
     }
   }
   delete mmap_readable_file;
@@ -342,7 +371,7 @@ auto WritAbleFile::Flush() -> RC {
 
 auto WritAbleFile::Close() -> RC {
   if (pos_ > 0) {
-    if (auto rc = Flush(); rc == RC::OK) {
+    if (auto rc = Flush(); rc != RC::OK) {
       return rc;
     }
   }
@@ -575,7 +604,7 @@ RandomAccessFile::~RandomAccessFile() {
  * @return SSTable 文件的路径。
  */
 auto FileMetaData::GetSSTablePath(string_view dbname) -> string {
-  return SstFile(SstDir(dbname), Sha256DigitToHex(sha256_));
+  return SstFile(SstDir(dbname), GetOid());
 }
 
 /**
@@ -583,7 +612,77 @@ auto FileMetaData::GetSSTablePath(string_view dbname) -> string {
  *
  * @return 文件的对象 ID（OID），以字符串形式返回。
  */
-auto FileMetaData::GetOid() const -> string { return Sha256DigitToHex(sha256_); }
+auto FileMetaData::GetOid() const -> string { return DigestToHex(sha256_, ContentDigestLength(content_hash_)); }
+
+auto FileMetaData::FileId() const -> uint64_t {
+  uint64_t id;
+  memcpy(&id, sha256_, sizeof(uint64_t));
+  return id;
+}
+
+/*
+ * | file_size | filter_size | num_keys | max_seq | global_seq | content_hash | digest | min_inner_key | max_inner_key |
+ * |  8 bytes  |   8 bytes   | 4 bytes  | 8 bytes |  8 bytes   |    1 byte    | 16/32  |  len + data   |  len + data   |
+ */
+void FileMetaData::EncodeTo(string &dst) const {
+  auto file_size = static_cast<uint64_t>(file_size_);
+  dst.append(reinterpret_cast<const char *>(&file_size), sizeof(file_size));
+  auto filter_size = static_cast<uint64_t>(filter_size_);
+  dst.append(reinterpret_cast<const char *>(&filter_size), sizeof(filter_size));
+  dst.append(reinterpret_cast<const char *>(&num_keys_), sizeof(num_keys_));
+  dst.append(reinterpret_cast<const char *>(&max_seq_), sizeof(max_seq_));
+  dst.append(reinterpret_cast<const char *>(&global_seq_), sizeof(global_seq_));
+  dst.push_back(static_cast<char>(content_hash_));
+  dst.append(reinterpret_cast<const char *>(sha256_), ContentDigestLength(content_hash_));
+  EncodeWithPreLen(dst, min_inner_key_.ToSSTableKey());
+  EncodeWithPreLen(dst, max_inner_key_.ToSSTableKey());
+}
+
+auto FileMetaData::DecodeFrom(string_view &src) -> RC {
+  constexpr size_t K_FIXED_SIZE = sizeof(uint64_t) * 2 + sizeof(int) + sizeof(int64_t) * 2 + 1;
+  if (src.size() < K_FIXED_SIZE) {
+    return RC::BAD_FILE_META;
+  }
+  uint64_t file_size;
+  memcpy(&file_size, src.data(), sizeof(file_size));
+  file_size_ = file_size;
+  src.remove_prefix(sizeof(file_size));
+  uint64_t filter_size;
+  memcpy(&filter_size, src.data(), sizeof(filter_size));
+  filter_size_ = filter_size;
+  src.remove_prefix(sizeof(filter_size));
+  memcpy(&num_keys_, src.data(), sizeof(num_keys_));
+  src.remove_prefix(sizeof(num_keys_));
+  memcpy(&max_seq_, src.data(), sizeof(max_seq_));
+  src.remove_prefix(sizeof(max_seq_));
+  memcpy(&global_seq_, src.data(), sizeof(global_seq_));
+  src.remove_prefix(sizeof(global_seq_));
+  content_hash_ = static_cast<ContentHashType>(src[0]);
+  src.remove_prefix(1);
+  if (content_hash_ != ContentHashType::SHA256 && content_hash_ != ContentHashType::HASH128) {
+    return RC::BAD_FILE_META;
+  }
+  size_t digest_len = ContentDigestLength(content_hash_);
+  if (src.size() < digest_len) {
+    return RC::BAD_FILE_META;
+  }
+  memcpy(sha256_, src.data(), digest_len);
+  src.remove_prefix(digest_len);
+
+  for (MemKey *key : {&min_inner_key_, &max_inner_key_}) {
+    int len;
+    if (src.size() < sizeof(int)) {
+      return RC::BAD_FILE_META;
+    }
+    Decode32(src.data(), &len);
+    if (len < 9 || src.size() < sizeof(int) + static_cast<size_t>(len)) {
+      return RC::BAD_FILE_META;
+    }
+    key->FromSSTableKey(src.substr(sizeof(int), len));
+    src.remove_prefix(sizeof(int) + len);
+  }
+  return RC::OK;
+}
 
 /**
  * 重载的流插入运算符，用于将 FileMetaData 对象输出到输出流中。
@@ -598,7 +697,7 @@ auto operator<<(ostream &os, const FileMetaData &meta) -> std::ostream & {
       "max_inner_key={} "
       "min_inner_key={}, sha256={} ]\n",
       meta.file_size_, meta.num_keys_, meta.max_seq_, meta.belong_to_level_, meta.max_inner_key_, meta.min_inner_key_,
-      Sha256DigitToHex(meta.sha256_));
+      meta.GetOid());
   return os;
 }
 
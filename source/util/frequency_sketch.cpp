@@ -0,0 +1,78 @@
+#include "util/frequency_sketch.hh"
+#include <algorithm>
+
+namespace lsm_tree {
+
+namespace {
+
+constexpr int      K_ROWS                  = 4;
+constexpr uint64_t K_SEEDS[K_ROWS]         = {0xc3a5c85c97cb3127ULL, 0xb492b66fbe98f273ULL, 0x9ae16a3b2f90404fULL,
+                                              0xcbf29ce484222325ULL};
+constexpr uint64_t K_RESET_MASK            = 0x7777777777777777ULL;
+constexpr size_t   K_MIN_WORDS             = 16;
+constexpr size_t   K_SAMPLE_SIZE_PER_ENTRY = 10;
+
+}  // namespace
+
+/* 每个条目对应一个 uint64_t（16 个计数器），老化时计数器的平均值约为 10 * 4 / 16 */
+FrequencySketch::FrequencySketch(size_t expected_entries) {
+  size_t words = K_MIN_WORDS;
+  while (words < expected_entries) {
+    words <<= 1;
+  }
+  counters_mask_ = words * 16 - 1;
+  sample_size_   = words * K_SAMPLE_SIZE_PER_ENTRY;
+  table_         = std::make_unique<std::atomic<uint64_t>[]>(words);
+}
+
+/* 每一行用不同的种子重新混合哈希值 */
+auto FrequencySketch::CounterIndex(uint64_t hash, int row) const -> size_t {
+  uint64_t h = (hash + K_SEEDS[row]) * K_SEEDS[row];
+  h ^= h >> 32;
+  return static_cast<size_t>(h) & counters_mask_;
+}
+
+/**
+ * @brief 增加 key 的访问计数
+ * @details 4 个计数器都已经饱和时不计入增加次数
+ * @param hash key 的哈希
+ */
+void FrequencySketch::Increment(uint64_t hash) {
+  bool added = false;
+  for (int row = 0; row < K_ROWS; row++) {
+    size_t                 index = CounterIndex(hash, row);
+    std::atomic<uint64_t> &word  = table_[index / 16];
+    int                    shift = static_cast<int>(index % 16) * 4;
+    uint64_t               old   = word.load(std::memory_order_relaxed);
+    while (((old >> shift) & 0xf) != K_MAX_FREQ) {
+      if (word.compare_exchange_weak(old, old + (1ULL << shift), std::memory_order_relaxed)) {
+        added = true;
+        break;
+      }
+    }
+  }
+  if (added && additions_.fetch_add(1, std::memory_order_relaxed) + 1 == sample_size_) {
+    Age();
+  }
+}
+
+auto FrequencySketch::Estimate(uint64_t hash) const -> int {
+  int freq = K_MAX_FREQ;
+  for (int row = 0; row < K_ROWS; row++) {
+    size_t index = CounterIndex(hash, row);
+    auto   word  = table_[index / 16].load(std::memory_order_relaxed);
+    freq         = std::min(freq, static_cast<int>((word >> ((index % 16) * 4)) & 0xf));
+  }
+  return freq;
+}
+
+/* 所有计数器减半，与并发的 Increment 交错时可能丢失少量计数，不影响估计 */
+void FrequencySketch::Age() {
+  for (size_t i = 0; i <= counters_mask_ / 16; i++) {
+    uint64_t old = table_[i].load(std::memory_order_relaxed);
+    table_[i].store((old >> 1) & K_RESET_MASK, std::memory_order_relaxed);
+  }
+  additions_.store(sample_size_ / 2, std::memory_order_relaxed);
+}
+
+}  // namespace lsm_tree
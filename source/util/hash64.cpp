@@ -0,0 +1,144 @@
+#include "util/hash64.hh"
+#include <cstring>
+
+namespace lsm_tree {
+
+namespace {
+
+constexpr uint64_t K_PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t K_PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t K_PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t K_PRIME_MX1 = 0x165667919E3779F9ULL;
+constexpr uint64_t K_PRIME_MX2 = 0x9FB21C651E98DF25ULL;
+
+/* 混合常量，每 16 字节输入使用其中一对 */
+constexpr uint64_t K_SECRET[8] = {
+    0xbe4ba423396cfeb8ULL, 0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL, 0x1f67b3b7a4a44072ULL,
+    0x78e5c0cc4ee679cbULL, 0x2172ffcc7dd05a82ULL, 0x8e2443f7744608b8ULL, 0x4c263a81e69035e0ULL,
+};
+
+inline auto Read32(const char *p) -> uint32_t {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline auto Read64(const char *p) -> uint64_t {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline auto RotateLeft64(uint64_t v, int r) -> uint64_t { return (v << r) | (v >> (64 - r)); }
+
+/* 64x64 -> 128 乘法后折叠为 64 位 */
+inline auto Mul128Fold64(uint64_t lhs, uint64_t rhs) -> uint64_t {
+  auto product = static_cast<unsigned __int128>(lhs) * rhs;
+  return static_cast<uint64_t>(product) ^ static_cast<uint64_t>(product >> 64);
+}
+
+inline auto Avalanche(uint64_t h) -> uint64_t {
+  h ^= h >> 37;
+  h *= K_PRIME_MX1;
+  h ^= h >> 32;
+  return h;
+}
+
+inline auto StrongAvalanche(uint64_t h) -> uint64_t {
+  h ^= h >> 33;
+  h *= K_PRIME64_2;
+  h ^= h >> 29;
+  h *= K_PRIME64_3;
+  h ^= h >> 32;
+  return h;
+}
+
+inline auto Rrmxmx(uint64_t h, uint64_t len) -> uint64_t {
+  h ^= RotateLeft64(h, 49) ^ RotateLeft64(h, 24);
+  h *= K_PRIME_MX2;
+  h ^= (h >> 35) + len;
+  h *= K_PRIME_MX2;
+  return h ^ (h >> 28);
+}
+
+inline auto Mix16(const char *p, uint64_t s0, uint64_t s1, uint64_t seed) -> uint64_t {
+  return Mul128Fold64(Read64(p) ^ (s0 + seed), Read64(p + 8) ^ (s1 - seed));
+}
+
+auto Len1To3(const char *p, size_t len, uint64_t seed) -> uint64_t {
+  auto c1       = static_cast<uint32_t>(static_cast<unsigned char>(p[0]));
+  auto c2       = static_cast<uint32_t>(static_cast<unsigned char>(p[len >> 1]));
+  auto c3       = static_cast<uint32_t>(static_cast<unsigned char>(p[len - 1]));
+  auto combined = (c1 << 16) | (c2 << 24) | c3 | (static_cast<uint32_t>(len) << 8);
+  auto bitflip  = (K_SECRET[0] ^ (K_SECRET[0] >> 32)) + seed;
+  return StrongAvalanche(combined ^ bitflip);
+}
+
+auto Len4To8(const char *p, size_t len, uint64_t seed) -> uint64_t {
+  seed ^= static_cast<uint64_t>(__builtin_bswap32(static_cast<uint32_t>(seed))) << 32;
+  uint64_t input1  = Read32(p);
+  uint64_t input2  = Read32(p + len - 4);
+  uint64_t bitflip = (K_SECRET[1] ^ K_SECRET[2]) - seed;
+  uint64_t input64 = input2 + (input1 << 32);
+  return Rrmxmx(input64 ^ bitflip, len);
+}
+
+auto Len9To16(const char *p, size_t len, uint64_t seed) -> uint64_t {
+  uint64_t bitflip1 = (K_SECRET[3] ^ K_SECRET[4]) + seed;
+  uint64_t bitflip2 = (K_SECRET[5] ^ K_SECRET[6]) - seed;
+  uint64_t lo       = Read64(p) ^ bitflip1;
+  uint64_t hi       = Read64(p + len - 8) ^ bitflip2;
+  uint64_t acc      = len + __builtin_bswap64(lo) + hi + Mul128Fold64(lo, hi);
+  return Avalanche(acc);
+}
+
+/* 两条累加链交替处理 16 字节分组，减少乘法的依赖延迟，最后 16 字节单独混合 */
+auto Len17Plus(const char *p, size_t len, uint64_t seed) -> uint64_t {
+  uint64_t    acc1 = len * K_PRIME64_1;
+  uint64_t    acc2 = seed;
+  const char *end  = p + len - 16;
+  int         i    = 0;
+  for (; p + 32 <= end; p += 32, i += 4) {
+    acc1 += Mix16(p, K_SECRET[i & 7], K_SECRET[(i + 1) & 7], seed);
+    acc2 += Mix16(p + 16, K_SECRET[(i + 2) & 7], K_SECRET[(i + 3) & 7], seed);
+  }
+  if (p + 16 <= end) {
+    acc1 += Mix16(p, K_SECRET[i & 7], K_SECRET[(i + 1) & 7], seed);
+    p += 16;
+    i += 2;
+  }
+  if (p < end) {
+    acc2 += Mix16(p, K_SECRET[i & 7], K_SECRET[(i + 1) & 7], seed);
+  }
+  acc1 += Mix16(end, K_SECRET[7], K_SECRET[0], seed);
+  return Avalanche(acc1 + RotateLeft64(acc2, 31));
+}
+
+}  // namespace
+
+/**
+ * @brief 计算 64 位哈希
+ * @details 参照 XXH3 按输入长度分段处理：短 key 只需要 1~2 次读取和一次乘法，
+ *          长 key 按 16 字节分组混合。不保证与 XXH3 的结果一致。
+ * @param data 输入
+ * @param len 输入长度
+ * @param seed 种子
+ * @return uint64_t 哈希值
+ */
+auto Hash64(const char *data, size_t len, uint64_t seed) -> uint64_t {
+  if (len == 0) {
+    return StrongAvalanche(seed ^ K_SECRET[7] ^ K_SECRET[0]);
+  }
+  if (len <= 3) {
+    return Len1To3(data, len, seed);
+  }
+  if (len <= 8) {
+    return Len4To8(data, len, seed);
+  }
+  if (len <= 16) {
+    return Len9To16(data, len, seed);
+  }
+  return Len17Plus(data, len, seed);
+}
+
+}  // namespace lsm_tree
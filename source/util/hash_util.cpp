@@ -1,6 +1,7 @@
 #include "util/hash_util.hh"
+#include <array>
 #include <charconv>
-#include <iomanip>
+#include <cstring>
 
 namespace lsm_tree {
 
@@ -19,24 +20,65 @@ auto HexStringToInt(const std::string_view &input) -> std::optional<int> {
   return out;
 }
 
+namespace {
+
+/* 每个字节对应的两个 16 进制字符 */
+constexpr auto K_HEX_TABLE = []() {
+  constexpr char         digits[] = "0123456789abcdef";
+  std::array<char, 512> table{};
+  for (int i = 0; i < 256; i++) {
+    table[i * 2]     = digits[i >> 4];
+    table[i * 2 + 1] = digits[i & 0xf];
+  }
+  return table;
+}();
+
+/* 16 进制字符对应的值，非 16 进制字符为 -1 */
+constexpr auto K_UNHEX_TABLE = []() {
+  std::array<int8_t, 256> table{};
+  table.fill(-1);
+  for (int i = 0; i < 10; i++) {
+    table['0' + i] = static_cast<int8_t>(i);
+  }
+  for (int i = 0; i < 6; i++) {
+    table['a' + i] = static_cast<int8_t>(10 + i);
+    table['A' + i] = static_cast<int8_t>(10 + i);
+  }
+  return table;
+}();
+
+}  // namespace
+
+auto DigestToHex(const unsigned char *digest, size_t len) -> string {
+  string hex(len * 2, '\0');
+  for (size_t i = 0; i < len; i++) {
+    memcpy(&hex[i * 2], &K_HEX_TABLE[digest[i] * 2], 2);
+  }
+  return hex;
+}
+
+auto HexToDigest(string_view hex, unsigned char *digest) -> bool {
+  if (hex.size() % 2 != 0) {
+    return false;
+  }
+  for (size_t i = 0; i < hex.size(); i += 2) {
+    int high = K_UNHEX_TABLE[static_cast<unsigned char>(hex[i])];
+    int low  = K_UNHEX_TABLE[static_cast<unsigned char>(hex[i + 1])];
+    if (high < 0 || low < 0) {
+      return false;
+    }
+    digest[i / 2] = static_cast<unsigned char>(high << 4 | low);
+  }
+  return true;
+}
+
 /**
  * @brief  将hash转换为16进制字符串
  *
  * @param hash
  * @return string
  */
-auto Sha256DigitToHex(const unsigned char hash[]) -> string {
-  std::stringstream ss;
-  ss.setf(std::ios::hex, std::ios::basefield);
-
-  for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-    ss.width(2);
-    ss.fill('0');
-    ss << static_cast<unsigned int>(hash[i]);
-  }
-  ss.setf(std::ios::dec, std::ios::basefield);
-  return ss.str();
-}
+auto Sha256DigitToHex(const unsigned char hash[]) -> string { return DigestToHex(hash, SHA256_DIGEST_LENGTH); }
 
 /**
  * @brief  将16进制字符串转换为hash
@@ -45,8 +87,6 @@ auto Sha256DigitToHex(const unsigned char hash[]) -> string {
  * @param hash
  */
 void HexToSha256Digit(string_view hex, unsigned char *hash) {
-  for (int i = 0; i < SHA256_DIGEST_LENGTH; i++) {
-    hash[i] = static_cast<unsigned char>(HexStringToInt(hex.substr(i * 2, 2)).value());
-  }
+  HexToDigest(hex.substr(0, SHA256_DIGEST_LENGTH * 2), hash);
 }
 }  // namespace lsm_tree
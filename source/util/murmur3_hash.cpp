@@ -1,4 +1,5 @@
 #include "util/murmur3_hash.hh"
+#include <cstring>
 
 namespace lsm_tree {
 
@@ -8,7 +9,63 @@ static auto RotateLeft(int value, int32_t count) -> int {
   return ((value << count) | (value >> ((-count) & mask)));
 }
 
+static inline auto RotateLeft32(uint32_t value, int count) -> uint32_t {
+  return (value << count) | (value >> (32 - count));
+}
+
+/**
+ * @brief 标准的 MurmurHash3_x86_32
+ * @details 按 4 字节小端读取输入，尾部字节按无符号处理
+ */
 auto Murmur3Hash(uint32_t seed, const char *data, size_t len) -> uint32_t {
+  const uint32_t c1   = 0xcc9e2d51;
+  const uint32_t c2   = 0x1b873593;
+  const uint32_t r1   = 15;
+  const uint32_t r2   = 13;
+  const uint32_t m    = 5;
+  const uint32_t n    = 0xe6546b64;
+  const size_t   len4 = len / sizeof(uint32_t);
+  uint32_t       k1   = 0;
+
+  for (size_t i = 0; i < len4; i++) {
+    uint32_t k;
+    memcpy(&k, data + i * sizeof(uint32_t), sizeof(uint32_t));
+    k *= c1;
+    k = RotateLeft32(k, r1);
+    k *= c2;
+
+    seed ^= k;
+    seed = RotateLeft32(seed, r2) * m + n;
+  }
+
+  const auto *tail = reinterpret_cast<const unsigned char *>(data + len4 * sizeof(uint32_t));
+  switch (len & (sizeof(uint32_t) - 1)) {
+    case 3:
+      k1 ^= static_cast<uint32_t>(tail[2]) << 16;
+      [[fallthrough]];
+    case 2:
+      k1 ^= static_cast<uint32_t>(tail[1]) << 8;
+      [[fallthrough]];
+    case 1:
+      k1 ^= static_cast<uint32_t>(tail[0]);
+      k1 *= c1;
+      k1 = RotateLeft32(k1, r1);
+      k1 *= c2;
+      seed ^= k1;
+      break;
+  }
+
+  seed ^= static_cast<uint32_t>(len);
+  seed ^= (seed >> 16);
+  seed *= 0x85ebca6b;
+  seed ^= (seed >> 13);
+  seed *= 0xc2b2ae35;
+  seed ^= (seed >> 16);
+
+  return seed;
+}
+
+auto LegacyMurmur3Hash(uint32_t seed, const char *data, size_t len) -> uint32_t {
   const uint32_t c1 = 0xcc9e2d51;
   const uint32_t c2 = 0x1b873593;
   const uint32_t r1 = 15;
@@ -0,0 +1,18 @@
+#include "util/prefix_extractor.hh"
+#include <fmt/format.h>
+
+namespace lsm_tree {
+
+auto FixedPrefixExtractor::Name() const -> string { return fmt::format("fixed:{}", prefix_len_); }
+
+auto CappedPrefixExtractor::Name() const -> string { return fmt::format("capped:{}", prefix_len_); }
+
+auto NewFixedPrefixExtractor(size_t prefix_len) -> std::shared_ptr<const PrefixExtractor> {
+  return std::make_shared<FixedPrefixExtractor>(prefix_len);
+}
+
+auto NewCappedPrefixExtractor(size_t prefix_len) -> std::shared_ptr<const PrefixExtractor> {
+  return std::make_shared<CappedPrefixExtractor>(prefix_len);
+}
+
+}  // namespace lsm_tree
@@ -0,0 +1,349 @@
+#include "version.hh"
+#include <algorithm>
+#include <cstring>
+#include "block/filter_policy.hh"
+#include "util/hash_util.hh"
+#include "util/monitor_logger.hh"
+
+namespace lsm_tree {
+
+namespace {
+
+auto UserKeyRangeOverlap(const FileMetaData &file, string_view smallest, string_view largest) -> bool {
+  return !(file.max_inner_key_.user_key_ < smallest || file.min_inner_key_.user_key_ > largest);
+}
+
+/* L0 从新到旧，其他层按最小 key */
+void SortLevel(int level, vector<Version::FileRef> &files) {
+  if (level == 0) {
+    std::stable_sort(files.begin(), files.end(),
+                     [](const auto &a, const auto &b) { return a->max_seq_ > b->max_seq_; });
+  } else {
+    std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) {
+      return a->min_inner_key_.user_key_ < b->min_inner_key_.user_key_;
+    });
+  }
+}
+
+auto Sha256Of(string_view content) -> std::array<unsigned char, SHA256_DIGEST_LENGTH> {
+  std::array<unsigned char, SHA256_DIGEST_LENGTH> digest;
+  SHA256(reinterpret_cast<const unsigned char *>(content.data()), content.size(), digest.data());
+  return digest;
+}
+
+}  // namespace
+
+/*
+**********************************************************************************************************************************************
+* Version
+**********************************************************************************************************************************************
+*/
+
+auto Version::LevelBytes(int level) const -> size_t {
+  size_t bytes = 0;
+  for (const auto &file : files_[level]) {
+    bytes += file->file_size_;
+  }
+  return bytes;
+}
+
+auto Version::LevelKeys(int level) const -> uint64_t {
+  uint64_t keys = 0;
+  for (const auto &file : files_[level]) {
+    keys += file->num_keys_;
+  }
+  return keys;
+}
+
+/* bits_per_key_ 不大于 0 表示不使用过滤器，不再分配 */
+auto Version::FilterBitsPerKey(const DBOptions &options, int level, uint64_t added_keys) const -> int {
+  if (!options.optimize_filters_for_levels_ || options.bits_per_key_ <= 0) {
+    return options.bits_per_key_;
+  }
+  vector<uint64_t> level_keys(K_NUM_LEVELS);
+  for (int i = 0; i < K_NUM_LEVELS; i++) {
+    level_keys[i] = LevelKeys(i);
+  }
+  level_keys[level] += added_keys;
+  return AllocateFilterBits(level_keys, options.bits_per_key_)[level];
+}
+
+void Version::GetOverlappingFiles(int level, string_view smallest, string_view largest,
+                                  vector<FileRef> &files) const {
+  files.clear();
+  for (const auto &file : files_[level]) {
+    if (UserKeyRangeOverlap(*file, smallest, largest)) {
+      files.push_back(file);
+    }
+  }
+}
+
+/* L1 及以下二分查找第一个最大 key 不小于 smallest 的文件 */
+auto Version::OverlapInLevel(int level, string_view smallest, string_view largest) const -> bool {
+  const auto &files = files_[level];
+  if (level == 0) {
+    return std::any_of(files.begin(), files.end(),
+                       [&](const FileRef &file) { return UserKeyRangeOverlap(*file, smallest, largest); });
+  }
+  auto iter = std::lower_bound(files.begin(), files.end(), smallest, [](const FileRef &file, string_view key) {
+    return file->max_inner_key_.user_key_ < key;
+  });
+  return iter != files.end() && UserKeyRangeOverlap(**iter, smallest, largest);
+}
+
+/*
+**********************************************************************************************************************************************
+* VersionSet
+**********************************************************************************************************************************************
+*/
+
+VersionSet::VersionSet(string_view dbname, const DBOptions &options)
+    : dbname_(dbname), options_(options), current_(std::make_shared<Version>()) {}
+
+auto VersionSet::Current() const -> std::shared_ptr<const Version> {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return current_;
+}
+
+/**
+ * @brief 读取 CURRENT 指向的 rev 文件和各层的 lvl 文件
+ * @details rev 文件和 lvl 文件按内容的 SHA-256 命名，读取后校验内容与文件名一致，不一致说明文件损坏。
+ * @return RC CURRENT 损坏时返回 BAD_CURRENT_FILE，rev 文件损坏时返回 BAD_REVISION，lvl 文件损坏时返回 BAD_LEVEL
+ */
+auto VersionSet::Recover() -> RC {
+  std::lock_guard<std::mutex> apply_lock(apply_mutex_);
+  for (const auto &dir : {RevDir(dbname_), SstDir(dbname_), LevelDir(dbname_)}) {
+    if (!FileManager::Exists(dir)) {
+      if (auto rc = FileManager::Create(dir, FileOptions::DIR_); rc != RC::OK) {
+        return rc;
+      }
+    }
+  }
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    if (!FileManager::Exists(LevelDir(dbname_, level))) {
+      if (auto rc = FileManager::Create(LevelDir(dbname_, level), FileOptions::DIR_); rc != RC::OK) {
+        return rc;
+      }
+    }
+  }
+  if (!FileManager::Exists(CurrentFile(dbname_))) {
+    return RC::OK;
+  }
+
+  string current;
+  if (auto rc = FileManager::ReadFileToString(CurrentFile(dbname_), current); rc != RC::OK) {
+    return rc;
+  }
+  Digest revision;
+  if (current.size() != SHA256_DIGEST_LENGTH * 2 || !HexToDigest(current, revision.data())) {
+    MLog->error("bad CURRENT file in {}: {}", dbname_, current);
+    return RC::BAD_CURRENT_FILE;
+  }
+  string content;
+  if (auto rc = FileManager::ReadFileToString(RevFile(RevDir(dbname_), current), content); rc != RC::OK) {
+    return rc;
+  }
+  if (content.size() != sizeof(int64_t) + SHA256_DIGEST_LENGTH * K_NUM_LEVELS || Sha256Of(content) != revision) {
+    MLog->error("bad revision file {} in {}", current, dbname_);
+    return RC::BAD_REVISION;
+  }
+  int64_t last_sequence;
+  memcpy(&last_sequence, content.data(), sizeof(last_sequence));
+
+  auto version = std::make_shared<Version>();
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    memcpy(level_digests_[level].data(), content.data() + sizeof(int64_t) + SHA256_DIGEST_LENGTH * level,
+           SHA256_DIGEST_LENGTH);
+    if (auto rc = LoadLevel(level, level_digests_[level], version->files_[level]); rc != RC::OK) {
+      return rc;
+    }
+  }
+  revision_     = revision;
+  has_revision_ = true;
+  SetLastSequence(last_sequence);
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_ = std::move(version);
+  return RC::OK;
+}
+
+/* lvl 文件：文件个数（4 字节） + 每个文件的 FileMetaData */
+auto VersionSet::LoadLevel(int level, const Digest &digest, vector<Version::FileRef> &files) const -> RC {
+  string hex = DigestToHex(digest.data(), digest.size());
+  string content;
+  if (auto rc = FileManager::ReadFileToString(LevelFile(LevelDir(dbname_, level), hex), content); rc != RC::OK) {
+    return rc;
+  }
+  if (content.size() < sizeof(int) || Sha256Of(content) != digest) {
+    MLog->error("bad level file {} of level {} in {}", hex, level, dbname_);
+    return RC::BAD_LEVEL;
+  }
+  int num_files;
+  memcpy(&num_files, content.data(), sizeof(num_files));
+  string_view src = string_view(content).substr(sizeof(num_files));
+  for (int i = 0; i < num_files; i++) {
+    auto file = std::make_shared<FileMetaData>();
+    if (auto rc = file->DecodeFrom(src); rc != RC::OK) {
+      return RC::BAD_LEVEL;
+    }
+    file->belong_to_level_ = level;
+    files.push_back(std::move(file));
+  }
+  if (!src.empty()) {
+    return RC::BAD_LEVEL;
+  }
+  SortLevel(level, files);
+  return RC::OK;
+}
+
+auto VersionSet::LogAndApply(const VersionEdit &edit) -> RC {
+  return LogAndApply([&edit](const Version &, VersionEdit &target) {
+    target = edit;
+    return RC::OK;
+  });
+}
+
+auto VersionSet::LogAndApply(const std::function<RC(const Version &, VersionEdit &)> &make_edit) -> RC {
+  std::lock_guard<std::mutex> apply_lock(apply_mutex_);
+  auto                        base = Current();
+  VersionEdit                 edit;
+  if (auto rc = make_edit(*base, edit); rc != RC::OK) {
+    return rc;
+  }
+  auto version = std::make_shared<Version>();
+  if (auto rc = Apply(*base, edit, *version); rc != RC::OK) {
+    return rc;
+  }
+  int64_t last_sequence = std::max(LastSequence(), edit.last_sequence_);
+  if (auto rc = Persist(*version, last_sequence); rc != RC::OK) {
+    return rc;
+  }
+  /* 写入可能同时在增加序列号，只在更大时替换 */
+  int64_t current_sequence = LastSequence();
+  while (current_sequence < last_sequence &&
+         !last_sequence_.compare_exchange_weak(current_sequence, last_sequence, std::memory_order_acq_rel)) {
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_ = std::move(version);
+  return RC::OK;
+}
+
+/* 删除的文件必须存在于对应的层；L1 及以下应用后的文件不能重叠 */
+auto VersionSet::Apply(const Version &base, const VersionEdit &edit, Version &version) const -> RC {
+  version.files_ = base.files_;
+  for (const auto &[level, oid] : edit.deleted_files_) {
+    if (level < 0 || level >= K_NUM_LEVELS) {
+      return RC::BAD_LEVEL;
+    }
+    auto &files = version.files_[level];
+    auto  iter  = std::find_if(files.begin(), files.end(), [&](const auto &file) { return file->GetOid() == oid; });
+    if (iter == files.end()) {
+      MLog->error("delete file {} not in level {}", oid, level);
+      return RC::BAD_FILE_META;
+    }
+    files.erase(iter);
+  }
+  for (const auto &[level, meta] : edit.added_files_) {
+    if (level < 0 || level >= K_NUM_LEVELS) {
+      return RC::BAD_LEVEL;
+    }
+    auto file              = std::make_shared<FileMetaData>(meta);
+    file->belong_to_level_ = level;
+    version.files_[level].push_back(std::move(file));
+  }
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    auto &files = version.files_[level];
+    SortLevel(level, files);
+    for (size_t i = 1; level > 0 && i < files.size(); i++) {
+      if (files[i - 1]->max_inner_key_.user_key_ >= files[i]->min_inner_key_.user_key_) {
+        MLog->error("files {} and {} overlap in level {}", files[i - 1]->GetOid(), files[i]->GetOid(), level);
+        return RC::BAD_LEVEL;
+      }
+    }
+  }
+  return RC::OK;
+}
+
+/**
+ * @brief 写入新的 lvl 文件、rev 文件，再替换 CURRENT
+ * @details 内容没有变化的层得到同样的哈希，不会重写。CURRENT 替换之后才删除旧的 rev 文件和不再使用的 lvl 文件，
+ *          删除失败只会留下多余的文件，不影响恢复。
+ */
+auto VersionSet::Persist(const Version &version, int64_t last_sequence) -> RC {
+  std::array<Digest, K_NUM_LEVELS> level_digests;
+  string                           revision(reinterpret_cast<const char *>(&last_sequence), sizeof(last_sequence));
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    const auto &files     = version.files_[level];
+    auto        num_files = static_cast<int>(files.size());
+    string      content(reinterpret_cast<const char *>(&num_files), sizeof(num_files));
+    for (const auto &file : files) {
+      file->EncodeTo(content);
+    }
+    if (auto rc = WriteContentFile(LevelDir(dbname_, level), content, level_digests[level], LevelFile); rc != RC::OK) {
+      return rc;
+    }
+    revision.append(reinterpret_cast<const char *>(level_digests[level].data()), SHA256_DIGEST_LENGTH);
+  }
+  Digest revision_digest;
+  if (auto rc = WriteContentFile(RevDir(dbname_), revision, revision_digest, RevFile); rc != RC::OK) {
+    return rc;
+  }
+
+  string                    revision_hex = DigestToHex(revision_digest.data(), revision_digest.size());
+  std::unique_ptr<TempFile> current;
+  if (auto rc = FileManager::OpenTempFile(dbname_, "current_", current); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = current->Append(revision_hex); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = current->Sync(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = current->Close(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = current->ReName(CurrentFile(dbname_)); rc != RC::OK) {
+    return rc;
+  }
+
+  if (has_revision_) {
+    if (revision_ != revision_digest) {
+      FileManager::Destroy(RevFile(RevDir(dbname_), DigestToHex(revision_.data(), revision_.size())));
+    }
+    for (int level = 0; level < K_NUM_LEVELS; level++) {
+      if (level_digests_[level] != level_digests[level]) {
+        auto hex = DigestToHex(level_digests_[level].data(), SHA256_DIGEST_LENGTH);
+        FileManager::Destroy(LevelFile(LevelDir(dbname_, level), hex));
+      }
+    }
+  }
+  revision_      = revision_digest;
+  level_digests_ = level_digests;
+  has_revision_  = true;
+  return RC::OK;
+}
+
+auto VersionSet::WriteContentFile(string_view dir, string_view content, Digest &digest,
+                                  const std::function<string(string_view, string_view)> &file_name) const -> RC {
+  digest    = Sha256Of(content);
+  auto path = file_name(dir, DigestToHex(digest.data(), digest.size()));
+  if (FileManager::Exists(path)) {
+    return RC::OK;
+  }
+  std::unique_ptr<TempFile> file;
+  if (auto rc = FileManager::OpenTempFile(dir, "tmp_", file); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = file->Append(content); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = file->Sync(); rc != RC::OK) {
+    return rc;
+  }
+  if (auto rc = file->Close(); rc != RC::OK) {
+    return rc;
+  }
+  return file->ReName(path);
+}
+
+}  // namespace lsm_tree
@@ -30,7 +30,7 @@ void Worker::Add(std::function<void()> &&function) noexcept {
 void Worker::Run() { return this->operator()(); }
 
 void Worker::operator()() {
-  while (!closed_) {
+  while (true) {
     std::unique_lock<mutex> lock(work_queue_mutex_);
     while (!closed_ && work_queue_.empty()) {
       work_queue_cond_.wait(lock);
@@ -0,0 +1,163 @@
+#include "block/filter_block.hh"
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+using namespace std;
+
+TEST(FilterBlock, WholeKey) {
+  FilterBlockWriter writer(make_unique<BloomFilter>(10));
+  writer.Update("hello");
+  writer.Update("world");
+  writer.Keys2Block();
+  writer.Update("foo");
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block), RC::OK);
+  EXPECT_TRUE(reader.IsKeyExists(0, "hello"));
+  EXPECT_TRUE(reader.IsKeyExists(0, "world"));
+  EXPECT_TRUE(reader.IsKeyExists(1, "foo"));
+  EXPECT_FALSE(reader.IsKeyExists(2, "foo"));
+  /* 没有前缀过滤器时无法排除 */
+  EXPECT_TRUE(reader.IsTablePrefixExists("zzz"));
+}
+
+TEST(FilterBlock, PrefixFilter) {
+  auto              extractor = NewFixedPrefixExtractor(4);
+  FilterBlockWriter writer(make_unique<BloomFilter>(10), extractor);
+  writer.Update("t001-a");
+  writer.Update("t001-b");
+  writer.Keys2Block();
+  writer.Update("t002-a");
+  writer.Update("t3");  // 不在定义域内
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block, extractor.get()), RC::OK);
+  EXPECT_EQ(reader.PrefixExtractorName(), "fixed:4");
+  EXPECT_TRUE(reader.IsKeyExists(0, "t001-a"));
+  EXPECT_TRUE(reader.IsKeyExists(1, "t3"));
+  EXPECT_TRUE(reader.IsPrefixExists(0, "t001"));
+  EXPECT_TRUE(reader.IsPrefixExists(1, "t002-zzz"));
+  EXPECT_TRUE(reader.IsTablePrefixExists("t001"));
+  EXPECT_TRUE(reader.IsTablePrefixExists("t002"));
+
+  int skipped = 0;
+  for (int i = 100; i < 200; i++) {
+    if (!reader.IsTablePrefixExists("t" + to_string(i))) {
+      skipped++;
+    }
+  }
+  EXPECT_GT(skipped, 90);
+}
+
+TEST(FilterBlock, PrefixOnly) {
+  auto              extractor = NewCappedPrefixExtractor(3);
+  FilterBlockWriter writer(make_unique<BloomFilter>(10), extractor, false);
+  writer.Update("abc1");
+  writer.Update("abc2");
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+
+  /* 提取器不一致时不能使用前缀过滤，也不能用完整 key 排除 */
+  FilterBlockReader mismatch;
+  auto              other = NewCappedPrefixExtractor(2);
+  EXPECT_EQ(mismatch.Init(block, other.get()), RC::OK);
+  EXPECT_TRUE(mismatch.IsKeyExists(0, "xyz"));
+  EXPECT_TRUE(mismatch.IsPrefixExists(0, "xyz"));
+  EXPECT_TRUE(mismatch.IsTablePrefixExists("xyz"));
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block, extractor.get()), RC::OK);
+  EXPECT_TRUE(reader.IsKeyExists(0, "abc9"));
+  EXPECT_TRUE(reader.IsPrefixExists(0, "abc"));
+}
+
+TEST(FilterBlock, LookupContext) {
+  auto              extractor = NewFixedPrefixExtractor(4);
+  FilterBlockWriter writer(make_unique<BloomFilter>(10), extractor, false);
+  for (int i = 0; i < 100; i++) {
+    writer.Update("t" + to_string(1000 + i) + "-key");
+  }
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block, extractor.get()), RC::OK);
+  for (int i = 0; i < 100; i++) {
+    string        key = "t" + to_string(1000 + i) + "-other";
+    LookupContext ctx(key, extractor.get());
+    EXPECT_TRUE(ctx.has_prefix_);
+    EXPECT_EQ(ctx.key_.Hash(), Hash64(key));
+    EXPECT_TRUE(reader.IsKeyExists(0, ctx));
+  }
+  /* 上下文中的前缀不是由构建时的提取器算出的，不能用来排除 */
+  auto          other = NewFixedPrefixExtractor(4);
+  LookupContext ctx("zzzz", other.get());
+  EXPECT_TRUE(reader.IsKeyExists(0, ctx));
+}
+
+TEST(FilterBlock, LegacyMurmur3Version) {
+  FilterBlockWriter writer(make_unique<BloomFilter>(10, BloomFilter::K_MURMUR3_VERSION));
+  vector<string>    keys;
+  for (int i = 0; i < 200; i++) {
+    keys.push_back("key\x80\xff" + to_string(i));
+    writer.Update(keys.back());
+  }
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block), RC::OK);
+  for (const auto &key : keys) {
+    EXPECT_TRUE(reader.IsKeyExists(0, key));
+    EXPECT_TRUE(reader.IsKeyExists(0, LookupContext(key)));
+  }
+}
+
+TEST(FilterBlock, BatchProbe) {
+  for (int version : {BloomFilter::K_MURMUR3_VERSION, BloomFilter::K_HASH64_VERSION}) {
+    FilterBlockWriter writer(make_unique<BloomFilter>(10, version));
+    for (int block = 0; block < 4; block++) {
+      for (int i = 0; i < 100; i++) {
+        writer.Update("key" + to_string(block * 100 + i));
+      }
+      writer.Keys2Block();
+    }
+    string block;
+    EXPECT_EQ(writer.Final(block), RC::OK);
+    FilterBlockReader reader;
+    EXPECT_EQ(reader.Init(block), RC::OK);
+
+    vector<string>                keys;
+    vector<int>                   block_nums;
+    vector<LookupContext>         ctxs;
+    vector<const LookupContext *> ctx_ptrs;
+    for (int i = 0; i < 1000; i++) {
+      keys.push_back("key" + to_string(i));
+      block_nums.push_back((i / 100) % 5);
+    }
+    for (const auto &key : keys) {
+      ctxs.emplace_back(key);
+    }
+    for (const auto &ctx : ctxs) {
+      ctx_ptrs.push_back(&ctx);
+    }
+    vector<bool> results;
+    reader.IsKeysExist(block_nums, ctx_ptrs, results);
+    ASSERT_EQ(results.size(), keys.size());
+    for (size_t i = 0; i < keys.size(); i++) {
+      EXPECT_EQ(results[i], reader.IsKeyExists(block_nums[i], ctxs[i]));
+      if (i < 400) {
+        EXPECT_TRUE(results[i]);
+      }
+      if (block_nums[i] == 4) {
+        EXPECT_FALSE(results[i]);
+      }
+    }
+  }
+}
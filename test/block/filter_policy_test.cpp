@@ -0,0 +1,105 @@
+#include "block/filter_policy.hh"
+#include <cmath>
+#include <memory>
+#include <string>
+#include "block/filter_block.hh"
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+using namespace std;
+
+TEST(FilterPolicy, AllocateFilterBits) {
+  vector<uint64_t> level_keys = {10000, 100000, 1000000, 10000000};
+  auto             bits       = AllocateFilterBits(level_keys, 10);
+  ASSERT_EQ(bits.size(), level_keys.size());
+  for (size_t i = 1; i < bits.size(); i++) {
+    EXPECT_GT(bits[i - 1], bits[i]);
+  }
+
+  /* 总内存与统一分配相当，误判率之和（每次查询的期望 I/O）更小 */
+  double total_keys = 0;
+  double total_bits = 0;
+  double uniform    = 0;
+  double monkey     = 0;
+  for (size_t i = 0; i < bits.size(); i++) {
+    total_keys += static_cast<double>(level_keys[i]);
+    total_bits += static_cast<double>(level_keys[i]) * bits[i];
+    uniform += BloomFalsePositiveRate(10);
+    monkey += BloomFalsePositiveRate(bits[i]);
+  }
+  EXPECT_NEAR(total_bits / total_keys, 10, 0.5);
+  EXPECT_LT(monkey, uniform);
+
+  /* 空层使用默认值，单层等价于统一分配 */
+  EXPECT_EQ(AllocateFilterBits({0, 1000}, 10), (vector<int>{10, 10}));
+  /* 预算很小时最大的层不再分配 bit */
+  auto tight = AllocateFilterBits({100, 1000000}, 0.01);
+  EXPECT_GT(tight[0], 1);
+  EXPECT_EQ(tight[1], 1);
+}
+
+/* 去掉的层占用的 1 bit/key 计入预算，总内存不超过 bits_per_key * 总 key 数 */
+TEST(FilterPolicy, AllocateFilterBitsDroppedLevel) {
+  vector<uint64_t> level_keys = {100000, 100000, 100000, 1000000};
+  auto             bits       = AllocateFilterBits(level_keys, 1.1);
+  ASSERT_EQ(bits.size(), level_keys.size());
+  EXPECT_EQ(bits.back(), 1);
+  double total_keys = 0;
+  double total_bits = 0;
+  for (size_t i = 0; i < bits.size(); i++) {
+    total_keys += static_cast<double>(level_keys[i]);
+    total_bits += static_cast<double>(level_keys[i]) * bits[i];
+  }
+  EXPECT_LE(total_bits, 1.1 * total_keys);
+}
+
+TEST(FilterPolicy, BloomFilterSize) {
+  FilterBlockWriter writer(make_unique<BloomFilter>(10));
+  for (int i = 0; i < 1000; i++) {
+    writer.Update("key" + to_string(i));
+  }
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+  /* 1000 个 key，每个 10 bit，加上偏移量和 filter_info */
+  EXPECT_LT(block.size(), 1250 + 64);
+
+  FilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block), RC::OK);
+  int false_positives = 0;
+  for (int i = 0; i < 10000; i++) {
+    EXPECT_TRUE(reader.IsKeyExists(0, "key" + to_string(i % 1000)));
+    if (reader.IsKeyExists(0, "missing" + to_string(i))) {
+      false_positives++;
+    }
+  }
+  EXPECT_LT(false_positives, 10000 * BloomFalsePositiveRate(10) * 2);
+}
+
+TEST(FilterPolicy, FilterStats) {
+  FilterStats stats;
+  stats.AddFilter(0, 100);
+  stats.AddFilter(0, 50);
+  stats.AddFilter(2, 1000);
+  stats.RemoveFilter(0, 50);
+  EXPECT_EQ(stats.FilterBytes(0), 100);
+  EXPECT_EQ(stats.FilterBytes(1), 0);
+  EXPECT_EQ(stats.FilterBytes(2), 1000);
+
+  for (int i = 0; i < 100; i++) {
+    stats.RecordProbe(2, i < 10);
+  }
+  for (int i = 0; i < 5; i++) {
+    stats.RecordFalsePositive(2);
+  }
+  EXPECT_EQ(stats.Probes(2), 100);
+  EXPECT_DOUBLE_EQ(stats.ObservedFalsePositiveRate(2), 5.0 / 95);
+  EXPECT_DOUBLE_EQ(stats.ObservedFalsePositiveRate(1), 0);
+  /* 超出范围的层计入最后一层 */
+  stats.AddFilter(100, 1);
+  EXPECT_EQ(stats.FilterBytes(FilterStats::K_MAX_LEVELS - 1), 1);
+
+  auto str = stats.ToString();
+  EXPECT_NE(str.find("L0"), string::npos);
+  EXPECT_NE(str.find("L2"), string::npos);
+  EXPECT_EQ(str.find("L1"), string::npos);
+}
@@ -0,0 +1,118 @@
+#include "block/range_filter_block.hh"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+using namespace std;
+
+namespace {
+
+auto BuildRangeFilter(const set<string> &keys, int max_depth) -> string {
+  RangeFilterBlockWriter writer(10, max_depth);
+  for (const auto &key : keys) {
+    EXPECT_EQ(writer.Update(key), RC::OK);
+  }
+  string block;
+  EXPECT_EQ(writer.Final(block), RC::OK);
+  return block;
+}
+
+auto HasKeyInRange(const set<string> &keys, const string &lower, const string &upper) -> bool {
+  auto iter = keys.lower_bound(lower);
+  return iter != keys.end() && (upper.empty() || *iter < upper);
+}
+
+auto Key(uint64_t i) -> string {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "user%012lu", static_cast<unsigned long>(i));
+  return buf;
+}
+
+}  // namespace
+
+TEST(RangeFilterBlock, Basic) {
+  set<string> keys = {"apple", "apricot", "banana", "blueberry", "cherry"};
+  string      block = BuildRangeFilter(keys, 8);
+
+  RangeFilterBlockReader reader;
+  EXPECT_EQ(reader.Init(block), RC::OK);
+  EXPECT_TRUE(reader.MayContainRange("a", "b"));
+  EXPECT_TRUE(reader.MayContainRange("b", ""));
+  EXPECT_TRUE(reader.MayContainRange("apple", "apple\x01"));
+  EXPECT_TRUE(reader.MayContainRange("az", "bananaz"));
+  EXPECT_FALSE(reader.MayContainRange("0", "apple"));
+  EXPECT_FALSE(reader.MayContainRange("cherry\x01", ""));
+  EXPECT_FALSE(reader.MayContainRange("b", "a"));
+  EXPECT_FALSE(reader.MayContainRange("apple\x01", "apricot"));
+  EXPECT_FALSE(reader.MayContainRange("c", "cherry"));
+
+  RangeFilterBlockReader empty;
+  EXPECT_EQ(empty.Init(BuildRangeFilter({}, 8)), RC::OK);
+  EXPECT_FALSE(empty.MayContainRange("", ""));
+
+  RangeFilterBlockReader bad;
+  EXPECT_EQ(bad.Init(block.substr(1)), RC::FILTER_BLOCK_ERROR);
+}
+
+/* 与暴力查找对比：不能有漏判，短范围的空查询大多能被排除 */
+TEST(RangeFilterBlock, ShortRangeScan) {
+  mt19937_64  rng(7);
+  set<string> keys;
+  for (int i = 0; i < 5000; i++) {
+    keys.insert(Key(rng() % 10000000));
+  }
+  for (int max_depth : {2, 4, 8}) {
+    string                 block = BuildRangeFilter(keys, max_depth);
+    RangeFilterBlockReader reader;
+    ASSERT_EQ(reader.Init(block), RC::OK);
+
+    int empty_ranges = 0;
+    int skipped      = 0;
+    for (int i = 0; i < 20000; i++) {
+      uint64_t begin = rng() % 10000000;
+      string   lower = Key(begin);
+      string   upper = Key(begin + 100);
+      bool     exist = HasKeyInRange(keys, lower, upper);
+      bool     may   = reader.MayContainRange(lower, upper);
+      ASSERT_TRUE(!exist || may) << lower << " " << upper;
+      if (!exist) {
+        empty_ranges++;
+        skipped += may ? 0 : 1;
+      }
+    }
+    if (max_depth == 8) {
+      EXPECT_GT(skipped, empty_ranges * 9 / 10);
+    }
+  }
+}
+
+TEST(RangeFilterBlock, RandomBytes) {
+  mt19937_64  rng(11);
+  set<string> keys;
+  auto        random_key = [&]() {
+    string key(1 + rng() % 6, '\0');
+    for (auto &c : key) {
+      c = static_cast<char>("ab\x00\xff"[rng() % 4]);
+    }
+    return key;
+  };
+  for (int i = 0; i < 200; i++) {
+    keys.insert(random_key());
+  }
+  for (int max_depth : {1, 3, 8}) {
+    string                 block = BuildRangeFilter(keys, max_depth);
+    RangeFilterBlockReader reader;
+    ASSERT_EQ(reader.Init(block), RC::OK);
+    for (int i = 0; i < 20000; i++) {
+      string lower = random_key();
+      string upper = random_key();
+      if (i % 10 == 0) {
+        upper.clear();
+      }
+      ASSERT_TRUE(!HasKeyInRange(keys, lower, upper) || reader.MayContainRange(lower, upper));
+    }
+  }
+}
@@ -0,0 +1,140 @@
+#include "block_cache.hh"
+#include <string>
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr size_t K_BLOCK_SIZE = 4096;
+
+/* 测试用的游程编码：每段为 1 字节长度 + 1 字节内容 */
+auto Compress(const std::string &block) -> std::string {
+  std::string compressed;
+  for (size_t i = 0; i < block.size();) {
+    size_t run = 1;
+    while (i + run < block.size() && run < 255 && block[i + run] == block[i]) {
+      run++;
+    }
+    compressed.push_back(static_cast<char>(run));
+    compressed.push_back(block[i]);
+    i += run;
+  }
+  return compressed;
+}
+
+auto Decompress(std::string_view compressed, std::string &block) -> RC {
+  if (compressed.size() % 2 != 0) {
+    return RC::CHECK_SUM_ERROR;
+  }
+  block.clear();
+  for (size_t i = 0; i < compressed.size(); i += 2) {
+    block.append(static_cast<uint8_t>(compressed[i]), compressed[i + 1]);
+  }
+  return RC::OK;
+}
+
+/* 每 64 字节重复一个字符，压缩率约为 1/16 */
+auto MakeBlock(uint64_t seed) -> std::string {
+  std::string block(K_BLOCK_SIZE, '\0');
+  for (size_t i = 0; i < K_BLOCK_SIZE; i++) {
+    block[i] = static_cast<char>('a' + (seed + i / 64) % 26);
+  }
+  return block;
+}
+
+auto MakeOptions(size_t capacity) -> CacheOptions {
+  CacheOptions options;
+  options.capacity_   = capacity;
+  options.shard_bits_ = 0;
+  return options;
+}
+
+}  // namespace
+
+/* 工作集超过未压缩层的容量时，未命中的块从压缩层解压，不需要读磁盘 */
+TEST(BlockCache, CompressedTier) {
+  constexpr int K_BLOCKS = 64;
+
+  BlockCache cache(MakeOptions(32 * K_BLOCK_SIZE), 0.25, Decompress);
+  EXPECT_EQ(cache.Capacity(), 32 * K_BLOCK_SIZE);
+  int  disk_reads = 0;
+  auto read_block = [&](uint64_t offset) -> std::string {
+    BlockCacheKey key(1, offset);
+    if (auto handle = cache.Lookup(key)) {
+      return *handle;
+    }
+    disk_reads++;
+    std::string block = MakeBlock(offset);
+    return *cache.Insert(key, block, Compress(block));
+  };
+
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < K_BLOCKS; i++) {
+      ASSERT_EQ(read_block(i), MakeBlock(i));
+    }
+  }
+  EXPECT_EQ(disk_reads, K_BLOCKS);
+  EXPECT_LE(cache.Usage(), cache.Capacity());
+  auto stats = cache.Stats();
+  EXPECT_GT(stats.decompressions_, 0);
+  EXPECT_EQ(stats.decompress_failures_, 0);
+
+  /* 不使用压缩层时，工作集超过容量后按 LRU 顺序访问每次都要读磁盘 */
+  BlockCache uncompressed_only(MakeOptions(32 * K_BLOCK_SIZE), 0, Decompress);
+  disk_reads = 0;
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < K_BLOCKS; i++) {
+      BlockCacheKey key(1, i);
+      if (!uncompressed_only.Lookup(key)) {
+        disk_reads++;
+        std::string block = MakeBlock(i);
+        uncompressed_only.Insert(key, block, Compress(block));
+      }
+    }
+  }
+  EXPECT_EQ(disk_reads, 3 * K_BLOCKS);
+  EXPECT_EQ(uncompressed_only.Stats().compressed_.inserts_, 0);
+}
+
+/* 没有解压函数时忽略压缩层的比例，全部容量给未压缩层 */
+TEST(BlockCache, NoDecompressor) {
+  constexpr int K_BLOCKS = 24;
+
+  BlockCache cache(MakeOptions(32 * K_BLOCK_SIZE), 0.5, nullptr);
+  for (int i = 0; i < K_BLOCKS; i++) {
+    std::string block = MakeBlock(i);
+    cache.Insert({1, static_cast<uint64_t>(i)}, block, Compress(block));
+  }
+  for (int i = 0; i < K_BLOCKS; i++) {
+    EXPECT_TRUE(cache.Lookup({1, static_cast<uint64_t>(i)})) << i;
+  }
+  EXPECT_EQ(cache.Stats().compressed_.inserts_, 0);
+  EXPECT_EQ(cache.Capacity(), 32 * K_BLOCK_SIZE);
+}
+
+/* 没有压缩的块只放入未压缩层；解压失败的块从压缩层删除，按未命中处理 */
+TEST(BlockCache, InsertAndErase) {
+  BlockCache  cache(MakeOptions(64 * K_BLOCK_SIZE), 0.5, Decompress);
+  std::string block = MakeBlock(0);
+  cache.Insert({1, 0}, block, "");
+  cache.Insert({1, 1}, block, std::string(2 * K_BLOCK_SIZE, 'x'));
+  cache.Insert({1, 2}, block, "odd");
+  EXPECT_EQ(cache.Stats().compressed_.inserts_, 1);
+
+  cache.Erase({1, 0});
+  EXPECT_FALSE(cache.Lookup({1, 0}));
+
+  /* 把 {1, 2} 挤出未压缩层，只留在压缩层中 */
+  for (uint64_t i = 0; i < 64; i++) {
+    cache.Insert({2, i}, MakeBlock(i), "");
+  }
+  EXPECT_FALSE(cache.Lookup({1, 2}));
+  EXPECT_EQ(cache.Stats().decompress_failures_, 1);
+  EXPECT_FALSE(cache.Lookup({1, 2}));
+  EXPECT_EQ(cache.Stats().decompress_failures_, 1);
+
+  cache.SetCapacity(16 * K_BLOCK_SIZE);
+  EXPECT_EQ(cache.Capacity(), 16 * K_BLOCK_SIZE);
+  EXPECT_LE(cache.Usage(), cache.Capacity());
+}
@@ -0,0 +1,270 @@
+#include "cache.hh"
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "block/block.hh"
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+using namespace std;
+
+TEST(ShardedCache, InsertLookup) {
+  ShardedCache<int, string> cache(100, 0);
+  EXPECT_FALSE(cache.Lookup(1));
+  EXPECT_EQ(*cache.Insert(1, "one", 10), "one");
+  auto handle = cache.Lookup(1);
+  ASSERT_TRUE(handle);
+  EXPECT_EQ(*handle, "one");
+  EXPECT_EQ(handle->size(), 3);
+  EXPECT_EQ(cache.Usage(), 10);
+
+  /* 替换后旧的 Handle 仍然有效 */
+  cache.Insert(1, "uno", 20);
+  EXPECT_EQ(*handle, "one");
+  EXPECT_EQ(*cache.Lookup(1), "uno");
+  EXPECT_EQ(cache.Usage(), 20);
+
+  EXPECT_TRUE(cache.Erase(1));
+  EXPECT_FALSE(cache.Erase(1));
+  EXPECT_FALSE(cache.Lookup(1));
+  EXPECT_EQ(cache.Usage(), 0);
+  EXPECT_EQ(*handle, "one");
+}
+
+TEST(ShardedCache, EvictByCharge) {
+  ShardedCache<int, int> cache(100, 0);
+  for (int i = 0; i < 10; i++) {
+    cache.Insert(i, i, 10);
+  }
+  EXPECT_EQ(cache.Usage(), 100);
+  /* 访问 0 之后最久未使用的是 1 */
+  EXPECT_TRUE(cache.Lookup(0));
+  cache.Insert(10, 10, 15);
+  EXPECT_TRUE(cache.Lookup(0));
+  EXPECT_FALSE(cache.Lookup(1));
+  EXPECT_FALSE(cache.Lookup(2));
+  EXPECT_TRUE(cache.Lookup(3));
+  EXPECT_LE(cache.Usage(), 100);
+
+  /* 比容量还大的条目插入后立刻淘汰 */
+  cache.Insert(11, 11, 1000);
+  EXPECT_FALSE(cache.Lookup(11));
+}
+
+TEST(ShardedCache, PinnedEntries) {
+  ShardedCache<int, int> cache(30, 0);
+  auto                   h0 = cache.Insert(0, 0, 10);
+  auto                   h1 = cache.Insert(1, 1, 10);
+  auto                   h2 = cache.Insert(2, 2, 10);
+  /* 被引用的条目不能淘汰，允许暂时超出容量 */
+  auto h3 = cache.Insert(3, 3, 10);
+  EXPECT_EQ(cache.Usage(), 40);
+  EXPECT_EQ(cache.PinnedUsage(), 40);
+  EXPECT_TRUE(cache.Lookup(0));
+
+  /* 释放引用后淘汰 */
+  h0.Reset();
+  EXPECT_FALSE(cache.Lookup(0));
+  EXPECT_EQ(cache.Usage(), 30);
+
+  auto copy = h1;
+  h1.Reset();
+  EXPECT_EQ(*copy, 1);
+  EXPECT_EQ(cache.PinnedUsage(), 30);
+  auto moved = std::move(copy);
+  EXPECT_FALSE(copy);
+  EXPECT_EQ(*moved, 1);
+
+  cache.SetCapacity(0);
+  EXPECT_EQ(cache.Usage(), 30);
+  moved.Reset();
+  h2.Reset();
+  h3.Reset();
+  EXPECT_EQ(cache.Usage(), 0);
+  /* 容量为 0 时不缓存，但仍然返回可用的 Handle */
+  auto h4 = cache.Insert(4, 4, 10);
+  EXPECT_EQ(*h4, 4);
+  EXPECT_FALSE(cache.Lookup(4));
+}
+
+/* 热点 key 被访问过两次后，一次大范围扫描不会把它们挤出缓存 */
+TEST(ShardedCache, S3FifoScanResistance) {
+  for (auto policy : {CacheEvictionPolicy::LRU, CacheEvictionPolicy::S3_FIFO}) {
+    ShardedCache<int, int> cache(1000, 0, policy);
+    for (int round = 0; round < 2; round++) {
+      for (int i = 0; i < 50; i++) {
+        if (!cache.Lookup(i)) {
+          cache.Insert(i, i, 10);
+        }
+      }
+    }
+    for (int i = 1000; i < 3000; i++) {
+      if (!cache.Lookup(i)) {
+        cache.Insert(i, i, 10);
+      }
+    }
+    int hot_hits = 0;
+    for (int i = 0; i < 50; i++) {
+      hot_hits += cache.Lookup(i) ? 1 : 0;
+    }
+    EXPECT_LE(cache.Usage(), 1000);
+    if (policy == CacheEvictionPolicy::LRU) {
+      EXPECT_EQ(hot_hits, 0);
+    } else {
+      EXPECT_EQ(hot_hits, 50);
+    }
+  }
+}
+
+/* 刚被小队列淘汰的 key 再次插入时直接进入主队列 */
+TEST(ShardedCache, S3FifoGhost) {
+  ShardedCache<int, int> cache(100, 0, CacheEvictionPolicy::S3_FIFO);
+  for (int i = 0; i < 20; i++) {
+    cache.Insert(i, i, 10);
+  }
+  EXPECT_FALSE(cache.Lookup(0));
+  cache.Insert(0, 0, 10);
+  for (int i = 100; i < 200; i++) {
+    cache.Insert(i, i, 10);
+  }
+  EXPECT_TRUE(cache.Lookup(0));
+  EXPECT_FALSE(cache.Lookup(1));
+
+  /* 被引用的条目不会被淘汰 */
+  auto pinned = cache.Insert(500, 500, 10);
+  for (int i = 200; i < 300; i++) {
+    cache.Insert(i, i, 10);
+  }
+  EXPECT_TRUE(cache.Lookup(500));
+  EXPECT_EQ(cache.PinnedUsage(), 10);
+}
+
+TEST(ShardedCache, Concurrent) {
+  for (auto policy : {CacheEvictionPolicy::LRU, CacheEvictionPolicy::S3_FIFO}) {
+    ShardedCache<int, int> cache(1000, 4, policy);
+    vector<thread>         threads;
+    for (int t = 0; t < 8; t++) {
+      threads.emplace_back([&cache, t]() {
+        for (int i = 0; i < 20000; i++) {
+          int  key    = (i * 7 + t) % 500;
+          auto handle = cache.Lookup(key);
+          if (handle) {
+            EXPECT_EQ(*handle, key);
+          } else {
+            cache.Insert(key, key, 5);
+          }
+        }
+      });
+    }
+    for (auto &th : threads) {
+      th.join();
+    }
+    EXPECT_LE(cache.Usage(), 1000 + 16 * 5);
+    EXPECT_EQ(cache.PinnedUsage(), 0);
+  }
+}
+
+/* 只访问一次的 key 不能挤掉被反复访问的 key */
+TEST(ShardedCache, TinyLfuAdmission) {
+  for (auto policy : {CacheEvictionPolicy::LRU, CacheEvictionPolicy::S3_FIFO}) {
+    CacheOptions options;
+    options.capacity_               = 1000;
+    options.shard_bits_             = 0;
+    options.policy_                 = policy;
+    options.tiny_lfu_admission_     = true;
+    options.estimated_entry_charge_ = 10;
+    ShardedCache<int, int> cache(options);
+    for (int round = 0; round < 5; round++) {
+      for (int i = 0; i < 100; i++) {
+        if (!cache.Lookup(i)) {
+          cache.Insert(i, i, 10);
+        }
+      }
+    }
+    for (int i = 1000; i < 2000; i++) {
+      if (!cache.Lookup(i)) {
+        /* 没有被缓存时仍然返回可用的 Handle */
+        EXPECT_EQ(*cache.Insert(i, i, 10), i);
+      }
+    }
+    int hot_hits = 0;
+    for (int i = 0; i < 100; i++) {
+      hot_hits += cache.Lookup(i) ? 1 : 0;
+    }
+    EXPECT_GT(hot_hits, 95);
+
+    auto stats = cache.Stats();
+    EXPECT_EQ(stats.lookups_, 500 + 1000 + 100);
+    EXPECT_GT(stats.rejections_, 900);
+    EXPECT_EQ(stats.hits_, 400 + hot_hits);
+    EXPECT_EQ(stats.inserts_, 100 + 1000);
+  }
+}
+
+/* 不同表相同偏移量的块互不干扰 */
+TEST(ShardedCache, BlockCacheKey) {
+  ShardedCache<BlockCacheKey, std::string> cache(1 << 20);
+  std::unordered_set<uint64_t>            ids;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_TRUE(ids.insert(cache.NewId()).second);
+  }
+
+  uint64_t table1 = cache.NewId();
+  uint64_t table2 = cache.NewId();
+  for (uint64_t offset = 0; offset < 64 * 4096; offset += 4096) {
+    cache.Insert({table1, offset}, "t1_" + std::to_string(offset), 100);
+    cache.Insert({table2, offset}, "t2_" + std::to_string(offset), 100);
+  }
+  for (uint64_t offset = 0; offset < 64 * 4096; offset += 4096) {
+    auto h1 = cache.Lookup({table1, offset});
+    auto h2 = cache.Lookup({table2, offset});
+    ASSERT_TRUE(h1 && h2);
+    EXPECT_EQ(*h1, "t1_" + std::to_string(offset));
+    EXPECT_EQ(*h2, "t2_" + std::to_string(offset));
+  }
+  EXPECT_FALSE(cache.Lookup({table1, 1}));
+}
+
+/* 扫描只替换低优先级池，高优先级池超出比例时最早的条目降级 */
+TEST(ShardedCache, PriorityPool) {
+  for (auto policy : {CacheEvictionPolicy::LRU, CacheEvictionPolicy::S3_FIFO}) {
+    CacheOptions options;
+    options.capacity_            = 1000;
+    options.shard_bits_          = 0;
+    options.policy_              = policy;
+    options.high_pri_pool_ratio_ = 0.3;
+    ShardedCache<int, int> cache(options);
+    for (int i = 0; i < 20; i++) {
+      cache.Insert(i, i, 10, CachePriority::HIGH);
+    }
+    for (int i = 1000; i < 2000; i++) {
+      if (!cache.Lookup(i)) {
+        cache.Insert(i, i, 10);
+      }
+    }
+    for (int i = 0; i < 20; i++) {
+      EXPECT_TRUE(cache.Lookup(i));
+    }
+    auto stats = cache.Stats();
+    EXPECT_EQ(stats.usage_, 1000);
+    EXPECT_EQ(stats.high_pri_usage_, 200);
+    EXPECT_DOUBLE_EQ(stats.HighPriRatio(), 0.2);
+
+    for (int i = 20; i < 100; i++) {
+      cache.Insert(i, i, 10, CachePriority::HIGH);
+    }
+    EXPECT_LE(cache.HighPriorityUsage(), 300);
+    EXPECT_EQ(cache.Usage(), 1000);
+    /* 最近插入的高优先级条目都在 */
+    for (int i = 70; i < 100; i++) {
+      EXPECT_TRUE(cache.Lookup(i));
+    }
+  }
+
+  /* 比例为 0 时不区分优先级 */
+  ShardedCache<int, int> cache(CacheOptions{.capacity_ = 1000, .shard_bits_ = 0});
+  cache.Insert(1, 1, 10, CachePriority::HIGH);
+  EXPECT_EQ(cache.HighPriorityUsage(), 0);
+  EXPECT_EQ(cache.Usage(), 10);
+}
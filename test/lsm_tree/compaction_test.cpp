@@ -0,0 +1,629 @@
+#include "compaction.hh"
+#include <fmt/format.h>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "db.hh"
+#include "gtest/gtest.h"
+#include "memtable/memtable.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto TestDir(const std::string &name) -> std::string {
+  std::string dir = ::testing::TempDir() + "compaction_" + name;
+  if (FileManager::Exists(dir)) {
+    FileManager::Destroy(dir);
+  }
+  FileManager::Create(dir, FileOptions::DIR_);
+  return dir;
+}
+
+/* 只用于选择输入的文件元数据，磁盘上没有对应的 sst 文件 */
+auto MakeFile(int id, const std::string &smallest, const std::string &largest, int64_t seq, size_t size)
+    -> FileMetaData {
+  FileMetaData meta;
+  memset(meta.sha256_, id, sizeof(meta.sha256_));
+  meta.file_size_     = size;
+  meta.num_keys_      = 1;
+  meta.max_seq_       = seq;
+  meta.min_inner_key_ = MemKey(smallest, seq);
+  meta.max_inner_key_ = MemKey(largest, seq);
+  return meta;
+}
+
+auto Oids(const vector<Version::FileRef> &files) -> std::vector<std::string> {
+  std::vector<std::string> oids;
+  for (const auto &file : files) {
+    oids.push_back(file->GetOid());
+  }
+  return oids;
+}
+
+auto UserKey(int i) -> std::string { return fmt::format("key{:08}", i); }
+
+auto Value(int i, int version) -> std::string {
+  return fmt::format("value{:08}-{}-{}", i, version, std::string(64, 'v'));
+}
+
+auto CountSstFiles(const std::string &dbname) -> int {
+  int files = 0;
+  FileManager::ReadDir(
+      SstDir(dbname), [](string_view name) { return name.ends_with(".sst"); }, [&](string_view) { files++; });
+  return files;
+}
+
+}  // namespace
+
+TEST(LeveledCompactionPicker, LevelTargets) {
+  DBOptions options;
+  options.max_bytes_for_level_base_       = 1000;
+  options.max_bytes_for_level_multiplier_ = 10;
+  options.target_file_size_base_          = 100;
+  options.target_file_size_multiplier_    = 2;
+  LeveledCompactionPicker picker(options);
+  EXPECT_DOUBLE_EQ(picker.MaxBytesForLevel(1), 1000);
+  EXPECT_DOUBLE_EQ(picker.MaxBytesForLevel(3), 100000);
+  EXPECT_EQ(picker.MaxFileSizeForLevel(1), 100);
+  EXPECT_EQ(picker.MaxFileSizeForLevel(3), 400);
+}
+
+/* 从最旧的 L0 文件开始扩展到所有重叠的 L0 文件，再加入 L1 中重叠的文件 */
+TEST(LeveledCompactionPicker, PickL0WithOverlappingFiles) {
+  DBOptions options;
+  options.level_files_limit_ = 4;
+  auto       dbname          = TestDir("pick_l0");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  LeveledCompactionPicker picker(options);
+
+  auto        a = MakeFile(1, "a", "c", 1, 100);
+  auto        b = MakeFile(2, "b", "d", 2, 100);
+  auto        c = MakeFile(3, "x", "z", 3, 100);
+  VersionEdit edit;
+  edit.AddFile(0, a);
+  edit.AddFile(0, b);
+  edit.AddFile(0, c);
+  edit.AddFile(1, MakeFile(4, "a", "b", 0, 100));
+  edit.AddFile(1, MakeFile(5, "c", "e", 0, 100));
+  edit.AddFile(1, MakeFile(6, "m", "n", 0, 100));
+  edit.AddFile(2, MakeFile(7, "e", "f", 0, 100));
+  edit.AddFile(2, MakeFile(8, "g", "h", 0, 100));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+  EXPECT_FALSE(picker.NeedsCompaction(*versions.Current()));
+
+  VersionEdit more;
+  more.AddFile(0, MakeFile(9, "e", "f", 4, 100));
+  ASSERT_EQ(versions.LogAndApply(more), RC::OK);
+  auto version = versions.Current();
+  EXPECT_DOUBLE_EQ(picker.LevelScore(*version, 0), 1);
+  ASSERT_TRUE(picker.NeedsCompaction(*version));
+
+  auto compaction = picker.PickCompaction(*version);
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->output_level_, 1);
+  EXPECT_FALSE(compaction->IsTrivialMove());
+  ASSERT_EQ(compaction->inputs_.size(), 2);
+  EXPECT_EQ(compaction->inputs_[0].level_, 0);
+  EXPECT_EQ(Oids(compaction->inputs_[0].files_), (std::vector<std::string>{b.GetOid(), a.GetOid()}));
+  EXPECT_EQ(compaction->inputs_[1].level_, 1);
+  EXPECT_EQ(compaction->inputs_[1].files_.size(), 2);
+  /* L1 的输入把范围扩展到 [a, e]，与 L2 的 [e, f] 重叠 */
+  EXPECT_EQ(Oids(compaction->grandparents_), (std::vector<std::string>{MakeFile(7, "e", "f", 0, 0).GetOid()}));
+  EXPECT_EQ(compaction->NumInputFiles(), 4);
+  EXPECT_EQ(compaction->InputBytes(), 400);
+}
+
+/* L1 超过目标大小时选择与 L2 重叠比例最小的文件，不重叠时可以直接移动 */
+TEST(LeveledCompactionPicker, PickLeastOverlappingFile) {
+  DBOptions options;
+  options.max_bytes_for_level_base_ = 150;
+  auto       dbname                 = TestDir("pick_least_overlap");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  LeveledCompactionPicker picker(options);
+
+  VersionEdit edit;
+  edit.AddFile(1, MakeFile(1, "a", "c", 0, 100));
+  edit.AddFile(1, MakeFile(2, "d", "f", 0, 100));
+  edit.AddFile(1, MakeFile(3, "g", "i", 0, 100));
+  edit.AddFile(2, MakeFile(4, "a", "b", 0, 1000));
+  edit.AddFile(2, MakeFile(5, "e", "e", 0, 50));
+  edit.AddFile(2, MakeFile(6, "g", "g", 0, 30));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+  auto version = versions.Current();
+  EXPECT_DOUBLE_EQ(picker.LevelScore(*version, 1), 2);
+
+  auto compaction = picker.PickCompaction(*version);
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->output_level_, 2);
+  EXPECT_EQ(Oids(compaction->inputs_[0].files_), (std::vector<std::string>{MakeFile(3, "", "", 0, 0).GetOid()}));
+  ASSERT_EQ(compaction->inputs_.size(), 2);
+  EXPECT_EQ(Oids(compaction->inputs_[1].files_), (std::vector<std::string>{MakeFile(6, "", "", 0, 0).GetOid()}));
+
+  /* L2 中与 [g, i] 重叠的文件移到 L3 之后，[g, i] 可以直接移动 */
+  VersionEdit move;
+  move.DeleteFile(2, MakeFile(6, "", "", 0, 0).GetOid());
+  move.AddFile(3, MakeFile(6, "g", "g", 0, 30));
+  ASSERT_EQ(versions.LogAndApply(move), RC::OK);
+  compaction = picker.PickCompaction(*versions.Current());
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->NumInputFiles(), 1);
+  EXPECT_EQ(Oids(compaction->grandparents_), (std::vector<std::string>{MakeFile(6, "", "", 0, 0).GetOid()}));
+  EXPECT_TRUE(compaction->IsTrivialMove());
+}
+
+/* 写入触发多层 compaction，每层文件不重叠，输出文件按目标大小切分，被替换的文件从磁盘删除 */
+TEST(LeveledCompaction, CompactAcrossLevels) {
+  constexpr int K_KEYS = 20000;
+
+  DBOptions options;
+  options.create_if_not_exists_     = true;
+  options.mem_table_size_           = 64 << 10;
+  options.level_files_limit_        = 4;
+  options.max_bytes_for_level_base_ = 512 << 10;
+  options.target_file_size_base_    = 64 << 10;
+  auto dbname                       = ::testing::TempDir() + "compaction_across_levels";
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+
+  std::vector<int> keys(K_KEYS);
+  for (int i = 0; i < K_KEYS; i++) {
+    keys[i] = i;
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  {
+    std::unique_ptr<DB> db;
+    ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+    for (int version = 0; version < 2; version++) {
+      for (int i : keys) {
+        ASSERT_EQ(db->Put(UserKey(i), Value(i, version)), RC::OK);
+      }
+    }
+    for (int i = 0; i < K_KEYS; i += 5) {
+      ASSERT_EQ(db->Delete(UserKey(i)), RC::OK);
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+    ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+
+    auto version = db->CurrentVersion();
+    EXPECT_LT(version->NumFiles(0), options.level_files_limit_);
+    EXPECT_GT(version->NumFiles(1), 1);
+    EXPECT_GT(version->NumFiles(2), 0);
+    int total_files = 0;
+    for (int level = 0; level < K_NUM_LEVELS; level++) {
+      total_files += version->NumFiles(level);
+      const auto &files = version->Files(level);
+      for (size_t i = 1; level > 0 && i < files.size(); i++) {
+        EXPECT_LT(files[i - 1]->max_inner_key_.user_key_, files[i]->min_inner_key_.user_key_);
+      }
+      for (const auto &file : files) {
+        if (level > 0) {
+          EXPECT_LT(file->file_size_, 2 * options.target_file_size_base_);
+        }
+      }
+    }
+    EXPECT_EQ(CountSstFiles(dbname), total_files);
+    EXPECT_GT(db->GetCompactionStats(1).compactions_, 0);
+    EXPECT_GT(db->GetCompactionStats(1).bytes_written_, 0);
+    EXPECT_GT(db->GetCompactionStats(2).compactions_ + db->GetCompactionStats(2).trivial_moves_, 0);
+
+    std::string value;
+    for (int i = 0; i < K_KEYS; i++) {
+      if (i % 5 == 0) {
+        EXPECT_EQ(db->Get(UserKey(i), value), RC::NOT_FOUND) << i;
+      } else {
+        ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+        EXPECT_EQ(value, Value(i, 1));
+      }
+    }
+  }
+
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    EXPECT_EQ(db->Get(UserKey(i), value), i % 5 == 0 ? RC::NOT_FOUND : RC::OK) << i;
+  }
+}
+
+/* 除最旧的有序段外的大小达到最旧的段的 200% 时合并所有有序段到最后一层 */
+TEST(UniversalCompactionPicker, SpaceAmplification) {
+  DBOptions options;
+  options.compaction_style_  = CompactionStyle::UNIVERSAL;
+  options.level_files_limit_ = 3;
+  auto       dbname          = TestDir("universal_space_amp");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  auto picker = NewCompactionPicker(options);
+
+  VersionEdit edit;
+  edit.AddFile(0, MakeFile(1, "a", "c", 3, 100));
+  edit.AddFile(0, MakeFile(2, "b", "d", 2, 100));
+  edit.AddFile(K_NUM_LEVELS - 1, MakeFile(3, "a", "z", 0, 100));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+  auto version = versions.Current();
+  auto runs    = UniversalCompactionPicker::SortedRuns(*version);
+  ASSERT_EQ(runs.size(), 3);
+  EXPECT_EQ(runs[0].file_->max_seq_, 3);
+  EXPECT_EQ(runs[2].level_, K_NUM_LEVELS - 1);
+  ASSERT_TRUE(picker->NeedsCompaction(*version));
+
+  auto compaction = picker->PickCompaction(*version);
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->output_level_, K_NUM_LEVELS - 1);
+  ASSERT_EQ(compaction->inputs_.size(), 2);
+  EXPECT_EQ(compaction->inputs_[0].level_, 0);
+  EXPECT_EQ(compaction->inputs_[0].files_.size(), 2);
+  EXPECT_EQ(compaction->inputs_[1].level_, K_NUM_LEVELS - 1);
+  EXPECT_EQ(compaction->NumInputFiles(), 3);
+}
+
+/* 大小相近的有序段合并，写入下一个有序段之上的层 */
+TEST(UniversalCompactionPicker, SizeRatio) {
+  DBOptions options;
+  options.compaction_style_  = CompactionStyle::UNIVERSAL;
+  options.level_files_limit_ = 3;
+  auto       dbname          = TestDir("universal_size_ratio");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  UniversalCompactionPicker picker(options);
+
+  VersionEdit edit;
+  edit.AddFile(0, MakeFile(1, "a", "c", 4, 10));
+  edit.AddFile(0, MakeFile(2, "a", "c", 3, 10));
+  edit.AddFile(0, MakeFile(3, "a", "c", 2, 25));
+  edit.AddFile(5, MakeFile(4, "a", "z", 1, 1000));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+  auto compaction = picker.PickCompaction(*versions.Current());
+  ASSERT_NE(compaction, nullptr);
+  /* 25 大于 (10 + 10) * 101%，只合并最新的两个段，下一个段在 L0，输出为 L0 中的一个文件 */
+  EXPECT_EQ(compaction->output_level_, 0);
+  EXPECT_EQ(compaction->max_output_file_size_, SIZE_MAX);
+  ASSERT_EQ(compaction->inputs_.size(), 1);
+  EXPECT_EQ(Oids(compaction->inputs_[0].files_),
+            (std::vector<std::string>{MakeFile(1, "", "", 0, 0).GetOid(), MakeFile(2, "", "", 0, 0).GetOid()}));
+
+  /* 第三个段不大于 (10 + 10) * 101% 时一起合并，写入 L5 之上的 L4 */
+  VersionEdit resize;
+  resize.DeleteFile(0, MakeFile(3, "", "", 0, 0).GetOid());
+  resize.AddFile(0, MakeFile(5, "a", "c", 2, 20));
+  ASSERT_EQ(versions.LogAndApply(resize), RC::OK);
+  compaction = picker.PickCompaction(*versions.Current());
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->output_level_, 4);
+  EXPECT_EQ(compaction->NumInputFiles(), 3);
+}
+
+/* 没有大小相近的有序段时合并最新的段，使有序段个数降到触发值以下 */
+TEST(UniversalCompactionPicker, ReduceSortedRuns) {
+  DBOptions options;
+  options.compaction_style_  = CompactionStyle::UNIVERSAL;
+  options.level_files_limit_ = 3;
+  auto       dbname          = TestDir("universal_reduce");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  UniversalCompactionPicker picker(options);
+
+  VersionEdit edit;
+  edit.AddFile(0, MakeFile(1, "a", "c", 3, 10));
+  edit.AddFile(0, MakeFile(2, "a", "c", 2, 100));
+  edit.AddFile(3, MakeFile(3, "a", "z", 1, 1000));
+  edit.AddFile(K_NUM_LEVELS - 1, MakeFile(4, "a", "z", 0, 100000));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+  auto compaction = picker.PickCompaction(*versions.Current());
+  ASSERT_NE(compaction, nullptr);
+  EXPECT_EQ(compaction->NumInputFiles(), 2);
+  EXPECT_EQ(compaction->output_level_, 2);
+}
+
+namespace {
+
+/* 同样的写入在两种 compaction 策略下 compaction 写入的总字节数。每写 K_FLUSH_INTERVAL 个 key 就 Flush 并等待 compaction
+ * 完成，每次 compaction 的输入与后台线程的调度无关，结果是确定的 */
+auto CompactionBytesWritten(CompactionStyle style, const std::string &name) -> uint64_t {
+  constexpr int K_KEYS           = 20000;
+  constexpr int K_FLUSH_INTERVAL = 400;
+
+  DBOptions options;
+  options.create_if_not_exists_     = true;
+  options.compaction_style_         = style;
+  options.mem_table_size_           = 64 << 10;
+  options.level_files_limit_        = 8;
+  options.max_bytes_for_level_base_ = 256 << 10;
+  options.target_file_size_base_    = 64 << 10;
+  auto dbname                       = ::testing::TempDir() + "compaction_" + name;
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  std::unique_ptr<DB> db;
+  EXPECT_EQ(DB::Open(dbname, options, db), RC::OK);
+  std::mt19937     rng(7);
+  std::vector<int> last(K_KEYS, -1);
+  for (int n = 0; n < 3 * K_KEYS; n++) {
+    int i = static_cast<int>(rng() % K_KEYS);
+    EXPECT_EQ(db->Put(UserKey(i), Value(i, n)), RC::OK);
+    last[i] = n;
+    if ((n + 1) % K_FLUSH_INTERVAL == 0) {
+      EXPECT_EQ(db->Flush(), RC::OK);
+      EXPECT_EQ(db->WaitForCompaction(), RC::OK);
+    }
+  }
+  EXPECT_EQ(db->Delete(UserKey(1)), RC::OK);
+  EXPECT_EQ(db->Flush(), RC::OK);
+  EXPECT_EQ(db->WaitForCompaction(), RC::OK);
+
+  if (style == CompactionStyle::UNIVERSAL) {
+    EXPECT_LT(UniversalCompactionPicker::SortedRuns(*db->CurrentVersion()).size(), options.level_files_limit_);
+  }
+  std::string value;
+  EXPECT_EQ(db->Get(UserKey(1), value), RC::NOT_FOUND);
+  for (int i = 2; i < K_KEYS; i += 97) {
+    if (last[i] < 0) {
+      EXPECT_EQ(db->Get(UserKey(i), value), RC::NOT_FOUND) << i;
+    } else {
+      EXPECT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+      EXPECT_EQ(value, Value(i, last[i]));
+    }
+  }
+  uint64_t bytes_written = 0;
+  for (int level = 0; level < K_NUM_LEVELS; level++) {
+    bytes_written += db->GetCompactionStats(level).bytes_written_;
+  }
+  return bytes_written;
+}
+
+}  // namespace
+
+TEST(UniversalCompaction, LessWriteAmplificationThanLeveled) {
+  auto leveled   = CompactionBytesWritten(CompactionStyle::LEVELED, "write_amp_leveled");
+  auto universal = CompactionBytesWritten(CompactionStyle::UNIVERSAL, "write_amp_universal");
+  EXPECT_GT(universal, 0);
+  EXPECT_LT(universal, leveled);
+}
+
+namespace {
+
+/* 按顺序读出所有输出文件中的 key 和 value */
+auto ReadOutputs(const std::string &dbname, const DBOptions &options, const vector<FileMetaData> &outputs)
+    -> std::vector<std::pair<std::string, std::string>> {
+  std::vector<std::pair<std::string, std::string>> entries;
+  for (const auto &meta : outputs) {
+    std::shared_ptr<SSTableReader> reader;
+    EXPECT_EQ(SSTableReader::Open(SstFile(SstDir(dbname), meta.GetOid()), options, 1, nullptr, nullptr, reader),
+              RC::OK);
+    auto iter = reader->NewIterator();
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+      entries.emplace_back(iter.Key(), iter.Value());
+    }
+  }
+  return entries;
+}
+
+}  // namespace
+
+/* 按 key 范围切分成多个并发的 subcompaction，输出与不切分时相同的数据，且输出文件之间不重叠 */
+TEST(CompactionJob, SubcompactionsMatchSingleJob) {
+  constexpr int K_FILES = 4;
+  constexpr int K_KEYS  = 4000;
+
+  DBOptions options;
+  options.max_subcompactions_ = 4;
+  auto       dbname           = TestDir("subcompactions");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+
+  Compaction compaction;
+  compaction.inputs_.push_back({.level_ = 0});
+  compaction.output_level_         = 1;
+  compaction.max_output_file_size_ = 32 << 10;
+  std::mt19937 rng(11);
+  int64_t      seq = 0;
+  for (int f = 0; f < K_FILES; f++) {
+    MemTable memtable(options);
+    for (int n = 0; n < K_KEYS; n++) {
+      int i = static_cast<int>(rng() % (K_KEYS * 2));
+      memtable.Put(MemKey(UserKey(i), ++seq, n % 10 == 0 ? OperatorType::DELETE : OperatorType::PUT), Value(i, f));
+    }
+    FileMetaData *meta;
+    ASSERT_EQ(memtable.BuildSSTable(dbname, &meta), RC::OK);
+    compaction.inputs_[0].files_.insert(compaction.inputs_[0].files_.begin(), Version::FileRef(meta));
+  }
+
+  CompactionJob single(dbname, options, compaction);
+  ASSERT_EQ(single.Run(), RC::OK);
+  EXPECT_EQ(single.Stats().subcompactions_, 1);
+  EXPECT_TRUE(single.Boundaries().empty());
+
+  std::vector<std::shared_ptr<Worker>> workers;
+  for (int i = 1; i < options.max_subcompactions_; i++) {
+    workers.push_back(Worker::NewBackgroundWorker());
+  }
+  CompactionJob parallel(dbname, options, compaction, workers);
+  ASSERT_EQ(parallel.Run(), RC::OK);
+  for (const auto &worker : workers) {
+    worker->Stop();
+    worker->Join();
+  }
+  EXPECT_EQ(parallel.Stats().subcompactions_, options.max_subcompactions_);
+  EXPECT_EQ(parallel.Boundaries().size(), options.max_subcompactions_ - 1);
+  EXPECT_TRUE(std::is_sorted(parallel.Boundaries().begin(), parallel.Boundaries().end()));
+  EXPECT_EQ(parallel.Stats().input_entries_, K_FILES * K_KEYS);
+  EXPECT_EQ(parallel.Stats().output_entries_, single.Stats().output_entries_);
+  EXPECT_GE(parallel.Outputs().size(), single.Outputs().size());
+
+  const auto &outputs = parallel.Outputs();
+  for (size_t i = 1; i < outputs.size(); i++) {
+    EXPECT_LT(outputs[i - 1].max_inner_key_.user_key_, outputs[i].min_inner_key_.user_key_);
+  }
+  EXPECT_EQ(ReadOutputs(dbname, options, outputs), ReadOutputs(dbname, options, single.Outputs()));
+}
+
+/* DB 中的 L0 到 L1 compaction 并发执行，结果与写入一致 */
+TEST(LeveledCompaction, ParallelSubcompactions) {
+  constexpr int K_KEYS = 20000;
+
+  DBOptions options;
+  options.create_if_not_exists_  = true;
+  options.mem_table_size_        = 64 << 10;
+  options.level_files_limit_     = 8;
+  options.target_file_size_base_ = 64 << 10;
+  options.max_subcompactions_    = 4;
+  auto dbname                    = ::testing::TempDir() + "compaction_parallel_subcompactions";
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  std::mt19937     rng(3);
+  std::vector<int> last(K_KEYS, -1);
+  for (int n = 0; n < 2 * K_KEYS; n++) {
+    int i = static_cast<int>(rng() % K_KEYS);
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, n)), RC::OK);
+    last[i] = n;
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+
+  auto stats = db->GetCompactionStats(1);
+  EXPECT_GT(stats.compactions_, 0);
+  EXPECT_GT(stats.subcompactions_, stats.compactions_);
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    if (last[i] < 0) {
+      EXPECT_EQ(db->Get(UserKey(i), value), RC::NOT_FOUND) << i;
+    } else {
+      ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+      EXPECT_EQ(value, Value(i, last[i]));
+    }
+  }
+}
+
+/* 每个快照区间只保留最新的版本；比所有快照都旧的删除标记在更低的层没有该 key 时丢弃 */
+TEST(CompactionJob, DropObsoleteVersionsAndTombstones) {
+  DBOptions  options;
+  auto       dbname = TestDir("garbage_collection");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+
+  MemTable memtable(options);
+  memtable.Put(MemKey("a", 1), "a1");
+  memtable.Put(MemKey("a", 2), "a2");
+  memtable.Put(MemKey("a", 6), "a6");
+  memtable.Put(MemKey("b", 3), "b3");
+  memtable.Put(MemKey("b", 4, OperatorType::DELETE), "");
+  memtable.Put(MemKey("c", 5, OperatorType::DELETE), "");
+  memtable.Put(MemKey("d", 7, OperatorType::DELETE), "");
+  memtable.Put(MemKey("e", 8), "e8");
+  memtable.Put(MemKey("e", 9), "e9");
+  FileMetaData *meta;
+  ASSERT_EQ(memtable.BuildSSTable(dbname, &meta), RC::OK);
+  Version::FileRef file(meta);
+
+  /* L2 中有 c，c 的删除标记不能丢弃 */
+  VersionEdit edit;
+  edit.AddFile(0, *file);
+  edit.AddFile(2, MakeFile(100, "c", "c", 0, 100));
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+
+  Compaction compaction;
+  compaction.inputs_.push_back({.level_ = 0, .files_ = {file}});
+  compaction.output_level_         = 1;
+  compaction.max_output_file_size_ = SIZE_MAX;
+  compaction.input_version_        = versions.Current();
+  compaction.snapshots_            = {5};
+
+  CompactionJob job(dbname, options, compaction);
+  ASSERT_EQ(job.Run(), RC::OK);
+  std::vector<std::pair<std::string, std::string>> expected = {
+      {MemKey("a", 6).ToSSTableKey(), "a6"},
+      {MemKey("a", 2).ToSSTableKey(), "a2"},
+      {MemKey("c", 5, OperatorType::DELETE).ToSSTableKey(), ""},
+      {MemKey("d", 7, OperatorType::DELETE).ToSSTableKey(), ""},
+      {MemKey("e", 9).ToSSTableKey(), "e9"},
+  };
+  EXPECT_EQ(ReadOutputs(dbname, options, job.Outputs()), expected);
+  EXPECT_EQ(job.Stats().input_entries_, 9);
+  EXPECT_EQ(job.Stats().output_entries_, 5);
+  EXPECT_EQ(job.Stats().dropped_obsolete_entries_, 3);
+  EXPECT_EQ(job.Stats().dropped_tombstones_, 1);
+
+  /* 没有快照时只保留最新的版本；不知道更低的层时不丢弃删除标记 */
+  compaction.snapshots_.clear();
+  compaction.input_version_.reset();
+  CompactionJob latest(dbname, options, compaction);
+  ASSERT_EQ(latest.Run(), RC::OK);
+  EXPECT_EQ(latest.Stats().output_entries_, 5);
+  EXPECT_EQ(latest.Stats().dropped_obsolete_entries_, 4);
+  EXPECT_EQ(latest.Stats().dropped_tombstones_, 0);
+}
+
+/* 快照能看到的版本在 compaction 后仍可读，释放快照后的 compaction 丢弃它们和删除标记 */
+TEST(LeveledCompaction, SnapshotsKeepVisibleVersions) {
+  constexpr int K_KEYS = 100;
+
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  options.level_files_limit_    = 2;
+  auto dbname                   = ::testing::TempDir() + "compaction_snapshots";
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+  }
+  auto snapshot = db->GetSnapshot();
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 1)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(i % 3 == 0 ? db->Delete(UserKey(i)) : db->Put(UserKey(i), Value(i, 2)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+
+  auto stats = db->GetCompactionStats(1);
+  EXPECT_EQ(stats.compactions_, 1);
+  EXPECT_EQ(stats.dropped_obsolete_entries_, K_KEYS);
+  EXPECT_EQ(stats.dropped_tombstones_, 0);
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Get(UserKey(i), value, snapshot), RC::OK) << i;
+    EXPECT_EQ(value, Value(i, 0));
+    if (i % 3 == 0) {
+      EXPECT_EQ(db->Get(UserKey(i), value), RC::NOT_FOUND) << i;
+    } else {
+      ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+      EXPECT_EQ(value, Value(i, 2));
+    }
+  }
+
+  db->ReleaseSnapshot(snapshot);
+  for (int version = 3; version < 5; version++) {
+    for (int i = 0; i < K_KEYS; i++) {
+      if (i % 3 == version - 2) {
+        ASSERT_EQ(db->Put(UserKey(i), Value(i, version)), RC::OK);
+      }
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+  }
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+
+  stats = db->GetCompactionStats(1);
+  EXPECT_EQ(stats.compactions_, 2);
+  /* 第二次 compaction：删除的 key 丢弃删除标记和 v0，其余的 key 只保留 v3 或 v4 */
+  int deleted = (K_KEYS + 2) / 3;
+  EXPECT_EQ(stats.dropped_tombstones_, deleted);
+  EXPECT_EQ(stats.dropped_obsolete_entries_, K_KEYS + deleted + 2 * (K_KEYS - deleted));
+  for (int i = 0; i < K_KEYS; i++) {
+    EXPECT_EQ(db->Get(UserKey(i), value), i % 3 == 0 ? RC::NOT_FOUND : RC::OK) << i;
+  }
+}
@@ -0,0 +1,512 @@
+#include "db.hh"
+#include <fmt/format.h>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sstable/sst_file_writer.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto TestDB(const std::string &name) -> std::string {
+  std::string dbname = ::testing::TempDir() + "db_" + name;
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  return dbname;
+}
+
+/* 这些测试只检查 flush，L0 的文件个数不触发 compaction */
+auto SmallMemTableOptions() -> DBOptions {
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  options.mem_table_size_       = 64 << 10;
+  options.level_files_limit_    = 1 << 20;
+  return options;
+}
+
+auto UserKey(int i) -> std::string { return fmt::format("key{:08}", i); }
+
+auto Value(int i, int version) -> std::string {
+  return fmt::format("value{:08}-{}-{}", i, version, std::string(64, 'v'));
+}
+
+auto CountWALs(const std::string &dbname) -> int {
+  int wals = 0;
+  FileManager::ReadDir(
+      WalDir(dbname), [](string_view name) { return name.ends_with(".wal"); }, [&](string_view) { wals++; });
+  return wals;
+}
+
+}  // namespace
+
+TEST(DB, PutGetDelete) {
+  DBOptions options;
+  auto      dbname = TestDB("put_get_delete");
+  {
+    std::unique_ptr<DB> db;
+    EXPECT_EQ(DB::Open(dbname, options, db), RC::NOT_FOUND);
+    options.create_if_not_exists_ = true;
+    ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+    for (int i = 0; i < 100; i++) {
+      ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    }
+    ASSERT_EQ(db->Put(UserKey(1), Value(1, 1)), RC::OK);
+    ASSERT_EQ(db->Delete(UserKey(2)), RC::OK);
+    EXPECT_EQ(db->LastSequence(), 102);
+
+    std::string value;
+    ASSERT_EQ(db->Get(UserKey(0), value), RC::OK);
+    EXPECT_EQ(value, Value(0, 0));
+    ASSERT_EQ(db->Get(UserKey(1), value), RC::OK);
+    EXPECT_EQ(value, Value(1, 1));
+    EXPECT_EQ(db->Get(UserKey(2), value), RC::NOT_FOUND);
+    EXPECT_EQ(db->Get(UserKey(100), value), RC::NOT_FOUND);
+  }
+
+  /* 重新打开时回放 WAL，回放的数据 flush 到 L0 */
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  EXPECT_EQ(db->LastSequence(), 102);
+  EXPECT_EQ(db->CurrentVersion()->NumFiles(0), 1);
+  std::string value;
+  ASSERT_EQ(db->Get(UserKey(1), value), RC::OK);
+  EXPECT_EQ(value, Value(1, 1));
+  EXPECT_EQ(db->Get(UserKey(2), value), RC::NOT_FOUND);
+  ASSERT_EQ(db->Put(UserKey(2), Value(2, 2)), RC::OK);
+  ASSERT_EQ(db->Get(UserKey(2), value), RC::OK);
+  EXPECT_EQ(value, Value(2, 2));
+  EXPECT_EQ(db->LastSequence(), 103);
+}
+
+/* 内存表写满后切换，不可变内存表 flush 到 L0 后删除 WAL；L0 中较新的文件覆盖较旧的 */
+TEST(DB, FlushToL0) {
+  constexpr int K_KEYS = 5000;
+
+  auto options = SmallMemTableOptions();
+  auto dbname  = TestDB("flush_to_l0");
+  {
+    std::unique_ptr<DB> db;
+    ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+    for (int version = 0; version < 2; version++) {
+      for (int i = 0; i < K_KEYS; i++) {
+        ASSERT_EQ(db->Put(UserKey(i), Value(i, version)), RC::OK);
+      }
+    }
+    for (int i = 0; i < K_KEYS; i += 7) {
+      ASSERT_EQ(db->Delete(UserKey(i)), RC::OK);
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+    EXPECT_EQ(db->NumImmutableMemTables(), 0);
+    EXPECT_GT(db->CurrentVersion()->NumFiles(0), 4);
+    EXPECT_EQ(CountWALs(dbname), 1);
+
+    std::string value;
+    for (int i = 0; i < K_KEYS; i++) {
+      if (i % 7 == 0) {
+        EXPECT_EQ(db->Get(UserKey(i), value), RC::NOT_FOUND) << i;
+      } else {
+        ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+        EXPECT_EQ(value, Value(i, 1));
+      }
+    }
+  }
+
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    EXPECT_EQ(db->Get(UserKey(i), value), i % 7 == 0 ? RC::NOT_FOUND : RC::OK) << i;
+  }
+}
+
+/* 不可变内存表未满时写入不阻塞，flush 期间的不可变内存表仍然可读 */
+TEST(DB, ConcurrentReadsDuringFlush) {
+  constexpr int K_KEYS    = 20000;
+  constexpr int K_READERS = 4;
+
+  auto options                      = SmallMemTableOptions();
+  options.max_immutable_mem_tables_ = 64;
+  auto                dbname        = TestDB("concurrent_reads");
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+
+  std::atomic<int>         written{0};
+  std::atomic<bool>        done{false};
+  std::vector<std::thread> readers;
+  for (int r = 0; r < K_READERS; r++) {
+    readers.emplace_back([&, r]() {
+      std::mt19937 rng(r);
+      std::string  value;
+      while (!done.load()) {
+        int n = written.load();
+        if (n == 0) {
+          continue;
+        }
+        int i = static_cast<int>(rng() % n);
+        ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+        ASSERT_EQ(value, Value(i, 0));
+      }
+    });
+  }
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    written.store(i + 1);
+  }
+  done.store(true);
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(db->WriteStalls(), 0);
+  ASSERT_EQ(db->Flush(), RC::OK);
+  EXPECT_GT(db->CurrentVersion()->NumFiles(0), 10);
+}
+
+/* 只能有一个不可变内存表时写入会等待 flush，结果仍然正确 */
+TEST(DB, StallWhenImmutableQueueFull) {
+  constexpr int K_KEYS = 5000;
+
+  auto options                      = SmallMemTableOptions();
+  options.max_immutable_mem_tables_ = 1;
+  auto                dbname        = TestDB("stall");
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    EXPECT_LE(db->NumImmutableMemTables(), 1);
+  }
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Get(UserKey(i), value), RC::OK) << i;
+  }
+}
+
+/* 与内存表重叠的导入先 flush 内存表，导入的数据比之前的写入新，比之后的写入旧 */
+TEST(DB, IngestExternalFile) {
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  auto dbname                   = TestDB("ingest");
+  auto external                 = TestDB("ingest_external") + "/";
+  FileManager::Create(external, FileOptions::DIR_);
+
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+  }
+
+  SstFileWriter writer(options);
+  ASSERT_EQ(writer.Open(external), RC::OK);
+  for (int i = 50; i < 150; i++) {
+    ASSERT_EQ(writer.Put(UserKey(i), Value(i, 1)), RC::OK);
+  }
+  ExternalSstFileInfo info;
+  ASSERT_EQ(writer.Finish(&info), RC::OK);
+  ASSERT_EQ(db->IngestExternalFile({info.file_path_}, {}), RC::OK);
+  EXPECT_EQ(db->LastSequence(), 101);
+  auto version = db->CurrentVersion();
+  ASSERT_EQ(version->NumFiles(0), 2);
+  EXPECT_EQ(version->Files(0)[0]->global_seq_, 101);
+
+  std::string value;
+  ASSERT_EQ(db->Get(UserKey(10), value), RC::OK);
+  EXPECT_EQ(value, Value(10, 0));
+  ASSERT_EQ(db->Get(UserKey(60), value), RC::OK);
+  EXPECT_EQ(value, Value(60, 1));
+  ASSERT_EQ(db->Get(UserKey(140), value), RC::OK);
+  EXPECT_EQ(value, Value(140, 1));
+
+  ASSERT_EQ(db->Put(UserKey(60), Value(60, 2)), RC::OK);
+  ASSERT_EQ(db->Get(UserKey(60), value), RC::OK);
+  EXPECT_EQ(value, Value(60, 2));
+  EXPECT_EQ(db->LastSequence(), 102);
+}
+
+/* universal compaction 合并两个有序段时导入落在两段之间空隙的文件：导入等待 compaction 结束后再选层，两者都成功 */
+TEST(DB, IngestDuringUniversalCompaction) {
+  constexpr int K_ROUNDS = 10;
+  constexpr int K_KEYS   = 2000;
+
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  options.compaction_style_     = CompactionStyle::UNIVERSAL;
+  options.level_files_limit_    = 2;
+  auto dbname                   = TestDB("ingest_universal");
+  auto external                 = TestDB("ingest_universal_external") + "/";
+  FileManager::Create(external, FileOptions::DIR_);
+
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int round = 0; round < K_ROUNDS; round++) {
+    /* 每轮写两个有空隙的有序段，第二次 flush 后开始合并 */
+    int base = round * 4 * K_KEYS;
+    for (int i = base; i < base + K_KEYS; i++) {
+      ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+    for (int i = base + 2 * K_KEYS; i < base + 3 * K_KEYS; i++) {
+      ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+
+    SstFileWriter writer(options);
+    ASSERT_EQ(writer.Open(external), RC::OK);
+    for (int i = base + K_KEYS + 100; i < base + K_KEYS + 200; i++) {
+      ASSERT_EQ(writer.Put(UserKey(i), Value(i, 1)), RC::OK);
+    }
+    ExternalSstFileInfo info;
+    ASSERT_EQ(writer.Finish(&info), RC::OK);
+    ASSERT_EQ(db->IngestExternalFile({info.file_path_}, {}), RC::OK) << round;
+  }
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+  ASSERT_EQ(db->Put(UserKey(0), Value(0, 2)), RC::OK);
+
+  std::string value;
+  for (int round = 0; round < K_ROUNDS; round++) {
+    int base = round * 4 * K_KEYS;
+    ASSERT_EQ(db->Get(UserKey(base + 1), value), RC::OK);
+    EXPECT_EQ(value, Value(base + 1, 0));
+    ASSERT_EQ(db->Get(UserKey(base + K_KEYS + 150), value), RC::OK);
+    EXPECT_EQ(value, Value(base + K_KEYS + 150, 1));
+    ASSERT_EQ(db->Get(UserKey(base + 3 * K_KEYS - 1), value), RC::OK);
+    EXPECT_EQ(value, Value(base + 3 * K_KEYS - 1, 0));
+  }
+}
+
+/* 数据分布在内存表、L0 和 L1 及以下时，批量读取的结果与逐个 Get 相同 */
+TEST(DB, MultiGet) {
+  constexpr int K_KEYS = 5000;
+
+  DBOptions options;
+  options.create_if_not_exists_  = true;
+  options.mem_table_size_        = 64 << 10;
+  options.target_file_size_base_ = 64 << 10;
+  auto                dbname     = TestDB("multi_get");
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int version = 0; version < 2; version++) {
+    for (int i = 0; i < K_KEYS; i += version + 1) {
+      ASSERT_EQ(db->Put(UserKey(i), Value(i, version)), RC::OK);
+    }
+  }
+  for (int i = 0; i < K_KEYS; i += 7) {
+    ASSERT_EQ(db->Delete(UserKey(i)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+  for (int i = 0; i < K_KEYS; i += 11) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 2)), RC::OK);
+  }
+  auto version = db->CurrentVersion();
+  EXPECT_GT(version->NumFiles(0), 0);
+  EXPECT_GT(version->NumFiles(1), 1);
+
+  std::mt19937                  rng(7);
+  std::vector<std::string>      user_keys;
+  std::vector<std::string_view> keys;
+  for (int n = 0; n < 2000; n++) {
+    user_keys.push_back(UserKey(static_cast<int>(rng() % (K_KEYS + 500))));
+  }
+  keys.assign(user_keys.begin(), user_keys.end());
+
+  std::vector<std::string> values;
+  std::vector<RC>          rcs;
+  db->MultiGet(keys, values, rcs);
+  ASSERT_EQ(rcs.size(), keys.size());
+  for (size_t j = 0; j < keys.size(); j++) {
+    std::string value;
+    ASSERT_EQ(rcs[j], db->Get(keys[j], value)) << keys[j];
+    if (rcs[j] == RC::OK) {
+      EXPECT_EQ(values[j], value) << keys[j];
+    }
+  }
+}
+
+/* 生成的文件按层分配过滤器的 bit；过滤器内存按层统计，与当前 Version 中各层文件的过滤器大小之和相同 */
+TEST(DB, FilterStatsPerLevel) {
+  constexpr int K_KEYS = 5000;
+
+  DBOptions options;
+  options.create_if_not_exists_  = true;
+  options.mem_table_size_        = 64 << 10;
+  options.target_file_size_base_ = 64 << 10;
+  options.level_files_limit_     = 1;
+  auto dbname                    = TestDB("filter_stats_per_level");
+
+  auto expect_filter_bytes = [](DB &db) {
+    auto version = db.CurrentVersion();
+    for (int level = 0; level < K_NUM_LEVELS; level++) {
+      uint64_t bytes = 0;
+      for (const auto &file : version->Files(level)) {
+        EXPECT_GT(file->filter_size_, 0);
+        bytes += file->filter_size_;
+      }
+      EXPECT_EQ(db.GetFilterStats().FilterBytes(level), bytes) << level;
+    }
+  };
+
+  {
+    std::unique_ptr<DB> db;
+    ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+    for (int i = 0; i < K_KEYS; i++) {
+      ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+    }
+    ASSERT_EQ(db->Flush(), RC::OK);
+    ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+    expect_filter_bytes(*db);
+  }
+
+  /* 不再触发 compaction，新的 L0 文件按各层当前的 key 数分配 bit */
+  options.level_files_limit_ = 1 << 20;
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  expect_filter_bytes(*db);
+  auto version = db->CurrentVersion();
+  ASSERT_EQ(version->NumFiles(0), 0);
+  ASSERT_GT(version->LevelKeys(1), 0);
+  EXPECT_EQ(version->FilterBitsPerKey(options, 1, 0), options.bits_per_key_);
+  for (int i = 0; i < K_KEYS; i += 10) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 1)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  expect_filter_bytes(*db);
+
+  /* 浅层 key 少，分配的 bit 更多 */
+  version = db->CurrentVersion();
+  ASSERT_GT(version->NumFiles(0), 0);
+  EXPECT_GT(version->FilterBitsPerKey(options, 0, 0), options.bits_per_key_);
+  EXPECT_LE(version->FilterBitsPerKey(options, 1, 0), options.bits_per_key_);
+  auto bits_per_key = [&](int level) {
+    uint64_t bits = 0;
+    uint64_t keys = 0;
+    for (const auto &file : version->Files(level)) {
+      bits += file->filter_size_ * 8;
+      keys += file->num_keys_;
+    }
+    return static_cast<double>(bits) / static_cast<double>(keys);
+  };
+  EXPECT_GT(bits_per_key(0), bits_per_key(1));
+
+  options.optimize_filters_for_levels_ = false;
+  EXPECT_EQ(version->FilterBitsPerKey(options, 0, 0), options.bits_per_key_);
+}
+
+/* 直接移动到下一层的文件之后按新的层读取 */
+TEST(DB, TrivialMoveReopensTable) {
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  options.level_files_limit_    = 1;
+  auto                dbname    = TestDB("trivial_move_reopens_table");
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < 1000; i += 2) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  std::string value;
+  EXPECT_EQ(db->Get(UserKey(1), value), RC::NOT_FOUND);
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+  ASSERT_EQ(db->GetCompactionStats(1).trivial_moves_, 1);
+  ASSERT_EQ(db->CurrentVersion()->NumFiles(1), 1);
+
+  uint64_t probes = db->GetFilterStats().Probes(1);
+  EXPECT_EQ(db->Get(UserKey(3), value), RC::NOT_FOUND);
+  EXPECT_EQ(db->Get(UserKey(4), value), RC::OK);
+  EXPECT_EQ(db->GetFilterStats().Probes(1), probes + 2);
+}
+
+/* 块缓存容量不足时淘汰的块写入二级缓存，之后的读取从二级缓存命中 */
+TEST(DB, SecondaryCache) {
+  constexpr int K_KEYS = 5000;
+
+  DBOptions options;
+  options.create_if_not_exists_            = true;
+  options.mem_table_size_                  = 64 << 10;
+  options.block_cache_options_.capacity_   = 64 << 10;
+  options.block_cache_options_.shard_bits_ = 0;
+  options.secondary_cache_options_.path_   = TestDB("secondary_cache_dir");
+  auto                dbname               = TestDB("secondary_cache");
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < K_KEYS; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+  ASSERT_EQ(db->WaitForCompaction(), RC::OK);
+
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < K_KEYS; i++) {
+      std::string value;
+      ASSERT_EQ(db->Get(UserKey(i), value), RC::OK);
+      ASSERT_EQ(value, Value(i, 0));
+    }
+  }
+  auto stats = db->GetSecondaryCacheStats();
+  EXPECT_GT(stats.inserts_, 0);
+  EXPECT_GT(stats.hits_, 0);
+}
+
+/* SSTable 中查到的结果放入行缓存，之后的写入、删除和导入使缓存的结果对新的读取失效，快照仍读到旧的版本 */
+TEST(DB, RowCache) {
+  DBOptions options;
+  options.create_if_not_exists_ = true;
+  options.row_cache_capacity_   = 1 << 20;
+  auto dbname                   = TestDB("row_cache");
+  auto external                 = TestDB("row_cache_external") + "/";
+  FileManager::Create(external, FileOptions::DIR_);
+
+  std::unique_ptr<DB> db;
+  ASSERT_EQ(DB::Open(dbname, options, db), RC::OK);
+  for (int i = 0; i < 100; i++) {
+    ASSERT_EQ(db->Put(UserKey(i), Value(i, 0)), RC::OK);
+  }
+  ASSERT_EQ(db->Flush(), RC::OK);
+
+  std::string value;
+  for (int round = 0; round < 2; round++) {
+    ASSERT_EQ(db->Get(UserKey(10), value), RC::OK);
+    EXPECT_EQ(value, Value(10, 0));
+    EXPECT_EQ(db->Get(UserKey(200), value), RC::NOT_FOUND);
+  }
+  EXPECT_EQ(db->GetRowCacheStats().hits_, 2);
+
+  int64_t snapshot = db->GetSnapshot();
+  ASSERT_EQ(db->Put(UserKey(10), Value(10, 1)), RC::OK);
+  ASSERT_EQ(db->Delete(UserKey(20)), RC::OK);
+  ASSERT_EQ(db->Flush(), RC::OK);
+  ASSERT_EQ(db->Get(UserKey(10), value), RC::OK);
+  EXPECT_EQ(value, Value(10, 1));
+  EXPECT_EQ(db->Get(UserKey(20), value), RC::NOT_FOUND);
+  ASSERT_EQ(db->Get(UserKey(10), value, snapshot), RC::OK);
+  EXPECT_EQ(value, Value(10, 0));
+  ASSERT_EQ(db->Get(UserKey(20), value, snapshot), RC::OK);
+  EXPECT_EQ(value, Value(20, 0));
+  db->ReleaseSnapshot(snapshot);
+
+  /* 不重叠的导入全局序列号为 0，缓存的不存在的结果也要失效 */
+  SstFileWriter writer(options);
+  ASSERT_EQ(writer.Open(external), RC::OK);
+  ASSERT_EQ(writer.Put(UserKey(200), Value(200, 0)), RC::OK);
+  ExternalSstFileInfo info;
+  ASSERT_EQ(writer.Finish(&info), RC::OK);
+  ASSERT_EQ(db->IngestExternalFile({info.file_path_}, {}), RC::OK);
+  ASSERT_EQ(db->Get(UserKey(200), value), RC::OK);
+  EXPECT_EQ(value, Value(200, 0));
+
+  std::vector<std::string>      user_keys = {UserKey(10), UserKey(20), UserKey(30), UserKey(200), UserKey(300)};
+  std::vector<std::string_view> keys(user_keys.begin(), user_keys.end());
+  for (int round = 0; round < 2; round++) {
+    std::vector<std::string> values;
+    std::vector<RC>          rcs;
+    db->MultiGet(keys, values, rcs);
+    EXPECT_EQ(rcs, (std::vector<RC>{RC::OK, RC::NOT_FOUND, RC::OK, RC::OK, RC::NOT_FOUND}));
+    EXPECT_EQ(values[0], Value(10, 1));
+    EXPECT_EQ(values[2], Value(30, 0));
+    EXPECT_EQ(values[3], Value(200, 0));
+  }
+}
@@ -0,0 +1,273 @@
+#include "external_file_ingestion.hh"
+#include <fmt/format.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "gtest/gtest.h"
+#include "memtable/memtable.hh"
+#include "sstable/sst_file_writer.hh"
+#include "sstable/sstable.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto TestDir(const std::string &name) -> std::string {
+  std::string dir = ::testing::TempDir() + "ingestion_" + name + "/";
+  if (FileManager::Exists(dir)) {
+    FileManager::Destroy(dir);
+  }
+  FileManager::Create(dir, FileOptions::DIR_);
+  return dir;
+}
+
+auto UserKey(int i) -> std::string { return fmt::format("key{:08}", i); }
+
+auto Value(int i, const std::string &tag) -> std::string { return fmt::format("value{:08}-{}", i, tag); }
+
+/* 在 dir 下生成包含 [begin, end) 的外部文件 */
+auto WriteExternalFile(const DBOptions &options, const std::string &dir, int begin, int end, const std::string &tag)
+    -> ExternalSstFileInfo {
+  SstFileWriter writer(options);
+  EXPECT_EQ(writer.Open(dir), RC::OK);
+  for (int i = begin; i < end; i++) {
+    EXPECT_EQ(writer.Put(UserKey(i), Value(i, tag)), RC::OK);
+  }
+  ExternalSstFileInfo info;
+  EXPECT_EQ(writer.Finish(&info), RC::OK);
+  return info;
+}
+
+auto Ingest(const std::string &dbname, const DBOptions &options, VersionSet &versions,
+            const std::vector<std::string> &paths, const IngestExternalFileOptions &ingest_options = {})
+    -> std::vector<FileMetaData> {
+  ExternalFileIngestionJob job(dbname, options, ingest_options, &versions);
+  EXPECT_EQ(job.Prepare(paths), RC::OK);
+  EXPECT_EQ(job.InstallFiles(), RC::OK);
+  EXPECT_EQ(job.Apply(), RC::OK);
+  return job.Files();
+}
+
+auto Lookup(SSTableReader &table, int i, int64_t snapshot, std::string &key, std::string &value) -> RC {
+  std::string   user_key = UserKey(i);
+  LookupContext ctx(user_key);
+  return table.Get(ctx, MemKey(user_key, snapshot).ToSSTableKey(), key, value);
+}
+
+}  // namespace
+
+/* 与已有数据都不重叠的文件放入最底层，不分配序列号；恢复后 Version 不变 */
+TEST(ExternalFileIngestion, IngestIntoEmptyDB) {
+  DBOptions options;
+  auto      dbname   = TestDir("empty_db");
+  auto      external = TestDir("empty_db_external");
+  auto      info     = WriteExternalFile(options, external, 0, 1000, "a");
+  EXPECT_EQ(info.num_entries_, 1000);
+  EXPECT_EQ(info.smallest_key_, UserKey(0));
+  EXPECT_EQ(info.largest_key_, UserKey(999));
+
+  {
+    VersionSet versions(dbname, options);
+    ASSERT_EQ(versions.Recover(), RC::OK);
+    auto files = Ingest(dbname, options, versions, {info.file_path_});
+    ASSERT_EQ(files.size(), 1);
+    EXPECT_EQ(files[0].belong_to_level_, K_NUM_LEVELS - 1);
+    EXPECT_EQ(files[0].global_seq_, 0);
+    EXPECT_EQ(files[0].file_size_, info.file_size_);
+    EXPECT_EQ(versions.LastSequence(), 0);
+    EXPECT_TRUE(FileManager::Exists(files[0].GetSSTablePath(dbname)));
+    /* 默认拷贝，原文件保留 */
+    EXPECT_TRUE(FileManager::Exists(info.file_path_));
+  }
+
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  auto version = versions.Current();
+  ASSERT_EQ(version->NumFiles(K_NUM_LEVELS - 1), 1);
+  const auto &file = version->Files(K_NUM_LEVELS - 1)[0];
+  EXPECT_EQ(file->GetSSTablePath(dbname), SstFile(SstDir(dbname), file->GetOid()));
+  EXPECT_EQ(file->min_inner_key_.user_key_, UserKey(0));
+  EXPECT_EQ(file->max_inner_key_.user_key_, UserKey(999));
+  EXPECT_EQ(file->num_keys_, 1000);
+  for (int level = 0; level < K_NUM_LEVELS - 1; level++) {
+    EXPECT_EQ(version->NumFiles(level), 0);
+  }
+}
+
+/* 与已有数据重叠的文件分配全局序列号，放入重叠的层之上，读取时 key 的序列号按全局序列号处理 */
+TEST(ExternalFileIngestion, GlobalSequence) {
+  DBOptions  options;
+  auto       dbname   = TestDir("global_seq");
+  auto       external = TestDir("global_seq_external");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  versions.SetLastSequence(100);
+
+  auto base = WriteExternalFile(options, external, 0, 1000, "base");
+  ASSERT_EQ(Ingest(dbname, options, versions, {base.file_path_})[0].belong_to_level_, K_NUM_LEVELS - 1);
+
+  auto update = WriteExternalFile(options, external, 500, 600, "update");
+  auto files  = Ingest(dbname, options, versions, {update.file_path_});
+  ASSERT_EQ(files.size(), 1);
+  EXPECT_EQ(files[0].belong_to_level_, K_NUM_LEVELS - 2);
+  EXPECT_EQ(files[0].global_seq_, 101);
+  EXPECT_EQ(files[0].max_seq_, 101);
+  EXPECT_EQ(files[0].min_inner_key_.seq_, 101);
+  EXPECT_EQ(versions.LastSequence(), 101);
+
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(files[0].GetSSTablePath(dbname), options, files[0].belong_to_level_, nullptr, nullptr,
+                                table),
+            RC::OK);
+  table->SetGlobalSequence(files[0].global_seq_);
+  std::string key;
+  std::string value;
+  EXPECT_EQ(Lookup(*table, 550, 100, key, value), RC::NOT_FOUND);
+  ASSERT_EQ(Lookup(*table, 550, 101, key, value), RC::OK);
+  EXPECT_EQ(InnerKeyToUserKey(key), UserKey(550));
+  EXPECT_EQ(InnerKeySeq(key), 101);
+  EXPECT_EQ(value, Value(550, "update"));
+  int  entries = 0;
+  auto iter    = table->NewIterator();
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    EXPECT_EQ(InnerKeySeq(iter.Key()), 101);
+    EXPECT_EQ(InnerKeyToUserKey(iter.Key()), UserKey(500 + entries));
+    entries++;
+  }
+  EXPECT_EQ(entries, 100);
+
+  /* 不重叠的文件仍然放入最底层 */
+  auto disjoint = WriteExternalFile(options, external, 2000, 2100, "disjoint");
+  files         = Ingest(dbname, options, versions, {disjoint.file_path_});
+  EXPECT_EQ(files[0].belong_to_level_, K_NUM_LEVELS - 1);
+  EXPECT_EQ(files[0].global_seq_, 0);
+  EXPECT_EQ(versions.LastSequence(), 101);
+
+  /* 与 L0 重叠时只能放入 L0 */
+  MemTable memtable(options);
+  for (int i = 540; i < 560; i++) {
+    memtable.Put(MemKey(UserKey(i), 200 + i), Value(i, "memtable"));
+  }
+  FileMetaData *raw_meta;
+  ASSERT_EQ(memtable.BuildSSTable(dbname, &raw_meta), RC::OK);
+  std::unique_ptr<FileMetaData> flushed(raw_meta);
+  VersionEdit                   edit;
+  edit.AddFile(0, *flushed);
+  edit.SetLastSequence(flushed->max_seq_);
+  ASSERT_EQ(versions.LogAndApply(edit), RC::OK);
+
+  auto newest = WriteExternalFile(options, external, 550, 551, "newest");
+  files       = Ingest(dbname, options, versions, {newest.file_path_});
+  EXPECT_EQ(files[0].belong_to_level_, 0);
+  EXPECT_EQ(files[0].global_seq_, flushed->max_seq_ + 1);
+  auto version = versions.Current();
+  ASSERT_EQ(version->NumFiles(0), 2);
+  EXPECT_EQ(version->Files(0)[0]->GetOid(), files[0].GetOid());
+
+  VersionSet recovered(dbname, options);
+  ASSERT_EQ(recovered.Recover(), RC::OK);
+  EXPECT_EQ(recovered.LastSequence(), flushed->max_seq_ + 1);
+  EXPECT_EQ(recovered.Current()->NumFiles(0), 2);
+  EXPECT_EQ(recovered.Current()->Files(0)[0]->global_seq_, flushed->max_seq_ + 1);
+  EXPECT_EQ(recovered.Current()->NumFiles(K_NUM_LEVELS - 1), 2);
+  EXPECT_EQ(recovered.Current()->NumFiles(K_NUM_LEVELS - 2), 1);
+}
+
+/* move_files_ 通过硬链接导入，成功后删除原文件；文件名不是内容哈希时重新计算 */
+TEST(ExternalFileIngestion, MoveAndRename) {
+  DBOptions  options;
+  auto       dbname   = TestDir("move");
+  auto       external = TestDir("move_external");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+
+  auto info = WriteExternalFile(options, external, 0, 100, "a");
+  auto path = external + "data.sst";
+  ASSERT_EQ(FileManager::ReName(info.file_path_, path), RC::OK);
+  IngestExternalFileOptions ingest_options;
+  ingest_options.move_files_ = true;
+  auto files                 = Ingest(dbname, options, versions, {path}, ingest_options);
+  ASSERT_EQ(files.size(), 1);
+  EXPECT_EQ(SstFile(external, files[0].GetOid()), info.file_path_);
+  EXPECT_FALSE(FileManager::Exists(path));
+  EXPECT_TRUE(FileManager::Exists(files[0].GetSSTablePath(dbname)));
+
+  /* 校验内容哈希 */
+  auto checked = WriteExternalFile(options, external, 100, 200, "b");
+  ingest_options.verify_content_hash_ = true;
+  files = Ingest(dbname, options, versions, {checked.file_path_}, ingest_options);
+  EXPECT_EQ(SstFile(external, files[0].GetOid()), checked.file_path_);
+}
+
+TEST(ExternalFileIngestion, InvalidFiles) {
+  DBOptions  options;
+  auto       dbname   = TestDir("invalid");
+  auto       external = TestDir("invalid_external");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+
+  /* user_key 必须严格递增 */
+  SstFileWriter writer(options);
+  EXPECT_EQ(writer.Put(UserKey(0), "x"), RC::INVALID_ARGUMENT);
+  ASSERT_EQ(writer.Open(external), RC::OK);
+  ASSERT_EQ(writer.Put(UserKey(1), "x"), RC::OK);
+  EXPECT_EQ(writer.Put(UserKey(1), "y"), RC::INVALID_ARGUMENT);
+  EXPECT_EQ(writer.Delete(UserKey(0)), RC::INVALID_ARGUMENT);
+  ASSERT_EQ(writer.Delete(UserKey(2)), RC::OK);
+  ExternalSstFileInfo info;
+  ASSERT_EQ(writer.Finish(&info), RC::OK);
+  EXPECT_EQ(info.num_entries_, 2);
+
+  IngestExternalFileOptions ingest_options;
+  /* 同一批文件之间不能重叠 */
+  auto overlap = WriteExternalFile(options, external, 2, 10, "overlap");
+  {
+    ExternalFileIngestionJob job(dbname, options, ingest_options, &versions);
+    EXPECT_EQ(job.Prepare({info.file_path_, overlap.file_path_}), RC::INVALID_ARGUMENT);
+  }
+  /* DB 生成的带序列号的表不能导入 */
+  {
+    std::unique_ptr<TempFile> file;
+    ASSERT_EQ(FileManager::OpenTempFile(external, "seq_", file), RC::OK);
+    SSTableWriter table_writer(external, file.release(), options);
+    table_writer.SetOutputDir(external);
+    ASSERT_EQ(table_writer.Add(MemKey(UserKey(100), 7).ToSSTableKey(), "x"), RC::OK);
+    FileMetaData meta;
+    ASSERT_EQ(table_writer.Finish(&meta), RC::OK);
+    ExternalFileIngestionJob job(dbname, options, ingest_options, &versions);
+    EXPECT_EQ(job.Prepare({SstFile(external, meta.GetOid())}), RC::INVALID_ARGUMENT);
+  }
+  /* 已经导入的文件不能再次导入 */
+  Ingest(dbname, options, versions, {info.file_path_});
+  {
+    ExternalFileIngestionJob job(dbname, options, ingest_options, &versions);
+    ASSERT_EQ(job.Prepare({info.file_path_}), RC::OK);
+    ASSERT_EQ(job.InstallFiles(), RC::OK);
+    EXPECT_EQ(job.Apply(), RC::EXISTED);
+  }
+  EXPECT_EQ(versions.Current()->NumFiles(K_NUM_LEVELS - 1), 1);
+}
+
+/* 放入 sst 目录但没有生效的文件在 job 析构时删除，生效的文件保留 */
+TEST(ExternalFileIngestion, RemoveUnappliedFiles) {
+  DBOptions  options;
+  auto       dbname   = TestDir("unapplied");
+  auto       external = TestDir("unapplied_external");
+  VersionSet versions(dbname, options);
+  ASSERT_EQ(versions.Recover(), RC::OK);
+  auto info = WriteExternalFile(options, external, 0, 100, "a");
+
+  std::string installed;
+  {
+    ExternalFileIngestionJob job(dbname, options, {}, &versions);
+    ASSERT_EQ(job.Prepare({info.file_path_}), RC::OK);
+    ASSERT_EQ(job.InstallFiles(), RC::OK);
+    installed = SstFile(SstDir(dbname), job.Files()[0].GetOid());
+    EXPECT_TRUE(FileManager::Exists(installed));
+  }
+  EXPECT_FALSE(FileManager::Exists(installed));
+  EXPECT_EQ(versions.Current()->NumFiles(K_NUM_LEVELS - 1), 0);
+
+  Ingest(dbname, options, versions, {info.file_path_});
+  EXPECT_TRUE(FileManager::Exists(installed));
+}
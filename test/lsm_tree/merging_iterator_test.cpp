@@ -0,0 +1,131 @@
+#include "merging_iterator.hh"
+#include <fmt/format.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gtest/gtest.h"
+#include "memtable/keys.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+/* 有序 inner_key 数组上的迭代器，value 为输入的下标 */
+class VectorIterator {
+ public:
+  VectorIterator(const std::vector<std::string> *keys, std::string value) : keys_(keys), value_(std::move(value)) {}
+
+  auto Valid() const -> bool { return pos_ < keys_->size(); }
+  void SeekToFirst() { pos_ = 0; }
+  void Seek(std::string_view inner_key) {
+    pos_ = std::lower_bound(keys_->begin(), keys_->end(), inner_key,
+                            [](const std::string &a, std::string_view b) { return CmpInnerKey(a, b) < 0; }) -
+           keys_->begin();
+  }
+  void Next() { pos_++; }
+  auto Key() const -> std::string_view { return (*keys_)[pos_]; }
+  auto Value() const -> std::string_view { return value_; }
+  auto Status() const -> RC { return RC::OK; }
+
+ private:
+  const std::vector<std::string> *keys_;
+  std::string                     value_;
+  size_t                          pos_{0};
+};
+
+auto InnerKeyLess(const std::string &a, const std::string &b) -> bool { return CmpInnerKey(a, b) < 0; }
+
+auto Children(const std::vector<std::vector<std::string>> &inputs) -> std::vector<VectorIterator> {
+  std::vector<VectorIterator> children;
+  for (size_t i = 0; i < inputs.size(); i++) {
+    children.emplace_back(&inputs[i], std::to_string(i));
+  }
+  return children;
+}
+
+/* k 个随机输入，部分为空 */
+auto RandomInputs(int k, std::mt19937 &rng) -> std::vector<std::vector<std::string>> {
+  std::vector<std::vector<std::string>> inputs(k);
+  int                                   entries = static_cast<int>(rng() % 2000);
+  for (int i = 0; i < entries; i++) {
+    auto type = rng() % 4 == 0 ? OperatorType::DELETE : OperatorType::PUT;
+    inputs[rng() % k].push_back(MemKey(fmt::format("key{:06}", rng() % 500), i + 1, type).ToSSTableKey());
+  }
+  for (auto &input : inputs) {
+    std::sort(input.begin(), input.end(), InnerKeyLess);
+  }
+  return inputs;
+}
+
+}  // namespace
+
+TEST(InnerKeyComparator, SameOrderAsMemKey) {
+  std::vector<MemKey> keys = {{"a", 5}, {"a", 5, OperatorType::DELETE}, {"a", 7}, {"a", 1}, {"b", 0}, {"ab", 3}};
+  for (const auto &k1 : keys) {
+    for (const auto &k2 : keys) {
+      int cmp = InnerKeyComparator()(k1.ToSSTableKey(), k2.ToSSTableKey());
+      EXPECT_EQ(cmp < 0, k1 < k2) << k1 << " " << k2;
+      EXPECT_EQ(cmp > 0, k2 < k1) << k1 << " " << k2;
+    }
+  }
+}
+
+/* 归并的结果与把所有输入放在一起排序相同 */
+TEST(MergingIterator, MatchesSort) {
+  std::mt19937 rng(0);
+  for (int k : {1, 2, 3, 4, 5, 7, 8, 16, 33, 64, 70}) {
+    auto                     inputs = RandomInputs(k, rng);
+    std::vector<std::string> expected;
+    for (const auto &input : inputs) {
+      expected.insert(expected.end(), input.begin(), input.end());
+    }
+    std::sort(expected.begin(), expected.end(), InnerKeyLess);
+
+    MergingIterator<VectorIterator> iter(Children(inputs));
+    std::vector<std::string>        merged;
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+      merged.emplace_back(iter.Key());
+    }
+    EXPECT_EQ(merged, expected) << k;
+    EXPECT_EQ(iter.Status(), RC::OK);
+
+    /* Seek 到中间的 key */
+    if (!expected.empty()) {
+      const auto &target = expected[expected.size() / 2];
+      iter.Seek(target);
+      auto pos = std::lower_bound(expected.begin(), expected.end(), target, InnerKeyLess);
+      for (; pos != expected.end(); ++pos, iter.Next()) {
+        ASSERT_TRUE(iter.Valid());
+        EXPECT_EQ(iter.Key(), *pos);
+      }
+      EXPECT_FALSE(iter.Valid());
+    }
+  }
+}
+
+/* inner_key 相同时下标小的输入在前 */
+TEST(MergingIterator, TieBreakByIndex) {
+  auto                                  key = MemKey("key", 1).ToSSTableKey();
+  std::vector<std::vector<std::string>> inputs(5, std::vector<std::string>{key});
+  inputs[2].clear();
+
+  MergingIterator<VectorIterator> iter(Children(inputs));
+  std::vector<std::string>        values;
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    values.emplace_back(iter.Value());
+  }
+  EXPECT_EQ(values, (std::vector<std::string>{"0", "1", "3", "4"}));
+}
+
+TEST(MergingIterator, Empty) {
+  MergingIterator<VectorIterator> none({});
+  none.SeekToFirst();
+  EXPECT_FALSE(none.Valid());
+
+  std::vector<std::vector<std::string>> inputs(3);
+  MergingIterator<VectorIterator>       iter(Children(inputs));
+  iter.SeekToFirst();
+  EXPECT_FALSE(iter.Valid());
+}
@@ -0,0 +1,69 @@
+#include "row_cache.hh"
+#include <string>
+#include "gtest/gtest.h"
+#include "options.hh"
+
+using namespace lsm_tree;
+
+TEST(RowCache, Visibility) {
+  RowCache    cache(1 << 20);
+  bool        found = false;
+  std::string value;
+  EXPECT_FALSE(cache.Lookup("k", 10, found, value));
+
+  /* 快照 10 下读到序列号 5 写入的值 */
+  cache.RecordWrite("k", 5);
+  cache.Insert("k", 10, 5, true, "v5");
+  ASSERT_TRUE(cache.Lookup("k", 10, found, value));
+  EXPECT_TRUE(found);
+  EXPECT_EQ(value, "v5");
+  /* 之后没有写入，更新的快照也能使用 */
+  EXPECT_TRUE(cache.Lookup("k", 100, found, value));
+  /* 比版本更早的快照看不到该版本 */
+  EXPECT_FALSE(cache.Lookup("k", 4, found, value));
+
+  /* 序列号 20 的写入使更新的快照不能再使用缓存，快照 [5, 10] 仍然可以 */
+  cache.RecordWrite("k", 20);
+  EXPECT_FALSE(cache.Lookup("k", 20, found, value));
+  EXPECT_FALSE(cache.Lookup("k", 15, found, value));
+  EXPECT_TRUE(cache.Lookup("k", 7, found, value));
+  EXPECT_EQ(value, "v5");
+
+  /* 快照 30 下重新读取后，新的结果对更新的快照可见 */
+  cache.Insert("k", 30, 20, true, "v20");
+  ASSERT_TRUE(cache.Lookup("k", 40, found, value));
+  EXPECT_EQ(value, "v20");
+}
+
+/* 不存在或被删除的 key 也缓存结果 */
+TEST(RowCache, NotFound) {
+  RowCache    cache(1 << 20);
+  bool        found = true;
+  std::string value;
+  cache.Insert("missing", 10, 0, false, "");
+  ASSERT_TRUE(cache.Lookup("missing", 50, found, value));
+  EXPECT_FALSE(found);
+
+  cache.RecordWrite("deleted", 3);
+  cache.RecordWrite("deleted", 8);
+  cache.Insert("deleted", 10, 8, false, "");
+  ASSERT_TRUE(cache.Lookup("deleted", 9, found, value));
+  EXPECT_FALSE(found);
+  EXPECT_FALSE(cache.Lookup("deleted", 5, found, value));
+}
+
+/* 按 key 和值的大小计费，容量从块缓存的预算中划出 */
+TEST(RowCache, Capacity) {
+  DBOptions options;
+  options.block_cache_options_.capacity_ = 1 << 20;
+  options.row_cache_capacity_            = 64 << 10;
+  EXPECT_EQ(options.BlockCacheCapacity(), (1 << 20) - (64 << 10));
+
+  RowCache    cache(options.row_cache_capacity_, 0);
+  std::string big(1000, 'x');
+  for (int i = 0; i < 1000; i++) {
+    cache.Insert("key" + std::to_string(i), 10, 1, true, big);
+  }
+  EXPECT_LE(cache.Usage(), options.row_cache_capacity_);
+  EXPECT_GT(cache.Usage(), options.row_cache_capacity_ - 2 * (1000 + RowCache::K_ENTRY_OVERHEAD + 8));
+}
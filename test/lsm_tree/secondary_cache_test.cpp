@@ -0,0 +1,154 @@
+#include "secondary_cache.hh"
+#include <fstream>
+#include <memory>
+#include <string>
+#include "cache.hh"
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto TestDir(const std::string &name) -> std::string {
+  std::string dir = ::testing::TempDir() + "secondary_cache_" + name;
+  if (FileManager::Exists(dir)) {
+    FileManager::Destroy(dir);
+  }
+  return dir;
+}
+
+auto MakeBlock(uint64_t seed, size_t size) -> std::string {
+  std::string block(size, '\0');
+  for (size_t i = 0; i < size; i++) {
+    block[i] = static_cast<char>((seed * 131 + i) & 0xff);
+  }
+  return block;
+}
+
+}  // namespace
+
+TEST(SecondaryCache, InsertLookup) {
+  SecondaryCacheOptions options;
+  options.path_ = TestDir("insert_lookup");
+  std::unique_ptr<SecondaryCache> cache;
+  ASSERT_EQ(SecondaryCache::Open(options, cache), RC::OK);
+
+  for (uint64_t i = 0; i < 100; i++) {
+    cache->Insert({1, i * 4096}, MakeBlock(i, 1000 + i));
+  }
+  cache->WaitForPendingWrites();
+  std::string block;
+  for (uint64_t i = 0; i < 100; i++) {
+    ASSERT_EQ(cache->Lookup({1, i * 4096}, block), RC::OK);
+    EXPECT_EQ(block, MakeBlock(i, 1000 + i));
+  }
+  EXPECT_EQ(cache->Lookup({2, 0}, block), RC::NOT_FOUND);
+  cache->Erase({1, 0});
+  EXPECT_EQ(cache->Lookup({1, 0}, block), RC::NOT_FOUND);
+
+  auto stats = cache->Stats();
+  EXPECT_EQ(stats.inserts_, 100);
+  EXPECT_EQ(stats.hits_, 100);
+  EXPECT_EQ(stats.misses_, 2);
+}
+
+/* 记录损坏时校验失败，并从索引中删除 */
+TEST(SecondaryCache, CheckSum) {
+  SecondaryCacheOptions options;
+  options.path_ = TestDir("check_sum");
+  std::unique_ptr<SecondaryCache> cache;
+  ASSERT_EQ(SecondaryCache::Open(options, cache), RC::OK);
+  cache->Insert({1, 0}, MakeBlock(0, 4096));
+  cache->Insert({1, 4096}, MakeBlock(1, 4096));
+  cache->WaitForPendingWrites();
+
+  {
+    std::fstream file(FileManager::FixDirName(options.path_) + "000000" + SecondaryCache::K_FILE_SUFFIX,
+                      std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(SecondaryCache::K_HEADER_SIZE + 100);
+    file.put('\xff');
+  }
+  std::string block;
+  EXPECT_EQ(cache->Lookup({1, 0}, block), RC::CHECK_SUM_ERROR);
+  EXPECT_EQ(cache->Lookup({1, 0}, block), RC::NOT_FOUND);
+  ASSERT_EQ(cache->Lookup({1, 4096}, block), RC::OK);
+  EXPECT_EQ(block, MakeBlock(1, 4096));
+  EXPECT_EQ(cache->Stats().check_sum_errors_, 1);
+}
+
+/* 总大小超过容量时删除最早的文件 */
+TEST(SecondaryCache, Capacity) {
+  SecondaryCacheOptions options;
+  options.path_      = TestDir("capacity");
+  options.capacity_  = 64 << 10;
+  options.file_size_ = 16 << 10;
+  std::unique_ptr<SecondaryCache> cache;
+  ASSERT_EQ(SecondaryCache::Open(options, cache), RC::OK);
+  for (uint64_t i = 0; i < 200; i++) {
+    cache->Insert({1, i}, MakeBlock(i, 1024));
+    cache->WaitForPendingWrites();
+  }
+  EXPECT_LE(cache->Stats().usage_, options.capacity_);
+  std::string block;
+  EXPECT_EQ(cache->Lookup({1, 0}, block), RC::NOT_FOUND);
+  for (uint64_t i = 180; i < 200; i++) {
+    ASSERT_EQ(cache->Lookup({1, i}, block), RC::OK);
+    EXPECT_EQ(block, MakeBlock(i, 1024));
+  }
+}
+
+/* 内存中的块缓存淘汰的块写入二级缓存，再次读取时不需要读慢速设备 */
+TEST(SecondaryCache, TieredWithSlowDevice) {
+  constexpr size_t K_BLOCK_SIZE = 4096;
+  constexpr int    K_BLOCKS     = 256;
+
+  std::string dir = TestDir("tiered");
+  ASSERT_EQ(FileManager::Create(dir, FileOptions::DIR_), RC::OK);
+  std::string device_path = dir + "/slow_device";
+  {
+    std::ofstream device(device_path, std::ios::binary);
+    for (int i = 0; i < K_BLOCKS; i++) {
+      device << MakeBlock(i, K_BLOCK_SIZE);
+    }
+  }
+  RandomAccessFile *raw_device;
+  ASSERT_EQ(FileManager::OpenRandomAccessFile(device_path, &raw_device), RC::OK);
+  std::unique_ptr<RandomAccessFile> device(raw_device);
+
+  SecondaryCacheOptions options;
+  options.path_ = dir + "/cache";
+  std::unique_ptr<SecondaryCache> secondary;
+  ASSERT_EQ(SecondaryCache::Open(options, secondary), RC::OK);
+  ShardedCache<BlockCacheKey, std::string> primary(16 * K_BLOCK_SIZE, 0);
+  primary.SetEvictionCallback(
+      [&](const BlockCacheKey &key, const std::string &block) { secondary->Insert(key, block); });
+  uint64_t table = primary.NewId();
+
+  int  device_reads = 0;
+  auto read_block   = [&](uint64_t offset) -> std::string {
+    BlockCacheKey key(table, offset);
+    if (auto handle = primary.Lookup(key)) {
+      return *handle;
+    }
+    std::string block;
+    if (secondary->Lookup(key, block) != RC::OK) {
+      block.resize(K_BLOCK_SIZE);
+      string_view view(block);
+      EXPECT_EQ(device->Read(offset, K_BLOCK_SIZE, view, true), RC::OK);
+      device_reads++;
+    }
+    primary.Insert(key, block, K_BLOCK_SIZE);
+    return block;
+  };
+
+  for (int i = 0; i < K_BLOCKS; i++) {
+    EXPECT_EQ(read_block(i * K_BLOCK_SIZE), MakeBlock(i, K_BLOCK_SIZE));
+  }
+  EXPECT_EQ(device_reads, K_BLOCKS);
+  secondary->WaitForPendingWrites();
+  for (int i = 0; i < K_BLOCKS; i++) {
+    EXPECT_EQ(read_block(i * K_BLOCK_SIZE), MakeBlock(i, K_BLOCK_SIZE));
+  }
+  EXPECT_EQ(device_reads, K_BLOCKS);
+  EXPECT_GE(secondary->Stats().hits_, K_BLOCKS - 16);
+}
@@ -0,0 +1,284 @@
+#include <fmt/format.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sstable/sstable.hh"
+#include "table_test_util.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+constexpr int K_KEYS = 5000;
+
+auto UserKey(int i) -> std::string { return fmt::format("key{:08}", i); }
+
+auto Value(int i, int64_t seq) -> std::string {
+  return fmt::format("value{:08}-{}-{}", i, seq, std::string(i % 50, 'v'));
+}
+
+/* 偶数 key 写入 seq 为 1 和 2 的两个版本，3 的倍数的 key 最后被删除（seq 3），奇数 key 跳过以便查询不存在的 key */
+auto BuildVersionedTable(const std::string &name, const DBOptions &options) -> std::string {
+  return BuildTable("sstable_reader_" + name, options, [](SSTableWriter &writer) {
+    for (int i = 0; i < K_KEYS; i += 2) {
+      if (i % 3 == 0) {
+        EXPECT_EQ(writer.Add(MemKey(UserKey(i), 3, OperatorType::DELETE).ToSSTableKey(), ""), RC::OK);
+      }
+      EXPECT_EQ(writer.Add(MemKey(UserKey(i), 2).ToSSTableKey(), Value(i, 2)), RC::OK);
+      EXPECT_EQ(writer.Add(MemKey(UserKey(i), 1).ToSSTableKey(), Value(i, 1)), RC::OK);
+    }
+  });
+}
+
+auto Lookup(SSTableReader &table, int i, int64_t snapshot, std::string &key, std::string &value) -> RC {
+  std::string   user_key = UserKey(i);
+  LookupContext ctx(user_key);
+  return table.Get(ctx, MemKey(user_key, snapshot).ToSSTableKey(), key, value);
+}
+
+/* 点查和遍历的结果与写入的内容一致，与 I/O 方式和是否使用块缓存无关 */
+void CheckTable(SSTableReader &table) {
+  std::string key;
+  std::string value;
+  for (int i = 0; i < K_KEYS; i++) {
+    RC rc = Lookup(table, i, 10, key, value);
+    if (i % 2 != 0) {
+      EXPECT_EQ(rc, RC::NOT_FOUND) << i;
+      continue;
+    }
+    ASSERT_EQ(rc, RC::OK) << i;
+    EXPECT_EQ(InnerKeyToUserKey(key), UserKey(i));
+    if (i % 3 == 0) {
+      EXPECT_EQ(InnerKeyOpType(key), OperatorType::DELETE);
+    } else {
+      EXPECT_EQ(InnerKeySeq(key), 2);
+      EXPECT_EQ(value, Value(i, 2));
+    }
+    /* 快照之前的版本 */
+    ASSERT_EQ(Lookup(table, i, 1, key, value), RC::OK);
+    EXPECT_EQ(value, Value(i, 1));
+  }
+
+  auto iter    = table.NewIterator();
+  int  entries = 0;
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    entries++;
+  }
+  EXPECT_EQ(iter.Status(), RC::OK);
+  EXPECT_EQ(entries, K_KEYS + (K_KEYS + 5) / 6);
+
+  iter.Seek(MemKey(UserKey(101), 10).ToSSTableKey());
+  ASSERT_TRUE(iter.Valid());
+  EXPECT_EQ(InnerKeyToUserKey(iter.Key()), UserKey(102));
+  EXPECT_EQ(InnerKeySeq(iter.Key()), 3);
+  iter.Next();
+  ASSERT_TRUE(iter.Valid());
+  EXPECT_EQ(iter.Value(), Value(102, 2));
+
+  iter.Seek(MemKey(UserKey(K_KEYS), 10).ToSSTableKey());
+  EXPECT_FALSE(iter.Valid());
+}
+
+}  // namespace
+
+TEST(SSTableReader, MmapAndPread) {
+  DBOptions options;
+  auto      path = BuildVersionedTable("modes", options);
+
+  for (auto mode : {TableReadMode::MMAP, TableReadMode::PREAD}) {
+    options.table_read_mode_ = mode;
+    std::shared_ptr<SSTableReader> table;
+    ASSERT_EQ(SSTableReader::Open(path, options, 1, nullptr, nullptr, table), RC::OK);
+    size_t file_size = 0;
+    ASSERT_EQ(FileManager::GetFileSize(path, file_size), RC::OK);
+    EXPECT_EQ(table->FileSize(), file_size);
+    CheckTable(*table);
+  }
+}
+
+/* PREAD 时块经过块缓存；索引块和过滤器块在打开时解析并一直持有，计入块缓存的用量，点查不再查块缓存 */
+TEST(SSTableReader, BlockCache) {
+  DBOptions options;
+  auto      path = BuildVersionedTable("block_cache", options);
+
+  CacheOptions cache_options;
+  cache_options.capacity_ = 64UL << 20;
+  BlockCache  block_cache(cache_options, 0, nullptr);
+  FilterStats filter_stats;
+
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, &block_cache, &filter_stats, table), RC::OK);
+  auto opened = block_cache.Stats().uncompressed_;
+  EXPECT_EQ(opened.inserts_, 2);
+  EXPECT_EQ(opened.pinned_usage_, opened.usage_);
+  /* 超出表的范围的 key 只查索引块 */
+  std::string key;
+  std::string value;
+  for (int i = 0; i < 100; i++) {
+    EXPECT_EQ(Lookup(*table, K_KEYS + i, 10, key, value), RC::NOT_FOUND);
+  }
+  EXPECT_EQ(block_cache.Stats().uncompressed_.lookups_, opened.lookups_);
+
+  CheckTable(*table);
+  auto first = block_cache.Stats().uncompressed_;
+  EXPECT_GT(first.inserts_, 2);
+  CheckTable(*table);
+  auto second = block_cache.Stats().uncompressed_;
+  EXPECT_EQ(second.inserts_, first.inserts_);
+  EXPECT_GT(second.hits_, first.hits_);
+
+  /* 不存在的 key 大多被过滤器排除 */
+  EXPECT_GT(filter_stats.Probes(1), 0);
+  EXPECT_LT(filter_stats.ObservedFalsePositiveRate(1), 0.1);
+
+  /* 遍历期间关闭表，迭代器仍然持有表 */
+  auto iter = table->NewIterator();
+  table.reset();
+  iter.SeekToFirst();
+  EXPECT_TRUE(iter.Valid());
+}
+
+/* 上界之后的条目不可见；范围过滤器判断 [seek key, 上界) 内没有 key 时 Seek 不读数据块 */
+TEST(SSTableReader, UpperBound) {
+  DBOptions options;
+  options.range_filter_depth_ = 8;
+  auto path                   = BuildVersionedTable("upper_bound", options);
+
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, nullptr, nullptr, table), RC::OK);
+
+  std::string upper = UserKey(20);
+  ReadOptions read_options;
+  read_options.iterate_upper_bound_ = upper;
+  auto iter                         = table->NewIterator(read_options);
+  int  user_keys                    = 0;
+  for (iter.SeekToFirst(); iter.Valid(); iter.Next()) {
+    EXPECT_LT(InnerKeyToUserKey(iter.Key()), upper);
+    user_keys += InnerKeySeq(iter.Key()) == 1 ? 1 : 0;
+  }
+  EXPECT_EQ(user_keys, 10);
+
+  EXPECT_FALSE(table->MayContainRange(UserKey(K_KEYS), UserKey(K_KEYS + 100)));
+  std::string beyond                = UserKey(K_KEYS + 100);
+  read_options.iterate_upper_bound_ = beyond;
+  auto tail                         = table->NewIterator(read_options);
+  tail.Seek(MemKey(UserKey(K_KEYS), 10).ToSSTableKey());
+  EXPECT_FALSE(tail.Valid());
+  EXPECT_EQ(tail.Status(), RC::OK);
+}
+
+namespace {
+
+constexpr int K_PREFIX_GROUPS = 100;
+constexpr int K_GROUP_KEYS    = 50;
+
+/* 前缀为 "pNNN"，只有偶数组有 key */
+auto PrefixUserKey(int group, int i) -> std::string { return fmt::format("p{:03}-{:04}", group, i); }
+
+auto BuildPrefixTable(const DBOptions &options) -> std::string {
+  return BuildTable("sstable_reader_prefix_seek", options, [](SSTableWriter &writer) {
+    for (int group = 0; group < K_PREFIX_GROUPS; group += 2) {
+      for (int i = 0; i < K_GROUP_KEYS; i++) {
+        EXPECT_EQ(writer.Add(MemKey(PrefixUserKey(group, i), 1).ToSSTableKey(), std::string(100, 'v')), RC::OK);
+      }
+    }
+  });
+}
+
+}  // namespace
+
+/* 前缀查找只返回相同前缀的 key；过滤器排除的前缀不读取数据块 */
+TEST(SSTableReader, PrefixSeek) {
+  DBOptions options;
+  options.prefix_extractor_ = NewFixedPrefixExtractor(4);
+  auto path                 = BuildPrefixTable(options);
+
+  CacheOptions cache_options;
+  cache_options.capacity_ = 64UL << 20;
+  BlockCache                     block_cache(cache_options, 0, nullptr);
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, &block_cache, nullptr, table), RC::OK);
+
+  ReadOptions read_options;
+  read_options.prefix_seek_ = true;
+  auto iter                 = table->NewIterator(read_options);
+  for (int group = 0; group < K_PREFIX_GROUPS; group += 2) {
+    for (int start : {0, K_GROUP_KEYS / 2}) {
+      int keys = 0;
+      for (iter.Seek(MemKey(PrefixUserKey(group, start), 1).ToSSTableKey()); iter.Valid(); iter.Next()) {
+        EXPECT_EQ(InnerKeyToUserKey(iter.Key()), PrefixUserKey(group, start + keys));
+        keys++;
+      }
+      EXPECT_EQ(iter.Status(), RC::OK);
+      EXPECT_EQ(keys, K_GROUP_KEYS - start) << group;
+    }
+  }
+
+  /* 奇数组没有 key：全序查找会读取下一组所在的数据块，前缀查找基本都被过滤器排除 */
+  BlockCache                     cold_cache(cache_options, 0, nullptr);
+  std::shared_ptr<SSTableReader> cold;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, &cold_cache, nullptr, cold), RC::OK);
+  auto prefix_iter = cold->NewIterator(read_options);
+  prefix_iter.Seek(MemKey(PrefixUserKey(0, 0), 1).ToSSTableKey());
+  auto before = cold_cache.Stats().uncompressed_.inserts_;
+  for (int group = 1; group < K_PREFIX_GROUPS; group += 2) {
+    prefix_iter.Seek(MemKey(PrefixUserKey(group, 0), 1).ToSSTableKey());
+    EXPECT_FALSE(prefix_iter.Valid());
+  }
+  EXPECT_LE(cold_cache.Stats().uncompressed_.inserts_ - before, 2);
+
+  auto total_order = cold->NewIterator();
+  for (int group = 1; group < K_PREFIX_GROUPS - 1; group += 2) {
+    total_order.Seek(MemKey(PrefixUserKey(group, 0), 1).ToSSTableKey());
+    ASSERT_TRUE(total_order.Valid());
+    EXPECT_EQ(InnerKeyToUserKey(total_order.Key()), PrefixUserKey(group + 1, 0));
+  }
+  EXPECT_GT(cold_cache.Stats().uncompressed_.inserts_ - before, K_PREFIX_GROUPS / 4);
+}
+
+/* 批量点查的结果与逐个 Get 相同，过滤器排除的查询同样计入统计 */
+TEST(SSTableReader, MultiGet) {
+  DBOptions options;
+  auto      path = BuildVersionedTable("multi_get", options);
+
+  FilterStats                    filter_stats;
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, nullptr, &filter_stats, table), RC::OK);
+
+  std::vector<std::string>           user_keys;
+  std::vector<std::string>           inner_keys;
+  std::vector<LookupContext>         ctxs;
+  std::vector<const LookupContext *> ctx_ptrs;
+  std::vector<std::string_view>      inner_key_views;
+  for (int i = 0; i < K_KEYS + 10; i += 3) {
+    user_keys.push_back(UserKey(i));
+  }
+  ctxs.reserve(user_keys.size());
+  for (size_t j = 0; j < user_keys.size(); j++) {
+    inner_keys.push_back(MemKey(user_keys[j], j % 2 == 0 ? 10 : 1).ToSSTableKey());
+    ctxs.emplace_back(user_keys[j]);
+  }
+  for (size_t j = 0; j < user_keys.size(); j++) {
+    ctx_ptrs.push_back(&ctxs[j]);
+    inner_key_views.emplace_back(inner_keys[j]);
+  }
+
+  std::vector<std::string> keys;
+  std::vector<std::string> values;
+  std::vector<RC>          rcs;
+  ASSERT_EQ(table->MultiGet(ctx_ptrs, inner_key_views, keys, values, rcs), RC::OK);
+  auto probes = filter_stats.Probes(1);
+  EXPECT_GT(probes, 0);
+  for (size_t j = 0; j < user_keys.size(); j++) {
+    std::string key;
+    std::string value;
+    ASSERT_EQ(rcs[j], table->Get(ctxs[j], inner_keys[j], key, value)) << user_keys[j];
+    if (rcs[j] == RC::OK) {
+      EXPECT_EQ(keys[j], key);
+      EXPECT_EQ(values[j], value);
+    }
+  }
+  EXPECT_EQ(filter_stats.Probes(1), 2 * probes);
+}
@@ -0,0 +1,209 @@
+#include "sstable/sstable.hh"
+#include <fmt/format.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include "gtest/gtest.h"
+#include "memtable/memtable.hh"
+#include "table_test_util.hh"
+#include "util/hash_util.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto UserKey(int i) -> std::string { return fmt::format("key{:08}", i); }
+
+auto Value(int i) -> std::string { return fmt::format("value{:08}-{}", i, std::string(i % 100, 'v')); }
+
+}  // namespace
+
+/* 数据块写满后立即写入文件，文件名为内容的 SHA-256 */
+TEST(SSTableWriter, StreamingBuild) {
+  constexpr int K_KEYS = 20000;
+
+  DBOptions    options;
+  FileMetaData meta;
+  auto         path = BuildTable(
+      "sstable_streaming_build", options,
+      [&](SSTableWriter &writer) {
+        size_t last_size = 0;
+        int    flushes   = 0;
+        for (int i = 0; i < K_KEYS; i++) {
+          ASSERT_EQ(writer.Add(MemKey(UserKey(i), i + 1).ToSSTableKey(), Value(i)), RC::OK);
+          ASSERT_LE(writer.FileSize() - last_size, options.block_size_ + 1024);
+          flushes += writer.FileSize() != last_size ? 1 : 0;
+          last_size = writer.FileSize();
+        }
+        EXPECT_GT(flushes, 100);
+        /* key 必须严格递增 */
+        EXPECT_NE(writer.Add(MemKey(UserKey(0), 1).ToSSTableKey(), "x"), RC::OK);
+      },
+      &meta);
+  EXPECT_EQ(meta.num_keys_, K_KEYS);
+  EXPECT_EQ(meta.max_seq_, K_KEYS);
+  EXPECT_EQ(meta.min_inner_key_.user_key_, UserKey(0));
+  EXPECT_EQ(meta.max_inner_key_.user_key_, UserKey(K_KEYS - 1));
+
+  std::string content;
+  ASSERT_EQ(FileManager::ReadFileToString(path, content), RC::OK);
+  EXPECT_EQ(content.size(), meta.file_size_);
+  unsigned char sha256[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(content.data()), content.size(), sha256);
+  EXPECT_EQ(Sha256DigitToHex(sha256), meta.GetOid());
+
+  /* 尾信息块 -> 元数据块 -> 过滤器块，元数据块中的第一项是过滤器块 */
+  FooterBlockReader footer;
+  ASSERT_EQ(footer.Init(string_view(content).substr(content.size() - FooterBlockWriter::FOOTER_SIZE)), RC::OK);
+  const auto &meta_handle  = footer.MetaBlockHandle();
+  const auto &index_handle = footer.IndexBlockHandle();
+  EXPECT_EQ(meta_handle.block_offset_ + meta_handle.block_size_, index_handle.block_offset_);
+  EXPECT_EQ(index_handle.block_offset_ + index_handle.block_size_ + FooterBlockWriter::FOOTER_SIZE, content.size());
+
+  string_view name;
+  string_view encoded;
+  ASSERT_EQ(DecodeRestartsPointKeyAndValueWrap(content.data() + meta_handle.block_offset_, name, encoded), RC::OK);
+  EXPECT_EQ(name, SSTableWriter::K_FILTER_BLOCK_NAME);
+  BlockHandle filter_handle;
+  filter_handle.DecodeFrom(encoded);
+  EXPECT_LT(filter_handle.block_offset_ + filter_handle.block_size_, meta_handle.block_offset_);
+
+  FilterBlockReader filter;
+  ASSERT_EQ(filter.Init(string_view(content).substr(filter_handle.block_offset_, filter_handle.block_size_)), RC::OK);
+  EXPECT_TRUE(filter.IsKeyExists(0, UserKey(0)));
+
+  /* 属性块紧跟在过滤器块之后 */
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, nullptr, nullptr, table), RC::OK);
+  const auto *properties = table->Properties();
+  ASSERT_NE(properties, nullptr);
+  EXPECT_EQ(properties->num_entries_, K_KEYS);
+  EXPECT_EQ(properties->max_seq_, K_KEYS);
+  EXPECT_EQ(InnerKeyToUserKey(properties->smallest_key_), UserKey(0));
+  EXPECT_EQ(InnerKeyToUserKey(properties->largest_key_), UserKey(K_KEYS - 1));
+}
+
+/* 流水线写入与串行写入生成的文件完全相同 */
+TEST(SSTableWriter, PipelinedBuild) {
+  constexpr int K_KEYS = 20000;
+
+  auto build = [&](const std::string &name, int inflight_blocks) {
+    DBOptions options;
+    options.sstable_build_inflight_blocks_ = inflight_blocks;
+    FileMetaData meta;
+    auto         path = BuildTable(
+        "sstable_" + name, options,
+        [](SSTableWriter &writer) {
+          for (int i = 0; i < K_KEYS; i++) {
+            EXPECT_EQ(writer.Add(MemKey(UserKey(i), i + 1).ToSSTableKey(), Value(i)), RC::OK);
+          }
+        },
+        &meta);
+    std::string content;
+    EXPECT_EQ(FileManager::ReadFileToString(path, content), RC::OK);
+    EXPECT_EQ(content.size(), meta.file_size_);
+    return std::make_pair(meta.GetOid(), content);
+  };
+
+  auto serial = build("serial_build", 0);
+  for (int inflight_blocks : {1, 4, 64}) {
+    auto pipelined = build(fmt::format("pipelined_build_{}", inflight_blocks), inflight_blocks);
+    EXPECT_EQ(pipelined.first, serial.first);
+    EXPECT_TRUE(pipelined.second == serial.second);
+  }
+}
+
+/* 使用 HASH128 命名的表：文件名为 32 个 16 进制字符，哈希类型记录在尾信息块中 */
+TEST(SSTableWriter, ContentHash128) {
+  DBOptions options;
+  options.content_hash_ = ContentHashType::HASH128;
+  FileMetaData meta;
+  auto         path = BuildTable(
+      "sstable_content_hash128", options,
+      [](SSTableWriter &writer) {
+        for (int i = 0; i < 5000; i++) {
+          ASSERT_EQ(writer.Add(MemKey(UserKey(i), i + 1).ToSSTableKey(), Value(i)), RC::OK);
+        }
+      },
+      &meta);
+  EXPECT_EQ(meta.content_hash_, ContentHashType::HASH128);
+  EXPECT_EQ(meta.GetOid().size(), 32);
+
+  std::string content;
+  ASSERT_EQ(FileManager::ReadFileToString(path, content), RC::OK);
+  ContentHasher hasher(ContentHashType::HASH128);
+  hasher.Update(content);
+  unsigned char digest[K_MAX_CONTENT_DIGEST_LENGTH];
+  hasher.Final(digest);
+  EXPECT_EQ(DigestToHex(digest, 16), meta.GetOid());
+
+  FooterBlockReader footer;
+  ASSERT_EQ(footer.Init(string_view(content).substr(content.size() - FooterBlockWriter::FOOTER_SIZE)), RC::OK);
+  EXPECT_EQ(footer.ContentHash(), ContentHashType::HASH128);
+
+  std::shared_ptr<SSTableReader> table;
+  ASSERT_EQ(SSTableReader::Open(path, options, 1, nullptr, nullptr, table), RC::OK);
+  EXPECT_EQ(table->ContentHash(), ContentHashType::HASH128);
+}
+
+/* 旧格式的尾信息块没有哈希类型，按 SHA-256 处理 */
+TEST(FooterBlock, LegacyFormat) {
+  BlockHandle meta_handle;
+  BlockHandle index_handle;
+  meta_handle.SetMeta(100, 20);
+  index_handle.SetMeta(120, 30);
+  std::string legacy = "xx";
+  meta_handle.EncodeMeta(legacy);
+  index_handle.EncodeMeta(legacy);
+  legacy.append("\x12\x34");
+
+  FooterBlockReader footer;
+  ASSERT_EQ(footer.Init(legacy), RC::OK);
+  EXPECT_EQ(footer.ContentHash(), ContentHashType::SHA256);
+  EXPECT_EQ(footer.MetaBlockHandle().block_offset_, 100);
+  EXPECT_EQ(footer.IndexBlockHandle().block_size_, 30);
+  EXPECT_EQ(footer.Init(legacy.substr(0, legacy.size() - 1)), RC::UN_SUPPORTED_FORMAT);
+}
+
+TEST(SSTableWriter, EmptyTable) {
+  DBOptions options;
+  auto      dbname = TestDB("sstable_empty_table");
+
+  std::unique_ptr<TempFile> file;
+  ASSERT_EQ(FileManager::OpenTempFile(SstDir(dbname), "test_", file), RC::OK);
+  SSTableWriter writer(dbname, file.release(), options);
+  FileMetaData  meta;
+  EXPECT_EQ(writer.Finish(&meta), RC::NEW_SSTABLE_ERROR);
+}
+
+TEST(MemTable, BuildSSTable) {
+  DBOptions options;
+  auto      dbname = TestDB("sstable_build_sstable");
+  MemTable  memtable(options);
+
+  FileMetaData *raw_meta;
+  ASSERT_EQ(memtable.BuildSSTable(dbname, &raw_meta), RC::OK);
+  EXPECT_EQ(raw_meta, nullptr);
+
+  for (int i = 0; i < 1000; i++) {
+    memtable.Put(MemKey(UserKey(i), i + 1), Value(i));
+  }
+  memtable.Put(MemKey(UserKey(500), 2000, OperatorType::DELETE), "");
+  ASSERT_EQ(memtable.BuildSSTable(dbname, &raw_meta), RC::OK);
+  std::unique_ptr<FileMetaData> meta(raw_meta);
+  ASSERT_NE(meta, nullptr);
+  EXPECT_EQ(meta->num_keys_, 1001);
+  EXPECT_EQ(meta->max_seq_, 2000);
+  EXPECT_TRUE(FileManager::Exists(meta->GetSSTablePath(dbname)));
+
+  /* 临时文件已经被重命名 */
+  int files = 0;
+  ASSERT_EQ(FileManager::ReadDir(
+                SstDir(dbname), [](string_view name) { return !name.starts_with("."); },
+                [&](string_view name) {
+                  EXPECT_TRUE(name.ends_with(".sst"));
+                  files++;
+                }),
+            RC::OK);
+  EXPECT_EQ(files, 1);
+}
@@ -0,0 +1,108 @@
+#include "sstable/table_cache.hh"
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "gtest/gtest.h"
+#include "sstable/sstable.hh"
+#include "table_test_util.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+/* 写一个只有一个 key 的表，各个 file_id 都打开它 */
+auto BuildSingleKeyTable(const std::string &name, const DBOptions &options) -> std::string {
+  return BuildTable("table_cache_" + name, options, [](SSTableWriter &writer) {
+    EXPECT_EQ(writer.Add(MemKey("key", 1).ToSSTableKey(), "value"), RC::OK);
+  });
+}
+
+/* 记录每张表被打开的次数 */
+struct Opener {
+  explicit Opener(const std::string &name) : path_(BuildSingleKeyTable(name, options_)) {}
+
+  DBOptions               options_;
+  std::string             path_;
+  std::mutex              mutex_;
+  std::map<uint64_t, int> opens_;
+  std::atomic<int>        total_{0};
+
+  auto operator()(uint64_t file_id, const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) -> RC {
+    if (file_id == 0) {
+      return RC::OPEN_FILE_ERROR;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    opens_[file_id]++;
+    total_++;
+    return SSTableReader::Open(path_, options_, file.belong_to_level_, nullptr, nullptr, reader);
+  }
+};
+
+}  // namespace
+
+TEST(TableCache, LazyOpenAndLimit) {
+  Opener     opener("lazy_open");
+  TableCache cache(10, [&](uint64_t file_id, const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) {
+    return opener(file_id, file, reader);
+  });
+  FileMetaData meta;
+  EXPECT_EQ(opener.total_, 0);
+
+  TableCache::Handle handle;
+  ASSERT_EQ(cache.FindTable(1, meta, handle), RC::OK);
+  auto *reader = handle->get();
+  ASSERT_EQ(cache.FindTable(1, meta, handle), RC::OK);
+  EXPECT_EQ(handle->get(), reader);
+  EXPECT_EQ(opener.opens_[1], 1);
+
+  /* 打开失败不缓存 */
+  TableCache::Handle bad;
+  EXPECT_EQ(cache.FindTable(0, meta, bad), RC::OPEN_FILE_ERROR);
+  EXPECT_FALSE(bad);
+
+  for (uint64_t id = 2; id <= 30; id++) {
+    TableCache::Handle h;
+    ASSERT_EQ(cache.FindTable(id, meta, h), RC::OK);
+  }
+  EXPECT_LE(cache.OpenedTables(), 10);
+  /* 被持有的表不会被关闭 */
+  EXPECT_EQ(handle->get(), reader);
+  TableCache::Handle again;
+  ASSERT_EQ(cache.FindTable(1, meta, again), RC::OK);
+  EXPECT_EQ(again->get(), reader);
+  EXPECT_EQ(opener.opens_[1], 1);
+
+  /* 最早打开且没有被持有的表已经被关闭，再次访问时重新打开 */
+  ASSERT_EQ(cache.FindTable(2, meta, again), RC::OK);
+  EXPECT_EQ(opener.opens_[2], 2);
+
+  cache.Evict(1);
+  handle = TableCache::Handle();
+  ASSERT_EQ(cache.FindTable(1, meta, handle), RC::OK);
+  EXPECT_EQ(opener.opens_[1], 2);
+}
+
+/* 多个线程同时访问同一张表只打开一次 */
+TEST(TableCache, ConcurrentOpen) {
+  Opener     opener("concurrent_open");
+  TableCache cache(0, [&](uint64_t file_id, const FileMetaData &file, std::shared_ptr<SSTableReader> &reader) {
+    return opener(file_id, file, reader);
+  });
+  FileMetaData meta;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 8; t++) {
+    threads.emplace_back([&]() {
+      for (uint64_t id = 1; id <= 100; id++) {
+        TableCache::Handle handle;
+        EXPECT_EQ(cache.FindTable(id, meta, handle), RC::OK);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(opener.total_, 100);
+  EXPECT_EQ(cache.OpenedTables(), 100);
+}
@@ -0,0 +1,45 @@
+/**
+ * @file table_test_util.hh
+ * @brief SSTable 相关测试共用的建表函数
+ *
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include "gtest/gtest.h"
+#include "sstable/sstable.hh"
+
+namespace lsm_tree {
+
+/* 清空并重新创建临时目录下的数据库目录 name 和它的 sst 目录，返回数据库目录 */
+inline auto TestDB(const std::string &name) -> std::string {
+  std::string dbname = ::testing::TempDir() + name;
+  if (FileManager::Exists(dbname)) {
+    FileManager::Destroy(dbname);
+  }
+  FileManager::Create(dbname, FileOptions::DIR_);
+  FileManager::Create(SstDir(dbname), FileOptions::DIR_);
+  return dbname;
+}
+
+/* 在新建的数据库 name 中写一张表，add 按序写入所有 key；meta 不为空时返回表的元数据。返回表文件的路径 */
+inline auto BuildTable(const std::string &name, const DBOptions &options,
+                       const std::function<void(SSTableWriter &writer)> &add, FileMetaData *meta = nullptr)
+    -> std::string {
+  auto dbname = TestDB(name);
+
+  std::unique_ptr<TempFile> file;
+  EXPECT_EQ(FileManager::OpenTempFile(SstDir(dbname), "test_", file), RC::OK);
+  SSTableWriter writer(dbname, file.release(), options);
+  add(writer);
+  FileMetaData info;
+  EXPECT_EQ(writer.Finish(&info), RC::OK);
+  if (meta != nullptr) {
+    *meta = info;
+  }
+  return info.GetSSTablePath(dbname);
+}
+
+}  // namespace lsm_tree
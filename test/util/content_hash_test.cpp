@@ -0,0 +1,74 @@
+#include "util/content_hash.hh"
+#include <random>
+#include <string>
+#include "gtest/gtest.h"
+#include "util/hash_util.hh"
+
+using namespace lsm_tree;
+
+namespace {
+
+auto RandomString(size_t len, uint32_t seed) -> std::string {
+  std::mt19937 rng(seed);
+  std::string  data(len, '\0');
+  for (auto &c : data) {
+    c = static_cast<char>(rng());
+  }
+  return data;
+}
+
+auto Digest(ContentHashType type, std::string_view data) -> std::string {
+  ContentHasher hasher(type);
+  hasher.Update(data);
+  unsigned char digest[K_MAX_CONTENT_DIGEST_LENGTH];
+  hasher.Final(digest);
+  return DigestToHex(digest, ContentDigestLength(type));
+}
+
+}  // namespace
+
+TEST(ContentHasher, Sha256) {
+  std::string   data = RandomString(100000, 1);
+  unsigned char expected[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(data.data()), data.size(), expected);
+  EXPECT_EQ(Digest(ContentHashType::SHA256, data), Sha256DigitToHex(expected));
+}
+
+/* 结果只与内容有关，与 Update 的切分方式无关 */
+TEST(ContentHasher, Hash128Streaming) {
+  std::string data     = RandomString(5 * ContentHasher::K_CHUNK_SIZE + 1234, 2);
+  std::string expected = Digest(ContentHashType::HASH128, data);
+  EXPECT_EQ(expected.size(), 32);
+
+  std::mt19937 rng(3);
+  for (int round = 0; round < 20; round++) {
+    ContentHasher hasher(ContentHashType::HASH128);
+    size_t        offset = 0;
+    while (offset < data.size()) {
+      size_t len = std::min<size_t>(rng() % (ContentHasher::K_CHUNK_SIZE * 2), data.size() - offset);
+      hasher.Update(std::string_view(data).substr(offset, len));
+      offset += len;
+    }
+    unsigned char digest[K_MAX_CONTENT_DIGEST_LENGTH];
+    hasher.Final(digest);
+    EXPECT_EQ(DigestToHex(digest, ContentDigestLength(ContentHashType::HASH128)), expected);
+  }
+}
+
+TEST(ContentHasher, Hash128Distinguishes) {
+  std::string data     = RandomString(3 * ContentHasher::K_CHUNK_SIZE, 4);
+  std::string expected = Digest(ContentHashType::HASH128, data);
+
+  /* 修改任意一个分块中的一位 */
+  for (size_t pos : {size_t{0}, ContentHasher::K_CHUNK_SIZE + 7, data.size() - 1}) {
+    std::string flipped = data;
+    flipped[pos] ^= 1;
+    EXPECT_NE(Digest(ContentHashType::HASH128, flipped), expected);
+  }
+  /* 末尾追加 0 字节、交换两个分块 */
+  EXPECT_NE(Digest(ContentHashType::HASH128, data + std::string(1, '\0')), expected);
+  std::string swapped = data.substr(ContentHasher::K_CHUNK_SIZE, ContentHasher::K_CHUNK_SIZE) +
+                        data.substr(0, ContentHasher::K_CHUNK_SIZE) + data.substr(2 * ContentHasher::K_CHUNK_SIZE);
+  EXPECT_NE(Digest(ContentHashType::HASH128, swapped), expected);
+  EXPECT_NE(Digest(ContentHashType::HASH128, ""), Digest(ContentHashType::HASH128, std::string(1, '\0')));
+}
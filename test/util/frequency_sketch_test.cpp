@@ -0,0 +1,35 @@
+#include "util/frequency_sketch.hh"
+#include "gtest/gtest.h"
+
+using namespace lsm_tree;
+
+TEST(FrequencySketch, Estimate) {
+  FrequencySketch sketch(1024);
+  for (int i = 0; i < 10; i++) {
+    sketch.Increment(42);
+  }
+  for (int i = 0; i < 20; i++) {
+    sketch.Increment(7);
+  }
+  EXPECT_GE(sketch.Estimate(42), 10);
+  EXPECT_EQ(sketch.Estimate(7), FrequencySketch::K_MAX_FREQ);
+
+  int overestimated = 0;
+  for (uint64_t key = 1000; key < 2000; key++) {
+    overestimated += sketch.Estimate(key) > 0 ? 1 : 0;
+  }
+  EXPECT_LT(overestimated, 10);
+}
+
+TEST(FrequencySketch, Aging) {
+  FrequencySketch sketch(64);
+  for (int i = 0; i < 8; i++) {
+    sketch.Increment(42);
+  }
+  EXPECT_EQ(sketch.Estimate(42), 8);
+  /* 大量其他 key 的访问触发老化，旧的计数减半 */
+  for (uint64_t key = 0; key < 64 * 10; key++) {
+    sketch.Increment(key + 100000);
+  }
+  EXPECT_LE(sketch.Estimate(42), 4 + 1);
+}
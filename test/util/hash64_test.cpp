@@ -0,0 +1,57 @@
+#include "util/hash64.hh"
+#include <string>
+#include <unordered_set>
+#include "gtest/gtest.h"
+#include "util/murmur3_hash.hh"
+
+using namespace lsm_tree;
+using namespace std;
+
+TEST(Hash64, Deterministic) {
+  for (int len = 0; len < 300; len++) {
+    string data(len, 'a');
+    for (int i = 0; i < len; i++) {
+      data[i] = static_cast<char>(i * 31 + len);
+    }
+    EXPECT_EQ(Hash64(data), Hash64(data.data(), data.size()));
+    EXPECT_NE(Hash64(data, 1), Hash64(data, 2));
+    /* 非对齐的输入 */
+    string unaligned = "x" + data;
+    EXPECT_EQ(Hash64(unaligned.data() + 1, len), Hash64(data));
+  }
+}
+
+TEST(Hash64, EveryByteMatters) {
+  for (int len = 1; len < 100; len++) {
+    string data(len, '\0');
+    auto   base = Hash64(data);
+    for (int i = 0; i < len; i++) {
+      data[i] = '\x80';
+      EXPECT_NE(Hash64(data), base) << "len " << len << " pos " << i;
+      data[i] = '\0';
+    }
+  }
+}
+
+TEST(Hash64, FewCollisions) {
+  unordered_set<uint64_t> hashes;
+  unordered_set<uint32_t> low_hashes;
+  for (int i = 0; i < 100000; i++) {
+    auto h = Hash64("user_key_" + to_string(i));
+    hashes.insert(h);
+    low_hashes.insert(static_cast<uint32_t>(h));
+  }
+  EXPECT_EQ(hashes.size(), 100000);
+  EXPECT_GT(low_hashes.size(), 99990);
+}
+
+TEST(Murmur3Hash, StandardVectors) {
+  EXPECT_EQ(Murmur3Hash(0, "", 0), 0);
+  EXPECT_EQ(Murmur3Hash(1, "", 0), 0x514E28B7);
+  EXPECT_EQ(Murmur3Hash(0, "hello", 5), 0x248BFA47);
+  string fox = "The quick brown fox jumps over the lazy dog";
+  EXPECT_EQ(Murmur3Hash(0, fox.data(), fox.size()), 0x2E4FF723);
+  /* 旧实现逐字节按有符号 char 拼接，高位字节的结果与标准实现不同 */
+  string high = "\x80\x81\x82\x83";
+  EXPECT_NE(LegacyMurmur3Hash(0, high.data(), high.size()), Murmur3Hash(0, high.data(), high.size()));
+}
@@ -1,4 +1,5 @@
 #include "util/hash_util.hh"
+#include <cstring>
 #include "gtest/gtest.h"
 
 TEST(HashUtil, HexStringToInt) {
@@ -22,3 +23,15 @@ TEST(HashUtil, Sha256DigitToHex) {
   std::string hex = lsm_tree::Sha256DigitToHex(hash);
   EXPECT_EQ(hex, hash_str);
 }
+
+TEST(HashUtil, DigestToHex) {
+  unsigned char digest[] = {0x00, 0x01, 0x7f, 0x80, 0xab, 0xff};
+  std::string   hex      = lsm_tree::DigestToHex(digest, sizeof(digest));
+  EXPECT_EQ(hex, "00017f80abff");
+
+  unsigned char decoded[sizeof(digest)];
+  EXPECT_TRUE(lsm_tree::HexToDigest("00017F80ABff", decoded));
+  EXPECT_EQ(memcmp(decoded, digest, sizeof(digest)), 0);
+  EXPECT_FALSE(lsm_tree::HexToDigest("0g", decoded));
+  EXPECT_FALSE(lsm_tree::HexToDigest("abc", decoded));
+}